@@ -0,0 +1,46 @@
+# Check that the copies of simd_kernels.cpp built for higher ISA levels
+# don't export any symbols from the library.  Anything they emit from
+# simd.h must stay in their own simd_level_<level> namespace and be
+# local to the library, so that neither the linker nor the dynamic
+# loader can substitute it for a function that must run on any CPU.
+#
+# Usage:
+#
+#    cmake -DNM=<nm> -DLIBRARY=<libOpenImageIO.so> -DLEVELS=sse4,avx,...
+#          -P check_simd_kernel_symbols.cmake
+
+if (NOT NM OR NOT LIBRARY OR NOT LEVELS)
+    message (FATAL_ERROR "check_simd_kernel_symbols: NM, LIBRARY and LEVELS are required")
+endif ()
+
+string (REPLACE "," "|" _levels "${LEVELS}")
+set (_pattern "(simd_level_(${_levels})::|pvt::simd_kernels_(${_levels})\\()")
+
+# The dynamic symbol table must not mention them at all, and in the full
+# symbol table (if the library isn't stripped) they must all be local,
+# which nm lists with a lowercase type letter.
+set (_failed "")
+foreach (_table "-D" "")
+    execute_process (COMMAND ${NM} -C --defined-only ${_table} ${LIBRARY}
+                     OUTPUT_VARIABLE _symbols
+                     ERROR_QUIET
+                     RESULT_VARIABLE _result)
+    if (NOT _result EQUAL 0)
+        continue ()
+    endif ()
+    string (REPLACE "\n" ";" _symbols "${_symbols}")
+    foreach (_line ${_symbols})
+        if (_line MATCHES "${_pattern}")
+            if (_table STREQUAL "-D" OR _line MATCHES "^[0-9a-fA-F]* *[A-Z] ")
+                list (APPEND _failed "${_line}")
+            endif ()
+        endif ()
+    endforeach ()
+endforeach ()
+
+if (_failed)
+    list (REMOVE_DUPLICATES _failed)
+    string (REPLACE ";" "\n    " _failed "${_failed}")
+    message (FATAL_ERROR "SIMD kernel variant symbols exported from ${LIBRARY}:\n    ${_failed}")
+endif ()
+message (STATUS "No SIMD kernel variant symbols exported from ${LIBRARY}")
@@ -38,6 +38,7 @@
 
 
 #include <algorithm>
+#include <OpenImageIO/simd.h>
 #include "BaseTypeConverter.h"
 
 
@@ -60,6 +61,166 @@
 namespace dpx 
 {
 
+	// Fast path for unpacking 10-bit filled (method A or B) data into 16-bit
+	// buffers, used when the block starts on a 32-bit word boundary.  Each
+	// word holds three datums, the first one in the most significant bits,
+	// or in the least significant bits when LOWFIRST is true (which is how
+	// 1-channel images are stored).  Only whole words are unpacked; the
+	// return value is the number of datums written, always a multiple of 3.
+	// SIMD selects the SSE4.1 loop when the build has it (the unit test
+	// clears it to check the two loops against each other).
+	template <int PADDINGBITS, bool LOWFIRST, bool SIMD = true>
+	int Unfill10bitFilledWords(const U32 *readBuf, U16 *obuf, const int count)
+	{
+		const int words = count / 3;
+		int w = 0;
+#if OIIO_SIMD_SSE >= 4
+		// Four words (twelve datums) per iteration: split the words into
+		// three vectors of first/second/third datums, widen 10->16 bits,
+		// narrow to 16-bit lanes and shuffle them back into datum order.
+		const __m128i mask = _mm_set1_epi32(0x3ff);
+		const __m128i shufAB0 = _mm_setr_epi8(0,1, 8,9, -1,-1, 2,3, 10,11, -1,-1, 4,5, 12,13);
+		const __m128i shufC0  = _mm_setr_epi8(-1,-1, -1,-1, 0,1, -1,-1, -1,-1, 2,3, -1,-1, -1,-1);
+		const __m128i shufAB1 = _mm_setr_epi8(-1,-1, 6,7, 14,15, -1,-1, -1,-1, -1,-1, -1,-1, -1,-1);
+		const __m128i shufC1  = _mm_setr_epi8(4,5, -1,-1, -1,-1, 6,7, -1,-1, -1,-1, -1,-1, -1,-1);
+		for ( ; SIMD && w + 4 <= words; w += 4)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(readBuf + w));
+			__m128i hi = _mm_and_si128(_mm_srli_epi32(v, 20 + PADDINGBITS), mask);
+			__m128i mid = _mm_and_si128(_mm_srli_epi32(v, 10 + PADDINGBITS), mask);
+			__m128i lo = _mm_and_si128(_mm_srli_epi32(v, PADDINGBITS), mask);
+			__m128i a = LOWFIRST ? lo : hi;
+			__m128i c = LOWFIRST ? hi : lo;
+			// same as BaseTypeConvertU10ToU16
+			a = _mm_or_si128(_mm_slli_epi32(a, 6), _mm_srli_epi32(a, 4));
+			mid = _mm_or_si128(_mm_slli_epi32(mid, 6), _mm_srli_epi32(mid, 4));
+			c = _mm_or_si128(_mm_slli_epi32(c, 6), _mm_srli_epi32(c, 4));
+			__m128i ab = _mm_packus_epi32(a, mid);		// a0 a1 a2 a3 b0 b1 b2 b3
+			__m128i cc = _mm_packus_epi32(c, c);		// c0 c1 c2 c3 c0 c1 c2 c3
+			__m128i out0 = _mm_or_si128(_mm_shuffle_epi8(ab, shufAB0), _mm_shuffle_epi8(cc, shufC0));
+			__m128i out1 = _mm_or_si128(_mm_shuffle_epi8(ab, shufAB1), _mm_shuffle_epi8(cc, shufC1));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(obuf + 3 * w), out0);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(obuf + 3 * w + 8), out1);
+		}
+#endif
+		for ( ; w < words; w++)
+		{
+			const U32 word = readBuf[w];
+			U16 d0 = U16((word >> (20 + PADDINGBITS)) & 0x3ff);
+			U16 d1 = U16((word >> (10 + PADDINGBITS)) & 0x3ff);
+			U16 d2 = U16((word >> PADDINGBITS) & 0x3ff);
+			BaseTypeConvertU10ToU16(d0, d0);
+			BaseTypeConvertU10ToU16(d1, d1);
+			BaseTypeConvertU10ToU16(d2, d2);
+			obuf[3 * w] = LOWFIRST ? d2 : d0;
+			obuf[3 * w + 1] = d1;
+			obuf[3 * w + 2] = LOWFIRST ? d0 : d2;
+		}
+		return words * 3;
+	}
+
+	// Only 16-bit destination buffers (the native format for 10-bit DPX)
+	// have a fast path; everything else goes through the generic loop.
+	template <int PADDINGBITS, typename BUF>
+	inline int Unfill10bitFilledFast(const U32 *, BUF *, const int, const bool)
+	{
+		return 0;
+	}
+
+	template <int PADDINGBITS>
+	inline int Unfill10bitFilledFast(const U32 *readBuf, U16 *obuf, const int count, const bool lowfirst)
+	{
+		if (lowfirst)
+			return Unfill10bitFilledWords<PADDINGBITS, true>(readBuf, obuf, count);
+		return Unfill10bitFilledWords<PADDINGBITS, false>(readBuf, obuf, count);
+	}
+
+
+	// Fast path for widening 12-bit filled method B data (12 bits in the
+	// least significant bits of each 16-bit word) into 16-bit buffers, eight
+	// words per iteration with SSE2.  Returns the number of datums written.
+	template <bool SIMD>
+	int Unfill12bitFilledWords(const U16 *readBuf, U16 *obuf, const int count)
+	{
+		int i = 0;
+#if OIIO_SIMD_SSE >= 2
+		for ( ; SIMD && i + 8 <= count; i += 8)
+		{
+			// same as BaseTypeConvertU12ToU16
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(readBuf + i));
+			v = _mm_or_si128(_mm_slli_epi16(v, 4), _mm_srli_epi16(v, 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(obuf + i), v);
+		}
+#endif
+		for ( ; i < count; i++)
+		{
+			U16 d1 = readBuf[i];
+			BaseTypeConvertU12ToU16(d1, d1);
+			obuf[i] = d1;
+		}
+		return count;
+	}
+
+	template <typename BUF>
+	inline int Unfill12bitFilledFast(const U16 *, BUF *, const int)
+	{
+		return 0;
+	}
+
+	inline int Unfill12bitFilledFast(const U16 *readBuf, U16 *obuf, const int count)
+	{
+		return Unfill12bitFilledWords<true>(readBuf, obuf, count);
+	}
+
+
+	// Fast path for unpacking 12-bit packed data into 16-bit buffers, used
+	// when the block starts on a 32-bit word boundary.  Every three words
+	// hold exactly eight datums, the first one in the least significant
+	// bits, so whole groups unpack with fixed shifts.  UnPackPacked reads
+	// the buffer as 16-bit values in host order, so this only matches it
+	// on little-endian hosts.  Returns the number of datums written, always
+	// a multiple of 8.
+	inline int Unpack12bitPackedWords(const U32 *readBuf, U16 *obuf, const int count)
+	{
+		if (!OIIO::littleendian())
+			return 0;
+
+		const int groups = count / 8;
+		for (int g = 0; g < groups; g++)
+		{
+			const U32 w0 = readBuf[3 * g];
+			const U32 w1 = readBuf[3 * g + 1];
+			const U32 w2 = readBuf[3 * g + 2];
+			U16 d[8];
+			d[0] = U16(w0 & 0xfff);
+			d[1] = U16((w0 >> 12) & 0xfff);
+			d[2] = U16((w0 >> 24) | ((w1 & 0xf) << 8));
+			d[3] = U16((w1 >> 4) & 0xfff);
+			d[4] = U16((w1 >> 16) & 0xfff);
+			d[5] = U16((w1 >> 28) | ((w2 & 0xff) << 4));
+			d[6] = U16((w2 >> 8) & 0xfff);
+			d[7] = U16(w2 >> 20);
+			for (int k = 0; k < 8; k++)
+			{
+				BaseTypeConvertU12ToU16(d[k], d[k]);
+				obuf[8 * g + k] = d[k];
+			}
+		}
+		return groups * 8;
+	}
+
+	template <typename BUF>
+	inline int Unpack12bitPackedFast(const U32 *, BUF *, const int)
+	{
+		return 0;
+	}
+
+	inline int Unpack12bitPackedFast(const U32 *readBuf, U16 *obuf, const int count)
+	{
+		return Unpack12bitPackedWords(readBuf, obuf, count);
+	}
+
+
 	// this function is called when the DataSize is 10 bit and the packing method is kFilledMethodA or kFilledMethodB
 	template<typename BUF, int PADDINGBITS>
 	void Unfill10bitFilled(U32 *readBuf, const int x, BUF *data, int count, int bufoff, const int numberOfComponents)
@@ -154,8 +315,7 @@ namespace dpx
 			
 			// get the read count in bytes, round to the 32-bit boundry
 			int readSize = (block.x2 - block.x1 + 1) * numberOfComponents;
-			readSize += readSize % 3;
-			readSize = readSize / 3 * 4;
+			readSize = (readSize + 2) / 3 * 4;
 			
 			// determine buffer offset
 			int bufoff = line * datums;
@@ -169,18 +329,29 @@ namespace dpx
 #else					
 			BUF *obuf = data + bufoff;
 			int index = (block.x1 * sizeof(U32)) % numberOfComponents;
+			const int total = (block.x2 - block.x1 + 1) * numberOfComponents;
 
-			for (int count = (block.x2 - block.x1 + 1) * numberOfComponents - 1; count >= 0; count--)
+			// work-around for 1-channel DPX images - the first datum of each
+			// word is in the least significant bits, otherwise the columns are
+			// in the wrong order
+			const bool lowfirst = (numberOfComponents == 1);
+
+			// whole words starting on a word boundary take the fast path,
+			// any leftover datums are handled below
+			int done = 0;
+			if (block.x1 == 0)
+				done = Unfill10bitFilledFast<PADDINGBITS>(readBuf, obuf, total, lowfirst);
+
+			for (int count = total - 1; count >= done; count--)
 			{
 				// unpacking the buffer backwords
-				U16 d1 = U16(readBuf[(count + index) / 3] >> ((2 - (count + index) % 3) * 10 + PADDINGBITS) & 0x3ff);
+				int datum = (count + index) % 3;
+				if (!lowfirst)
+					datum = 2 - datum;
+				U16 d1 = U16(readBuf[(count + index) / 3] >> (datum * 10 + PADDINGBITS) & 0x3ff);
 				BaseTypeConvertU10ToU16(d1, d1);
 
 				BaseTypeConverter(d1, obuf[count]);
-
-				// work-around for 1-channel DPX images - to swap the outlying pixels, otherwise the columns are in the wrong order
-				if (numberOfComponents == 1 && count % 3 == 0)
-					std::swap(obuf[count], obuf[count + 2]);
 			}
 #endif		
 		}
@@ -207,12 +378,12 @@ namespace dpx
 	// 10 bit, packed data
 	// 12 bit, packed data
 	template <typename BUF, U32 MASK, int MULTIPLIER, int REMAIN, int REVERSE>
-	void UnPackPacked(U32 *readBuf, const int bitDepth, BUF *data, int count, int bufoff)
+	void UnPackPacked(U32 *readBuf, const int bitDepth, BUF *data, int count, int bufoff, const int done = 0)
 	{
-		// unpack the words in the buffer
+		// unpack the words in the buffer, skipping the first done datums
 		BUF *obuf = data + bufoff;
 				
-		for (int i = count - 1; i >= 0; i--)
+		for (int i = count - 1; i >= done; i--)
 		{
 			// unpacking the buffer backwords
 			// find the byte that the data starts in, read in as a 16 bits then shift and mask
@@ -289,9 +460,13 @@ namespace dpx
 	
 			fd->Read(dpxHeader, element, offset, readBuf, readSize);
 
-			// unpack the words in the buffer
+			// unpack the words in the buffer; whole groups of 12-bit datums
+			// starting on a word boundary take the fast path
 			int count = (block.x2 - block.x1 + 1) * numberOfComponents;
-			UnPackPacked<BUF, MASK, MULTIPLIER, REMAIN, REVERSE>(readBuf, dataSize, data, count, bufoff);
+			int done = 0;
+			if (dataSize == 12 && block.x1 == 0)
+				done = Unpack12bitPackedFast(readBuf, data + bufoff, count);
+			UnPackPacked<BUF, MASK, MULTIPLIER, REMAIN, REVERSE>(readBuf, dataSize, data, count, bufoff, done);
 		}
 
 		return true;
@@ -387,8 +562,9 @@ namespace dpx
 	
 			fd->Read(dpxHeader, element, offset, readBuf, width*2);
 				
-			// convert data		
-			for (int i = 0; i < width; i++)
+			// convert data
+			const int done = Unfill12bitFilledFast(readBuf, data + width * line, width);
+			for (int i = done; i < width; i++)
 			{
 				U16 d1 = readBuf[i];
 				BaseTypeConvertU12ToU16(d1, d1);
@@ -44,7 +44,7 @@ namespace dpx
 {
 	
 
-	void EndianBufferSwap(int bitdepth, dpx::Packing packing, void *buf, const size_t size)
+	inline void EndianBufferSwap(int bitdepth, dpx::Packing packing, void *buf, const size_t size)
 	{
 		switch (bitdepth)
 		{
@@ -158,8 +158,29 @@ namespace dpx
 		else if (BITDEPTH == 8)
 			return;
 
-		int i, entry;
-		for (i = 0; i < len; i++)
+		int i = 0, entry;
+
+		// 12-bit datums: eight of them fill exactly three words, so pack
+		// whole groups first.  Each group is loaded before its words are
+		// stored, and the words never overrun the next group's source, so
+		// this is safe to do in place.
+		if (BITDEPTH == 12)
+		{
+			const IB *sbuf = src + access.offset;
+			const int groups = len / 8;
+			for (int g = 0; g < groups; g++)
+			{
+				U32 d[8];
+				for (int k = 0; k < 8; k++)
+					d[k] = (static_cast<U32>(sbuf[8 * g + k]) >> shift) & mask;
+				dst_u32[3 * g] = d[0] | (d[1] << 12) | (d[2] << 24);
+				dst_u32[3 * g + 1] = (d[2] >> 8) | (d[3] << 4) | (d[4] << 16) | (d[5] << 28);
+				dst_u32[3 * g + 2] = (d[5] >> 4) | (d[6] << 8) | (d[7] << 20);
+			}
+			i = groups * 8;
+		}
+
+		for ( ; i < len; i++)
 		{
 			// read value and determine write location
 			U32 value = static_cast<U32>(src[i+access.offset]) >> shift;
@@ -215,36 +236,36 @@ namespace dpx
 		// shift bits over 2 if Method A
 		const int method_shift = (METHOD == kFilledMethodA ? 2 : 0);
 		
-		// loop through the buffer
-		int i;
-		U32 value = 0;
-		for (i = 0; i < len; i++)
+		// datum position (in units of 10 bits) of each datum within a word
+		const int rem0 = (reverse ? 2 : 0);
+		const int rem2 = (reverse ? 0 : 2);
+
+		// pack whole words first; each word only depends on its own three
+		// datums, so this is safe to do in place
+		const IB *sbuf = src + access.offset;
+		const int words = len / 3;
+		for (int w = 0; w < words; w++)
 		{
-			int div = i / 3;			// 3 10-bit values in a U32
-			int rem = i % 3;
-	
-			// write previously calculated value
-			if (i && rem == 0)
+			const U32 d0 = (static_cast<U32>(sbuf[3 * w]) >> shift) & bitmask;
+			const U32 d1 = (static_cast<U32>(sbuf[3 * w + 1]) >> shift) & bitmask;
+			const U32 d2 = (static_cast<U32>(sbuf[3 * w + 2]) >> shift) & bitmask;
+			dst_u32[w] = ((d0 << (bitdepth * rem0)) | (d1 << bitdepth) | (d2 << (bitdepth * rem2))) << method_shift;
+		}
+
+		// leftover datums in a final partial word
+		if (len > words * 3)
+		{
+			U32 value = 0;
+			for (int i = words * 3; i < len; i++)
 			{
-				dst_u32[div-1] = value;
-				value = 0;
+				int rem = i % 3;
+				if (reverse)
+					rem = 2 - rem;
+				value |= ((static_cast<U32>(sbuf[i]) >> shift) & bitmask) << (bitdepth * rem);
 			}
-
-			// if reverse the order
-			if (reverse)
-				rem = 2 - rem;
-
-			// place the 10 bits in the proper place with mask
-			U32 comp = ((static_cast<U32>(src[i+access.offset]) >> shift) << (bitdepth * rem)) << method_shift;
-			U32 mask = (bitmask << (bitdepth * rem)) << method_shift ;
-			
-			// overwrite only the proper 10 bits
-			value = (value & ~mask) | (comp & mask);
+			dst_u32[words] = value << method_shift;
 		}
 		
-		// write last
-		dst_u32[(len+2)/3-1] = value;
-
 		// adjust offset/length
 		// multiply * 2 because it takes two U16 = U32 and this func packs into a U32
 		access.offset = 0;
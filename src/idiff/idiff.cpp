@@ -263,6 +263,18 @@ main (int argc, char *argv[])
 
             // Compare the two images.
             //
+            // When no report or difference image is wanted, first try the
+            // quick pass/fail test, which stops at the first value over
+            // the tighter of the two thresholds.  If nothing is over it,
+            // the full comparison could only say "no warnings, no
+            // failures", so there's nothing more to do.
+            if (! verbose && ! perceptual && diffimage.empty() &&
+                  hardfail == std::numeric_limits<float>::max() &&
+                  hardwarn == std::numeric_limits<float>::max() &&
+                  ImageBufAlgo::compare_pass (img0, img1,
+                                              std::min (failthresh, warnthresh))) {
+                continue;
+            }
             ImageBufAlgo::CompareResults cr;
             ImageBufAlgo::compare (img0, img1, failthresh, warnthresh, cr);
 
@@ -94,7 +94,10 @@ grep_file (const std::string &filename, regex &re,
         return r;
     }
 
-    std::unique_ptr<ImageInput> in (ImageInput::open (filename.c_str()));
+    // We only ever look at metadata, never pixels
+    ImageSpec config;
+    config.attribute ("oiio:HeaderOnly", 1);
+    std::unique_ptr<ImageInput> in (ImageInput::open (filename.c_str(), &config));
     if (! in.get()) {
         if (! ignore_nonimage_files)
             std::cerr << geterror() << "\n";
@@ -70,6 +70,7 @@ static bool filenameprefix = false;
 static regex field_re;
 static bool subimages = false;
 static bool compute_sha1 = false;
+static std::string hash_algorithm = "sha1";
 static bool compute_stats = false;
 
 
@@ -100,6 +101,20 @@ print_sha1 (ImageInput *input)
             printf ("    SHA-1: unable to compute, could not read image\n");
             return;
         }
+        if (! Strutil::iequals (hash_algorithm, "sha1") &&
+            ! Strutil::iequals (hash_algorithm, "sha-1") &&
+            spec.channelformats.empty()) {
+            // One of the faster hashes: wrap the native pixels and let
+            // computePixelHash do the work in parallel.
+            ImageBuf wrapper (spec, &buf[0]);
+            std::string hash = computePixelHash (wrapper, hash_algorithm);
+            if (hash.empty())
+                printf ("    %s: unable to compute, %s\n",
+                        hash_algorithm.c_str(), wrapper.geterror().c_str());
+            else
+                printf ("    %s: %s\n", hash_algorithm.c_str(), hash.c_str());
+            return;
+        }
         sha.append (&buf[0], size);
     }
 
@@ -655,6 +670,7 @@ main (int argc, const char *argv[])
                 "-s", &sum, "Sum the image sizes",
                 "-a", &subimages, "Print info about all subimages",
                 "--hash", &compute_sha1, "Print SHA-1 hash of pixel values",
+                "--hash-algorithm %s", &hash_algorithm, "Hash for --hash: sha1 (default), xxh64, farmhash128",
                 "--stats", &compute_stats, "Print image pixel statistics (data window)",
                 NULL);
     if (ap.parse(argc, argv) < 0 || filenames.empty()) {
@@ -683,9 +699,15 @@ main (int argc, const char *argv[])
         longestname = std::max (longestname, s.length());
     longestname = std::min (longestname, (size_t)40);
 
+    // Unless we need the pixels, let the readers skip any work that is
+    // only needed to read pixel data.
+    ImageSpec config;
+    if (! compute_sha1 && ! compute_stats)
+        config.attribute ("oiio:HeaderOnly", 1);
+
     long long totalsize = 0;
     for (auto&& s : filenames) {
-        ImageInput *in = ImageInput::open (s.c_str());
+        ImageInput *in = ImageInput::open (s.c_str(), &config);
         if (! in) {
             std::string err = geterror();
             if (err.empty())
@@ -57,6 +57,9 @@ class OIIO_API ColorProcessor;
 ///
 /// NOTE: ColorConfig(s) and ColorProcessor(s) are potentially heavy-weight.
 /// Their construction / destruction should be kept to a minimum.
+/// A ColorConfig caches the processors it creates, so asking it again
+/// for the same transformation is cheap and shares any lookup tables
+/// already baked for it.
 
 class OIIO_API ColorConfig
 {
@@ -257,6 +260,12 @@ inline simd::vfloat4 sRGB_to_linear (const simd::vfloat4& x)
                          fast_pow_pos (madd (x, (1.0f / 1.055f), 0.055f*(1.0f/1.055f)), 2.4f));
 }
 
+inline simd::vfloat8 sRGB_to_linear (const simd::vfloat8& x)
+{
+    return simd::select (x <= 0.04045f, x * (1.0f/12.92f),
+                         fast_pow_pos (madd (x, (1.0f / 1.055f), 0.055f*(1.0f/1.055f)), 2.4f));
+}
+
 /// Utility -- convert linear value to sRGB
 inline float linear_to_sRGB (float x)
 {
@@ -273,6 +282,12 @@ inline simd::vfloat4 linear_to_sRGB (const simd::vfloat4& x)
                          madd (1.055f, fast_pow_pos (x, 1.f/2.4f),  -0.055f));
 }
 
+inline simd::vfloat8 linear_to_sRGB (const simd::vfloat8& x)
+{
+    return simd::select (x <= 0.0031308f, 12.92f * x,
+                         madd (1.055f, fast_pow_pos (x, 1.f/2.4f),  -0.055f));
+}
+
 
 /// Utility -- convert Rec709 value to linear
 ///    http://en.wikipedia.org/wiki/Rec._709
@@ -284,6 +299,18 @@ inline float Rec709_to_linear (float x)
         return powf ((x + 0.099f) * (1.0f/1.099f), (1.0f/0.45f));
 }
 
+inline simd::vfloat4 Rec709_to_linear (const simd::vfloat4& x)
+{
+    return simd::select (x < 0.081f, x * (1.0f/4.5f),
+                         fast_pow_pos (madd (x, (1.0f/1.099f), 0.099f*(1.0f/1.099f)), 1.0f/0.45f));
+}
+
+inline simd::vfloat8 Rec709_to_linear (const simd::vfloat8& x)
+{
+    return simd::select (x < 0.081f, x * (1.0f/4.5f),
+                         fast_pow_pos (madd (x, (1.0f/1.099f), 0.099f*(1.0f/1.099f)), 1.0f/0.45f));
+}
+
 /// Utility -- convert linear value to Rec709
 inline float linear_to_Rec709 (float x)
 {
@@ -293,6 +320,18 @@ inline float linear_to_Rec709 (float x)
         return 1.099f * powf(x, 0.45f) - 0.099f;
 }
 
+inline simd::vfloat4 linear_to_Rec709 (const simd::vfloat4& x)
+{
+    return simd::select (x < 0.018f, x * 4.5f,
+                         madd (1.099f, fast_pow_pos (x, 0.45f), -0.099f));
+}
+
+inline simd::vfloat8 linear_to_Rec709 (const simd::vfloat8& x)
+{
+    return simd::select (x < 0.018f, x * 4.5f,
+                         madd (1.099f, fast_pow_pos (x, 0.45f), -0.099f));
+}
+
 
 OIIO_NAMESPACE_END
 
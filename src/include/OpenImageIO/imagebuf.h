@@ -223,6 +223,7 @@ public:
     enum IBStorage { UNINITIALIZED,   // no pixel memory
                      LOCALBUFFER,     // The IB owns the memory
                      APPBUFFER,       // The IB wraps app's memory
+                                      //   (or is a view of another IB)
                      IMAGECACHE       // Backed by ImageCache
                    };
 
@@ -353,6 +354,61 @@ public:
     /// copy(src), but with optional override of pixel data type
     bool copy (const ImageBuf &src, TypeDesc format /*= TypeDesc::UNKNOWN*/);
 
+    /// Make *this a "view" of the pixels of src within roi: it refers to
+    /// src's local pixel memory rather than copying it, so it costs
+    /// nothing no matter how big the image is.  The view keeps src's
+    /// pixel coordinates (its data window is roi, which must lie within
+    /// src's data window) and covers the contiguous range of channels
+    /// [roi.chbegin,roi.chend), with the channel names, alpha and z
+    /// channels of src adjusted to match.  It gets its own copy of the
+    /// spec, so its origin, full window, channel names, and metadata may
+    /// be changed freely through specmod().
+    ///
+    /// The view shares ownership of src's pixel memory, so it stays
+    /// valid even if src is cleared or destroyed (unless src wrapped an
+    /// app buffer, which the app must keep alive).  Writing pixels of the
+    /// view writes the pixels of src, but copying the view (by the copy
+    /// constructor or copy()) makes an ordinary image that owns its
+    /// pixels.  The storage() of a view is APPBUFFER, and its local
+    /// pixels are generally not contiguous -- see pixel_stride() et al.
+    ///
+    /// Return true on success.  It fails (returning false, with an error
+    /// message in *this) if src's pixels are not in local memory (for
+    /// example, if src is backed by the ImageCache) or are deep, or if
+    /// roi is not within src.
+    bool make_view (const ImageBuf &src, ROI roi = ROI::All());
+
+    /// Is this ImageBuf a view of another's pixels (see make_view)?
+    bool is_view () const;
+
+    /// Store the local pixels "tile-major": in blocks of width x height
+    /// x depth pixels (each block contiguous and scanline-major within
+    /// itself), rather than as whole scanlines.  This keeps pixels that
+    /// are near each other vertically near each other in memory, which
+    /// helps operations that walk down columns (transpose, rotate90,
+    /// flop, warp, vertical filter passes) on wide images.  A width of
+    /// 0 restores ordinary scanline-major storage.  Pixels already in
+    /// local memory are rearranged; otherwise the layout is used when
+    /// they are next read or allocated, for example by a forced read(),
+    /// which reads a tiled file of the same tile size straight into the
+    /// matching tiles.  All ImageBuf methods, iterators, and
+    /// ImageBufAlgo functions work with either layout.  Return false
+    /// (and set an error) for a view, an application buffer, or a deep
+    /// image, whose layout can't be changed.
+    bool set_local_tiles (int width=64, int height=64, int depth=1);
+
+    /// The tile size of tile-major local pixels (width 0 if the pixels
+    /// are stored a scanline at a time).
+    int local_tile_width () const;
+    int local_tile_height () const;
+    int local_tile_depth () const;
+
+    /// The part of the data window stored in the same block of local
+    /// pixel memory as pixel (x,y,z): within it, pixels are evenly
+    /// spaced by pixel_stride(), scanline_stride(), and z_stride().  For
+    /// scanline-major pixels this is the whole data window.
+    ROI local_tile (int x, int y, int z=0) const;
+
     /// Swap with another ImageBuf
     void swap (ImageBuf &other) { std::swap (m_impl, other.m_impl); }
 
@@ -641,10 +697,26 @@ public:
 
     /// A raw pointer to "local" pixel memory, if they are fully in RAM
     /// and not backed by an ImageCache, or NULL otherwise.  You can
-    /// also test it like a bool to find out if pixels are local.
+    /// also test it like a bool to find out if pixels are local.  Unless
+    /// contiguous() is true, the pixels must be addressed with the
+    /// strides below (or pixeladdr()), within each local_tile() of
+    /// tile-major pixels.
     void *localpixels ();
     const void *localpixels () const;
 
+    /// Distance in bytes between successive pixels, scanlines, and
+    /// image planes of the local pixel memory (within one tile, for
+    /// tile-major pixels).  These are the sizes of a pixel, scanline,
+    /// and plane except for a view or tile-major pixels.
+    stride_t pixel_stride () const;
+    stride_t scanline_stride () const;
+    stride_t z_stride () const;
+
+    /// Are the local pixels laid out as one contiguous block, each
+    /// pixel, scanline, and plane immediately following the previous?
+    /// Always false if the pixels are not local.
+    bool contiguous () const;
+
     /// Are the pixels backed by an ImageCache, rather than the whole
     /// image being in RAM somewhere?
     bool cachedpixels () const;
@@ -871,9 +943,12 @@ public:
             bool v = valid(x_,y_,z_);
             bool e = exists(x_,y_,z_);
             if (m_localpixels) {
-                if (e)
+                if (e) {
                     m_proxydata = (char *)m_ib->pixeladdr (x_, y_, z_);
-                else {  // pixel not in data window
+                    m_tilexend = m_local_tiles
+                               ? m_ib->local_tile (x_, y_, z_).xend
+                               : m_img_xend;
+                } else {  // pixel not in data window
                     m_x = x_;  m_y = y_;  m_z = z_;
                     if (m_wrap == WrapBlack) {
                         m_proxydata = (char *)m_ib->blackpixel();
@@ -960,6 +1035,7 @@ public:
         bool m_valid, m_exists;
         bool m_deep;
         bool m_localpixels;
+        bool m_local_tiles;     // local pixels are tile-major
         // Image boundaries
         int m_img_xbegin, m_img_xend, m_img_ybegin, m_img_yend,
             m_img_zbegin, m_img_zend;
@@ -981,12 +1057,14 @@ public:
             const ImageSpec &spec (m_ib->spec());
             m_deep = spec.deep;
             m_localpixels = (m_ib->localpixels() != NULL);
+            m_local_tiles = m_localpixels && m_ib->local_tile_width();
             m_img_xbegin = spec.x; m_img_xend = spec.x+spec.width;
             m_img_ybegin = spec.y; m_img_yend = spec.y+spec.height;
             m_img_zbegin = spec.z; m_img_zend = spec.z+spec.depth;
             m_nchannels = spec.nchannels;
 //            m_tilewidth = spec.tile_width;
-            m_pixel_bytes = spec.pixel_bytes();
+            m_pixel_bytes = m_ib->pixel_stride();
+            m_tilexend = m_img_xend;
             m_x = 1<<31;
             m_y = 1<<31;
             m_z = 1<<31;
@@ -1009,7 +1087,15 @@ public:
             DASSERT (valid(m_x,m_y,m_z));    // should be true by definition
             m_proxydata += m_pixel_bytes;
             if (m_localpixels) {
-                if (OIIO_UNLIKELY(m_x >= m_img_xend)) {
+                // m_tilexend is the end of the row unless the pixels
+                // are tile-major.
+                if (OIIO_UNLIKELY(m_x >= m_tilexend)) {
+                    if (m_x < m_img_xend) {
+                        // Crossed into the next tile of the row
+                        m_proxydata = (char *)m_ib->pixeladdr (m_x, m_y, m_z);
+                        m_tilexend = m_ib->local_tile (m_x, m_y, m_z).xend;
+                        return;
+                    }
                     // Ran off the end of the row
                     m_exists = false;
                     if (m_wrap == WrapBlack) {
@@ -1277,6 +1363,224 @@ public:
     };
 
 
+    friend class SpanIteratorBase;
+
+    /// Base class for SpanIterator and ConstSpanIterator, which walk a
+    /// region of an ImageBuf one contiguous run ("span") of pixels at a
+    /// time rather than one pixel at a time.  Each scanline of the region
+    /// is covered by one or more spans, in order.  A span lies either
+    /// entirely inside the data window -- in which case its pixels are
+    /// evenly spaced, stride() values apart, in the local pixel memory
+    /// (in one tile of it, if tile-major) or in a single tile of an
+    /// ImageCache-backed image -- or
+    /// entirely outside it, in which case exists() is false and data()
+    /// points to a single black pixel with a stride() of 0 (the same
+    /// values the WrapBlack mode of Iterator would give).  All of the
+    /// range, wrap, and tile checks are thus paid once per span instead
+    /// of once per pixel, and a kernel is left with a plain loop:
+    /// \code
+    ///   for (ImageBuf::ConstSpanIterator<float> s (A, roi); !s.done(); ++s) {
+    ///       const float *a = s.data();
+    ///       for (int i = 0, n = s.npixels(); i < n; ++i, a += s.stride())
+    ///           ...
+    ///   }
+    /// \endcode
+    /// Several span iterators over the same ROI (of different images,
+    /// whose spans may break at different places) can be walked in
+    /// lockstep by processing the smallest npixels() of them and then
+    /// calling advance() on each with that count.
+    /// Deep images are not supported.
+    class SpanIteratorBase {
+    public:
+        SpanIteratorBase (const ImageBuf &ib, const ROI &roi)
+            : m_ib(&ib), m_tile(NULL), m_data(NULL), m_stride(0)
+        {
+            init_ib ();
+            if (roi.defined()) {
+                m_rng_xbegin = roi.xbegin;  m_rng_xend = roi.xend;
+                m_rng_ybegin = roi.ybegin;  m_rng_yend = roi.yend;
+                m_rng_zbegin = roi.zbegin;  m_rng_zend = roi.zend;
+            } else {
+                m_rng_xbegin = m_img_xbegin;  m_rng_xend = m_img_xend;
+                m_rng_ybegin = m_img_ybegin;  m_rng_yend = m_img_yend;
+                m_rng_zbegin = m_img_zbegin;  m_rng_zend = m_img_zend;
+            }
+            m_x = m_rng_xbegin;  m_y = m_rng_ybegin;  m_z = m_rng_zbegin;
+            if (m_rng_xbegin >= m_rng_xend || m_rng_ybegin >= m_rng_yend)
+                m_z = m_rng_zend;   // make empty range look "done"
+            if (! done())
+                find_span ();
+        }
+
+        ~SpanIteratorBase () {
+            if (m_tile)
+                m_ib->imagecache()->release_tile (m_tile);
+        }
+
+        /// Are we finished with the region?
+        bool done () const { return m_z >= m_rng_zend; }
+
+        /// Advance to the next span.
+        void operator++ () {
+            if (m_xend < m_rng_xend) {
+                m_x = m_xend;
+            } else {
+                m_x = m_rng_xbegin;
+                if (++m_y >= m_rng_yend) {
+                    m_y = m_rng_ybegin;
+                    if (++m_z >= m_rng_zend)
+                        return;
+                }
+            }
+            find_span ();
+        }
+
+        /// Advance by n pixels within the current scanline, where n is no
+        /// more than npixels().  If that consumes the rest of the current
+        /// span, move on to the next span.
+        void advance (int n) {
+            if (m_x + n >= m_xend) {
+                ++(*this);
+            } else {
+                m_x += n;
+                if (m_stride)
+                    m_data += (size_t) n * m_pixel_bytes;
+            }
+        }
+
+        /// Coordinates of the first pixel of the current span.
+        int x () const { return m_x; }
+        int y () const { return m_y; }
+        int z () const { return m_z; }
+        /// One past the last x coordinate of the current span.
+        int xend () const { return m_xend; }
+        /// Number of pixels in the current span.
+        int npixels () const { return m_xend - m_x; }
+        /// Distance, in channel values, between successive pixels.
+        /// This is nchannels() within the data window (more, within a
+        /// view of some of the channels of another image), and 0 for a
+        /// span outside it (where every pixel shares one black pixel).
+        int stride () const { return m_stride; }
+        /// Do the pixels of the current span have stored values?
+        bool exists () const { return m_stride != 0; }
+
+    protected:
+        const ImageBuf *m_ib;
+        bool m_localpixels;
+        bool m_local_tiles;     // local pixels are tile-major
+        int m_nchannels;
+        int m_pixel_bytes;      // distance between local pixels, in bytes
+        int m_local_stride;     // ... and in channel values
+        int m_rng_xbegin, m_rng_xend, m_rng_ybegin, m_rng_yend,
+            m_rng_zbegin, m_rng_zend;
+        int m_img_xbegin, m_img_xend, m_img_ybegin, m_img_yend,
+            m_img_zbegin, m_img_zend;
+        int m_x, m_y, m_z, m_xend;
+        ImageCache::Tile *m_tile;
+        int m_tilexbegin, m_tileybegin, m_tilezbegin, m_tilexend;
+        char *m_data;
+        int m_stride;
+
+        void init_ib () {
+            const ImageSpec &spec (m_ib->spec());
+            DASSERT (! spec.deep);
+            m_localpixels = (m_ib->localpixels() != NULL);
+            m_local_tiles = m_localpixels && m_ib->local_tile_width();
+            m_img_xbegin = spec.x; m_img_xend = spec.x+spec.width;
+            m_img_ybegin = spec.y; m_img_yend = spec.y+spec.height;
+            m_img_zbegin = spec.z; m_img_zend = spec.z+spec.depth;
+            m_nchannels = spec.nchannels;
+            m_pixel_bytes = (int) m_ib->pixel_stride();
+            m_local_stride = spec.format.size()
+                           ? m_pixel_bytes / (int) spec.format.size()
+                           : m_nchannels;
+        }
+
+        // Set m_xend, m_data, and m_stride for the span beginning at (m_x,m_y,m_z).
+        void find_span () {
+            m_data = (char *) m_ib->blackpixel ();
+            m_stride = 0;
+            if (m_y < m_img_ybegin || m_y >= m_img_yend ||
+                m_z < m_img_zbegin || m_z >= m_img_zend ||
+                m_x >= m_img_xend) {
+                m_xend = m_rng_xend;
+                return;
+            }
+            if (m_x < m_img_xbegin) {
+                m_xend = std::min (m_rng_xend, m_img_xbegin);
+                return;
+            }
+            m_xend = std::min (m_rng_xend, m_img_xend);
+            if (m_localpixels) {
+                m_data = (char *) m_ib->pixeladdr (m_x, m_y, m_z);
+                m_stride = m_local_stride;
+                if (m_local_tiles)
+                    m_xend = std::min (m_xend,
+                                       m_ib->local_tile (m_x, m_y, m_z).xend);
+            } else {
+                const void *p = m_ib->retile (m_x, m_y, m_z, m_tile,
+                                              m_tilexbegin, m_tileybegin,
+                                              m_tilezbegin, m_tilexend, true);
+                // A NULL tile means the read failed; the rest of the
+                // row is then treated as black, like Iterator does.
+                if (m_tile && p) {
+                    m_data = (char *) p;
+                    m_stride = m_nchannels;
+                    m_xend = std::min (m_xend, m_tilexend);
+                }
+            }
+        }
+
+        // Make sure it's writeable. Use with caution!
+        void make_writeable () {
+            if (! m_localpixels) {
+                if (m_tile)
+                    m_ib->imagecache()->release_tile (m_tile);
+                m_tile = NULL;
+                const_cast<ImageBuf*>(m_ib)->make_writeable (true);
+                DASSERT (m_ib->storage() != IMAGECACHE);
+                init_ib ();
+                if (! done())
+                    find_span ();
+            }
+        }
+
+    private:
+        // Not copyable -- a span iterator may hold a tile reference.
+        SpanIteratorBase (const SpanIteratorBase &);
+        const SpanIteratorBase & operator= (const SpanIteratorBase &);
+    };
+
+    /// Span-at-a-time iteration over a writeable ImageBuf whose internal
+    /// data type is known to be BUFT.  See SpanIteratorBase.  Spans
+    /// outside the data window (! exists()) have no storage of their own
+    /// and must not be written.
+    template<typename BUFT>
+    class SpanIterator : public SpanIteratorBase {
+    public:
+        SpanIterator (ImageBuf &ib, const ROI &roi = ROI())
+            : SpanIteratorBase (ib, roi)
+        {
+            make_writeable ();
+        }
+        /// Pointer to the first channel of the first pixel of the
+        /// current span.
+        BUFT *data () const { return (BUFT *) m_data; }
+    };
+
+    /// Span-at-a-time iteration over a const ImageBuf whose internal data
+    /// type is known to be BUFT.  See SpanIteratorBase.
+    template<typename BUFT>
+    class ConstSpanIterator : public SpanIteratorBase {
+    public:
+        ConstSpanIterator (const ImageBuf &ib, const ROI &roi = ROI())
+            : SpanIteratorBase (ib, roi) { }
+        /// Pointer to the first channel of the first pixel of the
+        /// current span.
+        const BUFT *data () const { return (const BUFT *) m_data; }
+    };
+
+
 protected:
     ImageBufImpl *m_impl;    //< PIMPL idiom
 
@@ -47,6 +47,7 @@
 #include <OpenEXR/ImathMatrix.h>       /* because we need M33f */
 
 #include <limits>
+#include <memory>
 
 #if !defined(__OPENCV_CORE_TYPES_H__) && !defined(OPENCV_CORE_TYPES_H)
 struct IplImage;  // Forward declaration; used by Intel Image lib & OpenCV
@@ -1140,6 +1141,126 @@ bool OIIO_API color_map (ImageBuf &dst, const ImageBuf &src,
                          ROI roi = ROI::All(), int nthreads = 0);
 
 
+/// A Pipeline records a sequence of "point" operations -- those for which
+/// each output pixel depends only on the same pixel of the input -- so
+/// that they can be run later, all together, by apply().  Running the
+/// operations one at a time would make a full pass over the image for each
+/// one, and allocate a full intermediate ImageBuf for each result. apply()
+/// instead makes a single parallel pass, running every recorded operation
+/// in turn on one small, cache-sized block of pixels before moving on to
+/// the next block.
+///
+/// The recording methods are named for, and compute the same thing as,
+/// the ImageBufAlgo functions described above, with their arguments
+/// referring to the channels of the image as it is at that point in the
+/// pipeline. They return a reference to the Pipeline so that they may be
+/// chained:
+///
+///     ImageBufAlgo::Pipeline p (A.spec());
+///     p.mul (gain).add (offset).clamp (0.0f, 1.0f).channels (3, order);
+///     p.apply (R, A);
+///
+/// All intermediate values are kept as float, so results may differ from
+/// running the individual functions on images of lower precision pixel
+/// types (which would round after every step), but only in the direction
+/// of being more accurate.
+class OIIO_API Pipeline {
+public:
+    /// Begin an empty pipeline whose input images will be described by
+    /// inspec (only its channels and metadata matter).
+    Pipeline (const ImageSpec &inspec = ImageSpec());
+    Pipeline (const Pipeline &p);
+    ~Pipeline ();
+    const Pipeline& operator= (const Pipeline &p);
+
+    /// The number of operations recorded.
+    size_t size () const;
+    bool empty () const { return size() == 0; }
+
+    /// The spec of the input that the pipeline was begun with, and the
+    /// spec that the result will have (which differs only if channels()
+    /// or colorconvert() were recorded).
+    const ImageSpec & inspec () const;
+    const ImageSpec & spec () const;
+
+    /// Add, subtract, multiply, divide (with x/0 giving 0), raise to a
+    /// power, or take the absolute difference from per-channel values
+    /// b[0..spec().nchannels-1], or a single value for all channels.
+    Pipeline& add (const float *b);
+    Pipeline& add (float b);
+    Pipeline& sub (const float *b);
+    Pipeline& sub (float b);
+    Pipeline& mul (const float *b);
+    Pipeline& mul (float b);
+    Pipeline& div (const float *b);
+    Pipeline& div (float b);
+    Pipeline& pow (const float *b);
+    Pipeline& pow (float b);
+    Pipeline& absdiff (const float *b);
+    Pipeline& absdiff (float b);
+    Pipeline& abs ();
+
+    /// Clamp to [min,max] per channel (NULL meaning no limit), and
+    /// optionally the alpha channel to [0,1].
+    Pipeline& clamp (const float *min, const float *max,
+                     bool clampalpha01 = false);
+    Pipeline& clamp (float min = -std::numeric_limits<float>::max(),
+                     float max = std::numeric_limits<float>::max(),
+                     bool clampalpha01 = false);
+
+    Pipeline& premult ();
+    Pipeline& unpremult ();
+
+    /// Shuffle, drop, or add channels, with the same arguments as the
+    /// channels() function.
+    Pipeline& channels (int nchannels, const int *channelorder,
+                        const float *channelvalues = NULL,
+                        const std::string *newchannelnames = NULL,
+                        bool shuffle_channel_names = false);
+
+    /// Color convert the first (up to) 4 channels. The first version
+    /// looks up the transform from the named color spaces (with "current"
+    /// or an empty from meaning the "oiio:ColorSpace" of the image at
+    /// this point), and sets "oiio:ColorSpace" of the result. The second
+    /// version uses a processor owned by the caller, which must stay
+    /// valid until the pipeline is done being applied.  If the transform
+    /// can't be made, the error is reported by has_error()/geterror()
+    /// and by any subsequent apply().
+    Pipeline& colorconvert (string_view from, string_view to,
+                            bool unpremult = false,
+                            string_view context_key = "",
+                            string_view context_value = "",
+                            ColorConfig *colorconfig = NULL);
+    Pipeline& colorconvert (const ColorProcessor *processor,
+                            bool unpremult = false);
+
+    /// Set dst to the result of running all the recorded operations on
+    /// src, within the pixel region of the roi (which defaults to all of
+    /// src). All channels are computed. If dst is not initialized, it
+    /// will be allocated like src but with spec()'s channels and metadata.
+    ///
+    /// Return true on success, false on error (with an appropriate error
+    /// message set in dst).
+    bool apply (ImageBuf &dst, const ImageBuf &src,
+                ROI roi = ROI::All(), int nthreads = 0) const;
+
+    /// Was there an error while recording an operation?  geterror()
+    /// returns (and clears) the message.
+    bool has_error () const;
+    std::string geterror () const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+    Pipeline& colorconvert (std::shared_ptr<const ColorProcessor> processor,
+                            bool unpremult, string_view tospace);
+    static void run_colorconvert (const ColorProcessor *processor,
+                                  bool unpremult, float *pixels, int npixels,
+                                  int nchannels, int stride);
+    void error (const std::string &message);
+};
+
+
 
 
 struct OIIO_API PixelStats {
@@ -1199,6 +1320,25 @@ bool OIIO_API compare (const ImageBuf &A, const ImageBuf &B,
                        CompareResults &result,
                        ROI roi = ROI::All(), int nthreads=0);
 
+/// Quick pass/fail numerical comparison of two images: return true if
+/// no more than maxfailures pixels have any channel (of the roi) that
+/// differs by more than failthresh, treating NaN and Inf the same way
+/// compare() does, and false otherwise.  Unlike compare(), this stops as
+/// soon as the failure budget is exceeded, skips runs of pixels whose
+/// bytes are identical in both images, and checks the rest with a
+/// vectorized threshold test, so it is much cheaper when all that is
+/// needed is whether the images match (a full compare() can follow to
+/// report the details of a mismatch).  Deep images fall back to
+/// compare().
+///
+/// The nthreads parameter specifies how many threads (potentially) may
+/// be used, but it's not a guarantee.  If nthreads == 0, it will use
+/// the global OIIO attribute "nthreads".  If nthreads == 1, it
+/// guarantees that it will not launch any new threads.
+bool OIIO_API compare_pass (const ImageBuf &A, const ImageBuf &B,
+                            float failthresh, imagesize_t maxfailures = 0,
+                            ROI roi = ROI::All(), int nthreads = 0);
+
 /// Compare two images using Hector Yee's perceptual metric, returning
 /// the number of pixels that fail the comparison.  Only the first three
 /// channels (or first three channels specified by roi) are compared.
@@ -1347,6 +1487,23 @@ std::string OIIO_API computePixelHashSHA1 (const ImageBuf &src,
                                            ROI roi = ROI::All(),
                                            int blocksize = 0, int nthreads=0);
 
+/// Compute a hash of all the pixels in the specified region of the image
+/// with the named algorithm, returned as a string of hex digits:
+///   "xxh64" (the default if algorithm is empty): 64 bit xxHash.
+///   "farmhash128": 128 bit farmhash fingerprint.
+///   "sha1": SHA-1, exactly as computePixelHashSHA1().
+/// xxh64 and farmhash128 are many times faster than SHA-1 and are fine
+/// for recognizing duplicate images, but are not cryptographic hashes.
+/// They always hash each 'blocksize' batch of scanlines (256 if blocksize
+/// is 0) of each z slice separately, in parallel, and then hash those
+/// results and the 'extrainfo' text together, so their results depend on
+/// blocksize.  An unknown algorithm name is an error (returning "").
+std::string OIIO_API computePixelHash (const ImageBuf &src,
+                                       string_view algorithm = "",
+                                       string_view extrainfo = "",
+                                       ROI roi = ROI::All(),
+                                       int blocksize = 0, int nthreads=0);
+
 
 /// Warp the src image using the supplied 3x3 transformation matrix.
 ///
@@ -1511,6 +1668,11 @@ bool OIIO_API resample (ImageBuf &dst, const ImageBuf &src,
 /// normalized is true, the kernel will be normalized for the 
 /// convolution, otherwise the original values will be used.
 ///
+/// Separable kernels (such as those made by make_kernel from box,
+/// gaussian, or binomial filters) are automatically applied as two 1D
+/// passes, and large 2D kernels via the FFT, whenever that is estimated
+/// to be cheaper than summing over the whole kernel at every pixel.
+///
 /// The nthreads parameter specifies how many threads (potentially) may
 /// be used, but it's not a guarantee.  If nthreads == 0, it will use
 /// the global OIIO attribute "nthreads".  If nthreads == 1, it
@@ -1607,6 +1769,10 @@ bool OIIO_API laplacian (ImageBuf &dst, const ImageBuf &src,
 /// the window size (including noise), without blurring edges that are
 /// larger than the window size.
 ///
+/// For 8 and 16 bit source images, the median is found with sliding
+/// histograms, so the cost per pixel grows little (or not at all) with
+/// the window size.
+///
 /// If roi is not defined, it defaults to the full size of dst (or src,
 /// if dst was undefined).  If dst is uninitialized, it will be
 /// allocated to be the size specified by roi.
@@ -1629,6 +1795,8 @@ bool OIIO_API median_filter (ImageBuf &dst, const ImageBuf &src,
 /// (which is taken to be a width x height square). If height is not
 /// set, it will default to be the same as width.
 ///
+/// The cost per pixel does not depend on the window size.
+///
 /// If roi is not defined, it defaults to the full size of dst (or src,
 /// if dst was undefined).  If dst is uninitialized, it will be
 /// allocated to be the size specified by roi.
@@ -1651,6 +1819,8 @@ bool OIIO_API dilate (ImageBuf &dst, const ImageBuf &src,
 /// (which is taken to be a width x height square). If height is not
 /// set, it will default to be the same as width.
 ///
+/// The cost per pixel does not depend on the window size.
+///
 /// If roi is not defined, it defaults to the full size of dst (or src,
 /// if dst was undefined).  If dst is uninitialized, it will be
 /// allocated to be the size specified by roi.
@@ -2146,11 +2316,34 @@ enum OIIO_API MakeTextureMode {
 ///                               the sake of ImageBuf math. (1)
 ///    maketx:hash (int)
 ///                           Compute the sha1 hash of the file in parallel. (1)
+///    maketx:hash_algorithm (string)
+///                           Which pixel hash to compute: "sha1" (stored
+///                               as "oiio:SHA-1"), or the faster "xxh64" or
+///                               "farmhash128" (stored, prefixed by the
+///                               algorithm name, as "oiio:PixelHash").
+///                               ("sha1")
 ///    maketx:allow_pixel_shift (int)
 ///                           Allow up to a half pixel shift per mipmap level.
 ///                               The fastest path may result in a slight shift
 ///                               in the image, accumulated for each mip level
 ///                               with an odd resolution. (0)
+///    maketx:stream (int)
+///                           If nonzero, and the texture needs no resizing,
+///                               color conversion, channel changes, or
+///                               filter other than box, stream it out a
+///                               band of scanlines at a time, so memory use
+///                               doesn't grow with the image size. (0)
+///    maketx:pipeline (int)
+///                           If nonzero, write each MIP level in the
+///                               background while the next one is being
+///                               computed. (1)
+///    maketx:dedup_index (string)
+///                           If not empty, the persistent index of texture
+///                               content shared with the ImageCache: if it
+///                               names an existing texture made from
+///                               identical pixels with identical settings,
+///                               copy that instead of computing the MIP
+///                               levels; and record the new texture. ("")
 ///
 bool OIIO_API make_texture (MakeTextureMode mode,
                             const ImageBuf &input,
@@ -98,6 +98,8 @@ public:
     ///     int forcefloat : if nonzero, convert all to float.
     ///     int failure_retries : number of times to retry a read before fail.
     ///     int deduplicate : if nonzero, detect duplicate textures (default=1)
+    ///     string dedup_index : persistent dedup index file shared with
+    ///                          maketx (default: none)
     ///     string substitute_image : uses the named image in place of all
     ///                               texture and image references.
     ///     int unassociatedalpha : if nonzero, keep unassociated alpha images
@@ -1284,6 +1284,20 @@ OIIO_API std::string geterror ();
 ///             When nonzero, allows TIFF to write 'half' pixel data.
 ///             N.B. Most apps may not read these correctly, but OIIO will.
 ///             That's why the default is not to support it.
+///     string simd_level
+///             Which of the compiled-in SIMD levels the hot kernels (pixel
+///             type conversion, over) use: "sse2", "sse4", "avx", "avx2",
+///             "avx512".  The default, "" or "auto", picks the best one
+///             the hardware supports.  A level that isn't available
+///             falls back to the best one below it.  Mainly for testing;
+///             every level gives the same results.
+///     int colorconvert:bake
+///             Whether colorconvert may replace the color processor with
+///             a table baked from it, for 8 and 16 bit sources:
+///             0 = never; 1 (the default) = exact 1D tables, for
+///             processors without channel crosstalk; 2 = also
+///             approximate 3D tables (33 or 65 nodes per axis,
+///             tetrahedrally interpolated) for processors with crosstalk.
 ///
 OIIO_API bool attribute (string_view name, TypeDesc type, const void *val);
 // Shortcuts for common types
@@ -1336,6 +1350,13 @@ inline bool attribute (string_view name, string_view val) {
 ///             Comma-separated list of the SIMD-related capabilities
 ///             detected at runtime at the time of the query (which may not
 ///             match the support compiled into the library).
+///     string "simd_levels"
+///             Comma-separated list of the SIMD levels that the hot
+///             kernels were compiled for and this hardware can run.  The
+///             one in use can be retrieved as "simd_level".
+///     string "simd_kernels"
+///             Comma-separated list of "kernel:level" telling which
+///             variant of each runtime-dispatched kernel is in use.
 OIIO_API bool getattribute (string_view name, TypeDesc type, void *val);
 // Shortcuts for common types
 inline bool getattribute (string_view name, int &val) {
@@ -332,6 +332,8 @@ public:
     ///     int accept_unmipped : if nonzero, accept unmipped images
     ///     int failure_retries : how many times to retry a read failure
     ///     int deduplicate : if nonzero, detect duplicate textures (default=1)
+    ///     string dedup_index : persistent dedup index file shared with
+    ///                          maketx (default: none)
     ///     int gray_to_rgb : make 1-channel images fill RGB lookups
     ///     int max_tile_channels : max channels to store all chans in a tile
     ///     string latlong_up : default "up" direction for latlong ("y")
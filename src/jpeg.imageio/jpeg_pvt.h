@@ -103,6 +103,7 @@ class JpgInput : public ImageInput {
     bool m_raw;               // Read raw coefficients, not scanlines
     bool m_cmyk;              // The input file is cmyk
     bool m_fatalerr;          // JPEG reader hit a fatal error
+    int m_scale;              // Decode at 1/m_scale resolution (1,2,4,8)
     struct jpeg_decompress_struct m_cinfo;
     my_error_mgr m_jerr;
     jvirt_barray_ptr *m_coeffs;
@@ -113,6 +114,7 @@ class JpgInput : public ImageInput {
         m_raw = false;
         m_cmyk = false;
         m_fatalerr = false;
+        m_scale = 1;
         m_coeffs = NULL;
         m_jerr.jpginput = this;
     }
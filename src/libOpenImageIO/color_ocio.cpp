@@ -29,6 +29,7 @@
 */
 
 #include <cmath>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -39,6 +40,10 @@
 #include <OpenImageIO/color.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
+#include <OpenImageIO/thread.h>
+
+#include "imageio_pvt.h"
 
 #ifdef USE_OCIO
 #include <OpenColorIO/OpenColorIO.h>
@@ -72,12 +77,25 @@ public:
     std::vector<std::pair<std::string,int> > colorspaces;
     std::string linear_alias;  // Alias for a scene-linear color space
 
+    // Processors already created from this config, keyed by a string
+    // that identifies the transform.  Handing out wrappers around these
+    // saves rebuilding the OCIO processor (and re-baking any lookup
+    // tables) for every image in a sequence.
+    mutable std::map<std::string, std::shared_ptr<ColorProcessor> > processor_cache;
+    mutable OIIO::mutex processor_cache_mutex;
+
     Impl() { }
     ~Impl() { }
     void inventory ();
     void add (const std::string &name, int index) {
         colorspaces.emplace_back(name, index);
     }
+    // Return a new handle to the cached processor for key, or NULL.
+    ColorProcessor *find_processor (const std::string &key) const;
+    // Add the newly created p (which may be NULL) to the cache under key,
+    // and return a handle to it.
+    ColorProcessor *cache_processor (const std::string &key,
+                                     ColorProcessor *p) const;
 };
 
 
@@ -350,6 +368,20 @@ ColorConfig::getDefaultViewName(string_view display) const
 
 
 
+// A lookup table baked from a ColorProcessor, which stands in for it on
+// 8 or 16 bit unsigned integer pixels (see ColorProcessor::lut()).  A 1D
+// table has an RGBA entry for every possible input value, so it is exact
+// for processors without channel crosstalk.  A 3D table is a lattice of
+// RGB results (padded to 4 floats) that is interpolated tetrahedrally.
+struct ColorLUT {
+    int bits = 8;                // input is 8 or 16 bit
+    int size = 0;                // 1D: entries; 3D: nodes per axis
+    bool is3d = false;
+    std::vector<float> table;    // 4 floats per entry or node
+};
+
+
+
 // Abstract wrapper class for objects that will apply color transformations.
 class ColorProcessor
 {
@@ -361,6 +393,133 @@ public:
     virtual void apply (float *data, int width, int height, int channels,
                         stride_t chanstride, stride_t xstride,
                         stride_t ystride) const = 0;
+
+    // Return the lookup table that may stand in for apply() on 'bits'
+    // (8 or 16) bit unsigned input at the given "colorconvert:bake"
+    // level, or NULL if there is none.  A table that doesn't exist yet is
+    // only baked if that costs less than applying the processor to the
+    // npixels of the image.  Tables are baked once and then shared by all
+    // handles to the same cached processor.
+    virtual std::shared_ptr<const ColorLUT> lut (int bits, int bake,
+                                                 imagesize_t npixels) const;
+
+private:
+    std::shared_ptr<const ColorLUT> bake_lut1d (int bits) const;
+    std::shared_ptr<const ColorLUT> bake_lut3d (int bits) const;
+
+    mutable OIIO::mutex m_lut_mutex;
+    mutable std::shared_ptr<const ColorLUT> m_lut[2];  // 8 bit, 16 bit
+    mutable bool m_lut_failed[2] = { false, false };
+};
+
+
+
+std::shared_ptr<const ColorLUT>
+ColorProcessor::lut (int bits, int bake, imagesize_t npixels) const
+{
+    bool crosstalk = hasChannelCrosstalk();
+    if ((bits != 8 && bits != 16) || bake < (crosstalk ? 2 : 1))
+        return nullptr;
+    int slot = (bits == 16);
+    lock_guard lock (m_lut_mutex);
+    if (! m_lut[slot] && ! m_lut_failed[slot]) {
+        imagesize_t cost = crosstalk ? 2 * (bits == 8 ? 33*33*33 : 65*65*65)
+                                     : (imagesize_t(1) << bits);
+        if (npixels < cost)
+            return nullptr;
+        m_lut[slot] = crosstalk ? bake_lut3d (bits) : bake_lut1d (bits);
+        m_lut_failed[slot] = ! m_lut[slot];
+    }
+    return m_lut[slot];
+}
+
+
+
+std::shared_ptr<const ColorLUT>
+ColorProcessor::bake_lut1d (int bits) const
+{
+    std::shared_ptr<ColorLUT> lut (new ColorLUT);
+    lut->bits = bits;
+    lut->size = 1 << bits;
+    lut->table.resize (lut->size * 4);
+    // Same int->float conversion that colorconvert's iterators do
+    for (int i = 0;  i < lut->size;  ++i) {
+        float v = bits == 8 ? convert_type<unsigned char,float>((unsigned char)i)
+                            : convert_type<unsigned short,float>((unsigned short)i);
+        for (int c = 0;  c < 4;  ++c)
+            lut->table[4*i+c] = v;
+    }
+    apply (&lut->table[0], lut->size, 1, 4, sizeof(float), 4*sizeof(float),
+           lut->size*4*sizeof(float));
+    return lut;
+}
+
+
+
+std::shared_ptr<const ColorLUT>
+ColorProcessor::bake_lut3d (int bits) const
+{
+    const int n = (bits == 8) ? 33 : 65;
+    const size_t nodes = size_t(n) * n * n;
+    std::shared_ptr<ColorLUT> lut (new ColorLUT);
+    lut->bits = bits;
+    lut->size = n;
+    lut->is3d = true;
+    // Bake the lattice twice, with alpha 1 and alpha 0.  RGB may only be
+    // tabulated if it doesn't depend on alpha, and alpha must pass
+    // through unchanged, since the table doesn't carry it.
+    std::vector<float> pass[2];
+    for (int p = 0;  p < 2;  ++p) {
+        pass[p].resize (nodes * 4);
+        float *t = &pass[p][0];
+        for (int b = 0;  b < n;  ++b)
+            for (int g = 0;  g < n;  ++g)
+                for (int r = 0;  r < n;  ++r, t += 4) {
+                    t[0] = float(r) / (n-1);
+                    t[1] = float(g) / (n-1);
+                    t[2] = float(b) / (n-1);
+                    t[3] = 1.0f - p;
+                }
+        apply (&pass[p][0], n, n*n, 4, sizeof(float), 4*sizeof(float),
+               n*4*sizeof(float));
+    }
+    for (size_t i = 0;  i < nodes;  ++i) {
+        const float *t0 = &pass[0][4*i], *t1 = &pass[1][4*i];
+        if (t0[0] != t1[0] || t0[1] != t1[1] || t0[2] != t1[2] ||
+            t0[3] != 1.0f || t1[3] != 0.0f)
+            return nullptr;
+    }
+    lut->table.swap (pass[0]);
+    return lut;
+}
+
+
+
+// Handle to a ColorProcessor shared through the ColorConfig's cache.
+// It forwards everything, so the processor and its baked tables are
+// built once no matter how many times the transform is requested.
+class ColorProcessor_Cached : public ColorProcessor
+{
+public:
+    ColorProcessor_Cached (std::shared_ptr<const ColorProcessor> p)
+        : m_p(p) { }
+    virtual bool isNoOp() const { return m_p->isNoOp(); }
+    virtual bool hasChannelCrosstalk() const {
+        return m_p->hasChannelCrosstalk();
+    }
+    virtual void apply (float *data, int width, int height, int channels,
+                        stride_t chanstride, stride_t xstride,
+                        stride_t ystride) const
+    {
+        m_p->apply (data, width, height, channels, chanstride, xstride,
+                    ystride);
+    }
+    virtual std::shared_ptr<const ColorLUT> lut (int bits, int bake,
+                                                 imagesize_t npixels) const {
+        return m_p->lut (bits, bake, npixels);
+    }
+private:
+    std::shared_ptr<const ColorProcessor> m_p;
 };
 
 
@@ -393,6 +552,83 @@ private:
 
 
 
+// Apply the per-value transfer function f (a functor taking vfloat4 or
+// vfloat8) to the color channels -- the first three -- of every pixel,
+// leaving alpha and any other channels alone.
+template<class F>
+static void
+apply_to_color (const F &f, float *data, int width, int height,
+                int channels, stride_t chanstride, stride_t xstride,
+                stride_t ystride)
+{
+    using namespace simd;
+    const int ncolor = std::min (channels, 3);
+    if (channels >= 1 && channels <= 4 && chanstride == sizeof(float) &&
+        xstride == channels * stride_t(sizeof(float))) {
+        // Contiguous 1-4 channel rows: treat each row as one float array
+        // and process 8 values (8 Y, 4 YA, 2 RGBA, or 2 2/3 RGB pixels)
+        // at a time.  Which lanes hold color repeats every 8 values, except
+        // for RGB, where they all do.
+        vbool8 color ((0 % channels) < 3, (1 % channels) < 3,
+                      (2 % channels) < 3, (3 % channels) < 3,
+                      (4 % channels) < 3, (5 % channels) < 3,
+                      (6 % channels) < 3, (7 % channels) < 3);
+        const int n = width * channels;
+        for (int y = 0;  y < height;  ++y) {
+            float *d = (float *)((char *)data + y*ystride);
+            int i = 0;
+            for ( ; i <= n-8;  i += 8) {
+                vfloat8 v (d+i);
+                select (color, f(v), v).store (d+i);
+            }
+            if (i < n) {
+                vfloat8 v;
+                v.load (d+i, n-i);
+                select (color, f(v), v).store (d+i, n-i);
+            }
+        }
+    } else {
+        // Anything else: one pixel at a time, gathering its color
+        // channels into a vfloat4.
+        for (int y = 0;  y < height;  ++y) {
+            char *d = (char *)data + y*ystride;
+            for (int x = 0;  x < width;  ++x, d += xstride) {
+                vfloat4 v (0.0f);
+                for (int c = 0;  c < ncolor;  ++c)
+                    v[c] = *(float *)(d + c*chanstride);
+                v = f(v);
+                for (int c = 0;  c < ncolor;  ++c)
+                    *(float *)(d + c*chanstride) = v[c];
+            }
+        }
+    }
+}
+
+
+
+// Functors for apply_to_color
+struct sRGB_to_linear_op {
+    template<class T> T operator() (const T &x) const { return sRGB_to_linear (x); }
+};
+struct linear_to_sRGB_op {
+    template<class T> T operator() (const T &x) const { return linear_to_sRGB (x); }
+};
+struct Rec709_to_linear_op {
+    template<class T> T operator() (const T &x) const { return Rec709_to_linear (x); }
+};
+struct linear_to_Rec709_op {
+    template<class T> T operator() (const T &x) const { return linear_to_Rec709 (x); }
+};
+struct gamma_op {
+    gamma_op (float g) : gamma(g) { }
+    template<class T> T operator() (const T &x) const {
+        return fast_pow_pos (x, T(gamma));
+    }
+    float gamma;
+};
+
+
+
 // ColorProcessor that hard-codes sRGB-to-linear
 class ColorProcessor_sRGB_to_linear : public ColorProcessor {
 public:
@@ -403,26 +639,8 @@ public:
                         stride_t chanstride, stride_t xstride,
                         stride_t ystride) const
     {
-        if (channels > 3)
-            channels = 3;
-        if (channels == 3) {
-            for (int y = 0;  y < height;  ++y) {
-                char *d = (char *)data + y*ystride;
-                for (int x = 0;  x < width;  ++x, d += xstride) {
-                    simd::vfloat4 r;
-                    r.load ((float *)d, 3);
-                    r = sRGB_to_linear (simd::vfloat4((float *)d));
-                    r.store ((float *)d, 3);
-                }
-            }
-        } else {
-            for (int y = 0;  y < height;  ++y) {
-                char *d = (char *)data + y*ystride;
-                for (int x = 0;  x < width;  ++x, d += xstride)
-                    for (int c = 0;  c < channels;  ++c)
-                        ((float *)d)[c] = sRGB_to_linear (((float *)d)[c]);
-            }
-        }
+        apply_to_color (sRGB_to_linear_op(), data, width, height, channels,
+                        chanstride, xstride, ystride);
     }
 };
 
@@ -437,26 +655,8 @@ public:
                         stride_t chanstride, stride_t xstride,
                         stride_t ystride) const
     {
-        if (channels > 3)
-            channels = 3;
-        if (channels == 3) {
-            for (int y = 0;  y < height;  ++y) {
-                char *d = (char *)data + y*ystride;
-                for (int x = 0;  x < width;  ++x, d += xstride) {
-                    simd::vfloat4 r;
-                    r.load ((float *)d, 3);
-                    r = linear_to_sRGB (simd::vfloat4((float *)d));
-                    r.store ((float *)d, 3);
-                }
-            }
-        } else {
-            for (int y = 0;  y < height;  ++y) {
-                char *d = (char *)data + y*ystride;
-                for (int x = 0;  x < width;  ++x, d += xstride)
-                    for (int c = 0;  c < channels;  ++c)
-                        ((float *)d)[c] = linear_to_sRGB (((float *)d)[c]);
-            }
-        }
+        apply_to_color (linear_to_sRGB_op(), data, width, height, channels,
+                        chanstride, xstride, ystride);
     }
 };
 
@@ -472,14 +672,8 @@ public:
                         stride_t chanstride, stride_t xstride,
                         stride_t ystride) const
     {
-        if (channels > 3)
-            channels = 3;
-        for (int y = 0;  y < height;  ++y) {
-            char *d = (char *)data + y*ystride;
-            for (int x = 0;  x < width;  ++x, d += xstride)
-                for (int c = 0;  c < channels;  ++c)
-                    ((float *)d)[c] = Rec709_to_linear (((float *)d)[c]);
-        }
+        apply_to_color (Rec709_to_linear_op(), data, width, height, channels,
+                        chanstride, xstride, ystride);
     }
 };
 
@@ -494,14 +688,8 @@ public:
                         stride_t chanstride, stride_t xstride,
                         stride_t ystride) const
     {
-        if (channels > 3)
-            channels = 3;
-        for (int y = 0;  y < height;  ++y) {
-            char *d = (char *)data + y*ystride;
-            for (int x = 0;  x < width;  ++x, d += xstride)
-                for (int c = 0;  c < channels;  ++c)
-                    ((float *)d)[c] = linear_to_Rec709 (((float *)d)[c]);
-        }
+        apply_to_color (linear_to_Rec709_op(), data, width, height, channels,
+                        chanstride, xstride, ystride);
     }
 };
 
@@ -519,27 +707,8 @@ public:
                         stride_t chanstride, stride_t xstride,
                         stride_t ystride) const
     {
-        if (channels > 3)
-            channels = 3;
-        if (channels == 3) {
-            simd::vfloat4 g = m_gamma;
-            for (int y = 0;  y < height;  ++y) {
-                char *d = (char *)data + y*ystride;
-                for (int x = 0;  x < width;  ++x, d += xstride) {
-                    simd::vfloat4 r;
-                    r.load ((float *)d, 3);
-                    r = fast_pow_pos (simd::vfloat4((float *)d), g);
-                    r.store ((float *)d, 3);
-                }
-            }
-        } else {
-            for (int y = 0;  y < height;  ++y) {
-                char *d = (char *)data + y*ystride;
-                for (int x = 0;  x < width;  ++x, d += xstride)
-                    for (int c = 0;  c < channels;  ++c)
-                        ((float *)d)[c] = powf (((float *)d)[c], m_gamma);
-            }
-        }
+        apply_to_color (gamma_op(m_gamma), data, width, height, channels,
+                        chanstride, xstride, ystride);
     }
 private:
     float m_gamma;
@@ -560,6 +729,39 @@ public:
 
 
 
+ColorProcessor *
+ColorConfig::Impl::find_processor (const std::string &key) const
+{
+    lock_guard lock (processor_cache_mutex);
+    auto found = processor_cache.find (key);
+    if (found == processor_cache.end())
+        return NULL;
+    // A hit succeeds just as creating the processor did the first time,
+    // so it must not leave an earlier failure visible to geterror().
+    error_.clear ();
+    return new ColorProcessor_Cached (found->second);
+}
+
+
+
+ColorProcessor *
+ColorConfig::Impl::cache_processor (const std::string &key,
+                                    ColorProcessor *p) const
+{
+    if (! p)
+        return NULL;
+    std::shared_ptr<ColorProcessor> shared (p);
+    lock_guard lock (processor_cache_mutex);
+    // Contexts that vary per shot or frame could make the cache grow
+    // without bound, so just start over if it gets large.
+    if (processor_cache.size() >= 256)
+        processor_cache.clear ();
+    processor_cache[key] = shared;
+    return new ColorProcessor_Cached (shared);
+}
+
+
+
 ColorProcessor*
 ColorConfig::createColorProcessor (string_view inputColorSpace,
                                    string_view outputColorSpace) const
@@ -577,6 +779,11 @@ ColorConfig::createColorProcessor (string_view inputColorSpace,
 {
     string_view inputrole, outputrole;
     std::string pending_error;
+    std::string key = Strutil::format ("colorspace\n%s\n%s\n%s\n%s",
+                                       inputColorSpace, outputColorSpace,
+                                       context_key, context_value);
+    if (ColorProcessor *cached = getImpl()->find_processor (key))
+        return cached;
 #ifdef USE_OCIO
     // Ask OCIO to make a Processor that can handle the requested
     // transformation.
@@ -628,7 +835,7 @@ ColorConfig::createColorProcessor (string_view inputColorSpace,
             // If we got a valid processor that does something useful,
             // return it now. If it boils down to a no-op, give a second
             // chance below to recognize it as a special case.
-            return new ColorProcessor_OCIO(p);
+            return getImpl()->cache_processor (key, new ColorProcessor_OCIO(p));
         }
     }
 #endif
@@ -638,27 +845,31 @@ ColorConfig::createColorProcessor (string_view inputColorSpace,
     // about even in such dire conditions.
     using namespace Strutil;
     if (iequals(inputColorSpace,outputColorSpace)) {
-        return new ColorProcessor_Ident;
+        return getImpl()->cache_processor (key, new ColorProcessor_Ident);
     }
     if ((iequals(inputColorSpace,"linear") || iequals(inputrole,"linear") ||
          iequals(inputColorSpace,"lnf") || iequals(inputColorSpace,"lnh"))
         && iequals(outputColorSpace,"sRGB")) {
-        return new ColorProcessor_linear_to_sRGB;
+        return getImpl()->cache_processor (key,
+                    new ColorProcessor_linear_to_sRGB);
     }
     if (iequals(inputColorSpace,"sRGB") &&
         (iequals(outputColorSpace,"linear") || iequals(outputrole,"linear") ||
          iequals(outputColorSpace,"lnf") || iequals(outputColorSpace,"lnh"))) {
-        return new ColorProcessor_sRGB_to_linear;
+        return getImpl()->cache_processor (key,
+                    new ColorProcessor_sRGB_to_linear);
     }
     if ((iequals(inputColorSpace,"linear") || iequals(inputrole,"linear") ||
          iequals(inputColorSpace,"lnf") || iequals(inputColorSpace,"lnh")) &&
         iequals(outputColorSpace,"Rec709")) {
-        return new ColorProcessor_linear_to_Rec709;
+        return getImpl()->cache_processor (key,
+                    new ColorProcessor_linear_to_Rec709);
     }
     if (iequals(inputColorSpace,"Rec709") &&
         (iequals(outputColorSpace,"linear") || iequals(outputrole,"linear") ||
          iequals(outputColorSpace,"lnf") || iequals(outputColorSpace,"lnh"))) {
-        return new ColorProcessor_Rec709_to_linear;
+        return getImpl()->cache_processor (key,
+                    new ColorProcessor_Rec709_to_linear);
     }
     if ((iequals(inputColorSpace,"linear") || iequals(inputrole,"linear") ||
          iequals(inputColorSpace,"lnf") || iequals(inputColorSpace,"lnh")) &&
@@ -666,7 +877,8 @@ ColorConfig::createColorProcessor (string_view inputColorSpace,
         string_view gamstr = outputColorSpace;
         Strutil::parse_prefix (gamstr, "GammaCorrected");
         float g = from_string<float>(gamstr);
-        return new ColorProcessor_gamma(1.0f/g);
+        return getImpl()->cache_processor (key,
+                    new ColorProcessor_gamma(1.0f/g));
     }
     if (istarts_with(inputColorSpace,"GammaCorrected") &&
         (iequals(outputColorSpace,"linear") || iequals(outputrole,"linear") ||
@@ -674,14 +886,14 @@ ColorConfig::createColorProcessor (string_view inputColorSpace,
         string_view gamstr = inputColorSpace;
         Strutil::parse_prefix (gamstr, "GammaCorrected");
         float g = from_string<float>(gamstr);
-        return new ColorProcessor_gamma(g);
+        return getImpl()->cache_processor (key, new ColorProcessor_gamma(g));
     }
 
 #ifdef USE_OCIO
     if (p) {
         // If we found a procesor from OCIO, even if it was a NoOp, and we
         // still don't have a better idea, return it.
-        return new ColorProcessor_OCIO(p);
+        return getImpl()->cache_processor (key, new ColorProcessor_OCIO(p));
     }
 #endif
 
@@ -700,6 +912,12 @@ ColorConfig::createLookTransform (string_view looks,
                                   string_view context_key,
                                   string_view context_value) const
 {
+    std::string key = Strutil::format ("look\n%s\n%s\n%s\n%d\n%s\n%s",
+                                       looks, inputColorSpace,
+                                       outputColorSpace, int(inverse),
+                                       context_key, context_value);
+    if (ColorProcessor *cached = getImpl()->find_processor (key))
+        return cached;
 #ifdef USE_OCIO
     // Ask OCIO to make a Processor that can handle the requested
     // transformation.
@@ -748,7 +966,7 @@ ColorConfig::createLookTransform (string_view looks,
         }
     
         getImpl()->error_ = "";
-        return new ColorProcessor_OCIO(p);
+        return getImpl()->cache_processor (key, new ColorProcessor_OCIO(p));
     }
 #endif
 
@@ -765,6 +983,11 @@ ColorConfig::createDisplayTransform (string_view display,
                                      string_view context_key,
                                      string_view context_value) const
 {
+    std::string key = Strutil::format ("display\n%s\n%s\n%s\n%s\n%s\n%s",
+                                       display, view, inputColorSpace, looks,
+                                       context_key, context_value);
+    if (ColorProcessor *cached = getImpl()->find_processor (key))
+        return cached;
 #ifdef USE_OCIO
     // Ask OCIO to make a Processor that can handle the requested
     // transformation.
@@ -807,7 +1030,7 @@ ColorConfig::createDisplayTransform (string_view display,
         }
     
         getImpl()->error_ = "";
-        return new ColorProcessor_OCIO(p);
+        return getImpl()->cache_processor (key, new ColorProcessor_OCIO(p));
     }
 #endif
 
@@ -819,6 +1042,9 @@ ColorConfig::createDisplayTransform (string_view display,
 ColorProcessor*
 ColorConfig::createFileTransform (string_view name, bool inverse) const
 {
+    std::string key = Strutil::format ("file\n%s\n%d", name, int(inverse));
+    if (ColorProcessor *cached = getImpl()->find_processor (key))
+        return cached;
 #ifdef USE_OCIO
     // Ask OCIO to make a Processor that can handle the requested
     // transformation.
@@ -845,7 +1071,7 @@ ColorConfig::createFileTransform (string_view name, bool inverse) const
         }
     
         getImpl()->error_ = "";
-        return new ColorProcessor_OCIO(p);
+        return getImpl()->cache_processor (key, new ColorProcessor_OCIO(p));
     }
 #endif
 
@@ -942,6 +1168,69 @@ ImageBufAlgo::colorconvert (ImageBuf &dst, const ImageBuf &src,
 
 
 
+// Apply a baked ColorLUT in place of the processor, reading the integer
+// source values directly so that a 1D table is indexed exactly.
+template<class Rtype, class Atype>
+static void
+colorconvert_lut (ImageBuf &R, const ImageBuf &A, const ColorLUT &lut,
+                  ROI roi, int nchannels)
+{
+    const float *table = &lut.table[0];
+    ImageBuf::ConstIterator<Atype,Atype> a (A, roi);
+    ImageBuf::Iterator<Rtype> r (R, roi);
+    if (! lut.is3d) {
+        for ( ; !r.done(); ++r, ++a)
+            for (int c = 0; c < nchannels; ++c)
+                r[c] = table[4*int(a[c])+c];
+        return;
+    }
+    // Tetrahedral interpolation in the RGB lattice
+    const int n = lut.size;
+    const float scale = float(n-1) / ((1 << lut.bits) - 1);
+    const int rgbchans = std::min (nchannels, 3);
+    for ( ; !r.done(); ++r, ++a) {
+        float f[3] = { 0.0f, 0.0f, 0.0f };
+        int i[3] = { 0, 0, 0 };
+        for (int c = 0; c < rgbchans; ++c) {
+            float x = float(a[c]) * scale;
+            i[c] = std::min (int(x), n-2);
+            f[c] = x - float(i[c]);
+        }
+        const int dr = 4, dg = 4*n, db = 4*n*n;
+        const float *p000 = table + i[0]*dr + i[1]*dg + i[2]*db;
+        simd::vfloat4 c000 (p000), c111 (p000+dr+dg+db);
+        // Pick the tetrahedron containing the sample by the ordering of
+        // the fractional coordinates, and walk its edges.
+        int d1, d2;
+        float t1, t2, t3;
+        if (f[0] >= f[1]) {
+            if (f[1] >= f[2]) {        // r >= g >= b
+                d1 = dr;  d2 = dr+dg;  t1 = f[0];  t2 = f[1];  t3 = f[2];
+            } else if (f[0] >= f[2]) { // r >= b > g
+                d1 = dr;  d2 = dr+db;  t1 = f[0];  t2 = f[2];  t3 = f[1];
+            } else {                   // b > r >= g
+                d1 = db;  d2 = dr+db;  t1 = f[2];  t2 = f[0];  t3 = f[1];
+            }
+        } else {
+            if (f[2] > f[1]) {         // b > g > r
+                d1 = db;  d2 = dg+db;  t1 = f[2];  t2 = f[1];  t3 = f[0];
+            } else if (f[2] > f[0]) {  // g >= b > r
+                d1 = dg;  d2 = dg+db;  t1 = f[1];  t2 = f[2];  t3 = f[0];
+            } else {                   // g > r >= b
+                d1 = dg;  d2 = dr+dg;  t1 = f[1];  t2 = f[0];  t3 = f[2];
+            }
+        }
+        simd::vfloat4 c1 (p000+d1), c2 (p000+d2);
+        simd::vfloat4 result = c000 + (c1 - c000) * t1 + (c2 - c1) * t2 + (c111 - c2) * t3;
+        for (int c = 0; c < rgbchans; ++c)
+            r[c] = result[c];
+        if (nchannels >= 4)
+            r[3] = convert_type<Atype,float>(a[3]);
+    }
+}
+
+
+
 template<class Rtype, class Atype>
 static bool
 colorconvert_impl (ImageBuf &R, const ImageBuf &A,
@@ -949,6 +1238,21 @@ colorconvert_impl (ImageBuf &R, const ImageBuf &A,
                    ROI roi, int nthreads)
 {
     using namespace ImageBufAlgo;
+    // 8 and 16 bit sources may be able to use a table baked from the
+    // processor instead of running it on every pixel.
+    const int bits = std::is_same<Atype,unsigned char>::value ? 8
+                   : std::is_same<Atype,unsigned short>::value ? 16 : 0;
+    const int nchannels = std::min (4, roi.nchannels());
+    if (bits && ! (unpremult && nchannels >= 4)) {
+        std::shared_ptr<const ColorLUT> lut =
+            processor->lut (bits, pvt::colorconvert_bake, roi.npixels());
+        if (lut) {
+            parallel_image (roi, parallel_image_options(nthreads), [&](ROI roi){
+                colorconvert_lut<Rtype,Atype> (R, A, *lut, roi, nchannels);
+            });
+            return true;
+        }
+    }
     parallel_image (roi, parallel_image_options(nthreads), [&](ROI roi){
         int width = roi.width();
         // Temporary space to hold one RGBA scanline
@@ -1071,6 +1375,114 @@ ImageBufAlgo::colorconvert (ImageBuf &dst, const ImageBuf &src,
 
 
 
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::colorconvert (string_view from, string_view to,
+                                      bool unpremult, string_view context_key,
+                                      string_view context_value,
+                                      ColorConfig *colorconfig)
+{
+    if (from.empty() || from == "current") {
+        from = spec().get_string_attribute ("oiio:Colorspace", "Linear");
+    }
+    if (from.empty() || to.empty()) {
+        error ("Unknown color space name");
+        return *this;
+    }
+    ColorProcessor *processor = NULL;
+    {
+        spin_lock lock (colorconfig_mutex);
+        if (! colorconfig)
+            colorconfig = default_colorconfig.get();
+        if (! colorconfig)
+            default_colorconfig.reset (colorconfig = new ColorConfig);
+        processor = colorconfig->createColorProcessor (from, to,
+                                                context_key, context_value);
+        if (! processor) {
+            if (colorconfig->error())
+                error (colorconfig->geterror());
+            else
+                error (Strutil::format ("Could not construct the color transform %s -> %s",
+                                        from, to));
+            return *this;
+        }
+    }
+    // The pipeline may outlive this call, so it shares ownership of the
+    // processor, which is deleted along with the last copy of the pipeline.
+    std::shared_ptr<const ColorProcessor> shared;
+    if (! processor->isNoOp())
+        shared.reset (processor, [](const ColorProcessor *p) {
+            spin_lock lock (colorconfig_mutex);
+            ColorConfig::deleteColorProcessor ((ColorProcessor *)p);
+        });
+    else {
+        spin_lock lock (colorconfig_mutex);
+        ColorConfig::deleteColorProcessor (processor);
+    }
+    return colorconvert (shared, unpremult, to);
+}
+
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::colorconvert (const ColorProcessor *processor,
+                                      bool unpremult)
+{
+    if (! processor) {
+        error ("Passed NULL ColorProcessor to colorconvert() [probable application bug]");
+        return *this;
+    }
+    if (processor->isNoOp())
+        return *this;
+    // Owned by the caller, so the deleter does nothing
+    return colorconvert (std::shared_ptr<const ColorProcessor> (processor,
+                                            [](const ColorProcessor *){}),
+                         unpremult, string_view());
+}
+
+
+
+// The Pipeline version of the colorconvert_impl loop, on a block of
+// float pixels 'stride' floats apart (stride >= 4) that have nchannels
+// valid channels.
+void
+ImageBufAlgo::Pipeline::run_colorconvert (const ColorProcessor *processor,
+                                          bool unpremult, float *pixels,
+                                          int npixels, int nchannels,
+                                          int stride)
+{
+    float *end = pixels + npixels*stride;
+    // The processor sees 4 channels; any we don't have are zero.
+    if (nchannels < 4)
+        for (float *p = pixels;  p < end;  p += stride)
+            std::fill (p + nchannels, p + 4, 0.0f);
+    const float fltmin = std::numeric_limits<float>::min();
+    unpremult &= (nchannels >= 4);
+    if (unpremult) {
+        for (float *p = pixels;  p < end;  p += stride) {
+            float alpha = p[3];
+            if (alpha > fltmin) {
+                p[0] /= alpha;
+                p[1] /= alpha;
+                p[2] /= alpha;
+            }
+        }
+    }
+    processor->apply (pixels, npixels, 1, 4, sizeof(float),
+                      stride*sizeof(float), npixels*stride*sizeof(float));
+    if (unpremult) {
+        for (float *p = pixels;  p < end;  p += stride) {
+            float alpha = p[3];
+            if (alpha > fltmin) {
+                p[0] *= alpha;
+                p[1] *= alpha;
+                p[2] *= alpha;
+            }
+        }
+    }
+}
+
+
+
 bool
 ImageBufAlgo::ociolook (ImageBuf &dst, const ImageBuf &src,
                         string_view looks, string_view from, string_view to,
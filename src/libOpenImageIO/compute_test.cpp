@@ -38,6 +38,8 @@
 
 #include <iostream>
 
+#include <OpenEXR/half.h>
+
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -187,6 +189,42 @@ test_arrays_like_image_simd_multithread_wrapper (ROI roi)
 
 
 
+// The same computation through per-pixel ImageBuf iterators, which pay
+// range and tile checks on every pixel.
+static void
+test_iterators (ROI roi)
+{
+    ImageBuf::ConstIterator<float> a (imgA, roi);
+    ImageBuf::ConstIterator<float> b (imgB, roi);
+    for (ImageBuf::Iterator<float> r (imgR, roi);  ! r.done();  ++r, ++a, ++b)
+        for (int c = roi.chbegin;  c < roi.chend;  ++c)
+            r[c] = a[c] * a[c] + b[c];
+}
+
+
+
+// The same computation through span iterators, which pay those checks
+// once per contiguous run of pixels.
+static void
+test_span_iterators (ROI roi)
+{
+    ImageBuf::SpanIterator<float> r (imgR, roi);
+    ImageBuf::ConstSpanIterator<float> a (imgA, roi);
+    ImageBuf::ConstSpanIterator<float> b (imgB, roi);
+    while (! r.done()) {
+        int n = std::min (r.npixels(), std::min (a.npixels(), b.npixels()));
+        float *rp = r.data();
+        const float *ap = a.data(), *bp = b.data();
+        for (int i = 0;  i < n;  ++i, rp += r.stride(),
+                             ap += a.stride(), bp += b.stride())
+            for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                rp[c] = ap[c] * ap[c] + bp[c];
+        r.advance (n);  a.advance (n);  b.advance (n);
+    }
+}
+
+
+
 static void
 test_IBA (ROI roi, int threads)
 {
@@ -253,6 +291,24 @@ test_compute ()
     OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,1), 0.25, 0.001);
     OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,2), 0.50, 0.001);
 
+    std::cout << "Test ImageBuf::Iterator, 1 thread: ";
+    ImageBufAlgo::zero (imgR);
+    time = time_trial (std::bind (test_iterators, roi), ntrials, iterations) / iterations;
+    std::cout << Strutil::format ("%.1f Mvals/sec, %.2f ns/pixel",
+                                  (size/1.0e6)/time, 1.0e9*time/npixels) << std::endl;
+    OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,0), 0.25, 0.001);
+    OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,1), 0.25, 0.001);
+    OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,2), 0.50, 0.001);
+
+    std::cout << "Test ImageBuf::SpanIterator, 1 thread: ";
+    ImageBufAlgo::zero (imgR);
+    time = time_trial (std::bind (test_span_iterators, roi), ntrials, iterations) / iterations;
+    std::cout << Strutil::format ("%.1f Mvals/sec, %.2f ns/pixel",
+                                  (size/1.0e6)/time, 1.0e9*time/npixels) << std::endl;
+    OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,0), 0.25, 0.001);
+    OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,1), 0.25, 0.001);
+    OIIO_CHECK_EQUAL_THRESH (imgR.getchannel(xres/2,yres/2,0,2), 0.50, 0.001);
+
     std::cout << "Test ImageBufAlgo::mad 1 thread: ";
     ImageBufAlgo::zero (imgR);
     time = time_trial (std::bind (test_IBA, roi, 1),
@@ -274,6 +330,65 @@ test_compute ()
 
 
 
+// Generic per-channel "over", the way it is done for arbitrary channel
+// layouts, for comparison with ImageBufAlgo::over's RGBA SIMD kernels.
+template<typename T>
+static void
+over_generic (ImageBuf &R, const ImageBuf &A, const ImageBuf &B, ROI roi)
+{
+    ImageBuf::ConstIterator<T> a (A, roi);
+    ImageBuf::ConstIterator<T> b (B, roi);
+    for (ImageBuf::Iterator<T> r (R, roi);  ! r.done();  ++r, ++a, ++b) {
+        float alpha = OIIO::clamp (a[3], 0.0f, 1.0f);
+        for (int c = roi.chbegin;  c < roi.chend;  ++c)
+            r[c] = a[c] + (1.0f - alpha) * b[c];
+    }
+}
+
+
+
+template<typename T>
+static void
+test_over (TypeDesc type)
+{
+    ImageSpec spec (xres, yres, 4, type);
+    spec.alpha_channel = 3;
+    ImageBuf A (spec), B (spec), R (spec), Rgeneric (spec);
+    float fgA[4] = { 0.25f, 0.5f, 0.125f, 0.5f }, fgB[4] = { 0.5f, 0.25f, 0.125f, 0.25f };
+    float bg[4] = { 0.75f, 0.5f, 0.25f, 1.0f };
+    ImageBufAlgo::fill (A, fgA, fgB, fgB, fgA);
+    ImageBufAlgo::fill (B, bg);
+    ROI roi = A.roi();
+    double npix = double(xres) * yres;
+
+    double time = time_trial (std::bind (over_generic<T>, std::ref(Rgeneric),
+                                         std::cref(A), std::cref(B), roi),
+                              ntrials, iterations/10+1) / (iterations/10+1);
+    std::cout << Strutil::format ("  %-6s generic:  %.1f Mpixels/sec\n",
+                                  type, (npix/1.0e6)/time);
+    time = time_trial ([&](){ ImageBufAlgo::over (R, A, B, roi, 1); },
+                       ntrials, iterations/10+1) / (iterations/10+1);
+    std::cout << Strutil::format ("  %-6s over:     %.1f Mpixels/sec\n",
+                                  type, (npix/1.0e6)/time);
+    ImageBufAlgo::CompareResults cr;
+    ImageBufAlgo::compare (R, Rgeneric, 1.0e-6f, 1.0e-6f, cr);
+    OIIO_CHECK_EQUAL (cr.nfail, 0);
+}
+
+
+
+static void
+test_compositing ()
+{
+    std::cout << "Test over, generic per-channel loop vs. RGBA SIMD kernel, 1 thread:\n";
+    test_over<float> (TypeDesc::FLOAT);
+    test_over<half> (TypeDesc::HALF);
+    test_over<unsigned char> (TypeDesc::UINT8);
+    test_over<unsigned short> (TypeDesc::UINT16);
+}
+
+
+
 static void
 getargs (int argc, char *argv[])
 {
@@ -332,6 +447,7 @@ int main (int argc, char *argv[])
     // imgB.write ("B.exr");
 
     test_compute ();
+    test_compositing ();
 
     return unit_test_failures;
 }
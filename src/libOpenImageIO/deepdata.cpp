@@ -39,6 +39,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/thread.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 
 OIIO_NAMESPACE_BEGIN
@@ -119,6 +120,45 @@ public:
         }
     }
 
+    // Data already allocated: raise the capacity of every pixel p to at
+    // least newcapacity[p], moving all the data just once (rather than
+    // once per pixel that grows, as set_capacity would).
+    void grow_all_capacity (const unsigned int *newcapacity) {
+        spin_lock lock (m_mutex);
+        int64_t npixels = int64_t (m_capacity.size());
+        std::vector<unsigned int> capacity (m_capacity);
+        bool grow = false;
+        for (int64_t p = 0; p < npixels; ++p) {
+            if (newcapacity[p] > capacity[p]) {
+                capacity[p] = newcapacity[p];
+                grow = true;
+            }
+        }
+        if (! grow)
+            return;
+        std::vector<unsigned int> cumcapacity (npixels);
+        size_t totalcapacity = 0;
+        for (int64_t p = 0; p < npixels; ++p) {
+            cumcapacity[p] = totalcapacity;
+            totalcapacity += capacity[p];
+        }
+        std::vector<char> data (totalcapacity * m_samplesize);
+        if (m_data.size()) {
+            // Each pixel's samples are contiguous in both the old and new
+            // layouts, so pixels may be moved in parallel.
+            parallel_for_chunked (0, npixels, 0, [&](int64_t b, int64_t e) {
+                for (int64_t p = b; p < e; ++p)
+                    if (m_nsamples[p])
+                        memcpy (&data[cumcapacity[p] * m_samplesize],
+                                &m_data[m_cumcapacity[p] * m_samplesize],
+                                m_nsamples[p] * m_samplesize);
+            });
+        }
+        m_data.swap (data);
+        m_capacity.swap (capacity);
+        m_cumcapacity.swap (cumcapacity);
+    }
+
     size_t data_offset (int pixel, int channel, int sample) {
         DASSERT (int(m_cumcapacity.size()) > pixel);
         DASSERT (m_capacity[pixel] >= m_nsamples[pixel]);
@@ -531,9 +571,11 @@ DeepData::set_all_samples (array_view<const unsigned int> samples)
         return;
     ASSERT (m_impl);
     if (m_impl->m_allocated) {
-        // Data already allocated: set pixels individually
-        for (int p = 0; p < m_npixels; ++p)
-            set_samples (p, int(samples[p]));
+        // Data already allocated: make room for any pixels that grow in
+        // one pass, after which only the sample counts need to change
+        // (growing or shrinking at the end of a pixel doesn't move data).
+        m_impl->grow_all_capacity (&samples[0]);
+        m_impl->m_nsamples.assign (&samples[0], &samples[m_npixels]);
     } else {
         // Data not yet allocated: copy in one shot
         m_impl->m_nsamples.assign (&samples[0], &samples[m_npixels]);
@@ -792,14 +834,18 @@ DeepData::get_pointers (std::vector<void*> &pointers) const
     ASSERT (m_impl);
     m_impl->alloc (m_npixels);
     pointers.resize (pixels()*channels());
-    for (int i = 0;  i < m_npixels;  ++i) {
-        if (m_impl->m_nsamples[i])
-            for (int c = 0;  c < m_nchannels;  ++c)
-                pointers[i*m_nchannels+c] = (void *)m_impl->data_ptr (i, c, 0);
-        else
-            for (int c = 0;  c < m_nchannels;  ++c)
-                pointers[i*m_nchannels+c] = NULL;
-    }
+    // For big deep images (the usual case when reading deep files), the
+    // pointer table is itself big enough to be worth filling in parallel.
+    parallel_for_chunked (0, m_npixels, 0, [&](int64_t b, int64_t e) {
+        for (int64_t i = b;  i < e;  ++i) {
+            if (m_impl->m_nsamples[i])
+                for (int c = 0;  c < m_nchannels;  ++c)
+                    pointers[i*m_nchannels+c] = (void *)m_impl->data_ptr (i, c, 0);
+            else
+                for (int c = 0;  c < m_nchannels;  ++c)
+                    pointers[i*m_nchannels+c] = NULL;
+        }
+    });
 }
 
 
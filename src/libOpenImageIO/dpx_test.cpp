@@ -0,0 +1,458 @@
+/*
+  Copyright 2017 Larry Gritz and the other authors and contributors.
+  All Rights Reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+  * Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+  * Neither the name of the software's owners nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  (This is the Modified BSD License)
+*/
+
+
+// Tests for the 10- and 12-bit pack/unpack kernels of libdpx and
+// libcineon, and for DPX and Cineon files written and read back through
+// the plugins.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/unittest.h>
+
+#include "../dpx.imageio/libdpx/DPX.h"
+#include "../dpx.imageio/libdpx/EndianSwap.h"
+#include "../dpx.imageio/libdpx/ReaderInternal.h"
+#include "../dpx.imageio/libdpx/WriterInternal.h"
+// libdpx and libcineon both define MAGIC_COOKIE
+#undef MAGIC_COOKIE
+#include "../cineon.imageio/libcineon/Cineon.h"
+#include "../cineon.imageio/libcineon/ReaderInternal.h"
+
+using namespace OIIO;
+
+typedef dpx::U8 U8;
+typedef dpx::U16 U16;
+typedef dpx::U32 U32;
+
+
+
+// Deterministic pseudo-random bits, so that failures are reproducible.
+static U32
+random_bits ()
+{
+    static U32 state = 12345;
+    state = state * 1664525 + 1013904223;
+    return state;
+}
+
+
+
+// Widen an n-bit value to 16 bits the way the readers do, so that pixels
+// made with it survive an n-bit round trip exactly.
+static U16
+widen (U32 x, int bits)
+{
+    return bits == 10 ? U16((x << 6) | (x >> 4)) : U16((x << 4) | (x >> 8));
+}
+
+
+
+// Datum i of a 10-bit filled buffer, taken straight from the bits.
+static U32
+filled10_datum (const U32 *words, int i, int padding, bool lowfirst)
+{
+    int pos = lowfirst ? i % 3 : 2 - i % 3;
+    return (words[i / 3] >> (pos * 10 + padding)) & 0x3ff;
+}
+
+
+
+// Datum i of a 12-bit packed buffer: bits [12i, 12i+12) of the words.
+static U32
+packed12_datum (const U32 *words, int i)
+{
+    int bit = i * 12;
+    unsigned long long pair = words[bit / 32];
+    if (bit % 32 > 20)
+        pair |= (unsigned long long)words[bit / 32 + 1] << 32;
+    return U32(pair >> (bit % 32)) & 0xfff;
+}
+
+
+
+// Datum counts that leave every possible partial word or group, and that
+// cover both the vector loops and their scalar tails.
+static const int datum_counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 11, 12, 13,
+                                    23, 24, 25, 47, 48, 49, 190, 191, 192 };
+static const int max_datums = 192;
+
+
+
+typedef int (*Unfill10Func) (const U32 *, U16 *, const int);
+
+static void
+check_unfill10 (const char *lib, Unfill10Func vectorized, Unfill10Func scalar,
+                int padding, bool lowfirst)
+{
+    std::cout << "  " << lib << " 10-bit filled, padding " << padding
+              << (lowfirst ? ", low datum first\n" : "\n");
+    std::vector<U32> words (max_datums / 3 + 1);
+    for (auto &w : words)
+        w = random_bits ();
+    for (int count : datum_counts) {
+        std::vector<U16> a (max_datums, 0xbeef), b (max_datums, 0xbeef);
+        std::vector<U16> ref (max_datums, 0xbeef);
+        int done = count / 3 * 3;
+        for (int i = 0; i < done; ++i)
+            ref[i] = widen (filled10_datum (&words[0], i, padding, lowfirst), 10);
+        OIIO_CHECK_EQUAL (vectorized (&words[0], &a[0], count), done);
+        OIIO_CHECK_EQUAL (scalar (&words[0], &b[0], count), done);
+        OIIO_CHECK_ASSERT (a == ref);
+        OIIO_CHECK_ASSERT (b == ref);
+    }
+}
+
+
+
+// The word-at-a-time and SSE unpacking of 10-bit filled data (method A
+// and B, either datum order) must match each other and the bit layout.
+template <int PADDINGBITS, bool LOWFIRST>
+static void
+test_unfill10 ()
+{
+    check_unfill10 ("dpx",
+                    dpx::Unfill10bitFilledWords<PADDINGBITS, LOWFIRST, true>,
+                    dpx::Unfill10bitFilledWords<PADDINGBITS, LOWFIRST, false>,
+                    PADDINGBITS, LOWFIRST);
+    check_unfill10 ("cineon",
+                    cineon::Unfill10bitFilledWords<PADDINGBITS, LOWFIRST, true>,
+                    cineon::Unfill10bitFilledWords<PADDINGBITS, LOWFIRST, false>,
+                    PADDINGBITS, LOWFIRST);
+}
+
+
+
+// Widening 12-bit filled method B data: SSE and scalar loops must match
+// BaseTypeConvertU12ToU16, including for garbage in the unused high bits.
+static void
+test_unfill12 ()
+{
+    std::cout << "  dpx 12-bit filled, method B\n";
+    std::vector<U16> src (max_datums);
+    for (auto &s : src)
+        s = U16(random_bits ());
+    for (int count : datum_counts) {
+        std::vector<U16> a (max_datums, 0xbeef), b (max_datums, 0xbeef);
+        std::vector<U16> ref (max_datums, 0xbeef);
+        for (int i = 0; i < count; ++i)
+            ref[i] = U16((src[i] << 4) | (src[i] >> 8));
+        OIIO_CHECK_EQUAL (dpx::Unfill12bitFilledWords<true> (&src[0], &a[0], count), count);
+        OIIO_CHECK_EQUAL (dpx::Unfill12bitFilledWords<false> (&src[0], &b[0], count), count);
+        OIIO_CHECK_ASSERT (a == ref);
+        OIIO_CHECK_ASSERT (b == ref);
+    }
+}
+
+
+
+typedef int (*Unpack12Func) (const U32 *, U16 *, const int);
+typedef void (*UnPackPackedFunc) (U32 *, const int, U16 *, int, int, const int);
+
+// Whole groups of 12-bit packed datums must unpack the same as the
+// per-datum UnPackPacked loop they replace.
+static void
+check_unpack12 (const char *lib, Unpack12Func words_func,
+                UnPackPackedFunc packed_func)
+{
+    std::cout << "  " << lib << " 12-bit packed\n";
+    // one spare word, since UnPackPacked reads 16 bits at a time
+    std::vector<U32> words (max_datums * 12 / 32 + 1);
+    for (auto &w : words)
+        w = random_bits ();
+    for (int count : datum_counts) {
+        std::vector<U16> a (max_datums, 0xbeef), ref (max_datums, 0xbeef);
+        packed_func (&words[0], 12, &ref[0], count, 0, 0);
+        int done = words_func (&words[0], &a[0], count);
+        OIIO_CHECK_EQUAL (done, littleendian() ? count / 8 * 8 : 0);
+        for (int i = done; i < count; ++i)
+            a[i] = ref[i];
+        OIIO_CHECK_ASSERT (a == ref);
+        if (littleendian()) {
+            for (int i = 0; i < count; ++i)
+                OIIO_CHECK_EQUAL (ref[i], widen (packed12_datum (&words[0], i), 12));
+        }
+    }
+}
+
+
+
+static void
+test_unpack12 ()
+{
+    check_unpack12 ("dpx", dpx::Unpack12bitPackedWords,
+                    dpx::UnPackPacked<U16, MASK_12BITPACKED, MULTIPLIER_12BITPACKED,
+                                      REMAIN_12BITPACKED, REVERSE_12BITPACKED>);
+    check_unpack12 ("cineon", cineon::Unpack12bitPackedWords,
+                    cineon::UnPackPacked<U16, MASK_12BITPACKED, MULTIPLIER_12BITPACKED,
+                                         REMAIN_12BITPACKED, REVERSE_12BITPACKED>);
+}
+
+
+
+// The DPX writer packs in place, the way WriteBuffer calls it; check the
+// bits it leaves against the layout the readers expect.
+template <dpx::Packing METHOD>
+static void
+test_pack10 (bool reverse)
+{
+    const int padding = (METHOD == dpx::kFilledMethodA) ? 2 : 0;
+    std::cout << "  dpx pack 10-bit filled, padding " << padding
+              << (reverse ? "\n" : ", low datum first\n");
+    for (int count : datum_counts) {
+        std::vector<U16> src (max_datums + 1);
+        for (auto &s : src)
+            s = widen (random_bits () & 0x3ff, 10);
+        std::vector<U16> buf (src);
+        dpx::BufferAccess access;
+        access.length = count;
+        dpx::WritePackedMethodAB_10bit<U16, METHOD> (&buf[0], &buf[0], count,
+                                                    reverse, access);
+        OIIO_CHECK_EQUAL (access.offset, 0);
+        OIIO_CHECK_EQUAL (access.length, (count + 2) / 3 * 2);
+        const U32 *words = reinterpret_cast<const U32 *>(&buf[0]);
+        for (int i = 0; i < count; ++i)
+            OIIO_CHECK_EQUAL (filled10_datum (words, i, padding, !reverse),
+                              U32(src[i] >> 6));
+    }
+}
+
+
+
+static void
+test_pack12 ()
+{
+    std::cout << "  dpx pack 12-bit packed\n";
+    for (int count : datum_counts) {
+        std::vector<U16> src (max_datums + 2);
+        for (auto &s : src)
+            s = widen (random_bits () & 0xfff, 12);
+        std::vector<U16> buf (src);
+        dpx::BufferAccess access;
+        access.length = count;
+        dpx::WritePackedMethod<U16, 12> (&buf[0], &buf[0], count, false, access);
+        OIIO_CHECK_EQUAL (access.offset, 0);
+        OIIO_CHECK_EQUAL (access.length, (count * 12 + 31) / 32 * 2);
+        const U32 *words = reinterpret_cast<const U32 *>(&buf[0]);
+        for (int i = 0; i < count; ++i)
+            OIIO_CHECK_EQUAL (packed12_datum (words, i), U32(src[i] >> 4));
+    }
+}
+
+
+
+// Make a w x h image of n-bit values widened to 16 bits.
+static std::vector<U16>
+make_pixels (int w, int h, int nchannels, int bits)
+{
+    std::vector<U16> pixels (size_t(w) * h * nchannels);
+    for (auto &p : pixels)
+        p = widen (random_bits () & ((1 << bits) - 1), bits);
+    return pixels;
+}
+
+
+
+static bool
+read_back (const std::string &filename, int w, int h, int nchannels,
+           int bits, const std::vector<U16> &pixels)
+{
+    ImageBuf B (filename);
+    if (! B.read (0, 0, true, TypeDesc::UINT16)) {
+        std::cout << "    " << B.geterror() << "\n";
+        return false;
+    }
+    const ImageSpec &spec (B.spec());
+    if (spec.width != w || spec.height != h || spec.nchannels != nchannels ||
+        spec.get_int_attribute ("oiio:BitsPerSample") != bits)
+        return false;
+    std::vector<U16> result (pixels.size());
+    B.get_pixels (B.roi(), TypeDesc::UINT16, &result[0]);
+    return result == pixels;
+}
+
+
+
+// Write and read back DPX files through the plugin, for 1, 3 and 4
+// channels at widths that leave 0, 1 and 2 datums in the last word of a
+// 10-bit line.
+static void
+test_dpx_roundtrip (int bits, const char *packing)
+{
+    for (int nchannels : { 1, 3, 4 }) {
+        for (int w : { 30, 31, 32 }) {
+            std::cout << "  dpx " << bits << "-bit " << packing << ", "
+                      << nchannels << " channels, width " << w << "\n";
+            const int h = 5;
+            std::vector<U16> pixels = make_pixels (w, h, nchannels, bits);
+            ImageBuf A (ImageSpec (w, h, nchannels, TypeDesc::UINT16));
+            A.set_pixels (A.roi(), TypeDesc::UINT16, &pixels[0]);
+            A.specmod().attribute ("oiio:BitsPerSample", bits);
+            A.specmod().attribute ("dpx:Packing", packing);
+            std::string filename = "roundtrip_dpx_test.dpx";
+            OIIO_CHECK_ASSERT (A.write (filename));
+            OIIO_CHECK_ASSERT (read_back (filename, w, h, nchannels, bits, pixels));
+            Filesystem::remove (filename);
+        }
+    }
+}
+
+
+
+template <typename T>
+static void
+put (std::vector<char> &buf, size_t offset, T value)
+{
+    memcpy (&buf[offset], &value, sizeof(T));
+}
+
+
+
+// There is no Cineon writer plugin, so lay out a minimal Cineon file by
+// hand (in native byte order, which the reader detects from the magic
+// number) with the same bit layouts the readers expect.
+static bool
+write_cineon (const std::string &filename, int w, int h, int nchannels,
+              int bits, cineon::Packing packing, const std::vector<U16> &pixels)
+{
+    typedef cineon::GenericHeader G;
+    const size_t headersize = sizeof(cineon::GenericHeader) + sizeof(cineon::IndustryHeader);
+    std::vector<char> header (headersize, 0);
+    put<U32> (header, offsetof(G, magicNumber), MAGIC_COOKIE);
+    put<U32> (header, offsetof(G, imageOffset), U32(headersize));
+    put<U32> (header, offsetof(G, genericSize), U32(sizeof(cineon::GenericHeader)));
+    put<U32> (header, offsetof(G, industrySize), U32(sizeof(cineon::IndustryHeader)));
+    put<U8> (header, offsetof(G, imageOrientation), U8(cineon::kLeftToRightTopToBottom));
+    put<U8> (header, offsetof(G, numberOfElements), U8(nchannels));
+    for (int c = 0;  c < nchannels;  ++c) {
+        size_t chan = offsetof(G, chan) + c * sizeof(cineon::ImageElement);
+        U8 desc = (nchannels == 1) ? U8(cineon::kGrayscale)
+                                   : U8(cineon::kPrintingDensityRed + c % 3);
+        put<U8> (header, chan + offsetof(cineon::ImageElement, designator) + 1, desc);
+        put<U8> (header, chan + offsetof(cineon::ImageElement, bitDepth), U8(bits));
+        put<U32> (header, chan + offsetof(cineon::ImageElement, pixelsPerLine), U32(w));
+        put<U32> (header, chan + offsetof(cineon::ImageElement, linesPerElement), U32(h));
+    }
+    put<U8> (header, offsetof(G, interleave), U8(cineon::kPixel));
+    put<U8> (header, offsetof(G, packing), U8(packing));
+
+    const int datums = w * nchannels;
+    std::vector<U32> data;
+    for (int y = 0;  y < h;  ++y) {
+        const U16 *line = &pixels[y * datums];
+        if (packing == cineon::kPacked) {
+            // 12-bit packed: datum i in bits [12i, 12i+12) of the line
+            std::vector<U32> words ((datums * 12 + 31) / 32, 0);
+            for (int i = 0;  i < datums;  ++i) {
+                unsigned long long d = line[i] >> 4;
+                int bit = i * 12;
+                words[bit / 32] |= U32(d << (bit % 32));
+                if (bit % 32 > 20)
+                    words[bit / 32 + 1] |= U32(d >> (32 - bit % 32));
+            }
+            data.insert (data.end(), words.begin(), words.end());
+        } else {
+            // 10-bit filled: three datums per word, the first in the high
+            // bits, left (method A) or right (method B) justified
+            const int padding = (packing == cineon::kLongWordLeft) ? 2 : 0;
+            std::vector<U32> words ((datums + 2) / 3, 0);
+            for (int i = 0;  i < datums;  ++i)
+                words[i / 3] |= U32(line[i] >> 6) << ((2 - i % 3) * 10 + padding);
+            data.insert (data.end(), words.begin(), words.end());
+        }
+    }
+    put<U32> (header, offsetof(G, fileSize), U32(headersize + data.size() * sizeof(U32)));
+
+    FILE *file = Filesystem::fopen (filename, "wb");
+    if (! file)
+        return false;
+    bool ok = fwrite (&header[0], 1, header.size(), file) == header.size() &&
+              fwrite (&data[0], sizeof(U32), data.size(), file) == data.size();
+    fclose (file);
+    return ok;
+}
+
+
+
+static void
+test_cineon_roundtrip (int bits, cineon::Packing packing, const char *name)
+{
+    for (int nchannels : { 1, 3, 4 }) {
+        for (int w : { 30, 31, 32 }) {
+            std::cout << "  cineon " << bits << "-bit " << name << ", "
+                      << nchannels << " channels, width " << w << "\n";
+            const int h = 5;
+            std::vector<U16> pixels = make_pixels (w, h, nchannels, bits);
+            std::string filename = "roundtrip_dpx_test.cin";
+            OIIO_CHECK_ASSERT (write_cineon (filename, w, h, nchannels, bits,
+                                             packing, pixels));
+            OIIO_CHECK_ASSERT (read_back (filename, w, h, nchannels, bits, pixels));
+            Filesystem::remove (filename);
+        }
+    }
+}
+
+
+
+int
+main (int argc, char **argv)
+{
+    std::cout << "Testing unpacking kernels:\n";
+    test_unfill10<PADDINGBITS_10BITFILLEDMETHODA, false> ();
+    test_unfill10<PADDINGBITS_10BITFILLEDMETHODA, true> ();
+    test_unfill10<PADDINGBITS_10BITFILLEDMETHODB, false> ();
+    test_unfill10<PADDINGBITS_10BITFILLEDMETHODB, true> ();
+    test_unfill12 ();
+    test_unpack12 ();
+
+    std::cout << "Testing packing kernels:\n";
+    test_pack10<dpx::kFilledMethodA> (false);
+    test_pack10<dpx::kFilledMethodA> (true);
+    test_pack10<dpx::kFilledMethodB> (false);
+    test_pack10<dpx::kFilledMethodB> (true);
+    test_pack12 ();
+
+    std::cout << "Testing file round trips:\n";
+    test_dpx_roundtrip (10, "Filled, method A");
+    test_dpx_roundtrip (10, "Filled, method B");
+    test_dpx_roundtrip (12, "Packed");
+    test_cineon_roundtrip (10, cineon::kLongWordLeft, "method A");
+    test_cineon_roundtrip (10, cineon::kLongWordRight, "method B");
+    test_cineon_roundtrip (12, cineon::kPacked, "packed");
+
+    return unit_test_failures;
+}
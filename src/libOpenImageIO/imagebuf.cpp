@@ -34,6 +34,7 @@
 
 
 #include <iostream>
+#include <limits>
 #include <memory>
 
 #include <OpenEXR/ImathFun.h>
@@ -50,6 +51,7 @@
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/thread.h>
 #include <OpenImageIO/simd.h>
+#include "imageio_pvt.h"
 
 OIIO_NAMESPACE_BEGIN
 
@@ -267,6 +269,119 @@ public:
         return (z * m_spec.height + y) * m_spec.width + x;
     }
 
+    // Set up the strides of local pixels that we lay out ourselves
+    // (anything but a view or an app buffer): the pixel, scanline, and
+    // plane sizes, or for tile-major pixels, those within a tile plus
+    // the tile grid.
+    void set_strides () {
+        m_tile_xoff = m_tile_yoff = m_tile_zoff = 0;
+        if (! m_local_tile_width) {
+            m_xstride = m_pixel_bytes;
+            m_ystride = m_scanline_bytes;
+            m_zstride = m_plane_bytes;
+            m_ntiles_x = m_ntiles_y = 0;
+            m_tile_stride = 0;
+            return;
+        }
+        m_xstride = m_pixel_bytes;
+        m_ystride = m_xstride * m_local_tile_width;
+        m_zstride = m_ystride * m_local_tile_height;
+        m_tile_stride = m_zstride * m_local_tile_depth;
+        m_ntiles_x = (m_spec.width + m_local_tile_width - 1) / m_local_tile_width;
+        m_ntiles_y = (m_spec.height + m_local_tile_height - 1) / m_local_tile_height;
+        m_tile_pow2 = ispow2 (m_local_tile_width) &&
+                      ispow2 (m_local_tile_height) &&
+                      ispow2 (m_local_tile_depth);
+        m_tile_xshift = m_tile_yshift = m_tile_zshift = 0;
+        while ((1 << m_tile_xshift) < m_local_tile_width)
+            ++m_tile_xshift;
+        while ((1 << m_tile_yshift) < m_local_tile_height)
+            ++m_tile_yshift;
+        while ((1 << m_tile_zshift) < m_local_tile_depth)
+            ++m_tile_zshift;
+    }
+
+    // Take on the strides and tile grid of src's local pixels.
+    void copy_layout (const ImageBufImpl &src) {
+        m_xstride = src.m_xstride;
+        m_ystride = src.m_ystride;
+        m_zstride = src.m_zstride;
+        m_local_tile_width = src.m_local_tile_width;
+        m_local_tile_height = src.m_local_tile_height;
+        m_local_tile_depth = src.m_local_tile_depth;
+        m_tile_xoff = src.m_tile_xoff;
+        m_tile_yoff = src.m_tile_yoff;
+        m_tile_zoff = src.m_tile_zoff;
+        m_ntiles_x = src.m_ntiles_x;
+        m_ntiles_y = src.m_ntiles_y;
+        m_tile_stride = src.m_tile_stride;
+        m_tile_pow2 = src.m_tile_pow2;
+        m_tile_xshift = src.m_tile_xshift;
+        m_tile_yshift = src.m_tile_yshift;
+        m_tile_zshift = src.m_tile_zshift;
+    }
+
+    // Bytes of memory needed to hold the pixels in our layout.
+    imagesize_t local_bytes () const {
+        if (! m_local_tile_width)
+            return m_spec.image_bytes ();
+        int ntiles_z = (m_spec.depth + m_local_tile_depth - 1) / m_local_tile_depth;
+        return imagesize_t(m_tile_stride) * m_ntiles_x * m_ntiles_y * ntiles_z;
+    }
+
+    // Address of local pixel (x,y,z), without any checks.
+    char *local_addr (int x, int y, int z) const {
+        x -= m_spec.x;
+        y -= m_spec.y;
+        z -= m_spec.z;
+        if (! m_local_tile_width)
+            return m_localpixels + (y * m_ystride + x * m_xstride + z * m_zstride);
+        x += m_tile_xoff;
+        y += m_tile_yoff;
+        z += m_tile_zoff;
+        int tx, ty, tz;
+        if (m_tile_pow2) {
+            tx = x >> m_tile_xshift;  x &= m_local_tile_width - 1;
+            ty = y >> m_tile_yshift;  y &= m_local_tile_height - 1;
+            tz = z >> m_tile_zshift;  z &= m_local_tile_depth - 1;
+        } else {
+            tx = x / m_local_tile_width;   x -= tx * m_local_tile_width;
+            ty = y / m_local_tile_height;  y -= ty * m_local_tile_height;
+            tz = z / m_local_tile_depth;   z -= tz * m_local_tile_depth;
+        }
+        stride_t tile = (stride_t(tz) * m_ntiles_y + ty) * m_ntiles_x + tx;
+        return m_localpixels + (tile * m_tile_stride + y * m_ystride +
+                                x * m_xstride + z * m_zstride);
+    }
+
+    // One past the last x (y, z) coordinate in the same tile of
+    // tile-major local pixels as x (y, z) -- or INT_MAX for
+    // scanline-major pixels.
+    int tile_xend (int x) const {
+        return tile_end (x, x - m_spec.x + m_tile_xoff, m_local_tile_width);
+    }
+    int tile_yend (int y) const {
+        return tile_end (y, y - m_spec.y + m_tile_yoff, m_local_tile_height);
+    }
+    int tile_zend (int z) const {
+        return tile_end (z, z - m_spec.z + m_tile_zoff, m_local_tile_depth);
+    }
+
+    // Copy all the pixels of src, which has the same spec but may have
+    // any strides or tile layout, into our local pixels.
+    void copy_local_pixels (const ImageBufImpl &src);
+
+    // Convert the pixels of roi (within the data window) from the local
+    // pixels to data, or if to_local is true, the other way, where data
+    // is of the given format and strides.  Tile-major pixels are done a
+    // tile at a time.
+    bool convert_local (ROI roi, bool to_local, void *data, TypeDesc format,
+                        stride_t xstride, stride_t ystride, stride_t zstride,
+                        int nthreads) const;
+
+    // Read all the pixels from the open in into tile-major local pixels.
+    bool read_local_tiles (ImageInput *in, int chbegin, int chend);
+
 private:
     ImageBuf::IBStorage m_storage; ///< Pixel storage class
     ustring m_name;              ///< Filename of the image
@@ -278,8 +393,10 @@ private:
     mutable int m_threads;       ///< thread policy for this image
     ImageSpec m_spec;            ///< Describes the image (size, etc)
     ImageSpec m_nativespec;      ///< Describes the true native image
-    std::unique_ptr<char[]> m_pixels; ///< Pixel data, if local and we own it
+    std::shared_ptr<char> m_pixels; ///< Pixel data, if local and we own
+                                 ///<   it (or share it, if a view)
     char *m_localpixels;         ///< Pointer to local pixels
+    bool m_view;                 ///< Is this a view of another IB?
     mutable spin_mutex m_valid_mutex;
     mutable bool m_spec_valid;   ///< Is the spec valid
     mutable bool m_pixels_valid; ///< Image is valid
@@ -288,6 +405,18 @@ private:
     size_t m_pixel_bytes;
     size_t m_scanline_bytes;
     size_t m_plane_bytes;
+    stride_t m_xstride;          ///< Strides through the local pixels
+    stride_t m_ystride;          ///<   (within a tile, if tile-major)
+    stride_t m_zstride;
+    int m_local_tile_width;      ///< Tile size of tile-major local pixels
+    int m_local_tile_height;     ///<   (all 0 for scanline-major)
+    int m_local_tile_depth;
+    int m_tile_xoff, m_tile_yoff, m_tile_zoff; ///< Data window position
+                                 ///<   in the tile grid (nonzero for views)
+    int m_ntiles_x, m_ntiles_y;  ///< Tiles per row and per plane of grid
+    stride_t m_tile_stride;      ///< Distance between successive tiles
+    bool m_tile_pow2;            ///< Tile sizes are all powers of 2 ...
+    int m_tile_xshift, m_tile_yshift, m_tile_zshift; ///< ... these
     ImageCache *m_imagecache;    ///< ImageCache to use
     TypeDesc m_cachedpixeltype;  ///< Data type stored in the cache
     DeepData m_deepdata;         ///< Deep data
@@ -300,12 +429,39 @@ private:
     std::unique_ptr<ImageSpec> m_configspec; // Configuration spec
     mutable std::string m_err;   ///< Last error message
 
+    static int tile_end (int c, int offset, int tilesize) {
+        return tilesize ? c - offset % tilesize + tilesize
+                        : std::numeric_limits<int>::max();
+    }
+
     const ImageBufImpl operator= (const ImageBufImpl &src); // unimplemented
     friend class ImageBuf;
 };
 
 
 
+// Call f(block) for each part of roi that lies within a single tile of
+// both a's and b's local pixels (just roi itself, if both are
+// scanline-major).
+template<class Func>
+static void
+for_each_local_tile (const ImageBufImpl &a, const ImageBufImpl &b,
+                     ROI roi, Func f)
+{
+    for (int z = roi.zbegin, zend;  z < roi.zend;  z = zend) {
+        zend = std::min (roi.zend, std::min (a.tile_zend(z), b.tile_zend(z)));
+        for (int y = roi.ybegin, yend;  y < roi.yend;  y = yend) {
+            yend = std::min (roi.yend, std::min (a.tile_yend(y), b.tile_yend(y)));
+            for (int x = roi.xbegin, xend;  x < roi.xend;  x = xend) {
+                xend = std::min (roi.xend, std::min (a.tile_xend(x), b.tile_xend(x)));
+                f (ROI (x, xend, y, yend, z, zend, roi.chbegin, roi.chend));
+            }
+        }
+    }
+}
+
+
+
 ImageBufImpl::ImageBufImpl (string_view filename,
                             int subimage, int miplevel,
                             ImageCache *imagecache,
@@ -316,10 +472,15 @@ ImageBufImpl::ImageBufImpl (string_view filename,
       m_current_subimage(subimage), m_current_miplevel(miplevel),
       m_nmiplevels(0),
       m_threads(0),
-      m_localpixels(NULL),
+      m_localpixels(NULL), m_view(false),
       m_spec_valid(false), m_pixels_valid(false),
       m_badfile(false), m_pixelaspect(1),
       m_pixel_bytes(0), m_scanline_bytes(0), m_plane_bytes(0),
+      m_xstride(0), m_ystride(0), m_zstride(0),
+      m_local_tile_width(0), m_local_tile_height(0), m_local_tile_depth(0),
+      m_tile_xoff(0), m_tile_yoff(0), m_tile_zoff(0),
+      m_ntiles_x(0), m_ntiles_y(0), m_tile_stride(0), m_tile_pow2(false),
+      m_tile_xshift(0), m_tile_yshift(0), m_tile_zshift(0),
       m_imagecache(imagecache), m_allocated_size(0),
       m_write_format(TypeDesc::UNKNOWN), m_write_tile_width(0),
       m_write_tile_height(0), m_write_tile_depth(1)
@@ -330,6 +491,7 @@ ImageBufImpl::ImageBufImpl (string_view filename,
         m_pixel_bytes = spec->pixel_bytes();
         m_scanline_bytes = spec->scanline_bytes();
         m_plane_bytes = clamped_mult64 (m_scanline_bytes, (imagesize_t)m_spec.height);
+        set_strides ();
         m_blackpixel.resize (round_to_multiple (m_pixel_bytes, OIIO_SIMD_MAX_SIZE_BYTES), 0);
         // NB make it big enough for SSE
         if (buffer) {
@@ -379,30 +541,55 @@ ImageBufImpl::ImageBufImpl (const ImageBufImpl &src)
 {
     m_spec_valid = src.m_spec_valid;
     m_pixels_valid = src.m_pixels_valid;
-    m_allocated_size = src.m_localpixels ? src.spec().image_bytes() : 0;
-    IB_local_mem_current += m_allocated_size;
+    m_view = false;
+    copy_layout (src);
+    m_allocated_size = 0;
     if (src.m_localpixels) {
         // Source had the image fully in memory (no cache)
-        if (m_storage == ImageBuf::APPBUFFER) {
+        if (m_storage == ImageBuf::APPBUFFER && ! src.m_view) {
             // Source just wrapped the client app's pixels, we do the same
             m_localpixels = src.m_localpixels;
+            m_allocated_size = src.spec().image_bytes();
         } else {
-            // We own our pixels -- copy from source
-            m_pixels.reset (new char [src.m_spec.image_bytes()]);
-            memcpy (m_pixels.get(), src.m_pixels.get(), m_spec.image_bytes());
+            // We own our pixels -- copy from source, which may be a view
+            // with any strides.  Tile-major pixels stay tile-major.
+            m_storage = ImageBuf::LOCALBUFFER;
+            set_strides ();
+            m_allocated_size = local_bytes ();
+            m_pixels.reset (new char [m_allocated_size],
+                            std::default_delete<char[]>());
             m_localpixels = m_pixels.get();
+            copy_local_pixels (src);
         }
     } else {
         // Source was cache-based or deep
         // nothing else to do
         m_localpixels = NULL;
     }
+    IB_local_mem_current += m_allocated_size;
     if (src.m_configspec)
         m_configspec.reset (new ImageSpec(*src.m_configspec));
 }
 
 
 
+void
+ImageBufImpl::copy_local_pixels (const ImageBufImpl &src)
+{
+    DASSERT (m_localpixels && src.m_localpixels &&
+             m_pixel_bytes == src.m_pixel_bytes);
+    for_each_local_tile (*this, src, get_roi (m_spec), [&](ROI t){
+        copy_image (m_spec.nchannels, t.width(), t.height(), t.depth(),
+                    src.local_addr (t.xbegin, t.ybegin, t.zbegin),
+                    m_pixel_bytes, src.m_xstride, src.m_ystride,
+                    src.m_zstride,
+                    local_addr (t.xbegin, t.ybegin, t.zbegin),
+                    m_xstride, m_ystride, m_zstride);
+    });
+}
+
+
+
 ImageBufImpl::~ImageBufImpl ()
 {
     // Do NOT destroy m_imagecache here -- either it was created
@@ -547,6 +734,7 @@ ImageBufImpl::clear ()
     m_nativespec = ImageSpec ();
     m_pixels.reset ();
     m_localpixels = NULL;
+    m_view = false;
     m_spec_valid = false;
     m_pixels_valid = false;
     m_badfile = false;
@@ -554,6 +742,10 @@ ImageBufImpl::clear ()
     m_pixel_bytes = 0;
     m_scanline_bytes = 0;
     m_plane_bytes = 0;
+    m_local_tile_width = 0;
+    m_local_tile_height = 0;
+    m_local_tile_depth = 0;
+    set_strides ();
     m_imagecache = NULL;
     m_deepdata.free ();
     m_blackpixel.clear ();
@@ -647,14 +839,17 @@ void
 ImageBufImpl::realloc ()
 {
     IB_local_mem_current -= m_allocated_size;
-    m_allocated_size = m_spec.deep ? size_t(0) : m_spec.image_bytes ();
-    IB_local_mem_current += m_allocated_size;
-    m_pixels.reset (m_allocated_size ? new char [m_allocated_size] : NULL);
-    m_localpixels = m_pixels.get();
-    m_storage = m_allocated_size ? ImageBuf::LOCALBUFFER : ImageBuf::UNINITIALIZED;
     m_pixel_bytes = m_spec.pixel_bytes();
     m_scanline_bytes = m_spec.scanline_bytes();
     m_plane_bytes = clamped_mult64 (m_scanline_bytes, (imagesize_t)m_spec.height);
+    set_strides ();
+    m_allocated_size = m_spec.deep ? size_t(0) : local_bytes ();
+    IB_local_mem_current += m_allocated_size;
+    m_pixels.reset (m_allocated_size ? new char [m_allocated_size] : NULL,
+                    std::default_delete<char[]>());
+    m_localpixels = m_pixels.get();
+    m_view = false;
+    m_storage = m_allocated_size ? ImageBuf::LOCALBUFFER : ImageBuf::UNINITIALIZED;
     m_blackpixel.resize (round_to_multiple (m_pixel_bytes, OIIO_SIMD_MAX_SIZE_BYTES), 0);
     // NB make it big enough for SSE
     if (m_allocated_size)
@@ -722,6 +917,7 @@ ImageBufImpl::init_spec (string_view filename, int subimage, int miplevel)
     m_pixel_bytes = m_spec.pixel_bytes();
     m_scanline_bytes = m_spec.scanline_bytes();
     m_plane_bytes = clamped_mult64 (m_scanline_bytes, (imagesize_t)m_spec.height);
+    set_strides ();
     m_blackpixel.resize (round_to_multiple (m_pixel_bytes, OIIO_SIMD_MAX_SIZE_BYTES), 0);
     // NB make it big enough for SSE
 
@@ -832,6 +1028,7 @@ ImageBufImpl::read (int subimage, int miplevel, int chbegin, int chend,
         m_pixel_bytes = m_spec.pixel_bytes();
         m_scanline_bytes = m_spec.scanline_bytes();
         m_plane_bytes = clamped_mult64 (m_scanline_bytes, (imagesize_t)m_spec.height);
+        set_strides ();
         m_blackpixel.resize (round_to_multiple (m_pixel_bytes, OIIO_SIMD_MAX_SIZE_BYTES), 0);
         // NB make it big enough for SSE
         m_pixels_valid = true;
@@ -893,7 +1090,9 @@ ImageBufImpl::read (int subimage, int miplevel, int chbegin, int chend,
                 ImageSpec newspec;
                 ok &= in->seek_subimage (subimage, miplevel, newspec);
             }
-            if (ok)
+            if (ok && m_local_tile_width)
+                ok &= read_local_tiles (in, chbegin, chend);
+            else if (ok)
                 ok &= in->read_image (chbegin, chend, convert, m_localpixels);
             in->close ();
             if (ok) {
@@ -911,13 +1110,19 @@ ImageBufImpl::read (int subimage, int miplevel, int chbegin, int chend,
     }
 
     // All other cases, no loss of precision is expected, so even a forced
-    // read should go through the image cache.
-    if (m_imagecache->get_pixels (m_name, subimage, miplevel,
-                                  m_spec.x, m_spec.x+m_spec.width,
-                                  m_spec.y, m_spec.y+m_spec.height,
-                                  m_spec.z, m_spec.z+m_spec.depth,
-                                  chbegin, chend,
-                                  m_spec.format, m_localpixels)) {
+    // read should go through the image cache.  Tile-major local pixels
+    // are filled a tile at a time.
+    bool ok = true;
+    for_each_local_tile (*this, *this, get_roi (m_spec), [&](ROI t){
+        if (ok)
+            ok = m_imagecache->get_pixels (m_name, subimage, miplevel,
+                                           t.xbegin, t.xend, t.ybegin, t.yend,
+                                           t.zbegin, t.zend, chbegin, chend,
+                                           m_spec.format,
+                                           local_addr (t.xbegin, t.ybegin, t.zbegin),
+                                           m_xstride, m_ystride, m_zstride);
+    });
+    if (ok) {
         m_pixels_valid = true;
     } else {
         m_pixels_valid = false;
@@ -929,6 +1134,108 @@ ImageBufImpl::read (int subimage, int miplevel, int chbegin, int chend,
 
 
 
+bool
+ImageBufImpl::read_local_tiles (ImageInput *in, int chbegin, int chend)
+{
+    const ImageSpec &inspec (in->spec());
+    ROI all = get_roi (m_spec);
+    bool ok = true;
+    if (inspec.tile_width == m_local_tile_width &&
+        inspec.tile_height == m_local_tile_height &&
+        std::max (1, inspec.tile_depth) == m_local_tile_depth &&
+        inspec.x == m_spec.x && inspec.y == m_spec.y && inspec.z == m_spec.z) {
+        // The file's tiles are the same as ours: read each one straight
+        // into place.
+        for_each_local_tile (*this, *this, all, [&](ROI t){
+            if (ok)
+                ok = in->read_tiles (t.xbegin, t.xend, t.ybegin, t.yend,
+                                     t.zbegin, t.zend, chbegin, chend,
+                                     m_spec.format,
+                                     local_addr (t.xbegin, t.ybegin, t.zbegin),
+                                     m_xstride, m_ystride, m_zstride);
+        });
+        return ok;
+    }
+
+    // Otherwise, read full-width strips (a row of the file's tiles, if
+    // it's tiled) and scatter each into our tiles.
+    int striph = inspec.tile_width ? inspec.tile_height : m_local_tile_height;
+    int stripd = inspec.tile_width ? std::max (1, inspec.tile_depth) : 1;
+    stride_t xstride = m_pixel_bytes, ystride = xstride * m_spec.width;
+    stride_t zstride = ystride * striph;
+    std::unique_ptr<char[]> tmp (new char [zstride * stripd]);
+    for (int z = all.zbegin;  z < all.zend && ok;  z += stripd) {
+        int zend = std::min (z + stripd, all.zend);
+        for (int y = all.ybegin;  y < all.yend && ok;  y += striph) {
+            int yend = std::min (y + striph, all.yend);
+            if (inspec.tile_width)
+                ok = in->read_tiles (all.xbegin, all.xend, y, yend, z, zend,
+                                     chbegin, chend, m_spec.format, &tmp[0],
+                                     xstride, ystride, zstride);
+            else
+                ok = in->read_scanlines (y, yend, z, chbegin, chend,
+                                         m_spec.format, &tmp[0],
+                                         xstride, ystride);
+            if (ok)
+                ok = convert_local (ROI (all.xbegin, all.xend, y, yend,
+                                         z, zend, 0, m_spec.nchannels),
+                                    true, &tmp[0], m_spec.format,
+                                    xstride, ystride, zstride, m_threads);
+        }
+    }
+    return ok;
+}
+
+
+
+bool
+ImageBufImpl::convert_local (ROI roi, bool to_local, void *data,
+                             TypeDesc format, stride_t xstride,
+                             stride_t ystride, stride_t zstride,
+                             int nthreads) const
+{
+    size_t chanoffset = roi.chbegin * m_spec.format.size();
+    if (! m_local_tile_width) {
+        char *local = local_addr (roi.xbegin, roi.ybegin, roi.zbegin) + chanoffset;
+        if (to_local)
+            return parallel_convert_image (roi.nchannels(), roi.width(),
+                                           roi.height(), roi.depth(),
+                                           data, format, xstride, ystride,
+                                           zstride, local, m_spec.format,
+                                           m_xstride, m_ystride, m_zstride,
+                                           -1, -1, nthreads);
+        return parallel_convert_image (roi.nchannels(), roi.width(),
+                                       roi.height(), roi.depth(),
+                                       local, m_spec.format,
+                                       m_xstride, m_ystride, m_zstride,
+                                       data, format, xstride, ystride,
+                                       zstride, -1, -1, nthreads);
+    }
+    atomic_int ok (1);
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI r){
+        for_each_local_tile (*this, *this, r, [&](ROI t){
+            char *local = local_addr (t.xbegin, t.ybegin, t.zbegin) + chanoffset;
+            char *buf = (char *)data + (t.zbegin - roi.zbegin) * zstride
+                      + (t.ybegin - roi.ybegin) * ystride
+                      + (t.xbegin - roi.xbegin) * xstride;
+            bool tok = to_local
+                ? convert_image (t.nchannels(), t.width(), t.height(),
+                                 t.depth(), buf, format, xstride, ystride,
+                                 zstride, local, m_spec.format,
+                                 m_xstride, m_ystride, m_zstride)
+                : convert_image (t.nchannels(), t.width(), t.height(),
+                                 t.depth(), local, m_spec.format,
+                                 m_xstride, m_ystride, m_zstride,
+                                 buf, format, xstride, ystride, zstride);
+            if (! tok)
+                ok = 0;
+        });
+    });
+    return ok != 0;
+}
+
+
+
 bool
 ImageBuf::read (int subimage, int miplevel, bool force, TypeDesc convert,
                 ProgressCallback progress_callback,
@@ -981,10 +1288,30 @@ ImageBuf::write (ImageOutput *out,
     const ImageSpec &bufspec (impl->m_spec);
     const ImageSpec &outspec (out->spec());
     TypeDesc bufformat = spec().format;
-    if (impl->m_localpixels) {
+    if (impl->m_localpixels && ! impl->m_local_tile_width) {
         // In-core pixel buffer for the whole image
-        ok = out->write_image (bufformat, impl->m_localpixels, as, as, as,
+        ok = out->write_image (bufformat, impl->m_localpixels,
+                               impl->m_xstride, impl->m_ystride,
+                               impl->m_zstride,
                                progress_callback, progress_callback_data);
+    } else if (impl->m_localpixels &&
+               outspec.tile_width == impl->m_local_tile_width &&
+               outspec.tile_height == impl->m_local_tile_height &&
+               std::max (1, outspec.tile_depth) == impl->m_local_tile_depth &&
+               outspec.x == bufspec.x && outspec.y == bufspec.y &&
+               outspec.z == bufspec.z && ! impl->m_tile_xoff &&
+               ! impl->m_tile_yoff && ! impl->m_tile_zoff) {
+        // Tile-major pixels in the same tiles as the file: write each
+        // tile straight from memory
+        for_each_local_tile (*impl, *impl, get_roi (bufspec), [&](ROI t){
+            if (ok)
+                ok = out->write_tiles (t.xbegin, t.xend, t.ybegin, t.yend,
+                                       t.zbegin, t.zend, bufformat,
+                                       impl->local_addr (t.xbegin, t.ybegin,
+                                                         t.zbegin),
+                                       impl->m_xstride, impl->m_ystride,
+                                       impl->m_zstride);
+        });
     } else if (deep()) {
         // Deep image record
         ok = out->write_deep_image (impl->m_deepdata);
@@ -992,7 +1319,8 @@ ImageBuf::write (ImageOutput *out,
         // The image we want to write is backed by ImageCache -- we must be
         // immediately writing out a file from disk, possibly with file
         // format or data format conversion, but without any ImageBufAlgo
-        // functions having been applied.
+        // functions having been applied -- or is tile-major in memory, in
+        // tiles that don't match the file's.
         const imagesize_t budget = 1024*1024*64; // 64 MB
         imagesize_t imagesize = bufspec.image_bytes();
         if (imagesize <= budget) {
@@ -1286,6 +1614,46 @@ ImageBuf::localpixels () const
 
 
 
+stride_t
+ImageBuf::pixel_stride () const
+{
+    impl()->validate_pixels ();
+    return impl()->m_xstride;
+}
+
+
+
+stride_t
+ImageBuf::scanline_stride () const
+{
+    impl()->validate_pixels ();
+    return impl()->m_ystride;
+}
+
+
+
+stride_t
+ImageBuf::z_stride () const
+{
+    impl()->validate_pixels ();
+    return impl()->m_zstride;
+}
+
+
+
+bool
+ImageBuf::contiguous () const
+{
+    const ImageBufImpl *impl = this->impl();
+    impl->validate_pixels ();
+    return impl->m_localpixels && ! impl->m_local_tile_width &&
+           impl->m_xstride == stride_t(impl->m_pixel_bytes) &&
+           impl->m_ystride == stride_t(impl->m_scanline_bytes) &&
+           impl->m_zstride == stride_t(impl->m_plane_bytes);
+}
+
+
+
 bool
 ImageBuf::cachedpixels () const
 {
@@ -1361,19 +1729,25 @@ copy_pixels_impl (ImageBuf &dst, const ImageBuf &src, ROI roi, int nthreads=0)
         if (is_same<D,S>::value) {
             // If both bufs are the same type, just directly copy the values
             if (src.localpixels() && roi.chbegin == 0 &&
-                roi.chend == dst.nchannels() && roi.chend == src.nchannels()) {
+                roi.chend == dst.nchannels() && roi.chend == src.nchannels() &&
+                src.pixel_stride() == stride_t(src.spec().pixel_bytes()) &&
+                dst.pixel_stride() == stride_t(dst.spec().pixel_bytes())) {
                 // Extra shortcut -- totally local pixels for src, copying all
-                // channels, so we can copy memory around line by line, rather
-                // than value by value.
-                int nxvalues = roi.width() * dst.nchannels();
+                // channels, so we can copy memory around line by line (or
+                // the part of a line within one tile, for tile-major
+                // pixels), rather than value by value.
                 for (int z = roi.zbegin; z < roi.zend; ++z)
-                    for (int y = roi.ybegin; y < roi.yend; ++y) {
-                        D *draw = (D *) dst.pixeladdr (roi.xbegin, y, z);
-                        const S *sraw = (const S *) src.pixeladdr (roi.xbegin, y, z);
-                        DASSERT (draw && sraw);
-                        for (int x = 0; x < nxvalues; ++x)
-                            draw[x] = sraw[x];
-                    }
+                    for (int y = roi.ybegin; y < roi.yend; ++y)
+                        for (int x = roi.xbegin, xend; x < roi.xend; x = xend) {
+                            xend = std::min (roi.xend,
+                                       std::min (src.local_tile (x, y, z).xend,
+                                                 dst.local_tile (x, y, z).xend));
+                            D *draw = (D *) dst.pixeladdr (x, y, z);
+                            const S *sraw = (const S *) src.pixeladdr (x, y, z);
+                            DASSERT (draw && sraw);
+                            for (int i = 0, n = (xend-x) * nchannels; i < n; ++i)
+                                draw[i] = sraw[i];
+                        }
             } else {
                 ImageBuf::Iterator<D,D> d (dst, roi);
                 ImageBuf::ConstIterator<D,D> s (src, roi);
@@ -1460,6 +1834,185 @@ ImageBuf::copy (const ImageBuf &src)
 
 
 
+bool
+ImageBuf::make_view (const ImageBuf &src, ROI roi)
+{
+    if (this == &src) {
+        error ("make_view: an ImageBuf can't be a view of itself");
+        return false;
+    }
+    const ImageBufImpl *s = src.impl();
+    s->validate_pixels ();
+    if (! s->m_localpixels || s->m_spec.deep) {
+        error ("make_view: %s", s->m_spec.deep ? "deep images can't be viewed"
+                                : "the source pixels are not in local memory");
+        return false;
+    }
+    const ImageSpec &srcspec (s->m_spec);
+    if (! roi.defined())
+        roi = get_roi (srcspec);
+    roi.chend = std::min (roi.chend, srcspec.nchannels);
+    if (roi.npixels() == 0 || roi.nchannels() <= 0 || ! src.contains_roi (roi)) {
+        error ("make_view: region is not within the source image");
+        return false;
+    }
+
+    // The view's spec is src's, narrowed to roi.
+    ImageSpec spec = srcspec;
+    set_roi (spec, roi);
+    spec.nchannels = roi.nchannels();
+    spec.channelformats.clear ();
+    if (int(spec.channelnames.size()) >= roi.chend)
+        spec.channelnames.assign (srcspec.channelnames.begin()+roi.chbegin,
+                                  srcspec.channelnames.begin()+roi.chend);
+    else
+        spec.default_channel_names ();
+    spec.alpha_channel = (srcspec.alpha_channel >= roi.chbegin &&
+                          srcspec.alpha_channel < roi.chend)
+                       ? srcspec.alpha_channel - roi.chbegin : -1;
+    spec.z_channel = (srcspec.z_channel >= roi.chbegin &&
+                      srcspec.z_channel < roi.chend)
+                   ? srcspec.z_channel - roi.chbegin : -1;
+    if (roi != src.roi()) {
+        // Any hash of src's pixels doesn't describe a part of them
+        spec.erase_attribute ("oiio:SHA-1");
+        spec.erase_attribute ("oiio:PixelHash");
+    }
+
+    // Tile-major pixels are addressed from the start of the tile grid,
+    // others from the view's first pixel.
+    char *base = s->m_local_tile_width ? s->m_localpixels
+               : s->local_addr (roi.xbegin, roi.ybegin, roi.zbegin);
+    base += roi.chbegin * srcspec.format.size();
+    std::shared_ptr<char> owner = s->m_pixels;
+    int nthreads = s->threads();
+    float pixelaspect = s->m_pixelaspect;
+
+    // Now turn ourselves into the view
+    ImageBufImpl *impl = this->impl();
+    impl->clear ();
+    impl->m_spec = spec;
+    impl->m_nativespec = spec;
+    impl->m_pixels = owner;
+    impl->m_localpixels = base;
+    impl->m_view = true;
+    impl->m_storage = APPBUFFER;
+    impl->m_pixel_bytes = spec.pixel_bytes();
+    impl->m_scanline_bytes = spec.scanline_bytes();
+    impl->m_plane_bytes = clamped_mult64 (impl->m_scanline_bytes,
+                                          (imagesize_t)spec.height);
+    impl->copy_layout (*s);
+    impl->m_tile_xoff += roi.xbegin - srcspec.x;
+    impl->m_tile_yoff += roi.ybegin - srcspec.y;
+    impl->m_tile_zoff += roi.zbegin - srcspec.z;
+    impl->m_blackpixel.resize (round_to_multiple (impl->m_pixel_bytes,
+                                                  OIIO_SIMD_MAX_SIZE_BYTES), 0);
+    impl->m_spec_valid = true;
+    impl->m_pixels_valid = true;
+    impl->m_pixelaspect = pixelaspect;
+    impl->m_threads = nthreads;
+    return true;
+}
+
+
+
+bool
+ImageBuf::is_view () const
+{
+    return impl()->m_view;
+}
+
+
+
+bool
+ImageBuf::set_local_tiles (int width, int height, int depth)
+{
+    ImageBufImpl *impl = this->impl();
+    impl->validate_pixels ();
+    if (width <= 0)
+        width = height = depth = 0;
+    else {
+        height = std::max (1, height);
+        depth = std::max (1, depth);
+    }
+    if (width == impl->m_local_tile_width &&
+        height == impl->m_local_tile_height &&
+        depth == impl->m_local_tile_depth)
+        return true;
+    if (impl->m_view || impl->m_storage == APPBUFFER || impl->m_spec.deep) {
+        error ("set_local_tiles: can't change the pixel layout of %s",
+               impl->m_view ? "a view" : impl->m_spec.deep ? "a deep image"
+                                       : "an application buffer");
+        return false;
+    }
+    if (! impl->m_localpixels) {
+        // Takes effect when the pixels are read or allocated
+        impl->m_local_tile_width = width;
+        impl->m_local_tile_height = height;
+        impl->m_local_tile_depth = depth;
+        impl->set_strides ();
+        return true;
+    }
+    // Rearrange the pixels we have, keeping the old ones alive (and
+    // described by a stand-in) while they are copied.
+    ImageBufImpl old ("", 0, 0, NULL, &impl->m_spec, impl->m_localpixels,
+                      NULL);
+    old.copy_layout (*impl);
+    std::shared_ptr<char> keep = impl->m_pixels;
+    impl->m_local_tile_width = width;
+    impl->m_local_tile_height = height;
+    impl->m_local_tile_depth = depth;
+    impl->realloc ();
+    impl->copy_local_pixels (old);
+    return true;
+}
+
+
+
+int
+ImageBuf::local_tile_width () const
+{
+    return impl()->m_local_tile_width;
+}
+
+
+
+int
+ImageBuf::local_tile_height () const
+{
+    return impl()->m_local_tile_height;
+}
+
+
+
+int
+ImageBuf::local_tile_depth () const
+{
+    return impl()->m_local_tile_depth;
+}
+
+
+
+ROI
+ImageBuf::local_tile (int x, int y, int z) const
+{
+    const ImageBufImpl *impl = this->impl();
+    ROI r = roi ();
+    if (impl->m_local_tile_width) {
+        int xend = impl->tile_xend (x), yend = impl->tile_yend (y),
+            zend = impl->tile_zend (z);
+        r.xbegin = std::max (r.xbegin, xend - impl->m_local_tile_width);
+        r.ybegin = std::max (r.ybegin, yend - impl->m_local_tile_height);
+        r.zbegin = std::max (r.zbegin, zend - impl->m_local_tile_depth);
+        r.xend = std::min (r.xend, xend);
+        r.yend = std::min (r.yend, yend);
+        r.zend = std::min (r.zend, zend);
+    }
+    return r;
+}
+
+
+
 template<typename T>
 static inline float getchannel_ (const ImageBuf &buf, int x, int y, int z,
                                  int c, ImageBuf::WrapMode wrap)
@@ -1715,6 +2268,24 @@ get_pixels_ (const ImageBuf &buf, ROI whole_roi, ROI roi, void *r_,
 
 
 
+// Can pixels of the given type be copied straight between this local
+// buffer and the user's memory by convert_image, rather than one channel
+// at a time through an iterator?
+static bool
+use_convert_image (const ImageBuf &buf, ROI roi, TypeDesc format)
+{
+    ROI data = buf.roi();
+    return buf.localpixels() &&
+           roi.xbegin >= data.xbegin && roi.xend <= data.xend &&
+           roi.ybegin >= data.ybegin && roi.yend <= data.yend &&
+           roi.zbegin >= data.zbegin && roi.zend <= data.zend &&
+           roi.chbegin >= 0 && roi.chend <= data.chend &&
+           (format == buf.spec().format ||
+            pvt::has_direct_conversion (buf.spec().format, format));
+}
+
+
+
 bool
 ImageBuf::get_pixels (ROI roi, TypeDesc format, void *result,
                       stride_t xstride, stride_t ystride,
@@ -1725,6 +2296,9 @@ ImageBuf::get_pixels (ROI roi, TypeDesc format, void *result,
     roi.chend = std::min (roi.chend, nchannels());
     ImageSpec::auto_stride (xstride, ystride, zstride, format.size(),
                             roi.nchannels(), roi.width(), roi.height());
+    if (use_convert_image (*this, roi, format))
+        return impl()->convert_local (roi, false, result, format,
+                                      xstride, ystride, zstride, threads());
     bool ok;
     OIIO_DISPATCH_TYPES2 (ok, "get_pixels", get_pixels_,
                           format, spec().format, *this, roi, roi,
@@ -1813,6 +2387,12 @@ ImageBuf::set_pixels (ROI roi, TypeDesc format, const void *data,
     if (! roi.defined())
         roi = this->roi();
     roi.chend = std::min (roi.chend, nchannels());
+    if (use_convert_image (*this, roi, format)) {
+        ImageSpec::auto_stride (xstride, ystride, zstride, format.size(),
+                                roi.nchannels(), roi.width(), roi.height());
+        return impl()->convert_local (roi, true, (void *)data, format,
+                                      xstride, ystride, zstride, threads());
+    }
     OIIO_DISPATCH_TYPES2 (ok, "set_pixels", set_pixels_,
                           spec().format, format, *this, roi,
                           data, xstride, ystride, zstride);
@@ -2165,7 +2745,7 @@ ImageBuf::set_roi_full (const ROI &newroi)
 bool
 ImageBuf::contains_roi (ROI roi) const
 {
-    ROI myroi = roi;
+    ROI myroi = this->roi();
     return (roi.defined() && myroi.defined() &&
             roi.xbegin >= myroi.xbegin && roi.xend <= myroi.xend &&
             roi.ybegin >= myroi.ybegin && roi.yend <= myroi.yend &&
@@ -2181,12 +2761,7 @@ ImageBufImpl::pixeladdr (int x, int y, int z) const
     if (cachedpixels())
         return NULL;
     validate_pixels ();
-    x -= m_spec.x;
-    y -= m_spec.y;
-    z -= m_spec.z;
-    size_t p = y * m_scanline_bytes + x * m_pixel_bytes
-             + z * m_plane_bytes;
-    return &(m_localpixels[p]);
+    return local_addr (x, y, z);
 }
 
 
@@ -2197,12 +2772,7 @@ ImageBufImpl::pixeladdr (int x, int y, int z)
     validate_pixels ();
     if (cachedpixels())
         return NULL;
-    x -= m_spec.x;
-    y -= m_spec.y;
-    z -= m_spec.z;
-    size_t p = y * m_scanline_bytes + x * m_pixel_bytes
-             + z * m_plane_bytes;
-    return &(m_localpixels[p]);
+    return local_addr (x, y, z);
 }
 
 
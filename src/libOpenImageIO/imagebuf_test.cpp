@@ -33,8 +33,11 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/timer.h>
 #include <OpenImageIO/unittest.h>
 
+#include <cstring>
 #include <iostream>
 
 using namespace OIIO;
@@ -253,6 +256,121 @@ void test_empty_iterator ()
 
 
 
+// Walk ROI roi of A with a ConstSpanIterator, checking every value
+// against what a ConstIterator (with the default black wrap) says, and
+// that the spans tile each scanline exactly. Return the number of spans.
+static int
+span_check (const ImageBuf &A, ROI roi)
+{
+    int nspans = 0;
+    ImageBuf::ConstIterator<float> p (A, roi);
+    int x = roi.xbegin, y = roi.ybegin;
+    for (ImageBuf::ConstSpanIterator<float> s (A, roi);  ! s.done();  ++s) {
+        ++nspans;
+        OIIO_CHECK_EQUAL (s.x(), x);
+        OIIO_CHECK_EQUAL (s.y(), y);
+        OIIO_CHECK_ASSERT (s.npixels() > 0 && s.xend() <= roi.xend);
+        bool inside = (s.x() >= A.xbegin() && s.x() < A.xend() &&
+                       s.y() >= A.ybegin() && s.y() < A.yend());
+        OIIO_CHECK_EQUAL (s.exists(), inside);
+        const float *v = s.data();
+        for (int i = 0;  i < s.npixels();  ++i, ++p, v += s.stride())
+            for (int c = 0;  c < A.nchannels();  ++c)
+                OIIO_CHECK_EQUAL (v[c], p[c]);
+        x = s.xend();
+        if (x == roi.xend) {
+            x = roi.xbegin;
+            ++y;
+        }
+    }
+    OIIO_CHECK_ASSERT (p.done());
+    OIIO_CHECK_EQUAL (y, roi.yend);
+    return nspans;
+}
+
+
+
+void
+test_span_iterator ()
+{
+    std::cout << "\nTesting span iterators\n";
+    const int xres = 40, yres = 24, nchans = 3;
+    ImageSpec spec (xres, yres, nchans, TypeDesc::FLOAT);
+    ImageBuf A (spec);
+    for (ImageBuf::Iterator<float> p (A);  ! p.done();  ++p)
+        for (int c = 0;  c < nchans;  ++c)
+            p[c] = p.x() + 100.0f * p.y() + 0.25f * c;
+
+    // In-memory: one span per scanline, plus one on each side that
+    // sticks out of the data window, plus whole rows outside of it.
+    OIIO_CHECK_EQUAL (span_check (A, A.roi()), yres);
+    OIIO_CHECK_EQUAL (span_check (A, ROI (-3, xres+2, -1, yres+1)),
+                      3*yres + 2);
+
+    // ImageCache-backed: spans also break at tile boundaries.
+    A.set_write_tiles (16, 16);
+    A.write ("span_imagebuf_test.tif");
+    ImageCache *ic = ImageCache::create (false);
+    {
+        ImageBuf B ("span_imagebuf_test.tif", ic);
+        B.read (0, 0, false, TypeDesc::FLOAT);
+        OIIO_CHECK_EQUAL (span_check (B, B.roi()), 3*yres);
+        span_check (B, ROI (-3, xres+2, -1, yres+1));
+        span_check (B, ROI (5, 20, 3, 20));
+    }
+    ImageCache::destroy (ic);
+    Filesystem::remove ("span_imagebuf_test.tif");
+
+    // Writing through a SpanIterator
+    ImageBuf R (ImageSpec (xres, yres, nchans, TypeDesc::FLOAT));
+    for (ImageBuf::SpanIterator<float> s (R, ROI (-2, 10, 0, 2));  ! s.done();  ++s) {
+        if (! s.exists())
+            continue;
+        float *v = s.data();
+        for (int i = 0;  i < s.npixels();  ++i, v += s.stride())
+            v[0] = 1.0f;
+    }
+    OIIO_CHECK_EQUAL (R.getchannel (0, 0, 0, 0), 1.0f);
+    OIIO_CHECK_EQUAL (R.getchannel (9, 1, 0, 0), 1.0f);
+    OIIO_CHECK_EQUAL (R.getchannel (10, 1, 0, 0), 0.0f);
+    OIIO_CHECK_EQUAL (R.getchannel (0, 2, 0, 0), 0.0f);
+}
+
+
+
+// Microbenchmark: the per-pixel cost of reading an image through
+// ConstIterator versus ConstSpanIterator.
+void
+time_span_iterator ()
+{
+    const int xres = 1920, yres = 1080, nchans = 4;
+    ImageBuf A (ImageSpec (xres, yres, nchans, TypeDesc::FLOAT));
+    ImageBufAlgo::zero (A);
+    float sum = 0.0f;
+    auto iter = [&](){
+        for (ImageBuf::ConstIterator<float> p (A);  ! p.done();  ++p)
+            for (int c = 0;  c < nchans;  ++c)
+                sum += p[c];
+    };
+    auto spans = [&](){
+        for (ImageBuf::ConstSpanIterator<float> s (A);  ! s.done();  ++s) {
+            const float *v = s.data();
+            for (int i = 0, n = s.npixels()*nchans;  i < n;  ++i)
+                sum += v[i];
+        }
+    };
+    double npixels = double(xres) * yres;
+    double t = time_trial (iter, 3, 5) / 5;
+    std::cout << Strutil::format ("  ConstIterator:     %.2f ns/pixel\n",
+                                  1.0e9 * t / npixels);
+    t = time_trial (spans, 3, 5) / 5;
+    std::cout << Strutil::format ("  ConstSpanIterator: %.2f ns/pixel\n",
+                                  1.0e9 * t / npixels);
+    OIIO_CHECK_EQUAL (sum, 0.0f);
+}
+
+
+
 void
 print (const ImageBuf &A)
 {
@@ -323,6 +441,255 @@ test_read_channel_subset ()
 
 
 
+void
+test_view ()
+{
+    std::cout << "\nTesting ImageBuf views\n";
+    const int xres = 16, yres = 12, nchans = 4;
+    ImageBuf A (ImageSpec (xres, yres, nchans, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p (A);  ! p.done();  ++p)
+        for (int c = 0;  c < nchans;  ++c)
+            p[c] = p.x() + 100.0f * p.y() + 0.25f * c;
+
+    // View channels [1,3) of a window of A
+    ROI roi (3, 11, 2, 9, 0, 1, 1, 3);
+    ImageBuf V;
+    OIIO_CHECK_ASSERT (V.make_view (A, roi));
+    OIIO_CHECK_ASSERT (V.is_view ());
+    OIIO_CHECK_EQUAL (V.storage(), ImageBuf::APPBUFFER);
+    OIIO_CHECK_EQUAL (V.roi(), ROI (3, 11, 2, 9, 0, 1, 0, 2));
+    OIIO_CHECK_EQUAL (V.spec().channelnames[0], "G");
+    OIIO_CHECK_EQUAL (V.spec().channelnames[1], "B");
+    OIIO_CHECK_EQUAL (V.spec().alpha_channel, -1);
+    OIIO_CHECK_EQUAL (V.pixel_stride(), stride_t(A.spec().pixel_bytes()));
+    OIIO_CHECK_ASSERT (A.contiguous() && ! V.contiguous());
+    OIIO_CHECK_EQUAL (V.pixeladdr (3, 2),
+                      (char *)A.pixeladdr (3, 2) + sizeof(float));
+    for (ImageBuf::ConstIterator<float> p (V);  ! p.done();  ++p)
+        for (int c = 0;  c < 2;  ++c)
+            OIIO_CHECK_EQUAL (p[c], A.getchannel (p.x(), p.y(), 0, c+1));
+    span_check (V, V.roi());
+    span_check (V, ROI (0, xres, 0, yres));
+
+    // get_pixels from the view
+    float pixels[8*7*2];
+    V.get_pixels (V.roi(), TypeDesc::FLOAT, pixels);
+    OIIO_CHECK_EQUAL (pixels[0], A.getchannel (3, 2, 0, 1));
+    OIIO_CHECK_EQUAL (pixels[8*7*2-1], A.getchannel (10, 8, 0, 2));
+
+    // IBA functions take views like any other image
+    ImageBuf Ccrop, C, S;
+    ImageBufAlgo::crop (Ccrop, A, ROI (3, 11, 2, 9));
+    int GB[] = { 1, 2 };
+    ImageBufAlgo::channels (C, Ccrop, 2, GB);
+    ImageBufAlgo::add (S, V, 1.0f);
+    for (ImageBuf::ConstIterator<float> p (S);  ! p.done();  ++p)
+        for (int c = 0;  c < 2;  ++c)
+            OIIO_CHECK_EQUAL (p[c], C.getchannel (p.x(), p.y(), 0, c) + 1.0f);
+    ImageBufAlgo::CompareResults cr;
+    ImageBufAlgo::compare (V, C, 0.0f, 0.0f, cr);
+    OIIO_CHECK_EQUAL (cr.nfail, 0);
+    OIIO_CHECK_EQUAL (ImageBufAlgo::computePixelHashSHA1 (V),
+                      ImageBufAlgo::computePixelHashSHA1 (C));
+
+    // Writing to the view writes to A
+    V.setpixel (4, 3, 0, (const float *)pixels);
+    OIIO_CHECK_EQUAL (A.getchannel (4, 3, 0, 1), pixels[0]);
+
+    // A copy of a view owns its pixels
+    ImageBuf D (V);
+    OIIO_CHECK_ASSERT (! D.is_view() && D.contiguous());
+    OIIO_CHECK_EQUAL (D.storage(), ImageBuf::LOCALBUFFER);
+    OIIO_CHECK_EQUAL (D.getchannel (10, 8, 0, 1), V.getchannel (10, 8, 0, 1));
+
+    // The view keeps the pixels alive after A lets go of them
+    float before = V.getchannel (10, 8, 0, 1);
+    A.clear ();
+    OIIO_CHECK_EQUAL (V.getchannel (10, 8, 0, 1), before);
+
+    // Regions outside the source can't be viewed
+    ImageBuf W;
+    OIIO_CHECK_ASSERT (! W.make_view (V, ROI (0, 8, 0, 8)));
+    OIIO_CHECK_ASSERT (W.has_error());
+    W.geterror ();
+}
+
+
+
+// Are A and B the same size with the same pixel values?
+static bool
+same_pixels (const ImageBuf &A, const ImageBuf &B)
+{
+    ImageBufAlgo::CompareResults cr;
+    return A.roi() == B.roi() &&
+           ImageBufAlgo::compare (A, B, 0.0f, 0.0f, cr) && cr.nfail == 0;
+}
+
+
+
+void
+test_local_tiles ()
+{
+    std::cout << "\nTesting tile-major ImageBuf pixels\n";
+    // Sizes that aren't multiples of the tile sizes, and a data window
+    // that doesn't start at the origin
+    const int xres = 45, yres = 37, nchans = 3;
+    ImageSpec spec (xres, yres, nchans, TypeDesc::FLOAT);
+    spec.x = 5;  spec.y = -3;
+    ImageBuf A (spec);
+    for (ImageBuf::Iterator<float> p (A);  ! p.done();  ++p)
+        for (int c = 0;  c < nchans;  ++c)
+            p[c] = p.x() + 100.0f * p.y() + 0.25f * c;
+
+    // Power-of-2 tiles take a different addressing path than others
+    static int tilesizes[][2] = { { 16, 8 }, { 12, 10 }, { 64, 64 } };
+    for (auto &ts : tilesizes) {
+        ImageBuf T (A);
+        OIIO_CHECK_ASSERT (T.set_local_tiles (ts[0], ts[1]));
+        OIIO_CHECK_EQUAL (T.local_tile_width(), ts[0]);
+        OIIO_CHECK_EQUAL (T.local_tile_height(), ts[1]);
+        OIIO_CHECK_EQUAL (T.local_tile_depth(), 1);
+        OIIO_CHECK_ASSERT (! T.contiguous() && T.localpixels());
+        OIIO_CHECK_EQUAL (T.local_tile (6, -3),
+                          ROI (5, std::min (5+ts[0], 50), -3,
+                               std::min (-3+ts[1], 34), 0, 1, 0, nchans));
+        OIIO_CHECK_EQUAL (T.scanline_stride(),
+                          stride_t(ts[0] * A.spec().pixel_bytes()));
+        OIIO_CHECK_ASSERT (same_pixels (A, T));
+        span_check (T, T.roi());
+        span_check (T, ROI (0, 60, -5, 40));
+
+        // Whole-image and partial get_pixels, then set_pixels back
+        std::vector<float> a (xres*yres*nchans), t (xres*yres*nchans);
+        A.get_pixels (A.roi(), TypeDesc::FLOAT, &a[0]);
+        T.get_pixels (T.roi(), TypeDesc::FLOAT, &t[0]);
+        OIIO_CHECK_ASSERT (a == t);
+        ROI part (9, 40, 1, 30, 0, 1, 1, 3);
+        T.get_pixels (part, TypeDesc::FLOAT, &t[0]);
+        OIIO_CHECK_EQUAL (t[0], A.getchannel (9, 1, 0, 1));
+        OIIO_CHECK_EQUAL (t[(31*29-1)*2+1], A.getchannel (39, 29, 0, 2));
+        ImageBuf U (A);
+        U.set_local_tiles (ts[0], ts[1]);
+        ImageBufAlgo::zero (U);
+        U.set_pixels (U.roi(), TypeDesc::FLOAT, &a[0]);
+        OIIO_CHECK_ASSERT (same_pixels (A, U));
+
+        // Column-heavy operations give the same results either way
+        ImageBuf R1, R2;
+        ImageBufAlgo::transpose (R1, A);
+        ImageBufAlgo::transpose (R2, T);
+        OIIO_CHECK_ASSERT (same_pixels (R1, R2));
+        ImageBufAlgo::rotate90 (R1, A);
+        ImageBufAlgo::rotate90 (R2, T);
+        OIIO_CHECK_ASSERT (same_pixels (R1, R2));
+        ImageBufAlgo::flop (R1, A);
+        ImageBufAlgo::flop (R2, T);
+        OIIO_CHECK_ASSERT (same_pixels (R1, R2));
+        ImageBuf P1 (A), P2 (T);
+        ImageBufAlgo::paste (P1, 20, 10, 0, 0, A);
+        ImageBufAlgo::paste (P2, 20, 10, 0, 0, A);
+        OIIO_CHECK_EQUAL (P2.local_tile_width(), ts[0]);
+        OIIO_CHECK_ASSERT (same_pixels (P1, P2));
+
+        // Views and copies of tile-major pixels
+        ImageBuf V;
+        OIIO_CHECK_ASSERT (V.make_view (T, ROI (13, 31, 4, 27, 0, 1, 1, 3)));
+        for (ImageBuf::ConstIterator<float> p (V);  ! p.done();  ++p)
+            for (int c = 0;  c < 2;  ++c)
+                OIIO_CHECK_EQUAL (p[c], A.getchannel (p.x(), p.y(), 0, c+1));
+        span_check (V, V.roi());
+        ImageBuf C (T);
+        OIIO_CHECK_EQUAL (C.local_tile_width(), ts[0]);
+        OIIO_CHECK_ASSERT (same_pixels (A, C));
+        ImageBuf D (V);
+        OIIO_CHECK_ASSERT (! D.is_view());
+        OIIO_CHECK_ASSERT (same_pixels (V, D));
+        OIIO_CHECK_ASSERT (! V.set_local_tiles (0));
+        V.geterror ();
+
+        // Back to scanline-major
+        OIIO_CHECK_ASSERT (T.set_local_tiles (0));
+        OIIO_CHECK_ASSERT (T.contiguous());
+        OIIO_CHECK_ASSERT (same_pixels (A, T));
+    }
+
+    // Reading a tiled file straight into matching tiles, or into tiles
+    // of another size
+    ImageBuf F (ImageSpec (xres, yres, nchans, TypeDesc::FLOAT));
+    ImageBufAlgo::paste (F, 0, 0, 0, 0, A);
+    F.set_write_tiles (16, 16);
+    F.write ("tiles_imagebuf_test.tif");
+    static int readsizes[][2] = { { 16, 16 }, { 32, 8 } };
+    for (auto &rs : readsizes) {
+        ImageBuf R ("tiles_imagebuf_test.tif");
+        R.set_local_tiles (rs[0], rs[1]);
+        OIIO_CHECK_ASSERT (R.read (0, 0, true, TypeDesc::FLOAT));
+        OIIO_CHECK_EQUAL (R.local_tile_width(), rs[0]);
+        OIIO_CHECK_ASSERT (same_pixels (F, R));
+        // ... and writing it out again
+        R.set_write_tiles (16, 16);
+        R.write ("tiles2_imagebuf_test.tif");
+        ImageBuf R2 ("tiles2_imagebuf_test.tif");
+        OIIO_CHECK_ASSERT (same_pixels (F, R2));
+    }
+    Filesystem::remove ("tiles_imagebuf_test.tif");
+    Filesystem::remove ("tiles2_imagebuf_test.tif");
+}
+
+
+
+// A file whose extension is missing or wrong must still be recognized by
+// its signature, and read the same as when it is named properly.
+void
+test_create_by_signature ()
+{
+    std::cout << "test ImageInput::create by signature\n";
+    ImageBuf A (ImageSpec (16, 8, 3, TypeDesc::UINT8));
+    float red[3] = { 1, 0, 0 }, blue[3] = { 0, 0, 1 };
+    ImageBufAlgo::checker (A, 4, 4, 1, red, blue);
+
+    // Lossless formats that are always built in
+    const char *formats[][2] = { { "tif", "tiff" }, { "exr", "openexr" },
+                                 { "png", "png" }, { "bmp", "bmp" } };
+    for (auto &f : formats) {
+        std::string named = Strutil::format ("sniff_imagebuf_test.%s", f[0]);
+        std::string bare = Strutil::format ("sniff_imagebuf_test_%s", f[0]);
+        std::string misnamed = bare + (strcmp (f[0], "png") ? ".png" : ".tif");
+        OIIO_CHECK_ASSERT (A.write (named));
+        Filesystem::copy (named, bare);
+        Filesystem::copy (named, misnamed);
+        ImageBuf N (named);
+        OIIO_CHECK_ASSERT (N.read ());
+        std::string names[2] = { bare, misnamed };
+        for (auto &name : names) {
+            ImageBuf B (name);
+            OIIO_CHECK_ASSERT (B.read ());
+            OIIO_CHECK_EQUAL (B.file_format_name(), f[1]);
+            ImageBufAlgo::CompareResults cr;
+            ImageBufAlgo::compare (N, B, 0.0f, 0.0f, cr);
+            OIIO_CHECK_EQUAL (cr.nfail, 0);
+            Filesystem::remove (name);
+        }
+        Filesystem::remove (named);
+    }
+
+    // Changing the plugin searchpath rescans the catalog, and must not
+    // lose the plugins already found.
+    std::string oldpath = OIIO::get_string_attribute ("plugin_searchpath");
+    OIIO::attribute ("plugin_searchpath", ".");
+    OIIO_CHECK_EQUAL (OIIO::get_string_attribute ("plugin_searchpath"), ".");
+    OIIO_CHECK_ASSERT (A.write ("sniff_imagebuf_test.tif"));
+    Filesystem::copy ("sniff_imagebuf_test.tif", "sniff_imagebuf_test");
+    ImageBuf B ("sniff_imagebuf_test");
+    OIIO_CHECK_ASSERT (B.read ());
+    OIIO_CHECK_EQUAL (B.file_format_name(), "tiff");
+    OIIO::attribute ("plugin_searchpath", oldpath);
+    Filesystem::remove ("sniff_imagebuf_test.tif");
+    Filesystem::remove ("sniff_imagebuf_test");
+}
+
+
+
 int
 main (int argc, char **argv)
 {
@@ -337,12 +704,17 @@ main (int argc, char **argv)
     iterator_wrap_test<ImageBuf::ConstIterator<float> > (ImageBuf::WrapClamp, "clamp");
     iterator_wrap_test<ImageBuf::ConstIterator<float> > (ImageBuf::WrapPeriodic, "periodic");
     iterator_wrap_test<ImageBuf::ConstIterator<float> > (ImageBuf::WrapMirror, "mirror");
+    test_span_iterator ();
+    time_span_iterator ();
 
     ImageBuf_test_appbuffer ();
     test_open_with_config ();
     test_read_channel_subset ();
 
     test_set_get_pixels ();
+    test_view ();
+    test_local_tiles ();
+    test_create_by_signature ();
 
     Filesystem::remove ("A_imagebuf_test.tif");
     return unit_test_failures;
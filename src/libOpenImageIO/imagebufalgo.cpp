@@ -31,7 +31,11 @@
 #include <OpenEXR/half.h>
 
 #include <cmath>
+#include <complex>
+#include <limits>
+#include <map>
 #include <memory>
+#include <vector>
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -212,14 +216,15 @@ ImageBufAlgo::IBAprep (ROI &roi, ImageBuf *dst, const ImageBuf *A,
             // Since we're altering pixels, be sure that any existing SHA
             // hash of dst's pixel values is erased.
             spec.erase_attribute ("oiio:SHA-1");
+            spec.erase_attribute ("oiio:PixelHash");
             std::string desc = spec.get_string_attribute ("ImageDescription");
             if (desc.size()) {
 #ifdef USE_BOOST_REGEX
-                static boost::regex regex_sha ("SHA-1=[[:xdigit:]]*[ ]*");
+                static boost::regex regex_sha ("(SHA-1|PixelHash)=[[:alnum:]:]*[ ]*");
                 spec.attribute ("ImageDescription",
                                 boost::regex_replace (desc, regex_sha, ""));
 #else
-                static std::regex regex_sha ("SHA-1=[[:xdigit:]]*[ ]*");
+                static std::regex regex_sha ("(SHA-1|PixelHash)=[[:alnum:]:]*[ ]*");
                 spec.attribute ("ImageDescription",
                                 std::regex_replace (desc, regex_sha, ""));
 #endif
@@ -399,6 +404,241 @@ convolve_ (ImageBuf &dst, const ImageBuf &src, const ImageBuf &kernel,
 
 
 
+// Helper for the row-based filters: fill row[] (nc floats per pixel)
+// with the src pixels [xbegin,xend) of scanline y of plane z, channels
+// [chbegin,chend), exactly as a WrapClamp iterator would see them:
+// coordinates are clamped to the display window, and any pixel still
+// outside the data window (for which the iterator's exists() would be
+// false) gets the value 'outside'. srcrow is scratch space.
+static void
+get_clamped_row (const ImageBuf &src, int xbegin, int xend, int y, int z,
+                 int chbegin, int chend, std::vector<float> &srcrow,
+                 float *row, float outside = 0.0f)
+{
+    const ImageSpec &spec (src.spec());
+    int nc = chend - chbegin;
+    y = clamp (y, spec.full_y, spec.full_y + spec.full_height - 1);
+    z = clamp (z, spec.full_z, spec.full_z + spec.full_depth - 1);
+    if (y < spec.y || y >= spec.y + spec.height ||
+        z < spec.z || z >= spec.z + spec.depth) {
+        std::fill (row, row + (xend-xbegin)*nc, outside);
+        return;
+    }
+    srcrow.resize (spec.width * nc);
+    src.get_pixels (ROI (spec.x, spec.x + spec.width, y, y+1, z, z+1,
+                         chbegin, chend),
+                    TypeDesc::FLOAT, &srcrow[0]);
+    for (int x = xbegin;  x < xend;  ++x, row += nc) {
+        int sx = clamp (x, spec.full_x, spec.full_x + spec.full_width - 1);
+        if (sx >= spec.x && sx < spec.x + spec.width)
+            std::copy_n (&srcrow[(sx - spec.x) * nc], nc, row);
+        else
+            std::fill (row, row + nc, outside);
+    }
+}
+
+
+
+// If the (2D, float, local) kernel is the outer product of a column and a
+// row vector -- as are box, gaussian, binomial, and any other kernel made
+// from a separable filter -- return true and store the factors so that
+// K(x,y) == xweights[x-kxbegin] * yweights[y-kybegin].
+static bool
+separable_kernel (const ImageBuf &kernel, std::vector<float> &xweights,
+                  std::vector<float> &yweights)
+{
+    ROI kroi = kernel.roi();
+    if (kroi.depth() != 1)
+        return false;
+    int kw = kroi.width(), kh = kroi.height(), kchans = kernel.nchannels();
+    const float *k = (const float *)kernel.localpixels();
+    // Use the largest value as the pivot for the factorization
+    int px = 0, py = 0;
+    float maxabs = 0.0f;
+    for (int y = 0;  y < kh;  ++y)
+        for (int x = 0;  x < kw;  ++x)
+            if (fabsf (k[(y*kw+x)*kchans]) > maxabs) {
+                maxabs = fabsf (k[(y*kw+x)*kchans]);
+                px = x;  py = y;
+            }
+    if (maxabs == 0.0f)
+        return false;
+    xweights.resize (kw);
+    yweights.resize (kh);
+    float pivot = k[(py*kw+px)*kchans];
+    for (int x = 0;  x < kw;  ++x)
+        xweights[x] = k[(py*kw+x)*kchans];
+    for (int y = 0;  y < kh;  ++y)
+        yweights[y] = k[(y*kw+px)*kchans] / pivot;
+    float tolerance = 1.0e-5f * maxabs;
+    for (int y = 0;  y < kh;  ++y)
+        for (int x = 0;  x < kw;  ++x)
+            if (fabsf (k[(y*kw+x)*kchans] - yweights[y]*xweights[x]) > tolerance)
+                return false;
+    return true;
+}
+
+
+
+// Convolution with a separable kernel, as a horizontal pass (each src
+// scanline filtered just once, into a ring of kh scratch rows) followed
+// by a vertical pass over those rows.
+template<typename DSTTYPE>
+static bool
+convolve_separable_ (ImageBuf &dst, const ImageBuf &src, ROI kroi,
+                     const std::vector<float> &xweights,
+                     const std::vector<float> &yweights,
+                     float scale, ROI roi, int nthreads)
+{
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+        int kw = kroi.width(), kh = kroi.height();
+        int nc = roi.nchannels();
+        int width = roi.width();
+        int rowlen = width * nc;
+        int z = roi.zbegin + kroi.zbegin;
+        std::vector<float> srcrow, padrow ((width + kw - 1) * nc);
+        std::vector<float> ring (kh * rowlen), outrow (rowlen);
+        std::vector<int> ringrow (kh, std::numeric_limits<int>::min());
+        const ImageSpec &srcspec (src.spec());
+
+        ImageBuf::Iterator<DSTTYPE> d (dst, roi);
+        for (int y = roi.ybegin;  y < roi.yend;  ++y) {
+            std::fill (outrow.begin(), outrow.end(), 0.0f);
+            for (int j = 0;  j < kh;  ++j) {
+                float wy = yweights[j];
+                if (wy == 0.0f)
+                    continue;
+                int sy = clamp (y + kroi.ybegin + j, srcspec.full_y,
+                                srcspec.full_y + srcspec.full_height - 1);
+                // The clamped rows under the kernel are at most kh
+                // consecutive rows, so they never share a ring slot.
+                int slot = ((sy % kh) + kh) % kh;
+                float *h = &ring[slot * rowlen];
+                if (ringrow[slot] != sy) {
+                    // Horizontal pass for src row sy
+                    get_clamped_row (src, roi.xbegin + kroi.xbegin,
+                                     roi.xend + kroi.xend - 1, sy, z,
+                                     roi.chbegin, roi.chend, srcrow,
+                                     &padrow[0]);
+                    std::fill (h, h + rowlen, 0.0f);
+                    for (int i = 0;  i < kw;  ++i) {
+                        float wx = xweights[i];
+                        if (wx == 0.0f)
+                            continue;
+                        const float *in = &padrow[i * nc];
+                        for (int k = 0;  k < rowlen;  ++k)
+                            h[k] += wx * in[k];
+                    }
+                    ringrow[slot] = sy;
+                }
+                for (int k = 0;  k < rowlen;  ++k)
+                    outrow[k] += wy * h[k];
+            }
+            const float *o = &outrow[0];
+            for (int x = roi.xbegin;  x < roi.xend;  ++x, ++d)
+                for (int c = roi.chbegin;  c < roi.chend;  ++c, ++o)
+                    d[c] = scale * (*o);
+        }
+    });
+    return true;
+}
+
+
+
+// Smallest n' >= n whose only prime factors are 2, 3 and 5, which kissfft
+// handles most efficiently.
+static int
+fft_friendly_size (int n)
+{
+    for ( ; ; ++n) {
+        int m = n;
+        while (m % 2 == 0) m /= 2;
+        while (m % 3 == 0) m /= 3;
+        while (m % 5 == 0) m /= 5;
+        if (m == 1)
+            return n;
+    }
+}
+
+
+
+// Convolution via the FFT: for big kernels, multiplying spectra beats
+// summing over the kernel for every pixel.
+static bool
+convolve_fft (ImageBuf &dst, const ImageBuf &src, const ImageBuf &kernel,
+              float scale, ROI roi, int nthreads)
+{
+    ROI kroi = kernel.roi();
+    int kw = kroi.width(), kh = kroi.height();
+    int kchans = kernel.nchannels();
+    int nc = roi.nchannels();
+    // Every output pixel only needs src pixels within the kernel's reach,
+    // so a circular convolution over the ROI padded by the kernel size
+    // (rounded up to a fast FFT size) never wraps into results we keep.
+    int pw = fft_friendly_size (roi.width() + kw - 1);
+    int ph = fft_friendly_size (roi.height() + kh - 1);
+    ImageSpec padspec (pw, ph, nc, TypeDesc::FLOAT);
+    ImageBuf P (padspec);
+    ImageBufAlgo::zero (P);
+    ImageBufAlgo::parallel_image (ROI (0, 1, 0, roi.height()+kh-1), nthreads,
+                                  [&](ROI r){
+        std::vector<float> srcrow;
+        for (int j = r.ybegin;  j < r.yend;  ++j)
+            get_clamped_row (src, roi.xbegin + kroi.xbegin,
+                             roi.xend + kroi.xend - 1,
+                             roi.ybegin + kroi.ybegin + j,
+                             roi.zbegin + kroi.zbegin,
+                             roi.chbegin, roi.chend, srcrow,
+                             (float *)P.pixeladdr (0, j));
+    });
+
+    // Kernel spectrum (computed once for all channels)
+    ImageBuf Kpad (ImageSpec (pw, ph, 1, TypeDesc::FLOAT)), Kfft;
+    ImageBufAlgo::zero (Kpad);
+    const float *k = (const float *)kernel.localpixels();
+    for (int y = 0;  y < kh;  ++y)
+        for (int x = 0;  x < kw;  ++x)
+            *(float *)Kpad.pixeladdr (x, y) = k[(y*kw+x)*kchans];
+    if (! ImageBufAlgo::fft (Kfft, Kpad, ROI::All(), nthreads)) {
+        dst.error ("%s", Kfft.geterror());
+        return false;
+    }
+
+    // fft/ifft are unitary, which scales the product of spectra by
+    // 1/sqrt(N); fold that back in along with the kernel normalization.
+    float fftscale = scale * sqrtf (float(pw) * float(ph));
+    for (int c = 0;  c < nc;  ++c) {
+        ImageBuf F, R;
+        ROI proi = get_roi (padspec);
+        proi.chbegin = c;  proi.chend = c+1;
+        if (! ImageBufAlgo::fft (F, P, proi, nthreads)) {
+            dst.error ("%s", F.geterror());
+            return false;
+        }
+        // Our kernel isn't flipped (convolve is really a correlation), so
+        // multiply by the conjugate of the kernel's spectrum.
+        std::complex<float> *f = (std::complex<float> *)F.localpixels();
+        const std::complex<float> *kf = (const std::complex<float> *)Kfft.localpixels();
+        ImageBufAlgo::parallel_image (ROI (0, 1, 0, ph), nthreads, [&](ROI r){
+            for (imagesize_t i = imagesize_t(r.ybegin)*pw, e = imagesize_t(r.yend)*pw;
+                 i < e;  ++i)
+                f[i] *= fftscale * std::conj (kf[i]);
+        });
+        if (! ImageBufAlgo::ifft (R, F, ROI::All(), nthreads)) {
+            dst.error ("%s", R.geterror());
+            return false;
+        }
+        if (! ImageBufAlgo::paste (dst, roi.xbegin, roi.ybegin, roi.zbegin,
+                                   roi.chbegin + c, R,
+                                   ROI (0, roi.width(), 0, roi.height()),
+                                   nthreads))
+            return false;
+    }
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::convolve (ImageBuf &dst, const ImageBuf &src,
                         const ImageBuf &kernel, bool normalize,
@@ -407,13 +647,50 @@ ImageBufAlgo::convolve (ImageBuf &dst, const ImageBuf &src,
     if (! IBAprep (roi, &dst, &src, IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
     bool ok;
-    // Ensure that the kernel is float and in local memory
+    // Ensure that the kernel is float and in contiguous local memory
     const ImageBuf *K = &kernel;
     ImageBuf Ktmp;
-    if (kernel.spec().format != TypeDesc::FLOAT || ! kernel.localpixels()) {
+    if (kernel.spec().format != TypeDesc::FLOAT || ! kernel.contiguous()) {
         Ktmp.copy (kernel, TypeDesc::FLOAT);
         K = &Ktmp;
     }
+
+    // Pick the cheapest method, with a rough cost model (in multiply-adds
+    // per channel): brute force visits every kernel tap for every pixel,
+    // a separable kernel can instead be applied as two 1D passes, and the
+    // FFT costs the same no matter the kernel size, but carries a large
+    // constant for the transforms of the padded image and the kernel.
+    ROI kroi = K->roi();
+    if (kroi.depth() == 1 && roi.depth() == 1) {
+        double npixels = double(roi.width()) * double(roi.height());
+        double taps = double(kroi.width()) * double(kroi.height());
+        double direct_cost = npixels * taps;
+        double padded = double(roi.width() + kroi.width() - 1)
+                      * double(roi.height() + kroi.height() - 1);
+        double fft_cost = 8.0 * padded * std::max (1.0, log2 (padded))
+                        * (2.0 + 1.0 / roi.nchannels());
+        std::vector<float> xweights, yweights;
+        double sep_cost = separable_kernel (*K, xweights, yweights)
+                        ? 2.0 * npixels * (kroi.width() + kroi.height())
+                        : direct_cost;
+
+        float scale = 1.0f;
+        if (normalize) {
+            scale = 0.0f;
+            for (ImageBuf::ConstIterator<float> k (*K); ! k.done(); ++k)
+                scale += k[0];
+            scale = 1.0f / scale;
+        }
+        if (fft_cost < direct_cost && fft_cost < sep_cost)
+            return convolve_fft (dst, src, *K, scale, roi, nthreads);
+        if (sep_cost < direct_cost) {
+            OIIO_DISPATCH_TYPES (ok, "convolve", convolve_separable_,
+                                 dst.spec().format, dst, src, kroi,
+                                 xweights, yweights, scale, roi, nthreads);
+            return ok;
+        }
+    }
+
     OIIO_DISPATCH_COMMON_TYPES2 (ok, "convolve", convolve_,
                           dst.spec().format, src.spec().format,
                           dst, src, *K, normalize, roi, nthreads);
@@ -630,9 +907,10 @@ median_filter_impl (ImageBuf &R, const ImageBuf &A, int width, int height,
                 }
             }
             if (n) {
+                // We only need the middle value, not a full sort
                 int mid = n/2;
                 for (int c = 0;  c < nchannels;  ++c) {
-                    std::sort (chans[c]+0, chans[c]+n);
+                    std::nth_element (chans[c]+0, chans[c]+mid, chans[c]+n);
                     r[c] = chans[c][mid];
                 }
             } else {
@@ -646,6 +924,200 @@ median_filter_impl (ImageBuf &R, const ImageBuf &A, int width, int height,
 
 
 
+// Median filter for 8 bit data, using the constant-time sliding histogram
+// method of Perreault & Hebert ("Median Filtering in Constant Time",
+// 2007). Each column keeps a histogram of the 'height' pixels of the
+// window in that column; moving down a row updates every column
+// histogram by one removal and one addition, and moving right along the
+// row updates the window's histogram by adding one column histogram and
+// subtracting another. The cost per pixel doesn't depend on the window
+// size. Window pixels that don't exist (outside the data window, after
+// clamping to the display window) are left out, as in
+// median_filter_impl.
+static bool
+median_filter_hist8 (ImageBuf &R, const ImageBuf &A, int width, int height,
+                     ROI roi, int nthreads)
+{
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+        const int nbins = 256;
+        int w_2 = std::max (1, width/2);
+        int h_2 = std::max (1, height/2);
+        int nchannels = R.nchannels();
+        int x0 = roi.xbegin - w_2;              // first window column
+        int ncols = roi.width() + width - 1;
+        std::vector<float> srcrow, row (ncols * nchannels);
+        std::vector<float> outrow (roi.width() * nchannels);
+        std::vector<uint16_t> colhist (ncols * nchannels * nbins, 0);
+        std::vector<int> colcount (ncols, 0);
+        std::vector<uint32_t> hist (nchannels * nbins);
+        float binvalue[nbins];
+        for (int b = 0;  b < nbins;  ++b)
+            binvalue[b] = convert_type<unsigned char,float> ((unsigned char)b);
+
+        // Add (delta=1) or remove (delta=-1) scanline y to the columns
+        auto update_columns = [&](int y, int delta) {
+            get_clamped_row (A, x0, x0+ncols, y, roi.zbegin, 0, nchannels,
+                             srcrow, &row[0],
+                             std::numeric_limits<float>::quiet_NaN());
+            for (int i = 0;  i < ncols;  ++i) {
+                const float *p = &row[i*nchannels];
+                if (std::isnan (p[0]))
+                    continue;   // doesn't exist
+                colcount[i] += delta;
+                uint16_t *h = &colhist[i*nchannels*nbins];
+                for (int c = 0;  c < nchannels;  ++c, h += nbins)
+                    h[convert_type<float,unsigned char>(p[c])] += delta;
+            }
+        };
+
+        for (int y = roi.ybegin - h_2;  y < roi.ybegin - h_2 + height;  ++y)
+            update_columns (y, 1);
+        for (int y = roi.ybegin;  y < roi.yend;  ++y) {
+            if (y > roi.ybegin) {
+                update_columns (y-1-h_2, -1);
+                update_columns (y-1-h_2+height, 1);
+            }
+            // Window histogram for the first pixel of the row
+            std::fill (hist.begin(), hist.end(), 0);
+            int n = 0;
+            for (int i = 0;  i < width;  ++i) {
+                n += colcount[i];
+                const uint16_t *h = &colhist[i*nchannels*nbins];
+                for (int b = 0;  b < nchannels*nbins;  ++b)
+                    hist[b] += h[b];
+            }
+            float *out = &outrow[0];
+            for (int x = 0;  x < roi.width();  ++x, out += nchannels) {
+                if (x > 0) {
+                    // Slide right: add the entering column, subtract the
+                    // one leaving.
+                    n += colcount[x+width-1] - colcount[x-1];
+                    const uint16_t *add = &colhist[(x+width-1)*nchannels*nbins];
+                    const uint16_t *sub = &colhist[(x-1)*nchannels*nbins];
+                    for (int b = 0;  b < nchannels*nbins;  ++b)
+                        hist[b] += add[b] - sub[b];
+                }
+                for (int c = 0;  c < nchannels;  ++c) {
+                    out[c] = 0.0f;
+                    if (! n)
+                        continue;
+                    // The median is the value of the sorted element n/2
+                    const uint32_t *h = &hist[c*nbins];
+                    int b = 0;
+                    for (uint32_t sum = h[0];  sum <= uint32_t(n/2);  sum += h[++b])
+                        ;
+                    out[c] = binvalue[b];
+                }
+            }
+            R.set_pixels (ROI (roi.xbegin, roi.xend, y, y+1, roi.zbegin,
+                               roi.zbegin+1, 0, nchannels),
+                          TypeDesc::FLOAT, &outrow[0]);
+        }
+    });
+    return true;
+}
+
+
+
+// Median filter for 16 bit data. A histogram with 64k bins per column
+// would be too big, so instead just the window's histogram slides along
+// each row (Huang's method), in two tiers so that the median can be found
+// by scanning at most 256 coarse plus 256 fine bins. Each step right
+// updates the histogram with the 'height' pixels entering and leaving,
+// rather than re-examining all width*height.
+static bool
+median_filter_hist16 (ImageBuf &R, const ImageBuf &A, int width, int height,
+                      ROI roi, int nthreads)
+{
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+        const int nbins = 65536;
+        int w_2 = std::max (1, width/2);
+        int h_2 = std::max (1, height/2);
+        int nchannels = R.nchannels();
+        int x0 = roi.xbegin - w_2;              // first window column
+        int ncols = roi.width() + width - 1;
+        int rowlen = ncols * nchannels;
+        std::vector<float> srcrow, outrow (roi.width() * nchannels);
+        // Window rows, held as 16 bit bins, or -1 for pixels that don't
+        // exist; a ring of 'height' rows indexed by y.
+        std::vector<int> rows (height * rowlen);
+        std::vector<float> row (rowlen);
+        // The histograms start out empty, and each row leaves them empty
+        // again, so the 64k bins per channel are only cleared once.
+        std::vector<uint32_t> fine (nchannels * nbins), coarse (nchannels * 256);
+
+        auto load_row = [&](int y) {
+            get_clamped_row (A, x0, x0+ncols, y, roi.zbegin, 0, nchannels,
+                             srcrow, &row[0],
+                             std::numeric_limits<float>::quiet_NaN());
+            int *r = &rows[(((y % height) + height) % height) * rowlen];
+            for (int i = 0;  i < rowlen;  ++i)
+                r[i] = std::isnan (row[i]) ? -1
+                     : int (convert_type<float,unsigned short>(row[i]));
+        };
+        int n = 0;
+        auto update_column = [&](int col, int ybegin, int delta) {
+            for (int j = 0;  j < height;  ++j) {
+                int y = ybegin + j;
+                const int *r = &rows[(((y % height) + height) % height) * rowlen
+                                     + col * nchannels];
+                if (r[0] < 0)
+                    continue;   // doesn't exist
+                n += delta;
+                for (int c = 0;  c < nchannels;  ++c) {
+                    fine[c*nbins + r[c]] += delta;
+                    coarse[c*256 + (r[c] >> 8)] += delta;
+                }
+            }
+        };
+
+        for (int y = roi.ybegin - h_2;  y < roi.ybegin - h_2 + height - 1;  ++y)
+            load_row (y);
+        for (int y = roi.ybegin;  y < roi.yend;  ++y) {
+            int ybegin = y - h_2;
+            load_row (ybegin + height - 1);
+            for (int i = 0;  i < width;  ++i)
+                update_column (i, ybegin, 1);
+            float *out = &outrow[0];
+            for (int x = 0;  x < roi.width();  ++x, out += nchannels) {
+                if (x > 0) {
+                    update_column (x-1, ybegin, -1);
+                    update_column (x+width-1, ybegin, 1);
+                }
+                for (int c = 0;  c < nchannels;  ++c) {
+                    out[c] = 0.0f;
+                    if (! n)
+                        continue;
+                    // Find the coarse bin holding sorted element n/2, then
+                    // the fine bin within it.
+                    uint32_t target = uint32_t(n/2);
+                    const uint32_t *ch = &coarse[c*256];
+                    uint32_t sum = 0;
+                    int cb = 0;
+                    while (sum + ch[cb] <= target)
+                        sum += ch[cb++];
+                    const uint32_t *fh = &fine[c*nbins + (cb << 8)];
+                    int fb = 0;
+                    while (sum + fh[fb] <= target)
+                        sum += fh[fb++];
+                    out[c] = convert_type<unsigned short,float> ((unsigned short)((cb << 8) + fb));
+                }
+            }
+            // Take the last window back out of the histograms, which is
+            // much cheaper than clearing them for the next row.
+            for (int i = roi.width() - 1;  i < roi.width() - 1 + width;  ++i)
+                update_column (i, ybegin, -1);
+            DASSERT (n == 0);
+            R.set_pixels (ROI (roi.xbegin, roi.xend, y, y+1, roi.zbegin,
+                               roi.zbegin+1, 0, nchannels),
+                          TypeDesc::FLOAT, &outrow[0]);
+        }
+    });
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::median_filter (ImageBuf &dst, const ImageBuf &src,
                              int width, int height,
@@ -654,6 +1126,17 @@ ImageBufAlgo::median_filter (ImageBuf &dst, const ImageBuf &src,
     if (! IBAprep (roi, &dst, &src,
             IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+
+    // 8 and 16 bit images can use histograms, so that the cost per pixel
+    // no longer grows with the area of the window.
+    if (src.spec().format == TypeDesc::UINT8 && height < 65536)
+        return median_filter_hist8 (dst, src, width, height, roi, nthreads);
+    if (src.spec().format == TypeDesc::UINT16)
+        return median_filter_hist16 (dst, src, width, height, roi, nthreads);
 
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2 (ok, "median_filter",
@@ -667,49 +1150,89 @@ ImageBufAlgo::median_filter (ImageBuf &dst, const ImageBuf &src,
 
 enum MorphOp { MorphDilate, MorphErode };
 
-template<class Rtype, class Atype>
+// Running max (or min) of every run of k consecutive elements of
+// in[0..n-1] (n >= k), spaced by stride, into out[0..n-k], using the
+// van Herk/Gil-Werman algorithm: with the data cut into blocks of k, the
+// max of any run is the max of a block suffix and the next block's
+// prefix, so it takes 3 comparisons per element no matter how big k is.
+// g and h are scratch arrays of at least n*stride elements. Each of the
+// 'stride' interleaved sequences (e.g. channels, or columns of a set of
+// rows) is handled independently.
+template<class CMP>
+static void
+vhgw_running (const float *in, float *out, int n, int k, int stride,
+              float *g, float *h, CMP better)
+{
+    // g: running best from the start of each block, forward
+    for (int i = 0;  i < n;  ++i) {
+        const float *a = in + i*stride;
+        float *gi = g + i*stride;
+        if (i % k == 0)
+            std::copy_n (a, stride, gi);
+        else
+            for (int s = 0;  s < stride;  ++s)
+                gi[s] = better (a[s], gi[s-stride]);
+    }
+    // h: running best to the end of each block, backward
+    for (int i = n-1;  i >= 0;  --i) {
+        const float *a = in + i*stride;
+        float *hi = h + i*stride;
+        if (i == n-1 || (i+1) % k == 0)
+            std::copy_n (a, stride, hi);
+        else
+            for (int s = 0;  s < stride;  ++s)
+                hi[s] = better (a[s], hi[s+stride]);
+    }
+    for (int i = 0;  i <= n-k;  ++i) {
+        const float *hi = h + i*stride;
+        const float *gi = g + (i+k-1)*stride;
+        float *o = out + i*stride;
+        for (int s = 0;  s < stride;  ++s)
+            o[s] = better (hi[s], gi[s]);
+    }
+}
+
+
+
+// Dilate/erode as separable running max/min: a max over the window is
+// the max over its rows of each row's max. Both passes use van
+// Herk/Gil-Werman, so the cost is independent of the window size. Window
+// pixels that don't exist (outside the data window after clamping to the
+// display window) are ignored by giving them the value that can never
+// win, just as they would be skipped by the iterator loop.
+template<class CMP>
 static bool
-morph_impl (ImageBuf &R, const ImageBuf &A, int width, int height,
-            MorphOp op, ROI roi, int nthreads)
+morph_separable (ImageBuf &R, const ImageBuf &A, int width, int height,
+                 float identity, CMP better, ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
-        if (width < 1)
-            width = 1;
-        if (height < 1)
-            height = width;
         int w_2 = std::max (1, width/2);
         int h_2 = std::max (1, height/2);
         int nchannels = R.nchannels();
-        float *vals = OIIO_ALLOCA (float, nchannels);
-        ImageBuf::ConstIterator<Atype> a (A, roi);
-        for (ImageBuf::Iterator<Rtype> r (R, roi);  !r.done();  ++r) {
-            a.rerange (r.x()-w_2, r.x()-w_2+width,
-                       r.y()-h_2, r.y()-h_2+height,
-                       r.z(), r.z()+1, ImageBuf::WrapClamp);
-            if (op == MorphDilate) {
-                for (int c = 0; c < nchannels; ++c)
-                    vals[c] = -std::numeric_limits<float>::max();
-                for ( ;  ! a.done(); ++a) {
-                    if (a.exists()) {
-                        for (int c = 0;  c < nchannels;  ++c)
-                            vals[c] = std::max(vals[c], a[c]);
-                    }
-                }
-            } else if (op == MorphErode) {
-                for (int c = 0; c < nchannels; ++c)
-                    vals[c] = std::numeric_limits<float>::max();
-                for ( ;  ! a.done(); ++a) {
-                    if (a.exists()) {
-                        for (int c = 0;  c < nchannels;  ++c)
-                            vals[c] = std::min(vals[c], a[c]);
-                    }
-                }
-            } else {
-                ASSERT (0 && "Unknown morphological operator");
-            }
-            for (int c = 0;  c < nchannels;  ++c)
-                r[c] = vals[c];
+        int x0 = roi.xbegin - w_2;              // first window column
+        int ncols = roi.width() + width - 1;
+        int nrows = roi.height() + height - 1;
+        int rowlen = roi.width() * nchannels;
+        std::vector<float> srcrow, row (ncols * nchannels);
+        std::vector<float> g (std::max (ncols, nrows * roi.width()) * nchannels);
+        std::vector<float> h (g.size());
+        // Horizontal pass: row max of every scanline the band touches
+        std::vector<float> rowbest (nrows * rowlen);
+        for (int j = 0;  j < nrows;  ++j) {
+            get_clamped_row (A, x0, x0+ncols, roi.ybegin - h_2 + j,
+                             roi.zbegin, 0, nchannels, srcrow, &row[0],
+                             identity);
+            vhgw_running (&row[0], &rowbest[j*rowlen], ncols, width,
+                          nchannels, &g[0], &h[0], better);
         }
+        // Vertical pass: treating each whole row as the unit, so the
+        // inner loops run over contiguous floats.
+        std::vector<float> out (roi.height() * rowlen);
+        vhgw_running (&rowbest[0], &out[0], nrows, height, rowlen,
+                      &g[0], &h[0], better);
+        R.set_pixels (ROI (roi.xbegin, roi.xend, roi.ybegin, roi.yend,
+                           roi.zbegin, roi.zbegin+1, 0, nchannels),
+                      TypeDesc::FLOAT, &out[0]);
     });
     return true;
 }
@@ -723,65 +1246,190 @@ ImageBufAlgo::dilate (ImageBuf &dst, const ImageBuf &src,
     if (! IBAprep (roi, &dst, &src,
             IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
-
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2 (ok, "dilate",
-                                 morph_impl, dst.spec().format,
-                                 src.spec().format, dst, src,
-                                 width, height, MorphDilate, roi, nthreads);
-    return ok;
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+
+    return morph_separable (dst, src, width, height,
+                            -std::numeric_limits<float>::max(),
+                            [](float a, float b){ return std::max (a, b); },
+                            roi, nthreads);
 }
 
 
 
 bool
 ImageBufAlgo::erode (ImageBuf &dst, const ImageBuf &src,
-                      int width, int height, ROI roi, int nthreads)
+                     int width, int height, ROI roi, int nthreads)
 {
     if (! IBAprep (roi, &dst, &src,
             IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+
+    return morph_separable (dst, src, width, height,
+                            std::numeric_limits<float>::max(),
+                            [](float a, float b){ return std::min (a, b); },
+                            roi, nthreads);
+}
 
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2 (ok, "erode",
-                                 morph_impl, dst.spec().format,
-                                 src.spec().format, dst, src,
-                                 width, height, MorphErode, roi, nthreads);
-    return ok;
+
+
+// Setting up a kissfft (factoring the length and computing its twiddle
+// factors) costs about as much as transforming several rows, and fft/ifft
+// get called over and over on same-sized images, so the plans are cached
+// by length and direction.  A "real" plan transforms n real values using
+// a complex transform of half the length (when n is even), and carries
+// the extra twiddles needed to split or merge the two halves.
+struct FFTPlan {
+    FFTPlan (int n, bool inverse, bool real)
+        : fft ((real && !(n & 1)) ? n/2 : n, inverse)
+    {
+        if (real && !(n & 1)) {
+            float phinc = (inverse ? 2.0f : -2.0f) * float(M_PI) / n;
+            twiddle.resize (n/2 + 1);
+            for (int k = 0;  k <= n/2;  ++k)
+                twiddle[k] = std::polar (1.0f, k * phinc);
+        }
+    }
+    kissfft<float> fft;
+    std::vector<std::complex<float> > twiddle;
+};
+
+
+
+static std::shared_ptr<const FFTPlan>
+fft_plan (int n, bool inverse, bool real)
+{
+    static mutex plan_mutex;
+    static std::map<int64_t, std::shared_ptr<const FFTPlan> > plans;
+    int64_t key = (int64_t(n) << 2) | (inverse ? 2 : 0) | (real ? 1 : 0);
+    lock_guard lock (plan_mutex);
+    auto found = plans.find (key);
+    if (found != plans.end())
+        return found->second;
+    if (plans.size() >= 64)
+        plans.clear ();   // Don't let odd sizes accumulate forever
+    std::shared_ptr<const FFTPlan> plan (new FFTPlan (n, inverse, real));
+    plans[key] = plan;
+    return plan;
 }
 
 
 
-// Helper function: fft of the horizontal rows
-static bool
-hfft_ (ImageBuf &dst, const ImageBuf &src, bool inverse, bool unitary,
-       ROI roi, int nthreads)
+// Forward transform of the n real values held in the real parts of
+// row[0..n-1], in place, into the full complex spectrum (times scale).
+// F is the caller's copy of plan.fft (kissfft keeps scratch space, so it
+// can't be shared between threads), and scratch holds at least 2*n
+// complex values.
+static void
+fft_real_row (std::complex<float> *row, int n, const FFTPlan &plan,
+              kissfft<float> &F, std::complex<float> *scratch, float scale)
+{
+    typedef std::complex<float> cpx;
+    if (n & 1) {
+        for (int k = 0;  k < n;  ++k)
+            scratch[k] = cpx (row[k].real(), 0.0f);
+        F.transform (scratch, row);
+        for (int k = 0;  k < n;  ++k)
+            row[k] *= scale;
+        return;
+    }
+    // Pack even/odd samples as one complex sequence of half the length,
+    // transform that, then untangle the spectra of the two halves.
+    int m = n/2;
+    cpx *z = scratch, *Z = scratch + m;
+    for (int k = 0;  k < m;  ++k)
+        z[k] = cpx (row[2*k].real(), row[2*k+1].real());
+    F.transform (z, Z);
+    const cpx *tw = &plan.twiddle[0];
+    for (int k = 0;  k <= m;  ++k) {
+        cpx Zk = Z[k == m ? 0 : k];
+        cpx Zc = std::conj (Z[k == 0 ? 0 : m-k]);
+        cpx even = 0.5f * (Zk + Zc);
+        cpx odd = cpx (0.0f, -0.5f) * (Zk - Zc);
+        row[k] = scale * (even + tw[k] * odd);
+    }
+    for (int k = 1;  k < m;  ++k)
+        row[n-k] = std::conj (row[k]);
+}
+
+
+
+// Inverse transform of the complex row[0..n-1], keeping only the real
+// part of the result (times scale) in out[0..n-1].  The real part is the
+// transform of the row's Hermitian-symmetric part, which for even n is
+// done with a complex transform of half the length.
+static void
+ifft_real_row (const std::complex<float> *row, float *out, int n,
+               const FFTPlan &plan, kissfft<float> &F,
+               std::complex<float> *scratch, float scale)
 {
-    ASSERT (dst.spec().format.basetype == TypeDesc::FLOAT &&
-            src.spec().format.basetype == TypeDesc::FLOAT &&
-            dst.spec().nchannels == 2 && src.spec().nchannels == 2 &&
-            dst.roi() == src.roi() &&
-            (dst.storage() == ImageBuf::LOCALBUFFER || dst.storage() == ImageBuf::APPBUFFER) &&
-            (src.storage() == ImageBuf::LOCALBUFFER || src.storage() == ImageBuf::APPBUFFER)
-        );
+    typedef std::complex<float> cpx;
+    if (n & 1) {
+        F.transform (row, scratch);
+        for (int k = 0;  k < n;  ++k)
+            out[k] = scale * scratch[k].real();
+        return;
+    }
+    int m = n/2;
+    cpx *Z = scratch, *z = scratch + m;
+    const cpx *tw = &plan.twiddle[0];
+    for (int k = 0;  k < m;  ++k) {
+        int j = m - k;
+        cpx Hk = 0.5f * (row[k] + std::conj (row[k == 0 ? 0 : n-k]));
+        cpx Hj = 0.5f * (std::conj (row[j]) + row[n-j]);   // conj(H[j])
+        Z[k] = (Hk + Hj) + cpx (0.0f, 1.0f) * (Hk - Hj) * tw[k];
+    }
+    F.transform (Z, z);
+    for (int k = 0;  k < m;  ++k) {
+        out[2*k]   = scale * z[k].real();
+        out[2*k+1] = scale * z[k].imag();
+    }
+}
 
-    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
-        int width = roi.width();
-        float rescale = sqrtf (1.0f / width);
-        kissfft<float> F (width, inverse);
-        for (int z = roi.zbegin;  z < roi.zend;  ++z) {
-            for (int y = roi.ybegin;  y < roi.yend;  ++y) {
-                std::complex<float> *s, *d;
-                s = (std::complex<float> *)src.pixeladdr(roi.xbegin, y, z);
-                d = (std::complex<float> *)dst.pixeladdr(roi.xbegin, y, z);
-                F.transform (s, d);
-                if (unitary)
-                    for (int x = 0;  x < width;  ++x)
-                        d[x] *= rescale;
+
+
+// In-place complex transform of columns [0,ncols) of a width x height
+// complex buffer.  Threads split the columns, and each works on blocks
+// of adjacent columns at a time: gathering a block reads short runs of
+// every row (rather than striding down the image once per column), the
+// columns are transformed contiguously, and the block is scattered back.
+static void
+fft_columns (std::complex<float> *data, int width, int height, int ncols,
+             bool inverse, float scale, int nthreads)
+{
+    typedef std::complex<float> cpx;
+    std::shared_ptr<const FFTPlan> plan = fft_plan (height, inverse, false);
+    ImageBufAlgo::parallel_image_options opt (nthreads, ImageBufAlgo::Split_X);
+    ImageBufAlgo::parallel_image (ROI (0, ncols, 0, height), opt, [&](ROI roi){
+        const int blocksize = 16;
+        kissfft<float> F (plan->fft);
+        std::vector<cpx> block (blocksize * height), col (height);
+        for (int x0 = roi.xbegin;  x0 < roi.xend;  x0 += blocksize) {
+            int nb = std::min (blocksize, roi.xend - x0);
+            for (int y = 0;  y < height;  ++y) {
+                const cpx *d = data + imagesize_t(y)*width + x0;
+                for (int i = 0;  i < nb;  ++i)
+                    block[i*height+y] = d[i];
+            }
+            for (int i = 0;  i < nb;  ++i) {
+                cpx *b = &block[i*height];
+                F.transform (b, &col[0]);
+                for (int y = 0;  y < height;  ++y)
+                    b[y] = scale * col[y];
+            }
+            for (int y = 0;  y < height;  ++y) {
+                cpx *d = data + imagesize_t(y)*width + x0;
+                for (int i = 0;  i < nb;  ++i)
+                    d[i] = block[i*height+y];
             }
         }
     });
-    return true;
 }
 
 
@@ -813,43 +1461,50 @@ ImageBufAlgo::fft (ImageBuf &dst, const ImageBuf &src,
     spec.channelnames.emplace_back("real");
     spec.channelnames.emplace_back("imag");
 
-    // And a spec that describes the transposed intermediate
-    ImageSpec specT = spec;
-    std::swap (specT.width, specT.height);
-    std::swap (specT.full_width, specT.full_height);
-
     // Resize dst
     dst.reset (dst.name(), spec);
 
-    // Copy src to a 2-channel (for "complex") float buffer
-    ImageBuf A (spec);
-    if (src.nchannels() < 2) {
-        // If we're pasting fewer than 2 channels, zero out channel 1.
-        ROI r = roi;
-        r.chbegin = 1; r.chend = 2;
-        zero (A, r);
-    }
-    if (! ImageBufAlgo::paste (A, 0, 0, 0, 0, src, roi, nthreads)) {
-        dst.error ("%s", A.geterror());
+    // Read the (real) source channel directly into the real parts of
+    // dst, which is where all the transforming happens.
+    typedef std::complex<float> cpx;
+    int width = spec.width, height = spec.height;
+    cpx *data = (cpx *)dst.localpixels();
+    if (! src.get_pixels (roi, TypeDesc::FLOAT, data, sizeof(cpx),
+                          width * sizeof(cpx))) {
+        dst.error ("%s", src.geterror());
         return false;
     }
 
-    // FFT the rows (into temp buffer B).
-    ImageBuf B (spec);
-    hfft_ (B, A, false /*inverse*/, true /*unitary*/,
-           get_roi(B.spec()), nthreads);
-
-    // Transpose and shift back to A
-    A.clear ();
-    ImageBufAlgo::transpose (A, B, ROI::All(), nthreads);
+    // FFT the rows.  The input is real, so each row's spectrum comes from
+    // a complex FFT of half the length.
+    std::shared_ptr<const FFTPlan> rowplan = fft_plan (width, false, true);
+    float rowscale = sqrtf (1.0f / width);
+    parallel_image (ROI (0, width, 0, height), nthreads, [&](ROI roi){
+        kissfft<float> F (rowplan->fft);
+        std::vector<cpx> scratch (2 * width);
+        for (int y = roi.ybegin;  y < roi.yend;  ++y)
+            fft_real_row (data + imagesize_t(y)*width, width, *rowplan,
+                          F, &scratch[0], rowscale);
+    });
 
-    // FFT what was originally the columns (back to B)
-    B.reset (specT);
-    hfft_ (B, A, false /*inverse*/, true /*unitary*/,
-           get_roi(A.spec()), nthreads);
+    // FFT the columns.  The spectrum of a real image is conjugate
+    // symmetric, F(u,v) = conj(F(-u,-v)), so only the first width/2+1
+    // columns need to be transformed...
+    int ncols = width/2 + 1;
+    fft_columns (data, width, height, ncols, false /*inverse*/,
+                 sqrtf (1.0f / height), nthreads);
 
-    // Transpose again, into the dest
-    ImageBufAlgo::transpose (dst, B, ROI::All(), nthreads);
+    // ...and the rest are filled in from them.
+    if (ncols < width) {
+        parallel_image (ROI (ncols, width, 0, height), nthreads, [&](ROI roi){
+            for (int y = roi.ybegin;  y < roi.yend;  ++y) {
+                cpx *d = data + imagesize_t(y)*width;
+                const cpx *s = data + imagesize_t(y ? height-y : 0)*width;
+                for (int x = roi.xbegin;  x < roi.xend;  ++x)
+                    d[x] = std::conj (s[width-x]);
+            }
+        });
+    }
 
     return true;
 }
@@ -884,34 +1539,37 @@ ImageBufAlgo::ifft (ImageBuf &dst, const ImageBuf &src,
     spec.z = spec.full_z = 0;
     spec.set_format (TypeDesc::FLOAT);
     spec.channelformats.clear();
-    spec.nchannels = 2;
+    spec.nchannels = 1;
     spec.channelnames.clear();
-    spec.channelnames.emplace_back("real");
-    spec.channelnames.emplace_back("imag");
-
-    // Inverse FFT the rows (into temp buffer B).
-    ImageBuf B (spec);
-    hfft_ (B, src, true /*inverse*/, true /*unitary*/,
-           get_roi(B.spec()), nthreads);
+    spec.channelnames.emplace_back("R");
 
-    // Transpose and shift back to A
-    ImageBuf A;
-    ImageBufAlgo::transpose (A, B, ROI::All(), nthreads);
+    // Copy the complex source into a working buffer.
+    typedef std::complex<float> cpx;
+    int width = spec.width, height = spec.height;
+    std::vector<cpx> data (imagesize_t(width) * height);
+    if (! src.get_pixels (roi, TypeDesc::FLOAT, &data[0])) {
+        dst.error ("%s", src.geterror());
+        return false;
+    }
 
-    // Inverse FFT what was originally the columns (back to B)
-    B.reset (A.spec());
-    hfft_ (B, A, true /*inverse*/, true /*unitary*/,
-           get_roi(A.spec()), nthreads);
+    // Inverse FFT the columns, in place.
+    fft_columns (&data[0], width, height, width, true /*inverse*/,
+                 sqrtf (1.0f / height), nthreads);
 
-    // Transpose again, into the dst, in the process throw out the
-    // imaginary part and go back to a single (real) channel.
-    spec.nchannels = 1;
-    spec.channelnames.clear ();
-    spec.channelnames.emplace_back("R");
+    // Inverse FFT the rows, directly into dst.  Only the real part of the
+    // result is kept, which needs just a half-length complex FFT per row.
     dst.reset (dst.name(), spec);
-    ROI Broi = get_roi(B.spec());
-    Broi.chend = 1;
-    ImageBufAlgo::transpose (dst, B, Broi, nthreads);
+    float *out = (float *)dst.localpixels();
+    std::shared_ptr<const FFTPlan> rowplan = fft_plan (width, true, true);
+    float rowscale = sqrtf (1.0f / width);
+    parallel_image (ROI (0, width, 0, height), nthreads, [&](ROI roi){
+        kissfft<float> F (rowplan->fft);
+        std::vector<cpx> scratch (2 * width);
+        for (int y = roi.ybegin;  y < roi.yend;  ++y)
+            ifft_real_row (&data[imagesize_t(y)*width],
+                           out + imagesize_t(y)*width, width, *rowplan,
+                           F, &scratch[0], rowscale);
+    });
 
     return true;
 }
@@ -35,13 +35,22 @@
 #include <OpenEXR/half.h>
 
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/dassert.h>
+#include <OpenImageIO/hash.h>
+#include <OpenImageIO/simd.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/SHA1.h>
 
 #ifdef USE_OPENSSL
@@ -130,6 +139,84 @@ finalize (ImageBufAlgo::PixelStats &p)
 
 
 
+// Accumulate the stats of one region of a non-deep image into p (already
+// reset).  This version is for 8 and 16 bit integer pixels, which can't
+// be NaN or Inf: it keeps exact integer sums and extrema, in tight loops
+// the compiler vectorizes, and converts to normalized float at the end.
+template<class T>
+static void
+pixel_stats_region (const ImageBuf &src, ROI roi, ImageBufAlgo::PixelStats &p,
+                    int /*batchsize*/, std::true_type /*small int*/)
+{
+    const int nc = roi.chend - roi.chbegin;
+    long long *sum = ALLOCA (long long, nc);
+    unsigned long long *sum2 = ALLOCA (unsigned long long, nc);
+    int *imin = ALLOCA (int, nc);
+    int *imax = ALLOCA (int, nc);
+    for (int c = 0;  c < nc;  ++c) {
+        sum[c] = 0;  sum2[c] = 0;
+        imin[c] = std::numeric_limits<T>::max();
+        imax[c] = std::numeric_limits<T>::min();
+    }
+    imagesize_t npixels = 0;
+    for (ImageBuf::ConstSpanIterator<T> s (src, roi);  ! s.done();  ++s) {
+        const T *v = s.data() + roi.chbegin;
+        int n = s.npixels(), stride = s.stride();
+        for (int i = 0;  i < n;  ++i, v += stride) {
+            for (int c = 0;  c < nc;  ++c) {
+                int x = v[c];
+                sum[c] += x;
+                sum2[c] += (unsigned long long)((long long)x * x);
+                imin[c] = std::min (imin[c], x);
+                imax[c] = std::max (imax[c], x);
+            }
+        }
+        npixels += n;
+    }
+    if (! npixels)
+        return;
+    const double scale = 1.0 / std::numeric_limits<T>::max();
+    for (int c = 0;  c < nc;  ++c) {
+        int ch = roi.chbegin + c;
+        p.finitecount[ch] = npixels;
+        p.sum[ch] = sum[c] * scale;
+        p.sum2[ch] = sum2[c] * (scale * scale);
+        p.min[ch] = convert_type<T,float> (T(imin[c]));
+        p.max[ch] = convert_type<T,float> (T(imax[c]));
+    }
+}
+
+
+// General version for float-like (and 32 bit integer) pixels, which
+// classifies each value as NaN, Inf or finite.  Batches of values are
+// summed separately and then merged, to preserve precision for large
+// regions.
+template<class T>
+static void
+pixel_stats_region (const ImageBuf &src, ROI roi, ImageBufAlgo::PixelStats &p,
+                    int batchsize, std::false_type /*small int*/)
+{
+    int nchannels = src.spec().nchannels;
+    ImageBufAlgo::PixelStats tmp;
+    reset (tmp, nchannels);
+    for (ImageBuf::ConstSpanIterator<T> s (src, roi);  ! s.done();  ++s) {
+        const T *v = s.data();
+        for (int i = 0, n = s.npixels();  i < n;  ++i, v += s.stride()) {
+            for (int c = roi.chbegin;  c < roi.chend;  ++c) {
+                float value = convert_type<T,float>(v[c]);
+                val (tmp, c, value);
+                if ((tmp.finitecount[c] % batchsize) == 0) {
+                    merge (p, tmp);
+                    reset (tmp, nchannels);
+                }
+            }
+        }
+    }
+    merge (p, tmp);
+}
+
+
+
 template <class T>
 static bool
 computePixelStats_ (const ImageBuf &src, ImageBufAlgo::PixelStats &stats,
@@ -176,17 +263,28 @@ computePixelStats_ (const ImageBuf &src, ImageBufAlgo::PixelStats &stats,
             }
         }
     } else {  // Non-deep case
-        // Loop over all pixels ...
-        for (ImageBuf::ConstIterator<T> s(src, roi); ! s.done();  ++s) {
-            for (int c = roi.chbegin;  c < roi.chend;  ++c) {
-                float value = s[c];
-                val (tmp, c, value);
-                if ((tmp.finitecount[c] % PIXELS_PER_BATCH) == 0) {
-                    merge (stats, tmp);
-                    reset (tmp, nchannels);
-                }
-            }
-        }
+        // Each thread reduces its own piece of the image into private
+        // stats. The partial results are merged afterwards in image order,
+        // so the (floating point) totals don't depend on thread timing.
+        typedef std::tuple<int,int,int> Position;
+        std::vector<std::pair<Position,ImageBufAlgo::PixelStats> > partials;
+        spin_mutex partials_mutex;
+        std::integral_constant<bool, std::numeric_limits<T>::is_integer
+                                     && sizeof(T) <= 2> small_int;
+        ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+            ImageBufAlgo::PixelStats p;
+            reset (p, nchannels);
+            pixel_stats_region<T> (src, roi, p, PIXELS_PER_BATCH, small_int);
+            spin_lock lock (partials_mutex);
+            partials.emplace_back (Position(roi.zbegin, roi.ybegin, roi.xbegin), p);
+        });
+        std::sort (partials.begin(), partials.end(),
+                   [](const std::pair<Position,ImageBufAlgo::PixelStats> &a,
+                      const std::pair<Position,ImageBufAlgo::PixelStats> &b) {
+                       return a.first < b.first;
+                   });
+        for (auto &partial : partials)
+            merge (stats, partial.second);
     }
 
     // Merge anything left over
@@ -222,9 +320,8 @@ ImageBufAlgo::computePixelStats (PixelStats &stats, const ImageBuf &src,
 
 
 
-template<class BUFT>
 inline void
-compare_value (ImageBuf::ConstIterator<BUFT,float> &a, int chan,
+compare_value (int x, int y, int z, int chan,
                float aval, float bval, ImageBufAlgo::CompareResults &result,
                float &maxval, double &batcherror, double &batch_sqrerror,
                bool &failed, bool &warned, float failthresh, float warnthresh)
@@ -235,9 +332,9 @@ compare_value (ImageBuf::ConstIterator<BUFT,float> &a, int chan,
         if (isfinite(result.maxerror)) {
             // non-finite errors trump finite ones
             result.maxerror = std::numeric_limits<float>::infinity();
-            result.maxx = a.x();
-            result.maxy = a.y();
-            result.maxz = a.z();
+            result.maxx = x;
+            result.maxy = y;
+            result.maxz = z;
             result.maxc = chan;
             return;
         }
@@ -251,9 +348,9 @@ compare_value (ImageBuf::ConstIterator<BUFT,float> &a, int chan,
     // return false).
     if (!(f <= result.maxerror)) {
         result.maxerror = f;
-        result.maxx = a.x();
-        result.maxy = a.y();
-        result.maxz = a.z();
+        result.maxx = x;
+        result.maxy = y;
+        result.maxz = z;
         result.maxc = chan;
     }
     if (! warned && !(f <= warnthresh)) {
@@ -268,6 +365,99 @@ compare_value (ImageBuf::ConstIterator<BUFT,float> &a, int chan,
 
 
 
+// Helpers for the non-deep compare paths: load 4 consecutive channel
+// values as normalized floats.  half goes through vfloat4's half load
+// (F16C when it is enabled).
+template<typename T>
+inline simd::vfloat4
+load4 (const T *p)
+{
+    return simd::vfloat4 (convert_type<T,float>(p[0]), convert_type<T,float>(p[1]),
+                          convert_type<T,float>(p[2]), convert_type<T,float>(p[3]));
+}
+
+template<> inline simd::vfloat4
+load4 (const float *p)
+{
+    return simd::vfloat4 (p);
+}
+
+template<> inline simd::vfloat4
+load4 (const half *p)
+{
+    simd::vfloat4 v;
+    v.load (p);
+    return v;
+}
+
+template<> inline simd::vfloat4
+load4 (const unsigned char *p)
+{
+    simd::vfloat4 v;
+    v.load (p);
+    return v * simd::vfloat4 (1.0f / std::numeric_limits<unsigned char>::max());
+}
+
+
+// Are the first n channel values of a and b all within thresh of each
+// other?  This is the vectorized common case; NaN or Inf anywhere makes
+// it return false, and the caller sorts out the details value by value.
+template<class Atype, class Btype>
+static bool
+all_within (const Atype *a, const Btype *b, int n, float thresh)
+{
+    const simd::vfloat4 t (thresh);
+    int i = 0;
+    for ( ;  i+4 <= n;  i += 4) {
+        simd::vfloat4 d = simd::abs (load4 (a+i) - load4 (b+i));
+        if (! simd::all (d <= t))
+            return false;
+    }
+    for ( ;  i < n;  ++i) {
+        float d = fabsf (convert_type<Atype,float>(a[i]) - convert_type<Btype,float>(b[i]));
+        if (! (d <= thresh))
+            return false;
+    }
+    return true;
+}
+
+
+// Do a span of n pixels have exactly the same bytes in both images?
+// Only meaningful when the pixel types and layouts are the same; the
+// caller checks that.
+template<class Atype, class Btype>
+inline bool
+identical_span (const Atype *a, const Btype *b, int n, int nchannels)
+{
+    return is_same<Atype,Btype>::value &&
+           memcmp (a, b, size_t(n) * nchannels * sizeof(Atype)) == 0;
+}
+
+
+// Can spans of A and B be compared as raw memory: same pixel type and
+// layout, covering every channel of the roi?  Each span must also be
+// packed (see packed_spans), which a view of some of the channels of
+// another image is not.
+static bool
+same_pixel_layout (const ImageBuf &A, const ImageBuf &B, ROI roi)
+{
+    return A.spec().format == B.spec().format
+        && A.nchannels() == B.nchannels()
+        && A.spec().channelformats.empty() && B.spec().channelformats.empty()
+        && roi.chbegin == 0 && roi.chend == A.nchannels();
+}
+
+
+// Are the current spans of a and b both stored values with each pixel
+// immediately following the previous one?
+inline bool
+packed_spans (const ImageBuf::SpanIteratorBase &a,
+              const ImageBuf::SpanIteratorBase &b, int nchannels)
+{
+    return a.stride() == nchannels && b.stride() == nchannels;
+}
+
+
 template <class Atype, class Btype>
 static bool
 compare_ (const ImageBuf &A, const ImageBuf &B,
@@ -288,35 +478,79 @@ compare_ (const ImageBuf &A, const ImageBuf &B,
     result.nfail = 0, result.nwarn = 0;
     float maxval = 1.0;  // max possible value
 
-    ImageBuf::ConstIterator<Atype> a (A, roi, ImageBuf::WrapBlack);
-    ImageBuf::ConstIterator<Btype> b (B, roi, ImageBuf::WrapBlack);
-    bool deep = A.deep();
     // Break up into batches to reduce cancelation errors as the error
     // sums become too much larger than the error for individual pixels.
     const int batchsize = 4096;   // As good a guess as any
-    for ( ;  ! a.done();  ) {
-        double batcherror = 0;
-        double batch_sqrerror = 0;
-        if (deep) {
+    if (A.deep()) {
+        ImageBuf::ConstIterator<Atype> a (A, roi, ImageBuf::WrapBlack);
+        ImageBuf::ConstIterator<Btype> b (B, roi, ImageBuf::WrapBlack);
+        for ( ;  ! a.done();  ) {
+            double batcherror = 0;
+            double batch_sqrerror = 0;
             for (int i = 0;  i < batchsize && !a.done();  ++i, ++a, ++b) {
                 bool warned = false, failed = false;  // For this pixel
                 for (int c = roi.chbegin;  c < roi.chend;  ++c)
                     for (int s = 0, e = a.deep_samples(); s < e;  ++s) {
-                        compare_value (a, c, a.deep_value(c,s),
-                                       b.deep_value(c,s), result, maxval,
+                        compare_value (a.x(), a.y(), a.z(), c,
+                                       a.deep_value(c,s), b.deep_value(c,s),
+                                       result, maxval,
                                        batcherror, batch_sqrerror,
                                        failed, warned, failthresh, warnthresh);
                     }
             }
-        } else {  // non-deep
-            for (int i = 0;  i < batchsize && !a.done();  ++i, ++a, ++b) {
-                bool warned = false, failed = false;  // For this pixel
-                for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                    compare_value (a, c, c < Achannels ? a[c] : 0.0f,
-                                   c < Bchannels ? b[c] : 0.0f,
-                                   result, maxval, batcherror, batch_sqrerror,
-                                   failed, warned, failthresh, warnthresh);
+            totalerror += batcherror;
+            totalsqrerror += batch_sqrerror;
+        }
+    } else {  // non-deep
+        // Spans whose bytes are identical in both images have no error
+        // at all, so they skip the per-value work (they only need to be
+        // scanned for the largest value, for PSNR).  The batches keep
+        // their pixel boundaries, so the sums come out exactly as if
+        // every pixel had been visited.
+        bool rawcompare = same_pixel_layout (A, B, roi)
+                          && failthresh >= 0.0f && warnthresh >= 0.0f;
+        ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+        ImageBuf::ConstSpanIterator<Btype> b (B, roi);
+        double batcherror = 0;
+        double batch_sqrerror = 0;
+        int inbatch = 0;
+        while (! a.done()) {
+            int n = std::min (a.npixels(), b.npixels());
+            const Atype *ap = a.data();
+            const Btype *bp = b.data();
+            if (rawcompare && packed_spans (a, b, Achannels) &&
+                    identical_span (ap, bp, n, Achannels)) {
+                for (int i = 0, e = n*Achannels;  i < e;  ++i) {
+                    float v = convert_type<Atype,float>(ap[i]);
+                    if (isfinite (v))
+                        maxval = std::max (maxval, v);
+                }
+                if (inbatch + n >= batchsize) {
+                    totalerror += batcherror;
+                    totalsqrerror += batch_sqrerror;
+                    batcherror = 0;
+                    batch_sqrerror = 0;
+                }
+                inbatch = (inbatch + n) % batchsize;
+            } else {
+                for (int i = 0;  i < n;  ++i, ap += a.stride(), bp += b.stride()) {
+                    bool warned = false, failed = false;  // For this pixel
+                    for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                        compare_value (a.x()+i, a.y(), a.z(), c,
+                                       c < Achannels ? convert_type<Atype,float>(ap[c]) : 0.0f,
+                                       c < Bchannels ? convert_type<Btype,float>(bp[c]) : 0.0f,
+                                       result, maxval, batcherror, batch_sqrerror,
+                                       failed, warned, failthresh, warnthresh);
+                    if (++inbatch == batchsize) {
+                        totalerror += batcherror;
+                        totalsqrerror += batch_sqrerror;
+                        batcherror = 0;
+                        batch_sqrerror = 0;
+                        inbatch = 0;
+                    }
+                }
             }
+            a.advance (n);  b.advance (n);
         }
         totalerror += batcherror;
         totalsqrerror += batch_sqrerror;
@@ -358,6 +592,93 @@ ImageBufAlgo::compare (const ImageBuf &A, const ImageBuf &B,
 
 
 
+// Does pixel p fail the compare_pass test: some channel differs by more
+// than failthresh, or is NaN or Inf in only one of the images?
+template <class Atype, class Btype>
+inline bool
+pixel_fails (const Atype *a, const Btype *b, int Achannels, int Bchannels,
+             ROI roi, float failthresh)
+{
+    for (int c = roi.chbegin;  c < roi.chend;  ++c) {
+        float aval = c < Achannels ? convert_type<Atype,float>(a[c]) : 0.0f;
+        float bval = c < Bchannels ? convert_type<Btype,float>(b[c]) : 0.0f;
+        if (!isfinite(aval) || !isfinite(bval)) {
+            if (isnan(aval) == isnan(bval) && isinf(aval) == isinf(bval))
+                continue; // NaN may match NaN, Inf may match Inf
+            return true;
+        }
+        if (! (fabsf (aval - bval) <= failthresh))
+            return true;
+    }
+    return false;
+}
+
+
+
+template <class Atype, class Btype>
+static bool
+compare_pass_ (const ImageBuf &A, const ImageBuf &B, float failthresh,
+               imagesize_t maxfailures, ROI roi, int nthreads)
+{
+    int Achannels = A.nchannels(), Bchannels = B.nchannels();
+    bool rawcompare = same_pixel_layout (A, B, roi) && failthresh >= 0.0f;
+    // The failure total is shared, but each thread only adds to it (and
+    // checks it) once per span, not per pixel.
+    atomic_ll nfail (0);
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+        ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+        ImageBuf::ConstSpanIterator<Btype> b (B, roi);
+        while (! a.done() && (imagesize_t) nfail.load() <= maxfailures) {
+            int n = std::min (a.npixels(), b.npixels());
+            const Atype *ap = a.data();
+            const Btype *bp = b.data();
+            bool whole = rawcompare && packed_spans (a, b, Achannels);
+            if (whole && (identical_span (ap, bp, n, Achannels) ||
+                          all_within (ap, bp, n*Achannels, failthresh))) {
+                // Every value in the span is within the threshold
+            } else {
+                long long spanfail = 0;
+                for (int i = 0;  i < n;  ++i, ap += a.stride(), bp += b.stride())
+                    spanfail += pixel_fails (ap, bp, Achannels, Bchannels,
+                                             roi, failthresh);
+                if (spanfail)
+                    nfail += spanfail;
+            }
+            a.advance (n);  b.advance (n);
+        }
+    });
+    return (imagesize_t) nfail.load() <= maxfailures;
+}
+
+
+
+bool
+ImageBufAlgo::compare_pass (const ImageBuf &A, const ImageBuf &B,
+                            float failthresh, imagesize_t maxfailures,
+                            ROI roi, int nthreads)
+{
+    if (! roi.defined())
+        roi = roi_union (get_roi(A.spec()), get_roi(B.spec()));
+    roi.chend = std::min (roi.chend, std::max(A.nchannels(), B.nchannels()));
+
+    // Deep images need the full comparison
+    if (A.deep() || B.deep()) {
+        if (B.deep() != A.deep())
+            return false;
+        CompareResults cr;
+        compare (A, B, failthresh, failthresh, cr, roi, nthreads);
+        return cr.nfail <= maxfailures;
+    }
+
+    bool ok;
+    OIIO_DISPATCH_TYPES2 (ok, "compare_pass", compare_pass_,
+                          A.spec().format, B.spec().format,
+                          A, B, failthresh, maxfailures, roi, nthreads);
+    return ok;
+}
+
+
+
 template<typename T>
 static inline bool
 isConstantColor_ (const ImageBuf &src, float *color,
@@ -492,28 +813,38 @@ ImageBufAlgo::isMonochrome (const ImageBuf &src, ROI roi, int nthreads)
 
 template<typename T>
 static bool
-color_count_ (const ImageBuf &src, atomic_ll *count,
+color_count_ (const ImageBuf &src, imagesize_t *count,
               int ncolors, const float *color, const float *eps,
               ROI roi, int nthreads)
 {
+    // Each thread counts into its own local array and adds it to the
+    // totals just once, at the end.
+    spin_mutex count_mutex;
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
         int nchannels = src.nchannels();
-        long long *n = ALLOCA (long long, ncolors);
+        imagesize_t *n = ALLOCA (imagesize_t, ncolors);
         for (int col = 0;  col < ncolors;  ++col)
             n[col] = 0;
-        for (ImageBuf::ConstIterator<T> p (src, roi);  !p.done();  ++p) {
-            int coloffset = 0;
-            for (int col = 0;  col < ncolors;  ++col, coloffset += nchannels) {
-                int match = 1;
-                for (int c = roi.chbegin;  c < roi.chend;  ++c) {
-                    if (fabsf(p[c] - color[coloffset+c]) > eps[c]) {
-                        match = 0;
-                        break;
+        float *value = ALLOCA (float, nchannels);
+        for (ImageBuf::ConstSpanIterator<T> s (src, roi);  ! s.done();  ++s) {
+            const T *p = s.data();
+            for (int i = 0, e = s.npixels();  i < e;  ++i, p += s.stride()) {
+                for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                    value[c] = convert_type<T,float>(p[c]);
+                int coloffset = 0;
+                for (int col = 0;  col < ncolors;  ++col, coloffset += nchannels) {
+                    int match = 1;
+                    for (int c = roi.chbegin;  c < roi.chend;  ++c) {
+                        if (fabsf(value[c] - color[coloffset+c]) > eps[c]) {
+                            match = 0;
+                            break;
+                        }
                     }
+                    n[col] += match;
                 }
-                n[col] += match;
             }
         }
+        spin_lock lock (count_mutex);
         for (int col = 0;  col < ncolors;  ++col)
             count[col] += n[col];
     });
@@ -544,7 +875,7 @@ ImageBufAlgo::color_count (const ImageBuf &src, imagesize_t *count,
         count[col] = 0;
     bool ok;
     OIIO_DISPATCH_TYPES (ok, "color_count", color_count_, src.spec().format,
-                         src, (atomic_ll *)count, ncolors, color, eps,
+                         src, count, ncolors, color, eps,
                          roi, nthreads);
     return ok;
 }
@@ -706,7 +1037,10 @@ simplePixelHashSHA1 (const ImageBuf &src,
     if (! roi.defined())
         roi = get_roi (src.spec());
 
-    bool localpixels = src.localpixels();
+    // Hash straight from the buffer only if the rows of the ROI follow
+    // each other in memory.
+    bool localpixels = src.contiguous() && roi.xbegin == src.xbegin() &&
+                       roi.xend == src.xend();
     imagesize_t scanline_bytes = roi.width() * src.spec().pixel_bytes();
     ASSERT (scanline_bytes < std::numeric_limits<unsigned int>::max());
     // Do it a few scanlines at a time
@@ -800,11 +1134,14 @@ ImageBufAlgo::computePixelHashSHA1 (const ImageBuf &src,
     std::vector<std::string> results (nblocks);
     parallel_for_chunked (roi.ybegin, roi.yend, blocksize,
                           [&](int64_t ybegin, int64_t yend){
-        int64_t b = (ybegin-src.ybegin())/blocksize;  // block number
-        ROI broi = roi;
-        broi.ybegin = ybegin;
-        broi.yend = yend;
-        results[b] = simplePixelHashSHA1 (src, "", broi);
+        // N.B. From inside the thread pool, this gets the whole range
+        for (int64_t y = ybegin;  y < yend;  y += blocksize) {
+            int64_t b = (y-roi.ybegin)/blocksize;  // block number
+            ROI broi = roi;
+            broi.ybegin = y;
+            broi.yend = std::min (y+blocksize, yend);
+            results[b] = simplePixelHashSHA1 (src, "", broi);
+        }
     });
 
 #ifdef USE_OPENSSL
@@ -840,6 +1177,122 @@ ImageBufAlgo::computePixelHashSHA1 (const ImageBuf &src,
 
 
 
+namespace {
+
+// Hash a buffer with xxh64 or farmhash's 128 bit fingerprint, returning
+// the digest as bytes, least significant first.
+std::string
+fast_hash (bool farm, const void *data, size_t size)
+{
+    uint64_t words[2] = { 0, 0 };
+    int nwords = 1;
+    if (farm) {
+        farmhash::uint128_t h = farmhash::Fingerprint128 ((const char *)data, size);
+        words[0] = farmhash::Uint128Low64 (h);
+        words[1] = farmhash::Uint128High64 (h);
+        nwords = 2;
+    } else {
+        words[0] = xxhash::XXH64 (data, size, 0);
+    }
+    std::string digest;
+    for (int w = 0;  w < nwords;  ++w)
+        for (int i = 0;  i < 8;  ++i)
+            digest += char ((words[w] >> (8*i)) & 0xff);
+    return digest;
+}
+
+
+
+// Hash the pixels of roi (one z slice) with fast_hash, straight from the
+// buffer if its scanlines are contiguous in memory.
+std::string
+fast_hash_block (const ImageBuf &src, bool farm, ROI roi)
+{
+    size_t pixel_bytes = src.spec().pixel_bytes();
+    size_t scanline_bytes = roi.width() * pixel_bytes;
+    size_t size = scanline_bytes * roi.height();
+    if (src.localpixels() && ! src.local_tile_width() &&
+        roi.xbegin == src.xbegin() && roi.xend == src.xend()) {
+        const char *p = (const char *)src.pixeladdr (roi.xbegin, roi.ybegin, roi.zbegin);
+        bool contiguous =
+            (roi.width() < 2 ||
+             (const char *)src.pixeladdr (roi.xbegin+1, roi.ybegin, roi.zbegin) - p == stride_t(pixel_bytes)) &&
+            (roi.height() < 2 ||
+             (const char *)src.pixeladdr (roi.xbegin, roi.ybegin+1, roi.zbegin) - p == stride_t(scanline_bytes));
+        if (contiguous)
+            return fast_hash (farm, p, size);
+    }
+    std::unique_ptr<char[]> tmp (new char [size]);
+    src.get_pixels (ROI (roi.xbegin, roi.xend, roi.ybegin, roi.yend,
+                         roi.zbegin, roi.zend),
+                    src.spec().format, tmp.get());
+    return fast_hash (farm, tmp.get(), size);
+}
+
+} // anon namespace
+
+
+
+std::string
+ImageBufAlgo::computePixelHash (const ImageBuf &src, string_view algorithm,
+                                string_view extrainfo, ROI roi,
+                                int blocksize, int nthreads)
+{
+    bool farm = false;
+    if (Strutil::iequals (algorithm, "sha1") ||
+        Strutil::iequals (algorithm, "sha-1")) {
+        return computePixelHashSHA1 (src, extrainfo, roi, blocksize,
+                                     nthreads);
+    } else if (Strutil::iequals (algorithm, "farmhash128") ||
+               Strutil::iequals (algorithm, "farmhash")) {
+        farm = true;
+    } else if (algorithm.size() && ! Strutil::iequals (algorithm, "xxh64") &&
+               ! Strutil::iequals (algorithm, "xxhash")) {
+        src.error ("computePixelHash: unknown hash algorithm \"%s\"",
+                   algorithm);
+        return std::string();
+    }
+
+    if (! roi.defined())
+        roi = get_roi (src.spec());
+    if (blocksize <= 0)
+        blocksize = 256;
+
+    // Hash each block of scanlines of each z slice separately (and in
+    // parallel), then hash the block digests and extrainfo together.
+    int nblocks = (roi.height()+blocksize-1) / blocksize;
+    int nunits = nblocks * roi.depth();
+    std::vector<std::string> results (nunits);
+    auto hash_units = [&](int64_t ubegin, int64_t uend) {
+        for (int64_t u = ubegin;  u < uend;  ++u) {
+            int z = roi.zbegin + int(u / nblocks);
+            int y = roi.ybegin + int(u % nblocks) * blocksize;
+            results[u] = fast_hash_block (src, farm,
+                            ROI (roi.xbegin, roi.xend, y,
+                                 std::min (y+blocksize, roi.yend), z, z+1,
+                                 roi.chbegin, roi.chend));
+        }
+    };
+    if (nthreads == 1)
+        hash_units (0, nunits);
+    else
+        parallel_for_chunked (0, nunits, 1, hash_units);
+
+    std::string all;
+    all.reserve (nunits * (farm ? 16 : 8) + extrainfo.size());
+    for (auto &r : results)
+        all += r;
+    all += extrainfo;
+    std::string digest = fast_hash (farm, all.data(), all.size());
+    // Print it most significant byte first
+    std::string hex;
+    for (size_t i = digest.size();  i-- > 0; )
+        hex += Strutil::format ("%02X", (int)(unsigned char)digest[i]);
+    return hex;
+}
+
+
+
 
 /// histogram_impl -----------------------------------------------------------
 /// Fully type-specialized version of histogram.
@@ -865,32 +1318,46 @@ histogram_impl (const ImageBuf &A, int channel,
     }
 
     // Initialize.
-    ImageBuf::ConstIterator<Atype, float> a (A, roi);
     float ratio = bins / (max-min);
     int bins_minus_1 = bins-1;
-    bool submin_ok = submin != NULL;
-    bool supermax_ok = supermax != NULL;
-    if (submin_ok)
-        *submin = 0;
-    if (supermax_ok)
-        *supermax = 0;
     histogram.assign(bins, 0);
-
-    // Compute histogram.
-    for ( ; ! a.done(); a++) {
-        float c = a[channel];
-        if (c >= min && c < max) {
-            // Map range min->max to 0->(bins-1).
-            histogram[ (int) ((c-min) * ratio) ]++;
-        } else if (c == max) {
-            histogram[bins_minus_1]++;
-        } else {
-            if (submin_ok && c < min)
-                (*submin)++;
-            else if (supermax_ok)
-                (*supermax)++;
+    imagesize_t nsubmin = 0, nsupermax = 0;
+
+    // Compute histogram: each thread fills its own, and they are summed
+    // at the end.
+    spin_mutex histogram_mutex;
+    ImageBufAlgo::parallel_image (roi, 0, [&](ROI roi){
+        std::vector<imagesize_t> h (bins, 0);
+        imagesize_t lo = 0, hi = 0;
+        for (ImageBuf::ConstSpanIterator<Atype> s (A, roi);  ! s.done();  ++s) {
+            const Atype *a = s.data() + channel;
+            for (int i = 0, n = s.npixels();  i < n;  ++i, a += s.stride()) {
+                float c = convert_type<Atype,float>(*a);
+                if (c >= min && c < max) {
+                    // Map range min->max to 0->(bins-1).
+                    h[ (int) ((c-min) * ratio) ]++;
+                } else if (c == max) {
+                    h[bins_minus_1]++;
+                } else {
+                    if (c < min)
+                        ++lo;
+                    else
+                        ++hi;
+                }
+            }
         }
-    }
+        spin_lock lock (histogram_mutex);
+        for (int b = 0;  b < bins;  ++b)
+            histogram[b] += h[b];
+        nsubmin += lo;
+        nsupermax += hi;
+    });
+    // As before, values below min count toward supermax when the caller
+    // isn't asking for submin.
+    if (submin)
+        *submin = nsubmin;
+    if (supermax)
+        *supermax = nsupermax + (submin ? 0 : nsubmin);
     return true;
 }
 
@@ -36,6 +36,7 @@
 #include <OpenEXR/half.h>
 
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 #include <OpenImageIO/imagebuf.h>
@@ -136,11 +137,26 @@ copy_ (ImageBuf &dst, const ImageBuf &src,
             }
         }
     } else {
-        ImageBuf::ConstIterator<S,D> s (src, roi);
-        ImageBuf::Iterator<D,D> d (dst, roi);
-        for ( ;  ! d.done();  ++d, ++s) {
-            for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                d[c] = s[c];
+        ImageBuf::ConstSpanIterator<S> s (src, roi);
+        ImageBuf::SpanIterator<D> d (dst, roi);
+        int nc = roi.nchannels();
+        while (! d.done()) {
+            int n = std::min (d.npixels(), s.npixels());
+            if (d.exists()) {
+                D *dp = d.data() + roi.chbegin;
+                const S *sp = s.data() + roi.chbegin;
+                if (is_same<D,S>::value && s.exists() &&
+                        nc == d.stride() && nc == s.stride()) {
+                    // Whole pixels of the same type: the span is one
+                    // contiguous block of memory.
+                    memcpy (dp, sp, size_t(n) * nc * sizeof(D));
+                } else {
+                    for (int i = 0;  i < n;  ++i, dp += d.stride(), sp += s.stride())
+                        for (int c = 0;  c < nc;  ++c)
+                            dp[c] = convert_type<S,D>(sp[c]);
+                }
+            }
+            d.advance (n);  s.advance (n);
         }
     }
 
@@ -652,16 +668,24 @@ channels_ (ImageBuf &dst, const ImageBuf &src,
 {
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
         int nchannels = src.nchannels();
-        ImageBuf::ConstIterator<DSTTYPE> s (src, roi);
-        ImageBuf::Iterator<DSTTYPE> d (dst, roi);
-        for (  ;  ! s.done();  ++s, ++d) {
-            for (int c = roi.chbegin;  c < roi.chend;  ++c) {
-                int cc = channelorder[c];
-                if (cc >= 0 && cc < nchannels)
-                    d[c] = s[cc];
-                else if (channelvalues)
-                    d[c] = channelvalues[c];
+        ImageBuf::ConstSpanIterator<DSTTYPE> s (src, roi);
+        ImageBuf::SpanIterator<DSTTYPE> d (dst, roi);
+        while (! d.done()) {
+            int n = std::min (d.npixels(), s.npixels());
+            if (d.exists()) {
+                DSTTYPE *dp = d.data();
+                const DSTTYPE *sp = s.data();
+                for (int i = 0;  i < n;  ++i, dp += d.stride(), sp += s.stride()) {
+                    for (int c = roi.chbegin;  c < roi.chend;  ++c) {
+                        int cc = channelorder[c];
+                        if (cc >= 0 && cc < nchannels)
+                            dp[c] = sp[cc];
+                        else if (channelvalues)
+                            dp[c] = convert_type<float,DSTTYPE>(channelvalues[c]);
+                    }
+                }
             }
+            d.advance (n);  s.advance (n);
         }
     });
     return true;
@@ -34,6 +34,7 @@
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -70,6 +71,12 @@ flatten_ (ImageBuf &dst, const ImageBuf &src,
         float &ARval (val[AR_channel]);
         float &AGval (val[AG_channel]);
         float &ABval (val[AB_channel]);
+        // When every channel is float (by far the most common for deep
+        // files), the samples of a pixel are a contiguous float array that
+        // we can walk directly, instead of looking up each value.
+        bool allfloat = true;
+        for (int c = 0;  c < nc;  ++c)
+            allfloat &= (dd->channeltype(c) == TypeDesc::FLOAT);
 
         for (ImageBuf::Iterator<DSTTYPE> r (dst, roi);  !r.done();  ++r) {
             int x = r.x(), y = r.y(), z = r.z();
@@ -80,13 +87,17 @@ flatten_ (ImageBuf &dst, const ImageBuf &src,
                 val[Z_channel] = 1.0e30;
             if (Zback_channel >= 0 && samps == 0)
                 val[Zback_channel] = 1.0e30;
+            const float *sampdata = NULL;
+            if (allfloat && samps)
+                sampdata = (const float *) dd->data_ptr (src.pixelindex (x, y, z, true), 0, 0);
             for (int s = 0;  s < samps;  ++s) {
                 float AR = ARval, AG = AGval, AB = ABval;  // make copies
                 float alpha = (AR + AG + AB) / 3.0f;
                 if (alpha >= 1.0f)
                     break;
                 for (int c = 0;  c < nc;  ++c) {
-                    float v = src.deep_value (x, y, z, c, s);
+                    float v = sampdata ? sampdata[s*nc+c]
+                                       : src.deep_value (x, y, z, c, s);
                     if (c == Z_channel || c == Zback_channel)
                         val[c] *= alpha;  // because Z are not premultiplied
                     float a;
@@ -266,6 +277,19 @@ ImageBufAlgo::deep_merge (ImageBuf &dst, const ImageBuf &A,
     int Azbackchan = Add.Zback_channel();
     int Bzchan = Bdd.Z_channel();
     int Bzbackchan = Bdd.Zback_channel();
+
+    // Pixels are independent, so both passes below can run in parallel,
+    // but only as long as no thread causes the dst data to be reallocated
+    // while others are using it. Reserving capacity for an unallocated
+    // dst only records the per-pixel counts, and the capacity reserved
+    // covers every split that merging can produce, so that holds unless
+    // dst already had data or is one of the inputs.
+    if (dstdd.allocated() || &dst == &A || &dst == &B)
+        nthreads = 1;
+    // The capacities are computed in parallel, but set_capacity locks, so
+    // they are set afterwards in one serial pass.
+    std::vector<int> newcap (dstdd.pixels(), -1);
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
     for (int z = roi.zbegin; z < roi.zend; ++z)
     for (int y = roi.ybegin; y < roi.yend; ++y)
     for (int x = roi.xbegin; x < roi.xend; ++x) {
@@ -323,11 +347,21 @@ ImageBufAlgo::deep_merge (ImageBuf &dst, const ImageBuf &A,
             }
         }
 
-        dstdd.set_capacity (dstpixel, Asamps+Bsamps+nsplits+self_overlap_splits);
+        if (dstpixel >= 0)
+            newcap[dstpixel] = Asamps+Bsamps+nsplits+self_overlap_splits;
     }
+    });
+    for (int p = 0, npixels = dstdd.pixels();  p < npixels;  ++p)
+        if (newcap[p] >= 0)
+            dstdd.set_capacity (p, newcap[p]);
+    // Allocate now, while only one thread is running, so that the merging
+    // threads all see dst already allocated (the unallocated DeepData
+    // bookkeeping isn't safe to change while another thread allocates).
+    dstdd.data_ptr (0, 0, 0);
 
     bool ok = ImageBufAlgo::copy (dst, A, TypeDesc::UNKNOWN, roi, nthreads);
 
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
     for (int z = roi.zbegin; z < roi.zend; ++z)
     for (int y = roi.ybegin; y < roi.yend; ++y)
     for (int x = roi.xbegin; x < roi.xend; ++x) {
@@ -341,6 +375,7 @@ ImageBufAlgo::deep_merge (ImageBuf &dst, const ImageBuf &A,
         if (occlusion_cull)
             dstdd.occlusion_cull (dstpixel);
     }
+    });
     return ok;
 }
 
@@ -364,22 +399,56 @@ ImageBufAlgo::deep_holdout (ImageBuf &dst, const ImageBuf &src,
 
     DeepData &dstdd (*dst.deepdata());
     const DeepData &srcdd (*src.deepdata());
+    const DeepData &threshdd (*thresh.deepdata());
+    int Zchan = dstdd.Z_channel();
+    int Zbackchan = dstdd.Zback_channel();
+
+    // Pixels are independent, so the work can be split among threads as
+    // long as no pixel outgrows the capacity reserved for it (growing
+    // would move the data out from under the other threads). Reserving
+    // room for one extra sample per sample that straddles the threshold
+    // covers every split below, but only helps if dst was not already
+    // allocated and isn't also an input.
+    if (dstdd.allocated() || &dst == &src || &dst == &thresh)
+        nthreads = 1;
+
     // First, reserve enough space in dst, to reduce the number of
-    // allocations we'll do later.
+    // allocations we'll do later.  The capacities are computed in
+    // parallel, but set_capacity locks, so they are set afterwards in
+    // one serial pass.
+    std::vector<int> newcap (dstdd.pixels(), -1);
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
     for (int z = roi.zbegin; z < roi.zend; ++z)
     for (int y = roi.ybegin; y < roi.yend; ++y)
     for (int x = roi.xbegin; x < roi.xend; ++x) {
         int dstpixel = dst.pixelindex (x, y, z, true);
         int srcpixel = src.pixelindex (x, y, z, true);
-        if (dstpixel >= 0 && srcpixel >= 0)
-            dstdd.set_capacity (dstpixel, srcdd.capacity(srcpixel));
+        if (dstpixel < 0 || srcpixel < 0)
+            continue;
+        int cap = srcdd.capacity (srcpixel);
+        int threshpixel = thresh.pixelindex (x, y, z, true);
+        if (threshpixel >= 0 && Zchan >= 0 && Zbackchan != Zchan) {
+            float zthresh = threshdd.opaque_z (threshpixel);
+            for (int s = 0, n = srcdd.samples(srcpixel); s < n; ++s)
+                if (srcdd.deep_value (srcpixel, Zchan, s) < zthresh &&
+                    srcdd.deep_value (srcpixel, Zbackchan, s) > zthresh)
+                    ++cap;
+        }
+        newcap[dstpixel] = cap;
     }
+    });
+    for (int p = 0, npixels = dstdd.pixels();  p < npixels;  ++p)
+        if (newcap[p] >= 0)
+            dstdd.set_capacity (p, newcap[p]);
+    // Allocate now, while only one thread is running, so that the threads
+    // below all see dst already allocated (the unallocated DeepData
+    // bookkeeping isn't safe to change while another thread allocates).
+    dstdd.data_ptr (0, 0, 0);
+
     // Now we compute each pixel: We copy the src pixel to dst, then split
     // any samples that span the opaque threshold, and then delete any
     // samples that lie beyond the threshold.
-    int Zchan = dstdd.Z_channel();
-    int Zbackchan = dstdd.Zback_channel();
-    const DeepData &threshdd (*thresh.deepdata());
+    ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
     for (ImageBuf::Iterator<float> r (dst, roi);  !r.done();  ++r) {
         int x = r.x(), y = r.y(), z = r.z();
         int srcpixel = src.pixelindex (x, y, z, true);
@@ -411,6 +480,7 @@ ImageBufAlgo::deep_holdout (ImageBuf &dst, const ImageBuf &src,
             }
         }
     }
+    });
     return true;
 }
 
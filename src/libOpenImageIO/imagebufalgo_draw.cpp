@@ -33,6 +33,8 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <memory>
+#include <unordered_map>
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -573,7 +575,10 @@ ImageBufAlgo::noise (ImageBuf &dst, string_view noisetype,
 
 #ifdef USE_FREETYPE
 namespace { // anon
-static mutex ft_mutex;
+// Recursive, because the last reference to a cached FontFace may be
+// dropped either while trimming the cache (lock held) or by a renderer
+// that has finished drawing (lock not held).
+static recursive_mutex ft_mutex;
 static FT_Library ft_library = NULL;
 static bool ft_broken = false;
 static std::vector<std::string> font_search_dirs;
@@ -581,27 +586,103 @@ static const char * default_font_name[] = {
         "DroidSans", "cour", "Courier New", "FreeMono", NULL
      };
 
-// Helper: given unicode and a font face, compute its size
+// One glyph rendered by FreeType, copied out of the FT_GlyphSlot (which
+// is overwritten by the next FT_Load_Char) so that drawing the same
+// character again is just a blit of these coverage values.
+struct GlyphBitmap {
+    int left = 0, top = 0;        // bitmap_left, bitmap_top
+    int width = 0, rows = 0;      // bitmap size
+    int advance = 0;              // pen advance, in whole pixels
+    std::vector<unsigned char> pixels;   // width*rows coverage values
+};
+
+
+// An open FT_Face set to one pixel size, and the glyphs rendered from it
+// so far.  Glyphs are never removed, so pointers to them stay valid for
+// as long as the FontFace lives.
+class FontFace {
+public:
+    FontFace (FT_Face face) : m_face(face) { }
+    ~FontFace () {
+        recursive_lock_guard ft_lock (ft_mutex);
+        FT_Done_Face (m_face);
+    }
+
+    // Return the rendered glyph for unicode character c, rendering and
+    // caching it on first use, or NULL if FreeType can't render it.
+    // The caller must hold ft_mutex.
+    const GlyphBitmap * glyph (uint32_t c) {
+        auto found = m_glyphs.find (c);
+        if (found != m_glyphs.end())
+            return found->second.get();
+        std::unique_ptr<GlyphBitmap> g;
+        if (FT_Load_Char (m_face, c, FT_LOAD_RENDER) == 0) {
+            FT_GlyphSlot slot = m_face->glyph;
+            g.reset (new GlyphBitmap);
+            g->left = slot->bitmap_left;
+            g->top = slot->bitmap_top;
+            g->width = slot->bitmap.width;
+            g->rows = slot->bitmap.rows;
+            g->advance = slot->advance.x >> 6;
+            g->pixels.resize (size_t(g->width) * g->rows);
+            for (int j = 0;  j < g->rows;  ++j)
+                std::copy_n (slot->bitmap.buffer + slot->bitmap.pitch*j,
+                             g->width, &g->pixels[size_t(j)*g->width]);
+        }
+        const GlyphBitmap *result = g.get();
+        m_glyphs[c] = std::move (g);   // failures are remembered as NULL
+        return result;
+    }
+
+private:
+    FT_Face m_face;
+    std::unordered_map<uint32_t, std::unique_ptr<GlyphBitmap> > m_glyphs;
+};
+
+typedef std::shared_ptr<FontFace> FontFaceRef;
+
+// Open faces keyed by resolved font filename and pixel size, and the
+// font names already resolved to filenames.  Both guarded by ft_mutex.
+// Callers hold a FontFaceRef, so trimming the face cache never pulls a
+// face out from under a render in progress.
+static std::unordered_map<std::string, FontFaceRef> font_faces;
+static std::unordered_map<std::string, std::string> resolved_fonts;
+static const size_t max_cached_faces = 64;
+
+
+
+// Helper: the rendered glyphs for each character of the unicode text
+// (NULL for any that can't be rendered).  Must hold ft_mutex.
+static void
+glyphs_for_unicode (FontFace &face, const std::vector<uint32_t> &utext,
+                    std::vector<const GlyphBitmap *> &glyphs)
+{
+    glyphs.resize (utext.size());
+    for (size_t n = 0, e = utext.size();  n < e;  ++n)
+        glyphs[n] = face.glyph (utext[n]);
+}
+
+
+
+// Helper: given the glyphs of a string, compute its size
 static ROI
-text_size_from_unicode (std::vector<uint32_t> &utext, FT_Face face)
+text_size_from_glyphs (const std::vector<const GlyphBitmap *> &glyphs)
 {
     ROI size;
     size.xbegin = size.ybegin = std::numeric_limits<int>::max();
     size.xend = size.yend = std::numeric_limits<int>::min();
-    FT_GlyphSlot slot = face->glyph;
     int x = 0;
-    for (size_t n = 0, e = utext.size();  n < e;  ++n) {
-        int error = FT_Load_Char (face, utext[n], FT_LOAD_RENDER);
-        if (error)
+    for (auto g : glyphs) {
+        if (! g)
             continue;  // ignore errors
-        size.ybegin = std::min (size.ybegin, -slot->bitmap_top);
-        size.yend = std::max (size.yend, int(slot->bitmap.rows) - int(slot->bitmap_top) + 1);
-        size.xbegin = std::min (size.xbegin, x + int(slot->bitmap_left));
-        size.xend = std::max (size.xend, x + int(slot->bitmap.width) + int(slot->bitmap_left) + 1);
+        size.ybegin = std::min (size.ybegin, -g->top);
+        size.yend = std::max (size.yend, g->rows - g->top + 1);
+        size.xbegin = std::min (size.xbegin, x + g->left);
+        size.xend = std::max (size.xend, x + g->width + g->left + 1);
         // increment pen position
-        x += slot->advance.x >> 6;
+        x += g->advance;
     }
-    return size;   // Font rendering not supported
+    return size;
 }
 
 } // anon namespace
@@ -661,6 +742,13 @@ resolve_font (int fontsize, string_view font_, std::string &result)
         }
     }
 
+    // Names we've resolved before don't need another directory search.
+    auto found = resolved_fonts.find (font_);
+    if (found != resolved_fonts.end()) {
+        result = found->second;
+        return true;
+    }
+
     // Try to find the font.  Experiment with several extensions
     std::string font = font_;
     if (font.empty()) {
@@ -698,6 +786,7 @@ resolve_font (int fontsize, string_view font_, std::string &result)
     }
 
     // Success
+    resolved_fonts[font_] = font;
     result = font;
     return true;
 #else
@@ -707,13 +796,45 @@ resolve_font (int fontsize, string_view font_, std::string &result)
 
 
 
+#ifdef USE_FREETYPE
+// Return the cached face for the resolved font file at the given pixel
+// size, opening it if needed.  On failure, return an empty ref and put
+// an error message in err.  The caller must hold ft_mutex.
+static FontFaceRef
+open_face (const std::string &font, int fontsize, std::string &err)
+{
+    std::string key = Strutil::format ("%s:%d", font, fontsize);
+    auto found = font_faces.find (key);
+    if (found != font_faces.end())
+        return found->second;
+
+    FT_Face face;      // handle to face object
+    if (FT_New_Face (ft_library, font.c_str(), 0 /* face index */, &face)) {
+        err = Strutil::format ("Could not set font face to \"%s\"", font);
+        return FontFaceRef();  // couldn't open the face
+    }
+    if (FT_Set_Pixel_Sizes (face /*handle*/, 0 /*width*/, fontsize/*height*/)) {
+        FT_Done_Face (face);
+        err = Strutil::format ("Could not set font size to %d", fontsize);
+        return FontFaceRef();  // couldn't set the character size
+    }
+    if (font_faces.size() >= max_cached_faces)
+        font_faces.clear ();
+    FontFaceRef ref (new FontFace (face));
+    font_faces[key] = ref;
+    return ref;
+}
+#endif
+
+
+
 ROI
 ImageBufAlgo::text_size (string_view text, int fontsize, string_view font_)
 {
     ROI size;
 #ifdef USE_FREETYPE
     // Thread safety
-    lock_guard ft_lock (ft_mutex);
+    recursive_lock_guard ft_lock (ft_mutex);
 
     std::string font;
     bool ok = resolve_font (fontsize, font_, font);
@@ -721,41 +842,18 @@ ImageBufAlgo::text_size (string_view text, int fontsize, string_view font_)
         return size;
     }
 
-    int error = 0;
-    FT_Face face;      // handle to face object
-    error = FT_New_Face (ft_library, font.c_str(), 0 /* face index */, &face);
-    if (error) {
-        return size;  // couldn't open the face
-    }
-
-    error = FT_Set_Pixel_Sizes (face /*handle*/, 0 /*width*/, fontsize/*height*/);
-    if (error) {
-        FT_Done_Face (face);
-        return size;  // couldn't set the character size
-    }
-
-    FT_GlyphSlot slot = face->glyph;  // a small shortcut
+    std::string err;
+    FontFaceRef face = open_face (font, fontsize, err);
+    if (! face)
+        return size;
 
     std::vector<uint32_t> utext;
     utext.reserve(text.size()); //Possible overcommit, but most text will be ascii
     Strutil::utf8_to_unicode(text, utext);
 
-    size.xbegin = size.ybegin = std::numeric_limits<int>::max();
-    size.xend = size.yend = std::numeric_limits<int>::min();
-    int x = 0;
-    for (size_t n = 0, e = utext.size();  n < e;  ++n) {
-        error = FT_Load_Char (face, utext[n], FT_LOAD_RENDER);
-        if (error)
-            continue;  // ignore errors
-        size.ybegin = std::min (size.ybegin, -slot->bitmap_top);
-        size.yend = std::max (size.yend, int(slot->bitmap.rows) - int(slot->bitmap_top) + 1);
-        size.xbegin = std::min (size.xbegin, x + int(slot->bitmap_left));
-        size.xend = std::max (size.xend, x + int(slot->bitmap.width) + int(slot->bitmap_left) + 1);
-        // increment pen position
-        x += slot->advance.x >> 6;
-    }
-
-    FT_Done_Face (face);
+    std::vector<const GlyphBitmap *> glyphs;
+    glyphs_for_unicode (*face, utext, glyphs);
+    size = text_size_from_glyphs (glyphs);
 #endif
 
     return size;   // Font rendering not supported
@@ -777,6 +875,31 @@ ImageBufAlgo::render_text (ImageBuf &R, int x, int y, string_view text,
 
 
 
+// Composite the rendered text (float coverage in textimg, with its
+// possibly-dilated alpha in alphaimg) over the pixels of R within roi.
+template<typename T>
+static bool
+render_text_composite_ (ImageBuf &R, const ImageBuf &textimg,
+                        const ImageBuf &alphaimg,
+                        array_view<const float> textcolor, ROI roi)
+{
+    size_t nchannels (R.spec().nchannels);
+    ImageBuf::ConstIterator<float> t (textimg, roi, ImageBuf::WrapBlack);
+    ImageBuf::ConstIterator<float> a (alphaimg, roi, ImageBuf::WrapBlack);
+    ImageBuf::Iterator<T> r (R, roi);
+    for ( ;  !r.done();  ++r, ++t, ++a) {
+        float val = t[0];
+        float alpha = a[0];
+        if (val == 0.0f && alpha == 0.0f)
+            continue;   // nothing drawn here
+        for (size_t c = 0;  c < nchannels;  ++c)
+            r[c] = val*textcolor[c] + (1.0f-alpha) * r[c];
+    }
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::render_text (ImageBuf &R, int x, int y, string_view text,
                            int fontsize, string_view font_,
@@ -790,33 +913,33 @@ ImageBufAlgo::render_text (ImageBuf &R, int x, int y, string_view text,
     }
 
 #ifdef USE_FREETYPE
-    // Thread safety
-    lock_guard ft_lock (ft_mutex);
-
-    std::string font;
-    bool ok = resolve_font (fontsize, font_, font);
-    if (! ok) {
-        std::string err = font.size() ? font : "Font error";
-        R.error ("%s", err);
-        return false;
-    }
-
-    int error = 0;
-    FT_Face face;      // handle to face object
-    error = FT_New_Face (ft_library, font.c_str(), 0 /* face index */, &face);
-    if (error) {
-        R.error ("Could not set font face to \"%s\"", font);
-        return false;  // couldn't open the face
-    }
-
-    error = FT_Set_Pixel_Sizes (face /*handle*/, 0 /*width*/, fontsize/*height*/);
-    if (error) {
-        FT_Done_Face (face);
-        R.error ("Could not set font size to %d", fontsize);
-        return false;  // couldn't set the character size
+    // Look up the face and its rendered glyphs under the lock.  After
+    // that, we only need our reference to the face (which keeps the
+    // glyphs alive), so the drawing itself runs unlocked.
+    FontFaceRef face;
+    std::vector<const GlyphBitmap *> glyphs;
+    {
+        recursive_lock_guard ft_lock (ft_mutex);
+        std::string font;
+        bool ok = resolve_font (fontsize, font_, font);
+        if (! ok) {
+            std::string err = font.size() ? font : "Font error";
+            R.error ("%s", err);
+            return false;
+        }
+        std::string err;
+        face = open_face (font, fontsize, err);
+        if (! face) {
+            R.error ("%s", err);
+            return false;
+        }
+        // Convert the UTF to 32 bit unicode
+        std::vector<uint32_t> utext;
+        utext.reserve(text.size()); //Possible overcommit, but most text will be ascii
+        Strutil::utf8_to_unicode(text, utext);
+        glyphs_for_unicode (*face, utext, glyphs);
     }
 
-    FT_GlyphSlot slot = face->glyph;  // a small shortcut
     size_t nchannels (R.spec().nchannels);
     if (textcolor.size() <= nchannels) {
         float *localtextcolor = ALLOCA (float, nchannels);
@@ -825,13 +948,8 @@ ImageBufAlgo::render_text (ImageBuf &R, int x, int y, string_view text,
         textcolor = array_view<const float>(localtextcolor, nchannels);
     }
 
-    // Convert the UTF to 32 bit unicode
-    std::vector<uint32_t> utext;
-    utext.reserve(text.size()); //Possible overcommit, but most text will be ascii
-    Strutil::utf8_to_unicode(text, utext);
-
     // Compute the size that the text will render as, into an ROI
-    ROI textroi = text_size_from_unicode (utext, face);
+    ROI textroi = text_size_from_glyphs (glyphs);
     textroi.zbegin = 0; textroi.zend = 1;
     textroi.chbegin = 0; textroi.chend = 1;
 
@@ -855,22 +973,24 @@ ImageBufAlgo::render_text (ImageBuf &R, int x, int y, string_view text,
     ImageBuf textimg (ImageSpec(textroi, TypeDesc::FLOAT));
     ImageBufAlgo::zero (textimg);
 
-    // Glyph by glyph, fill in our txtimg buffer
-    for (size_t n = 0, e = utext.size();  n < e;  ++n) {
-        int error = FT_Load_Char (face, utext[n], FT_LOAD_RENDER);
-        if (error)
+    // Glyph by glyph, blit the cached bitmaps into our txtimg buffer
+    for (auto g : glyphs) {
+        if (! g)
             continue;  // ignore errors
-        // now, draw to our target surface
-        for (int j = 0;  j < static_cast<int>(slot->bitmap.rows); ++j) {
-            int ry = y + j - slot->bitmap_top;
-            for (int i = 0;  i < static_cast<int>(slot->bitmap.width); ++i) {
-                int rx = x + i + slot->bitmap_left;
-                float b = slot->bitmap.buffer[slot->bitmap.pitch*j+i] / 255.0f;
-                textimg.setpixel (rx, ry, &b, 1);
-            }
+        for (int j = 0;  j < g->rows;  ++j) {
+            int ry = y + j - g->top;
+            int rx = x + g->left;
+            int ibegin = std::max (0, textroi.xbegin - rx);
+            int iend = std::min (g->width, textroi.xend - rx);
+            if (ry < textroi.ybegin || ry >= textroi.yend || ibegin >= iend)
+                continue;
+            const unsigned char *b = &g->pixels[size_t(j)*g->width];
+            float *t = (float *) textimg.pixeladdr (rx + ibegin, ry);
+            for (int i = ibegin;  i < iend;  ++i)
+                *t++ = b[i] / 255.0f;
         }
         // increment pen position
-        x += slot->advance.x >> 6;
+        x += g->advance;
     }
 
     // Generate the alpha image -- if drop shadow is requested, dilate,
@@ -888,21 +1008,11 @@ ImageBufAlgo::render_text (ImageBuf &R, int x, int y, string_view text,
     roi = roi_intersection (textroi, R.roi());
 
     // Now fill in the pixels of our destination image
-    float *pixelcolor = ALLOCA (float, nchannels);
-    ImageBuf::ConstIterator<float> t (textimg, roi, ImageBuf::WrapBlack);
-    ImageBuf::ConstIterator<float> a (alphaimg, roi, ImageBuf::WrapBlack);
-    ImageBuf::Iterator<float> r (R, roi);
-    for ( ;  !r.done();  ++r, ++t, ++a) {
-        float val = t[0];
-        float alpha = a[0];
-        R.getpixel (r.x(), r.y(), pixelcolor);
-        for (size_t c = 0;  c < nchannels;  ++c)
-            pixelcolor[c] = val*textcolor[c] + (1.0f-alpha) * pixelcolor[c];
-        R.setpixel (r.x(), r.y(), pixelcolor);
-    }
-
-    FT_Done_Face (face);
-    return true;
+    bool ok;
+    OIIO_DISPATCH_TYPES (ok, "render_text", render_text_composite_,
+                         R.spec().format, R, textimg, alphaimg,
+                         textcolor, roi);
+    return ok;
 
 #else
     R.error ("OpenImageIO was not compiled with FreeType for font rendering");
@@ -147,6 +147,8 @@ ImageBufAlgo::to_IplImage (const ImageBuf &src)
         DASSERT (0 && "Could not initialize ImageBuf.");
         return NULL;
     }
+    // The conversion below assumes scanline-major pixels
+    tmp.set_local_tiles (0);
 
     int dstFormat;
     TypeDesc dstSpecFormat;
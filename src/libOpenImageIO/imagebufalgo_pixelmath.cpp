@@ -45,6 +45,8 @@
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/simd.h>
 
+#include "simd_kernels.h"
+
 
 
 OIIO_NAMESPACE_BEGIN
@@ -116,12 +118,24 @@ add_impl (ImageBuf &R, const ImageBuf &A, const ImageBuf &B,
           ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
-        ImageBuf::Iterator<Rtype> r (R, roi);
-        ImageBuf::ConstIterator<Atype> a (A, roi);
-        ImageBuf::ConstIterator<Btype> b (B, roi);
-        for ( ;  !r.done();  ++r, ++a, ++b)
-            for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                r[c] = a[c] + b[c];
+        ImageBuf::SpanIterator<Rtype> r (R, roi);
+        ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+        ImageBuf::ConstSpanIterator<Btype> b (B, roi);
+        while (! r.done()) {
+            int n = std::min (r.npixels(), std::min (a.npixels(), b.npixels()));
+            if (r.exists()) {
+                Rtype *rp = r.data();
+                const Atype *ap = a.data();
+                const Btype *bp = b.data();
+                for (int i = 0;  i < n;  ++i, rp += r.stride(),
+                                     ap += a.stride(), bp += b.stride())
+                    for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                        rp[c] = convert_type<float,Rtype> (
+                                    convert_type<Atype,float>(ap[c]) +
+                                    convert_type<Btype,float>(bp[c]));
+            }
+            r.advance (n);  a.advance (n);  b.advance (n);
+        }
     });
     return true;
 }
@@ -149,11 +163,20 @@ add_impl (ImageBuf &R, const ImageBuf &A, const float *b,
                 }
             }
         } else {
-            ImageBuf::Iterator<Rtype> r (R, roi);
-            ImageBuf::ConstIterator<Atype> a (A, roi);
-            for ( ;  !r.done();  ++r, ++a)
-                for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                    r[c] = a[c] + b[c];
+            ImageBuf::SpanIterator<Rtype> r (R, roi);
+            ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+            while (! r.done()) {
+                int n = std::min (r.npixels(), a.npixels());
+                if (r.exists()) {
+                    Rtype *rp = r.data();
+                    const Atype *ap = a.data();
+                    for (int i = 0;  i < n;  ++i, rp += r.stride(), ap += a.stride())
+                        for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                            rp[c] = convert_type<float,Rtype> (
+                                        convert_type<Atype,float>(ap[c]) + b[c]);
+                }
+                r.advance (n);  a.advance (n);
+            }
         }
     });
     return true;
@@ -441,12 +464,24 @@ mul_impl (ImageBuf &R, const ImageBuf &A, const ImageBuf &B,
           ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
-        ImageBuf::Iterator<Rtype> r (R, roi);
-        ImageBuf::ConstIterator<Atype> a (A, roi);
-        ImageBuf::ConstIterator<Btype> b (B, roi);
-        for ( ;  !r.done();  ++r, ++a, ++b)
-            for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                r[c] = a[c] * b[c];
+        ImageBuf::SpanIterator<Rtype> r (R, roi);
+        ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+        ImageBuf::ConstSpanIterator<Btype> b (B, roi);
+        while (! r.done()) {
+            int n = std::min (r.npixels(), std::min (a.npixels(), b.npixels()));
+            if (r.exists()) {
+                Rtype *rp = r.data();
+                const Atype *ap = a.data();
+                const Btype *bp = b.data();
+                for (int i = 0;  i < n;  ++i, rp += r.stride(),
+                                     ap += a.stride(), bp += b.stride())
+                    for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                        rp[c] = convert_type<float,Rtype> (
+                                    convert_type<Atype,float>(ap[c]) *
+                                    convert_type<Btype,float>(bp[c]));
+            }
+            r.advance (n);  a.advance (n);  b.advance (n);
+        }
     });
     return true;
 }
@@ -493,10 +528,20 @@ mul_impl (ImageBuf &R, const ImageBuf &A, const float *b,
                 }
             }
         } else {
-            ImageBuf::ConstIterator<Atype> a (A, roi);
-            for (ImageBuf::Iterator<Rtype> r (R, roi);  !r.done();  ++r, ++a)
-                for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                    r[c] = a[c] * b[c];
+            ImageBuf::SpanIterator<Rtype> r (R, roi);
+            ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+            while (! r.done()) {
+                int n = std::min (r.npixels(), a.npixels());
+                if (r.exists()) {
+                    Rtype *rp = r.data();
+                    const Atype *ap = a.data();
+                    for (int i = 0;  i < n;  ++i, rp += r.stride(), ap += a.stride())
+                        for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                            rp[c] = convert_type<float,Rtype> (
+                                        convert_type<Atype,float>(ap[c]) * b[c]);
+                }
+                r.advance (n);  a.advance (n);
+            }
         }
     });
     return true;
@@ -628,52 +673,44 @@ mad_impl (ImageBuf &R, const ImageBuf &A, const ImageBuf &B, const ImageBuf &C,
           ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
-        if (   (is_same<Rtype,float>::value || is_same<Rtype,half>::value)
-            && (is_same<ABCtype,float>::value || is_same<ABCtype,half>::value)
-            // && R.localpixels() // has to be, because it's writeable
-            && A.localpixels() && B.localpixels() && C.localpixels()
-            // && R.contains_roi(roi)  // has to be, because IBAPrep
-            && A.contains_roi(roi) && B.contains_roi(roi) && C.contains_roi(roi)
-            && roi.chbegin == 0 && roi.chend == R.nchannels()
-            && roi.chend == A.nchannels() && roi.chend == B.nchannels()
-            && roi.chend == C.nchannels()) {
-            // Special case when all inputs are either float or half, with in-
-            // memory contiguous data and we're operating on the full channel
-            // range: skip iterators: For these circumstances, we can operate on
-            // the raw memory very efficiently. Otherwise, we will need the
-            // magic of the the Iterators (and pay the price).
-            int nxvalues = roi.width() * R.nchannels();
-            for (int z = roi.zbegin; z < roi.zend; ++z)
-                for (int y = roi.ybegin; y < roi.yend; ++y) {
-                    Rtype         *rraw =         (Rtype *) R.pixeladdr (roi.xbegin, y, z);
-                    const ABCtype *araw = (const ABCtype *) A.pixeladdr (roi.xbegin, y, z);
-                    const ABCtype *braw = (const ABCtype *) B.pixeladdr (roi.xbegin, y, z);
-                    const ABCtype *craw = (const ABCtype *) C.pixeladdr (roi.xbegin, y, z);
-                    DASSERT (araw && braw && craw);
-                    // The straightforward loop auto-vectorizes very well,
-                    // there's no benefit to using explicit SIMD here.
+        // When every span is in memory, holds all channels, and the types
+        // are float or half, the span is one flat array of values and the
+        // straightforward loop auto-vectorizes very well.  Otherwise, fall
+        // back to per-pixel channel loops (which still avoid Iterator
+        // overhead).
+        const bool flat = (is_same<Rtype,float>::value || is_same<Rtype,half>::value)
+                       && (is_same<ABCtype,float>::value || is_same<ABCtype,half>::value)
+                       && roi.chbegin == 0 && roi.chend == R.nchannels()
+                       && roi.chend == A.nchannels() && roi.chend == B.nchannels()
+                       && roi.chend == C.nchannels();
+        ImageBuf::SpanIterator<Rtype> r (R, roi);
+        ImageBuf::ConstSpanIterator<ABCtype> a (A, roi);
+        ImageBuf::ConstSpanIterator<ABCtype> b (B, roi);
+        ImageBuf::ConstSpanIterator<ABCtype> c (C, roi);
+        while (! r.done()) {
+            int n = std::min (std::min (r.npixels(), a.npixels()),
+                              std::min (b.npixels(), c.npixels()));
+            if (r.exists()) {
+                Rtype         *rraw = r.data();
+                const ABCtype *araw = a.data();
+                const ABCtype *braw = b.data();
+                const ABCtype *craw = c.data();
+                if (flat && a.exists() && b.exists() && c.exists()) {
+                    int nxvalues = n * R.nchannels();
                     for (int x = 0; x < nxvalues; ++x)
                         rraw[x] = araw[x] * braw[x] + craw[x];
-                    // But if you did want to explicitly vectorize, this is
-                    // how it would look:
-                    // int simdend = nxvalues & (~3); // how many float4's?
-                    // for (int x = 0; x < simdend; x += 4) {
-                    //     simd::float4 a_simd(araw+x), b_simd(braw+x), c_simd(craw+x);
-                    //     simd::float4 r_simd = a_simd * b_simd + c_simd;
-                    //     r_simd.store (rraw+x);
-                    // }
-                    // for (int x = simdend; x < nxvalues; ++x)
-                    //     rraw[x] = araw[x] * braw[x] + craw[x];
+                } else {
+                    for (int i = 0;  i < n;  ++i, rraw += r.stride(),
+                             araw += a.stride(), braw += b.stride(),
+                             craw += c.stride())
+                        for (int ch = roi.chbegin;  ch < roi.chend;  ++ch)
+                            rraw[ch] = convert_type<float,Rtype> (
+                                           convert_type<ABCtype,float>(araw[ch]) *
+                                           convert_type<ABCtype,float>(braw[ch]) +
+                                           convert_type<ABCtype,float>(craw[ch]));
                 }
-        } else {
-            ImageBuf::Iterator<Rtype> r (R, roi);
-            ImageBuf::ConstIterator<ABCtype> a (A, roi);
-            ImageBuf::ConstIterator<ABCtype> b (B, roi);
-            ImageBuf::ConstIterator<ABCtype> c (C, roi);
-            for ( ;  !r.done();  ++r, ++a, ++b, ++c) {
-                for (int ch = roi.chbegin;  ch < roi.chend;  ++ch)
-                    r[ch] = a[ch] * b[ch] + c[ch];
             }
+            r.advance (n);  a.advance (n);  b.advance (n);  c.advance (n);
         }
     });
     return true;
@@ -687,11 +724,20 @@ mad_implf (ImageBuf &R, const ImageBuf &A, const float *b, const float *c,
           ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
-        ImageBuf::Iterator<Rtype> r (R, roi);
-        ImageBuf::ConstIterator<Atype> a (A, roi);
-        for ( ;  !r.done();  ++r, ++a)
-            for (int ch = roi.chbegin;  ch < roi.chend;  ++ch)
-                r[ch] = a[ch] * b[ch] + c[ch];
+        ImageBuf::SpanIterator<Rtype> r (R, roi);
+        ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+        while (! r.done()) {
+            int n = std::min (r.npixels(), a.npixels());
+            if (r.exists()) {
+                Rtype *rp = r.data();
+                const Atype *ap = a.data();
+                for (int i = 0;  i < n;  ++i, rp += r.stride(), ap += a.stride())
+                    for (int ch = roi.chbegin;  ch < roi.chend;  ++ch)
+                        rp[ch] = convert_type<float,Rtype> (
+                                     convert_type<Atype,float>(ap[ch]) * b[ch] + c[ch]);
+            }
+            r.advance (n);  a.advance (n);
+        }
     });
     return true;
 }
@@ -1086,10 +1132,173 @@ ImageBufAlgo::rangeexpand (ImageBuf &dst, const ImageBuf &src,
 
 
 
+// SIMD helpers for the compositing kernels below (premult, unpremult,
+// over, zover), for the dominant case of whole RGBA pixels with alpha in
+// channel 3 and the same data type in every image.  One pixel is carried
+// in a vfloat4, normalized exactly the way convert_type() does it, so the
+// results match the generic per-channel loops.  half goes through
+// vfloat4's half load/store, which use F16C when it is enabled and a
+// table-based conversion otherwise.
+template<typename T>
+inline simd::vfloat4
+load_rgba (const T *p)
+{
+    return simd::vfloat4 (convert_type<T,float>(p[0]), convert_type<T,float>(p[1]),
+                          convert_type<T,float>(p[2]), convert_type<T,float>(p[3]));
+}
+
+template<> inline simd::vfloat4
+load_rgba (const float *p)
+{
+    return simd::vfloat4 (p);
+}
+
+template<> inline simd::vfloat4
+load_rgba (const half *p)
+{
+    simd::vfloat4 v;
+    v.load (p);
+    return v;
+}
+
+template<> inline simd::vfloat4
+load_rgba (const unsigned char *p)
+{
+    simd::vfloat4 v;
+    v.load (p);
+    return v * simd::vfloat4 (1.0f / std::numeric_limits<unsigned char>::max());
+}
+
+template<> inline simd::vfloat4
+load_rgba (const unsigned short *p)
+{
+    simd::vfloat4 v;
+    v.load (p);
+    return v * simd::vfloat4 (1.0f / std::numeric_limits<unsigned short>::max());
+}
+
+
+template<typename T>
+inline void
+store_rgba (T *p, const simd::vfloat4 &v)
+{
+    for (int c = 0;  c < 4;  ++c)
+        p[c] = convert_type<float,T>(v[c]);
+}
+
+template<> inline void
+store_rgba (float *p, const simd::vfloat4 &v)
+{
+    v.store (p);
+}
+
+template<> inline void
+store_rgba (half *p, const simd::vfloat4 &v)
+{
+    v.store (p);
+}
+
+template<> inline void
+store_rgba (unsigned char *p, const simd::vfloat4 &v)
+{
+    const float max = std::numeric_limits<unsigned char>::max();
+    simd::vint4 i (simd::min (simd::max (v * simd::vfloat4(max) + simd::vfloat4(0.5f),
+                                          simd::vfloat4::Zero()),
+                              simd::vfloat4(max)));
+    i.store (p);
+}
+
+template<> inline void
+store_rgba (unsigned short *p, const simd::vfloat4 &v)
+{
+    const float max = std::numeric_limits<unsigned short>::max();
+    simd::vint4 i (simd::min (simd::max (v * simd::vfloat4(max) + simd::vfloat4(0.5f),
+                                          simd::vfloat4::Zero()),
+                              simd::vfloat4(max)));
+    i.store (p);
+}
+
+
+// Can R = f(A [,B]) over roi use the RGBA SIMD kernels?  nchannels is
+// the required channel count (4, or 5 for RGBAZ with zover).
+static bool
+rgba_simd_ok (const ImageBuf &R, const ImageBuf &A, const ImageBuf *B,
+              ROI roi, int nchannels)
+{
+    const ImageSpec &spec (A.spec());
+    return roi.chbegin == 0 && roi.chend == nchannels
+        && spec.nchannels == nchannels && spec.alpha_channel == 3
+        && (nchannels == 4 ? spec.z_channel < 0 : spec.z_channel == 4)
+        && R.nchannels() == nchannels && R.spec().format == spec.format
+        && (! B || (B->nchannels() == nchannels && B->spec().format == spec.format))
+        && spec.channelformats.empty() && R.spec().channelformats.empty()
+        && (! B || B->spec().channelformats.empty());
+}
+
+
+template<class T>
+static void
+premult_rgba_simd (ImageBuf &R, const ImageBuf &A, ROI roi)
+{
+    const simd::vbool4 alphalane (false, false, false, true);
+    ImageBuf::SpanIterator<T> r (R, roi);
+    ImageBuf::ConstSpanIterator<T> a (A, roi);
+    while (! r.done()) {
+        int n = std::min (r.npixels(), a.npixels());
+        if (r.exists()) {
+            T *rp = r.data();
+            const T *ap = a.data();
+            for (int i = 0;  i < n;  ++i, rp += r.stride(), ap += a.stride()) {
+                simd::vfloat4 v = load_rgba (ap);
+                simd::vfloat4 alpha = simd::shuffle<3>(v);
+                store_rgba (rp, v * blend (alpha, simd::vfloat4::One(), alphalane));
+            }
+        }
+        r.advance (n);  a.advance (n);
+    }
+}
+
+
+template<class T>
+static void
+unpremult_rgba_simd (ImageBuf &R, const ImageBuf &A, ROI roi)
+{
+    // Dividing by 1 leaves a value unchanged, so alpha of 0 or 1 (which
+    // the generic code passes through) and the alpha channel itself
+    // just divide by 1 rather than branching.
+    const simd::vbool4 alphalane (false, false, false, true);
+    const simd::vfloat4 one = simd::vfloat4::One();
+    ImageBuf::SpanIterator<T> r (R, roi);
+    ImageBuf::ConstSpanIterator<T> a (A, roi);
+    while (! r.done()) {
+        int n = std::min (r.npixels(), a.npixels());
+        if (r.exists()) {
+            T *rp = r.data();
+            const T *ap = a.data();
+            for (int i = 0;  i < n;  ++i, rp += r.stride(), ap += a.stride()) {
+                simd::vfloat4 v = load_rgba (ap);
+                simd::vfloat4 alpha = simd::shuffle<3>(v);
+                simd::vbool4 passthru = (alpha == simd::vfloat4::Zero())
+                                      | (alpha == one) | alphalane;
+                store_rgba (rp, v / blend (alpha, one, passthru));
+            }
+        }
+        r.advance (n);  a.advance (n);
+    }
+}
+
+
+
 template<class Rtype, class Atype>
 static bool
 unpremult_ (ImageBuf &R, const ImageBuf &A, ROI roi, int nthreads)
 {
+    if (is_same<Rtype,Atype>::value && rgba_simd_ok (R, A, NULL, roi, 4)) {
+        ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+            unpremult_rgba_simd<Rtype> (R, A, roi);
+        });
+        return true;
+    }
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
         int alpha_channel = A.spec().alpha_channel;
         int z_channel = A.spec().z_channel;
@@ -1148,27 +1357,49 @@ template<class Rtype, class Atype>
 static bool
 premult_ (ImageBuf &R, const ImageBuf &A, ROI roi, int nthreads)
 {
+    if (is_same<Rtype,Atype>::value && rgba_simd_ok (R, A, NULL, roi, 4)) {
+        ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+            premult_rgba_simd<Rtype> (R, A, roi);
+        });
+        return true;
+    }
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
         int alpha_channel = A.spec().alpha_channel;
         int z_channel = A.spec().z_channel;
-            if (&R == &A) {
-            for (ImageBuf::Iterator<Rtype> r (R, roi);  !r.done();  ++r) {
-                float alpha = r[alpha_channel];
-                if (alpha == 1.0f)
+        if (&R == &A) {
+            for (ImageBuf::SpanIterator<Rtype> r (R, roi);  !r.done();  ++r) {
+                if (! r.exists())
                     continue;
-                for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                    if (c != alpha_channel && c != z_channel)
-                        r[c] = r[c] * alpha;
+                Rtype *rp = r.data();
+                for (int i = 0, n = r.npixels();  i < n;  ++i, rp += r.stride()) {
+                    float alpha = convert_type<Rtype,float>(rp[alpha_channel]);
+                    if (alpha == 1.0f)
+                        continue;
+                    for (int c = roi.chbegin;  c < roi.chend;  ++c)
+                        if (c != alpha_channel && c != z_channel)
+                            rp[c] = convert_type<float,Rtype> (
+                                        convert_type<Rtype,float>(rp[c]) * alpha);
+                }
             }
         } else {
-            ImageBuf::ConstIterator<Atype> a (A, roi);
-            for (ImageBuf::Iterator<Rtype> r (R, roi);  !r.done();  ++r, ++a) {
-                float alpha = a[alpha_channel];
-                for (int c = roi.chbegin;  c < roi.chend;  ++c)
-                    if (c != alpha_channel && c != z_channel)
-                        r[c] = a[c] * alpha;
-                    else
-                        r[c] = a[c];
+            ImageBuf::SpanIterator<Rtype> r (R, roi);
+            ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+            while (! r.done()) {
+                int n = std::min (r.npixels(), a.npixels());
+                if (r.exists()) {
+                    Rtype *rp = r.data();
+                    const Atype *ap = a.data();
+                    for (int i = 0;  i < n;  ++i, rp += r.stride(), ap += a.stride()) {
+                        float alpha = convert_type<Atype,float>(ap[alpha_channel]);
+                        for (int c = roi.chbegin;  c < roi.chend;  ++c) {
+                            float v = convert_type<Atype,float>(ap[c]);
+                            if (c != alpha_channel && c != z_channel)
+                                v *= alpha;
+                            rp[c] = convert_type<float,Rtype>(v);
+                        }
+                    }
+                }
+                r.advance (n);  a.advance (n);
             }
         }
     });
@@ -1511,12 +1742,70 @@ decode_over_channels (const ImageBuf &R, int &nchannels,
 
 
 
+// RGBA (or RGBAZ, for zover) case of over_impl: A, B, and R all have
+// data type T and alpha in channel 3 (and Z in channel 4).
+template<class T>
+static void
+over_rgba_simd (ImageBuf &R, const ImageBuf &A, const ImageBuf &B,
+                bool zcomp, bool z_zeroisinf, ROI roi)
+{
+    const bool has_z = (R.nchannels() == 5);
+    const float inf = std::numeric_limits<float>::max();
+    const simd::vfloat4 zero = simd::vfloat4::Zero(), one = simd::vfloat4::One();
+    const pvt::SimdKernels &kernels (pvt::simd_kernels());
+    ImageBuf::SpanIterator<T> r (R, roi);
+    ImageBuf::ConstSpanIterator<T> a (A, roi);
+    ImageBuf::ConstSpanIterator<T> b (B, roi);
+    while (! r.done()) {
+        int n = std::min (r.npixels(), std::min (a.npixels(), b.npixels()));
+        if (r.exists() && is_same<T,float>::value && ! has_z &&
+              r.stride() == 4 && a.stride() == 4 && b.stride() == 4) {
+            // Contiguous float RGBA: the runtime-dispatched wide kernel
+            kernels.over_rgba ((const float *)a.data(), (const float *)b.data(),
+                               (float *)r.data(), n);
+        } else if (r.exists()) {
+            T *rp = r.data();
+            const T *ap = a.data();
+            const T *bp = b.data();
+            for (int i = 0;  i < n;  ++i, rp += r.stride(),
+                                 ap += a.stride(), bp += b.stride()) {
+                const T *front = ap, *back = bp;
+                if (zcomp && has_z) {
+                    float az = convert_type<T,float>(ap[4]);
+                    float bz = convert_type<T,float>(bp[4]);
+                    if (z_zeroisinf) {
+                        if (az == 0.0f) az = inf;
+                        if (bz == 0.0f) bz = inf;
+                    }
+                    if (! (az <= bz))
+                        std::swap (front, back);
+                }
+                simd::vfloat4 f = load_rgba (front);
+                simd::vfloat4 alpha = simd::min (simd::max (simd::shuffle<3>(f), zero), one);
+                store_rgba (rp, f + (one - alpha) * load_rgba (back));
+                if (has_z)
+                    rp[4] = (alpha[0] != 0.0f) ? front[4] : back[4];
+            }
+        }
+        r.advance (n);  a.advance (n);  b.advance (n);
+    }
+}
+
+
+
 // Fully type-specialized version of over.
 template<class Rtype, class Atype, class Btype>
 static bool
 over_impl (ImageBuf &R, const ImageBuf &A, const ImageBuf &B,
            bool zcomp, bool z_zeroisinf, ROI roi, int nthreads)
 {
+    if (is_same<Rtype,Atype>::value && is_same<Rtype,Btype>::value &&
+          rgba_simd_ok (R, A, &B, roi, zcomp ? 5 : 4)) {
+        ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
+            over_rgba_simd<Rtype> (R, A, B, zcomp, z_zeroisinf, roi);
+        });
+        return true;
+    }
     ImageBufAlgo::parallel_image (roi, nthreads, [&](ROI roi){
         // It's already guaranteed that R, A, and B have matching channel
         // ordering, and have an alpha channel.  So just decode one.
@@ -1525,37 +1814,57 @@ over_impl (ImageBuf &R, const ImageBuf &A, const ImageBuf &B,
                               z_channel, ncolor_channels);
         bool has_z = (z_channel >= 0);
 
-        ImageBuf::ConstIterator<Atype> a (A, roi);
-        ImageBuf::ConstIterator<Btype> b (B, roi);
-        ImageBuf::Iterator<Rtype> r (R, roi);
-        for ( ; ! r.done(); ++r, ++a, ++b) {
-            float az = 0.0f, bz = 0.0f;
-            bool a_is_closer = true;  // will remain true if !zcomp
-            if (zcomp && has_z) {
-                az = a[z_channel];
-                bz = b[z_channel];
-                if (z_zeroisinf) {
-                    if (az == 0.0f) az = std::numeric_limits<float>::max();
-                    if (bz == 0.0f) bz = std::numeric_limits<float>::max();
-                }
-                a_is_closer = (az <= bz);
+        ImageBuf::SpanIterator<Rtype> r (R, roi);
+        ImageBuf::ConstSpanIterator<Atype> a (A, roi);
+        ImageBuf::ConstSpanIterator<Btype> b (B, roi);
+        while (! r.done()) {
+            int n = std::min (r.npixels(), std::min (a.npixels(), b.npixels()));
+            if (! r.exists()) {
+                r.advance (n);  a.advance (n);  b.advance (n);
+                continue;
             }
-            if (a_is_closer) {
-                // A over B
-                float alpha = clamp (a[alpha_channel], 0.0f, 1.0f);
-                float one_minus_alpha = 1.0f - alpha;
-                for (int c = roi.chbegin;  c < roi.chend;  c++)
-                    r[c] = a[c] + one_minus_alpha * b[c];
-                if (has_z)
-                    r[z_channel] = (alpha != 0.0) ? a[z_channel] : b[z_channel];
-            } else {
-                // B over A -- because we're doing a Z composite
-                float alpha = clamp (b[alpha_channel], 0.0f, 1.0f);
-                float one_minus_alpha = 1.0f - alpha;
-                for (int c = roi.chbegin;  c < roi.chend;  c++)
-                    r[c] = b[c] + one_minus_alpha * a[c];
-                r[z_channel] = (alpha != 0.0) ? b[z_channel] : a[z_channel];
+            Rtype *rp = r.data();
+            const Atype *ap = a.data();
+            const Btype *bp = b.data();
+            for (int i = 0;  i < n;  ++i, rp += r.stride(),
+                                 ap += a.stride(), bp += b.stride()) {
+                float az = 0.0f, bz = 0.0f;
+                bool a_is_closer = true;  // will remain true if !zcomp
+                if (zcomp && has_z) {
+                    az = convert_type<Atype,float>(ap[z_channel]);
+                    bz = convert_type<Btype,float>(bp[z_channel]);
+                    if (z_zeroisinf) {
+                        if (az == 0.0f) az = std::numeric_limits<float>::max();
+                        if (bz == 0.0f) bz = std::numeric_limits<float>::max();
+                    }
+                    a_is_closer = (az <= bz);
+                }
+                if (a_is_closer) {
+                    // A over B
+                    float alpha = clamp (convert_type<Atype,float>(ap[alpha_channel]), 0.0f, 1.0f);
+                    float one_minus_alpha = 1.0f - alpha;
+                    for (int c = roi.chbegin;  c < roi.chend;  c++)
+                        rp[c] = convert_type<float,Rtype> (
+                                    convert_type<Atype,float>(ap[c]) +
+                                    one_minus_alpha * convert_type<Btype,float>(bp[c]));
+                    if (has_z)
+                        rp[z_channel] = convert_type<float,Rtype> ((alpha != 0.0)
+                                            ? convert_type<Atype,float>(ap[z_channel])
+                                            : convert_type<Btype,float>(bp[z_channel]));
+                } else {
+                    // B over A -- because we're doing a Z composite
+                    float alpha = clamp (convert_type<Btype,float>(bp[alpha_channel]), 0.0f, 1.0f);
+                    float one_minus_alpha = 1.0f - alpha;
+                    for (int c = roi.chbegin;  c < roi.chend;  c++)
+                        rp[c] = convert_type<float,Rtype> (
+                                    convert_type<Btype,float>(bp[c]) +
+                                    one_minus_alpha * convert_type<Atype,float>(ap[c]));
+                    rp[z_channel] = convert_type<float,Rtype> ((alpha != 0.0)
+                                        ? convert_type<Btype,float>(bp[z_channel])
+                                        : convert_type<Atype,float>(ap[z_channel]));
+                }
             }
+            r.advance (n);  a.advance (n);  b.advance (n);
         }
     });
 
@@ -1597,4 +1906,540 @@ ImageBufAlgo::zover (ImageBuf &dst, const ImageBuf &A, const ImageBuf &B,
 
 
 
+// Pipeline: deferred, fused point operations.
+
+namespace {
+
+enum PipeOpType {
+    PipeAdd, PipeMul, PipePow, PipeAbsDiff, PipeAbs, PipeClamp,
+    PipePremult, PipeUnpremult, PipeChannels, PipeColorConvert
+};
+
+struct PipeOp {
+    PipeOpType type;
+    int nchannels;                  // channels of the input to this op
+    std::vector<float> a, b;        // per-channel values (e.g. min, max)
+    std::vector<int> order;         // for channels()
+    int alpha_channel, z_channel;
+    bool flag;                      // clampalpha01, or unpremult
+    std::shared_ptr<const ColorProcessor> processor;
+};
+
+}  // anon namespace
+
+
+class ImageBufAlgo::Pipeline::Impl {
+public:
+    ImageSpec m_inspec, m_spec;
+    std::vector<PipeOp> m_ops;
+    int m_maxchannels;              // widest the pixels get at any stage
+    std::string m_err;
+
+    Impl (const ImageSpec &inspec)
+        : m_inspec(inspec), m_spec(inspec),
+          m_maxchannels(inspec.nchannels) { }
+
+    PipeOp & newop (PipeOpType type) {
+        m_ops.emplace_back ();
+        PipeOp &op (m_ops.back());
+        op.type = type;
+        op.nchannels = m_spec.nchannels;
+        op.alpha_channel = m_spec.alpha_channel;
+        op.z_channel = m_spec.z_channel;
+        op.flag = false;
+        return op;
+    }
+
+    void perchannel (PipeOpType type, const float *b) {
+        PipeOp &op (newop (type));
+        op.a.assign (b, b + m_spec.nchannels);
+    }
+
+    void run (const PipeOp &op, float *pixels, int npixels, int stride) const;
+};
+
+
+
+ImageBufAlgo::Pipeline::Pipeline (const ImageSpec &inspec)
+    : m_impl (new Impl (inspec))
+{
+}
+
+
+
+ImageBufAlgo::Pipeline::Pipeline (const Pipeline &p)
+    : m_impl (new Impl (*p.m_impl))
+{
+}
+
+
+
+ImageBufAlgo::Pipeline::~Pipeline ()
+{
+}
+
+
+
+const ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::operator= (const Pipeline &p)
+{
+    if (&p != this)
+        *m_impl = *p.m_impl;
+    return *this;
+}
+
+
+
+size_t
+ImageBufAlgo::Pipeline::size () const
+{
+    return m_impl->m_ops.size();
+}
+
+
+
+const ImageSpec &
+ImageBufAlgo::Pipeline::inspec () const
+{
+    return m_impl->m_inspec;
+}
+
+
+
+const ImageSpec &
+ImageBufAlgo::Pipeline::spec () const
+{
+    return m_impl->m_spec;
+}
+
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::add (const float *b)
+{
+    m_impl->perchannel (PipeAdd, b);
+    return *this;
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::add (float b)
+{
+    std::vector<float> vals (spec().nchannels, b);
+    return add (&vals[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::sub (const float *b)
+{
+    std::vector<float> vals (b, b + spec().nchannels);
+    for (auto &v : vals)
+        v = -v;
+    return add (&vals[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::sub (float b)
+{
+    return add (-b);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::mul (const float *b)
+{
+    m_impl->perchannel (PipeMul, b);
+    return *this;
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::mul (float b)
+{
+    std::vector<float> vals (spec().nchannels, b);
+    return mul (&vals[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::div (const float *b)
+{
+    // Same as div(): multiply by the reciprocal, with x/0 giving 0.
+    std::vector<float> binv (b, b + spec().nchannels);
+    for (auto &v : binv)
+        v = (v == 0.0f) ? 0.0f : 1.0f/v;
+    return mul (&binv[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::div (float b)
+{
+    std::vector<float> vals (spec().nchannels, b);
+    return div (&vals[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::pow (const float *b)
+{
+    m_impl->perchannel (PipePow, b);
+    return *this;
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::pow (float b)
+{
+    std::vector<float> vals (spec().nchannels, b);
+    return pow (&vals[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::absdiff (const float *b)
+{
+    m_impl->perchannel (PipeAbsDiff, b);
+    return *this;
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::absdiff (float b)
+{
+    std::vector<float> vals (spec().nchannels, b);
+    return absdiff (&vals[0]);
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::abs ()
+{
+    m_impl->newop (PipeAbs);
+    return *this;
+}
+
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::clamp (const float *min, const float *max,
+                               bool clampalpha01)
+{
+    PipeOp &op (m_impl->newop (PipeClamp));
+    const float big = std::numeric_limits<float>::max();
+    if (min)
+        op.a.assign (min, min + op.nchannels);
+    else
+        op.a.resize (op.nchannels, -big);
+    if (max)
+        op.b.assign (max, max + op.nchannels);
+    else
+        op.b.resize (op.nchannels, big);
+    op.flag = clampalpha01;
+    return *this;
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::clamp (float min, float max, bool clampalpha01)
+{
+    std::vector<float> minvec (spec().nchannels, min);
+    std::vector<float> maxvec (spec().nchannels, max);
+    return clamp (&minvec[0], &maxvec[0], clampalpha01);
+}
+
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::premult ()
+{
+    // Without an alpha channel, premult() is just a copy
+    if (spec().alpha_channel >= 0)
+        m_impl->newop (PipePremult);
+    return *this;
+}
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::unpremult ()
+{
+    if (spec().alpha_channel >= 0)
+        m_impl->newop (PipeUnpremult);
+    return *this;
+}
+
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::channels (int nchannels, const int *channelorder,
+                                  const float *channelvalues,
+                                  const std::string *newchannelnames,
+                                  bool shuffle_channel_names)
+{
+    const ImageSpec src = spec();
+    if (nchannels <= 0 || src.nchannels == 0) {
+        error (Strutil::format ("%d-channel images not supported",
+                                nchannels <= 0 ? nchannels : src.nchannels));
+        return *this;
+    }
+    std::vector<int> order (nchannels);
+    for (int c = 0;  c < nchannels;  ++c)
+        order[c] = channelorder ? channelorder[c] : c;
+    bool inorder = (nchannels == src.nchannels);
+    for (int c = 0;  c < nchannels && inorder;  ++c) {
+        inorder &= (order[c] == c);
+        if (newchannelnames && newchannelnames[c].size())
+            inorder &= (newchannelnames[c] == src.channelnames[c]);
+    }
+    if (inorder)
+        return *this;
+
+    // Work out the new channel names and designations just as channels()
+    // does.
+    ImageSpec &newspec (m_impl->m_spec);
+    newspec.nchannels = nchannels;
+    newspec.default_channel_names ();
+    newspec.channelformats.clear();
+    newspec.alpha_channel = -1;
+    newspec.z_channel = -1;
+    bool all_same_type = true;
+    for (int c = 0; c < nchannels;  ++c) {
+        int csrc = order[c];
+        bool valid = (csrc >= 0 && csrc < src.nchannels);
+        if (newchannelnames && newchannelnames[c].size())
+            newspec.channelnames[c] = newchannelnames[c];
+        else if (valid)
+            newspec.channelnames[c] = src.channelnames[csrc];
+        TypeDesc type = valid ? src.channelformat(csrc) : src.format;
+        newspec.channelformats.push_back (type);
+        if (type != newspec.channelformats.front())
+            all_same_type = false;
+        if ((shuffle_channel_names && csrc == src.alpha_channel) ||
+              Strutil::iequals (newspec.channelnames[c], "A") ||
+              Strutil::iequals (newspec.channelnames[c], "alpha"))
+            newspec.alpha_channel = c;
+        if ((shuffle_channel_names && csrc == src.z_channel) ||
+              Strutil::iequals (newspec.channelnames[c], "Z"))
+            newspec.z_channel = c;
+    }
+    if (all_same_type)
+        newspec.channelformats.clear();
+
+    m_impl->m_ops.emplace_back ();
+    PipeOp &op (m_impl->m_ops.back());
+    op.type = PipeChannels;
+    op.nchannels = src.nchannels;
+    op.alpha_channel = op.z_channel = -1;
+    op.flag = false;
+    op.order = order;
+    op.a.resize (nchannels, 0.0f);
+    for (int c = 0;  c < nchannels;  ++c) {
+        if (order[c] >= src.nchannels)
+            op.order[c] = -1;
+        if (op.order[c] < 0 && channelvalues)
+            op.a[c] = channelvalues[c];
+    }
+    m_impl->m_maxchannels = std::max (m_impl->m_maxchannels, nchannels);
+    return *this;
+}
+
+
+
+ImageBufAlgo::Pipeline&
+ImageBufAlgo::Pipeline::colorconvert (std::shared_ptr<const ColorProcessor> processor,
+                                      bool unpremult, string_view tospace)
+{
+    if (tospace.size())
+        m_impl->m_spec.attribute ("oiio:ColorSpace", tospace);
+    if (! processor)
+        return *this;   // no-op transform
+    PipeOp &op (m_impl->newop (PipeColorConvert));
+    op.processor = processor;
+    op.flag = unpremult;
+    // The processor always sees 4 channels
+    m_impl->m_maxchannels = std::max (m_impl->m_maxchannels, 4);
+    return *this;
+}
+
+
+
+void
+ImageBufAlgo::Pipeline::error (const std::string &message)
+{
+    if (m_impl->m_err.size() && m_impl->m_err.back() != '\n')
+        m_impl->m_err += '\n';
+    m_impl->m_err += message;
+}
+
+
+
+bool
+ImageBufAlgo::Pipeline::has_error () const
+{
+    return ! m_impl->m_err.empty();
+}
+
+
+
+std::string
+ImageBufAlgo::Pipeline::geterror () const
+{
+    std::string e;
+    std::swap (e, m_impl->m_err);
+    return e;
+}
+
+
+
+// Run one operation on npixels pixels, each of which is 'stride' floats
+// apart.
+void
+ImageBufAlgo::Pipeline::Impl::run (const PipeOp &op, float *pixels,
+                                   int npixels, int stride) const
+{
+    int nc = op.nchannels;
+    const float *a = op.a.size() ? &op.a[0] : NULL;
+    const float *b = op.b.size() ? &op.b[0] : NULL;
+    float *end = pixels + npixels*stride;
+    switch (op.type) {
+    case PipeAdd:
+        for (float *p = pixels;  p < end;  p += stride)
+            for (int c = 0;  c < nc;  ++c)
+                p[c] += a[c];
+        break;
+    case PipeMul:
+        for (float *p = pixels;  p < end;  p += stride)
+            for (int c = 0;  c < nc;  ++c)
+                p[c] *= a[c];
+        break;
+    case PipePow:
+        for (float *p = pixels;  p < end;  p += stride)
+            for (int c = 0;  c < nc;  ++c)
+                p[c] = std::pow (p[c], a[c]);
+        break;
+    case PipeAbsDiff:
+        for (float *p = pixels;  p < end;  p += stride)
+            for (int c = 0;  c < nc;  ++c)
+                p[c] = std::abs (p[c] - a[c]);
+        break;
+    case PipeAbs:
+        for (float *p = pixels;  p < end;  p += stride)
+            for (int c = 0;  c < nc;  ++c)
+                p[c] = std::abs (p[c]);
+        break;
+    case PipeClamp:
+        for (float *p = pixels;  p < end;  p += stride) {
+            for (int c = 0;  c < nc;  ++c)
+                p[c] = OIIO::clamp (p[c], a[c], b[c]);
+            if (op.flag && op.alpha_channel >= 0)
+                p[op.alpha_channel] = OIIO::clamp (p[op.alpha_channel], 0.0f, 1.0f);
+        }
+        break;
+    case PipePremult:
+        for (float *p = pixels;  p < end;  p += stride) {
+            float alpha = p[op.alpha_channel];
+            if (alpha == 1.0f)
+                continue;
+            for (int c = 0;  c < nc;  ++c)
+                if (c != op.alpha_channel && c != op.z_channel)
+                    p[c] *= alpha;
+        }
+        break;
+    case PipeUnpremult:
+        for (float *p = pixels;  p < end;  p += stride) {
+            float alpha = p[op.alpha_channel];
+            if (alpha == 0.0f || alpha == 1.0f)
+                continue;
+            for (int c = 0;  c < nc;  ++c)
+                if (c != op.alpha_channel && c != op.z_channel)
+                    p[c] /= alpha;
+        }
+        break;
+    case PipeChannels: {
+        int newnc = (int) op.order.size();
+        float *tmp = OIIO_ALLOCA (float, newnc);
+        for (float *p = pixels;  p < end;  p += stride) {
+            for (int c = 0;  c < newnc;  ++c)
+                tmp[c] = op.order[c] < 0 ? a[c] : p[op.order[c]];
+            std::copy_n (tmp, newnc, p);
+        }
+        break;
+    }
+    case PipeColorConvert:
+        run_colorconvert (op.processor.get(), op.flag, pixels, npixels,
+                          nc, stride);
+        break;
+    }
+}
+
+
+
+bool
+ImageBufAlgo::Pipeline::apply (ImageBuf &dst, const ImageBuf &src,
+                               ROI roi, int nthreads) const
+{
+    const Impl &impl (*m_impl);
+    if (impl.m_err.size()) {
+        dst.error ("%s", impl.m_err);
+        return false;
+    }
+    if (src.initialized() && src.nchannels() != impl.m_inspec.nchannels) {
+        dst.error ("Pipeline expected %d channels, but the image has %d",
+                   impl.m_inspec.nchannels, src.nchannels());
+        return false;
+    }
+    // An uninitialized dst gets src's pixel type, with the channels and
+    // metadata that the operations leave it with.
+    ImageSpec newspec = impl.m_spec;
+    if (src.initialized()) {
+        newspec.set_format (src.spec().format);
+        newspec.channelformats = impl.m_spec.channelformats;
+    }
+    if (! IBAprep (roi, &dst, &src, NULL, NULL, &newspec,
+                   IBAprep_NO_SUPPORT_VOLUME))
+        return false;
+    if (dst.nchannels() != impl.m_spec.nchannels) {
+        dst.error ("Pipeline produces %d channels, but the destination has %d",
+                   impl.m_spec.nchannels, dst.nchannels());
+        return false;
+    }
+    if (impl.m_ops.empty())
+        return ImageBufAlgo::paste (dst, roi.xbegin, roi.ybegin, roi.zbegin,
+                                    0, src, roi, nthreads);
+
+    int inchans = src.nchannels(), outchans = dst.nchannels();
+    int stride = impl.m_maxchannels;
+    // Blocks of about 64KB, so that each one stays in cache through the
+    // whole sequence of operations.
+    int blockpixels = std::max (64, 16384 / stride);
+    parallel_image (roi, nthreads, [&](ROI roi){
+        int width = roi.width();
+        int bw = std::min (width, blockpixels);
+        int bh = (bw == width) ? std::max (1, blockpixels / width) : 1;
+        std::vector<float> buf (bw * bh * stride);
+        for (int y = roi.ybegin;  y < roi.yend;  y += bh) {
+            int yend = std::min (y + bh, roi.yend);
+            for (int x = roi.xbegin;  x < roi.xend;  x += bw) {
+                int xend = std::min (x + bw, roi.xend);
+                int npixels = (xend - x) * (yend - y);
+                stride_t xstride = stride * sizeof(float);
+                stride_t ystride = (xend - x) * xstride;
+                src.get_pixels (ROI (x, xend, y, yend, roi.zbegin, roi.zend,
+                                     0, inchans),
+                                TypeDesc::FLOAT, &buf[0], xstride, ystride);
+                for (const PipeOp &op : impl.m_ops)
+                    impl.run (op, &buf[0], npixels, stride);
+                dst.set_pixels (ROI (x, xend, y, yend, roi.zbegin, roi.zend,
+                                     0, outchans),
+                                TypeDesc::FLOAT, &buf[0], xstride, ystride);
+            }
+        }
+    });
+    return true;
+}
+
+
+
 OIIO_NAMESPACE_END
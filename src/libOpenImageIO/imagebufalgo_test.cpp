@@ -31,16 +31,25 @@
 // Based on the sample at:
 // http://code.google.com/p/googletest/wiki/GoogleTestPrimer#Writing_the_main()_Function
 
+#include <OpenEXR/half.h>
+
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/deepdata.h>
+#include <OpenImageIO/filter.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/color.h>
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/unittest.h>
+#include <OpenImageIO/strutil.h>
 
+#include <algorithm>
+#include <complex>
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <string>
 #include <cstdio>
 
@@ -424,6 +433,45 @@ void test_mad ()
 
 
 
+// Tests ImageBufAlgo::Pipeline against running the same ops one by one
+void test_pipeline ()
+{
+    std::cout << "test pipeline\n";
+    const int WIDTH = 300, HEIGHT = 70, CHANNELS = 4;
+    ImageSpec spec (WIDTH, HEIGHT, CHANNELS, TypeDesc::FLOAT);
+    spec.alpha_channel = 3;
+    ImageBuf A (spec);
+    const float tl[CHANNELS] = { 0.0, 0.5, 1.0, 1.0 };
+    const float tr[CHANNELS] = { 1.0, 0.0, 0.25, 0.5 };
+    const float bl[CHANNELS] = { 0.5, 1.0, 0.0, 0.0 };
+    const float br[CHANNELS] = { 2.0, 0.75, 0.5, 0.25 };
+    ImageBufAlgo::fill (A, tl, tr, bl, br);
+
+    const float mulval[CHANNELS] = { 0.5, 2.0, 1.0, 1.0 };
+    const int order[3] = { 2, 1, 0 };
+    ImageBuf T1, T2, T3, T4, R;
+    ImageBufAlgo::mul (T1, A, mulval);
+    ImageBufAlgo::add (T2, T1, 0.125f);
+    ImageBufAlgo::clamp (T3, T2, 0.0f, 1.0f, true);
+    ImageBufAlgo::premult (T4, T3);
+    ImageBufAlgo::channels (R, T4, 3, order);
+
+    ImageBufAlgo::Pipeline p (A.spec());
+    p.mul (mulval).add (0.125f).clamp (0.0f, 1.0f, true).premult();
+    p.channels (3, order);
+    OIIO_CHECK_EQUAL (int(p.size()), 5);
+    OIIO_CHECK_EQUAL (p.spec().nchannels, 3);
+    ImageBuf P;
+    OIIO_CHECK_ASSERT (p.apply (P, A));
+    OIIO_CHECK_EQUAL (P.nchannels(), 3);
+    OIIO_CHECK_EQUAL (P.roi(), R.roi());
+    ImageBufAlgo::CompareResults comp;
+    ImageBufAlgo::compare (R, P, 1e-6, 1e-6, comp);
+    OIIO_CHECK_EQUAL (comp.maxerror, 0.0);
+}
+
+
+
 // Tests ImageBufAlgo::compare
 void test_compare ()
 {
@@ -470,6 +518,36 @@ void test_compare ()
 
 
 
+// Tests compare and compare_pass of a view of some of the channels of
+// an image, whose pixels are not packed in memory.
+void test_compare_channel_view ()
+{
+    std::cout << "test compare channel view\n";
+    // A holds 0..15 in memory, C holds 0..7.  The first two channels of
+    // A differ from C everywhere but the first pixel, even though the
+    // first 8 floats of A are identical to C.
+    ImageBuf A (ImageSpec (4, 1, 4, TypeDesc::FLOAT));
+    ImageBuf C (ImageSpec (4, 1, 2, TypeDesc::FLOAT));
+    for (int x = 0;  x < 4;  ++x) {
+        float a[4] = { float(4*x), float(4*x+1), float(4*x+2), float(4*x+3) };
+        float c[2] = { float(2*x), float(2*x+1) };
+        A.setpixel (x, 0, a, 4);
+        C.setpixel (x, 0, c, 2);
+    }
+    ImageBuf V;
+    OIIO_CHECK_ASSERT (V.make_view (A, ROI (0, 4, 0, 1, 0, 1, 0, 2)));
+    ImageBufAlgo::CompareResults comp;
+    ImageBufAlgo::compare (V, C, 0.5f, 0.5f, comp);
+    OIIO_CHECK_EQUAL (comp.nfail, 3);
+    OIIO_CHECK_EQUAL (comp.maxerror, 6.0);
+    OIIO_CHECK_EQUAL (comp.maxx, 3);
+    OIIO_CHECK_ASSERT (! ImageBufAlgo::compare_pass (V, C, 0.5f));
+    OIIO_CHECK_ASSERT (! ImageBufAlgo::compare_pass (C, V, 0.5f));
+    OIIO_CHECK_ASSERT (ImageBufAlgo::compare_pass (V, C, 0.5f, 3));
+}
+
+
+
 // Tests ImageBufAlgo::isConstantColor
 void test_isConstantColor ()
 {
@@ -573,6 +651,52 @@ void test_computePixelStats ()
 
 
 
+// Test computePixelHash with each algorithm
+void
+test_computePixelHash ()
+{
+    std::cout << "test computePixelHash\n";
+    ImageSpec spec (16, 600, 3, TypeDesc::UINT8);
+    ImageBuf A (spec);
+    float pink[] = { 0.5f, 0.3f, 0.3f }, green[] = { 0.1f, 0.5f, 0.1f };
+    ImageBufAlgo::checker (A, 4, 3, 1, pink, green);
+    ImageBuf B;
+    B.copy (A);
+
+    // A sub-region that isn't full width must hash the same as the same
+    // pixels in an image of their own.
+    ROI sub (2, 11, 5, 500);
+    ImageBuf C;
+    ImageBufAlgo::cut (C, A, sub);
+
+    const char *algs[] = { "xxh64", "farmhash128", "sha1" };
+    for (auto alg : algs) {
+        std::string h = ImageBufAlgo::computePixelHash (A, alg, "", ROI::All(), 64);
+        OIIO_CHECK_ASSERT (h.size());
+        OIIO_CHECK_EQUAL (h, ImageBufAlgo::computePixelHash (B, alg, "", ROI::All(), 64));
+        OIIO_CHECK_EQUAL (h, ImageBufAlgo::computePixelHash (A, alg, "", ROI::All(), 64, 1));
+        OIIO_CHECK_NE (h, ImageBufAlgo::computePixelHash (A, alg, "extra", ROI::All(), 64));
+        OIIO_CHECK_EQUAL (ImageBufAlgo::computePixelHash (A, alg, "", sub, 64),
+                          ImageBufAlgo::computePixelHash (C, alg, "", ROI::All(), 64));
+    }
+    OIIO_CHECK_EQUAL (ImageBufAlgo::computePixelHash (A, "xxh64").size(), size_t(16));
+    OIIO_CHECK_EQUAL (ImageBufAlgo::computePixelHash (A, "farmhash128").size(), size_t(32));
+    OIIO_CHECK_EQUAL (ImageBufAlgo::computePixelHash (A, "sha1", "", ROI::All(), 64),
+                      ImageBufAlgo::computePixelHashSHA1 (A, "", ROI::All(), 64));
+
+    // Changing one pixel changes the hash
+    std::string before = ImageBufAlgo::computePixelHash (B, "xxh64");
+    B.setpixel (7, 333, green);
+    OIIO_CHECK_NE (before, ImageBufAlgo::computePixelHash (B, "xxh64"));
+
+    // Unknown algorithms are an error
+    OIIO_CHECK_EQUAL (ImageBufAlgo::computePixelHash (A, "md5"), "");
+    OIIO_CHECK_ASSERT (A.has_error());
+    A.geterror ();
+}
+
+
+
 // Tests histogram computation.
 void histogram_computation_test ()
 {
@@ -652,6 +776,166 @@ test_maketx_from_imagebuf()
 
 
 
+// Make a texture from each of src and ref, and check that every MIP level
+// of the two is identical.
+static void
+check_same_texture (const ImageBuf &src, const ImageBuf &ref)
+{
+    const char *srcname = "oiio-maketx-src.exr";
+    const char *refname = "oiio-maketx-ref.exr";
+    ImageSpec configspec;
+    OIIO_CHECK_ASSERT (ImageBufAlgo::make_texture (ImageBufAlgo::MakeTxTexture,
+                                                   src, srcname, configspec));
+    OIIO_CHECK_ASSERT (ImageBufAlgo::make_texture (ImageBufAlgo::MakeTxTexture,
+                                                   ref, refname, configspec));
+    ImageBuf S (srcname), R (refname);
+    OIIO_CHECK_ASSERT (R.nmiplevels() > 1);
+    OIIO_CHECK_EQUAL (S.nmiplevels(), R.nmiplevels());
+    OIIO_CHECK_EQUAL (S.nchannels(), R.nchannels());
+    for (int m = 0;  m < R.nmiplevels();  ++m) {
+        ImageBuf Sm (srcname, 0, m), Rm (refname, 0, m);
+        OIIO_CHECK_EQUAL (Sm.roi(), Rm.roi());
+        ImageBufAlgo::CompareResults comparison;
+        ImageBufAlgo::compare (Sm, Rm, 0.0f, 0.0f, comparison);
+        OIIO_CHECK_EQUAL (comparison.nfail, 0);
+    }
+    remove (srcname);  // clean up
+    remove (refname);
+}
+
+
+
+// Test make_texture from ImageBufs whose local pixels aren't one plain
+// scanline-major block: a channel subset and an ROI of another image
+// (as oiiotool's --ch, --crop and --cut make before -otex), and
+// tile-major pixels.
+void
+test_maketx_from_views ()
+{
+    std::cout << "test make_texture from views\n";
+    ImageBuf A (ImageSpec (40, 32, 4, TypeDesc::FLOAT));
+    float pink[] = { 0.5f, 0.3f, 0.3f, 1.0f };
+    float green[] = { 0.1f, 0.5f, 0.1f, 0.25f };
+    ImageBufAlgo::checker (A, 3, 5, 1, pink, green);
+
+    // Channels 1-3 of A
+    ImageBuf chview, chref;
+    OIIO_CHECK_ASSERT (chview.make_view (A, ROI (0, 40, 0, 32, 0, 1, 1, 4)));
+    OIIO_CHECK_ASSERT (! chview.contiguous());
+    int chorder[] = { 1, 2, 3 };
+    ImageBufAlgo::channels (chref, A, 3, chorder);
+    check_same_texture (chview, chref);
+
+    // A window of A
+    ROI window (5, 29, 3, 27);
+    ImageBuf roiview, roiref;
+    OIIO_CHECK_ASSERT (roiview.make_view (A, window));
+    OIIO_CHECK_ASSERT (! roiview.contiguous());
+    ImageBufAlgo::crop (roiref, A, window);
+    check_same_texture (roiview, roiref);
+
+    // Tile-major pixels, with partial tiles at the right and bottom
+    ImageBuf tiled (A);
+    OIIO_CHECK_ASSERT (tiled.set_local_tiles (16, 16));
+    OIIO_CHECK_ASSERT (! tiled.contiguous());
+    check_same_texture (tiled, A);
+}
+
+
+
+// Test that a streamed make_texture matches the in-memory one: the same
+// pixels in every MIP level, and the same hash.
+void
+test_maketx_stream ()
+{
+    std::cout << "test make_texture streaming\n";
+    // A uint8 source, which both paths convert to float.  The odd sizes
+    // exercise MIP levels that aren't exact halvings.
+    ImageBuf A (ImageSpec (96, 36, 3, TypeDesc::UINT8));
+    float pink[] = { 0.5f, 0.3f, 0.3f }, green[] = { 0.1f, 0.5f, 0.1f };
+    ImageBufAlgo::checker (A, 5, 7, 1, pink, green);
+    const char *srcname = "oiio-stream-src.tif";
+    const char *memname = "oiio-stream-mem.exr";
+    const char *streamname = "oiio-stream.exr";
+    A.write (srcname);
+
+    ImageSpec configspec;
+    OIIO_CHECK_ASSERT (ImageBufAlgo::make_texture (ImageBufAlgo::MakeTxTexture,
+                                                   srcname, memname, configspec));
+    configspec.attribute ("maketx:stream", 1);
+    OIIO_CHECK_ASSERT (ImageBufAlgo::make_texture (ImageBufAlgo::MakeTxTexture,
+                                                   srcname, streamname, configspec));
+
+    ImageBuf M (memname), S (streamname);
+    OIIO_CHECK_ASSERT (M.spec().get_string_attribute ("oiio:SHA-1").size());
+    OIIO_CHECK_EQUAL (M.spec().get_string_attribute ("oiio:SHA-1"),
+                      S.spec().get_string_attribute ("oiio:SHA-1"));
+    OIIO_CHECK_EQUAL (M.nmiplevels(), S.nmiplevels());
+    for (int m = 0;  m < M.nmiplevels();  ++m) {
+        ImageBuf Mm (memname, 0, m), Sm (streamname, 0, m);
+        OIIO_CHECK_EQUAL (Mm.roi(), Sm.roi());
+        // The top level is copied exactly; the filtered levels may round
+        // differently.
+        float thresh = m ? 1.0e-5f : 0.0f;
+        ImageBufAlgo::CompareResults comparison;
+        ImageBufAlgo::compare (Mm, Sm, thresh, thresh, comparison);
+        OIIO_CHECK_EQUAL (comparison.nfail, 0);
+    }
+    remove (srcname);  // clean up
+    remove (memname);
+    remove (streamname);
+}
+
+
+
+// Test that make_texture writes the same file whether or not it writes
+// each MIP level in the background while computing the next.
+void
+test_maketx_pipeline ()
+{
+    std::cout << "test make_texture pipelining\n";
+    // A plain image, and one with overscan using a wider filter, which
+    // depends on the display window of each level being reset.
+    ImageBuf A (ImageSpec (64, 48, 3, TypeDesc::FLOAT));
+    float pink[] = { 0.5f, 0.3f, 0.3f }, green[] = { 0.1f, 0.5f, 0.1f };
+    ImageBufAlgo::checker (A, 5, 7, 1, pink, green);
+    ImageSpec overscanspec (72, 56, 3, TypeDesc::FLOAT);
+    overscanspec.x = overscanspec.y = -4;
+    overscanspec.full_width = 64;
+    overscanspec.full_height = 48;
+    ImageBuf O (overscanspec);
+    ImageBufAlgo::checker (O, 5, 7, 1, pink, green);
+
+    for (int i = 0;  i < 2;  ++i) {
+        const ImageBuf &src (i ? O : A);
+        const char *names[2] = { "oiio-pipeline0.exr", "oiio-pipeline1.exr" };
+        for (int pipeline = 0;  pipeline < 2;  ++pipeline) {
+            ImageSpec configspec;
+            configspec.attribute ("maketx:pipeline", pipeline);
+            if (i)
+                configspec.attribute ("maketx:filtername", "lanczos3");
+            OIIO_CHECK_ASSERT (ImageBufAlgo::make_texture (
+                                    ImageBufAlgo::MakeTxTexture, src,
+                                    names[pipeline], configspec));
+        }
+        ImageBuf P0 (names[0]), P1 (names[1]);
+        OIIO_CHECK_ASSERT (P0.nmiplevels() > 1);
+        OIIO_CHECK_EQUAL (P0.nmiplevels(), P1.nmiplevels());
+        for (int m = 0;  m < P0.nmiplevels();  ++m) {
+            ImageBuf L0 (names[0], 0, m), L1 (names[1], 0, m);
+            OIIO_CHECK_EQUAL (L0.roi(), L1.roi());
+            OIIO_CHECK_EQUAL (L0.roi_full(), L1.roi_full());
+            ImageBufAlgo::CompareResults comparison;
+            ImageBufAlgo::compare (L0, L1, 0.0f, 0.0f, comparison);
+            OIIO_CHECK_EQUAL (comparison.nfail, 0);
+        }
+        remove (names[0]);  // clean up
+        remove (names[1]);
+    }
+}
+
+
+
 // Test various IBAprep features
 void
 test_IBAprep ()
@@ -722,6 +1006,889 @@ test_IBAprep ()
 
 
 
+// Every SIMD level of the runtime-dispatched kernels must give the same
+// results, bit for bit.
+void
+test_simd_dispatch ()
+{
+    std::cout << "test simd dispatch\n";
+    std::vector<string_view> levels;
+    std::string levellist = OIIO::get_string_attribute ("simd_levels");
+    Strutil::split (levellist, levels, ",");
+    OIIO_CHECK_ASSERT (levels.size() >= 1);
+
+    // Odd sizes, so the scalar tails of the kernels get exercised too
+    const int w = 37, h = 5, n = w * h * 4;
+    std::vector<float> src (n), src2 (n);
+    for (int i = 0;  i < n;  ++i) {
+        src[i] = float((i * 7919) % 1031) / 1000.0f - 0.01f;
+        src2[i] = float((i * 104729) % 997) / 500.0f;
+    }
+    ImageSpec spec (w, h, 4, TypeDesc::FLOAT);
+    ImageBuf A (spec, &src[0]), B (spec, &src2[0]);
+
+    // Integer sources, and the scalar reference for every conversion.
+    std::vector<unsigned char> u8 (n);
+    std::vector<unsigned short> u16 (n);
+    for (int i = 0;  i < n;  ++i) {
+        u8[i] = (unsigned char)(i * 31);
+        u16[i] = (unsigned short)(i * 4099);
+    }
+    std::vector<float> u8f_ref (n), u16f_ref (n), hf_ref (n);
+    std::vector<unsigned char> fu8_ref (n);
+    std::vector<unsigned short> fu16_ref (n), h_ref (n);
+    for (int i = 0;  i < n;  ++i) {
+        u8f_ref[i] = convert_type<unsigned char,float> (u8[i]);
+        u16f_ref[i] = convert_type<unsigned short,float> (u16[i]);
+        fu8_ref[i] = convert_type<float,unsigned char> (src[i]);
+        fu16_ref[i] = convert_type<float,unsigned short> (src[i]);
+        h_ref[i] = half(src[i]).bits();
+        hf_ref[i] = half(src[i]);
+    }
+
+    std::vector<float> over0;
+    for (auto level : levels) {
+        OIIO::attribute ("simd_level", level);
+        OIIO_CHECK_EQUAL (OIIO::get_string_attribute ("simd_level"), level);
+        ImageBuf R;
+        ImageBufAlgo::over (R, A, B);
+        std::vector<float> over (n);
+        R.get_pixels (R.roi(), TypeDesc::FLOAT, &over[0]);
+
+        std::vector<float> u8f (n), u16f (n), hf (n);
+        std::vector<unsigned char> fu8 (n);
+        std::vector<unsigned short> fu16 (n), h (n);
+        convert_types (TypeDesc::UINT8, &u8[0], TypeDesc::FLOAT, &u8f[0], n);
+        convert_types (TypeDesc::UINT16, &u16[0], TypeDesc::FLOAT, &u16f[0], n);
+        convert_types (TypeDesc::FLOAT, &src[0], TypeDesc::UINT8, &fu8[0], n);
+        convert_types (TypeDesc::FLOAT, &src[0], TypeDesc::UINT16, &fu16[0], n);
+        convert_types (TypeDesc::FLOAT, &src[0], TypeDesc::HALF, &h[0], n);
+        convert_types (TypeDesc::HALF, &h[0], TypeDesc::FLOAT, &hf[0], n);
+        OIIO_CHECK_ASSERT (u8f == u8f_ref);
+        OIIO_CHECK_ASSERT (u16f == u16f_ref);
+        OIIO_CHECK_ASSERT (fu8 == fu8_ref);
+        OIIO_CHECK_ASSERT (fu16 == fu16_ref);
+        OIIO_CHECK_ASSERT (h == h_ref);
+        OIIO_CHECK_ASSERT (hf == hf_ref);
+        if (over0.empty())
+            over0 = over;
+        else
+            OIIO_CHECK_ASSERT (memcmp (&over[0], &over0[0], n*sizeof(float)) == 0);
+    }
+    OIIO::attribute ("simd_level", "auto");
+}
+
+
+
+// Convert every value of type S (given as its bits) to D by way of float,
+// the way convert_types does for pairs without a direct kernel.
+template<typename S, typename D>
+static D
+through_float (S s)
+{
+    return convert_type<float,D> (convert_type<S,float> (s));
+}
+
+template<> half through_float (unsigned char s) { return half (convert_type<unsigned char,float> (s)); }
+template<> half through_float (unsigned short s) { return half (convert_type<unsigned short,float> (s)); }
+template<> unsigned char through_float (half s) { return convert_type<float,unsigned char> (float(s)); }
+template<> unsigned short through_float (half s) { return convert_type<float,unsigned short> (float(s)); }
+
+
+template<typename S, typename D>
+static void
+check_direct_conversion (TypeDesc stype, TypeDesc dtype)
+{
+    const int n = int(sizeof(S)) == 1 ? 256 : 65536;
+    std::vector<S> src (n);
+    for (int i = 0;  i < n;  ++i) {
+        if (sizeof(S) == 1)
+            memcpy (&src[i], &i, 1);
+        else {
+            unsigned short bits = (unsigned short) i;
+            memcpy (&src[i], &bits, 2);
+        }
+    }
+    std::vector<D> dst (n);
+    OIIO_CHECK_ASSERT (convert_types (stype, &src[0], dtype, &dst[0], n));
+    int mismatches = 0;
+    for (int i = 0;  i < n;  ++i) {
+        if (stype == TypeDesc::HALF && isnan (float(src[i])))
+            continue;   // undefined through float
+        D ref = through_float<S,D> (src[i]);
+        if (memcmp (&ref, &dst[i], sizeof(D)))
+            ++mismatches;
+    }
+    OIIO_CHECK_EQUAL (mismatches, 0);
+}
+
+
+
+// Every pair that convert_types converts directly (any two different
+// types among uint8, uint16 and half), for every source value, must give
+// the same result as converting through float.
+void
+test_direct_conversions ()
+{
+    std::cout << "test direct conversions\n";
+    typedef unsigned char uchar;
+    typedef unsigned short ushort;
+    check_direct_conversion<uchar,ushort> (TypeDesc::UINT8, TypeDesc::UINT16);
+    check_direct_conversion<uchar,half> (TypeDesc::UINT8, TypeDesc::HALF);
+    check_direct_conversion<ushort,uchar> (TypeDesc::UINT16, TypeDesc::UINT8);
+    check_direct_conversion<ushort,half> (TypeDesc::UINT16, TypeDesc::HALF);
+    check_direct_conversion<half,uchar> (TypeDesc::HALF, TypeDesc::UINT8);
+    check_direct_conversion<half,ushort> (TypeDesc::HALF, TypeDesc::UINT16);
+}
+
+
+
+// colorconvert of 8 and 16 bit images through a baked 1D table must give
+// exactly the same results as running the color processor.
+void
+test_colorconvert_bake ()
+{
+    std::cout << "test colorconvert bake\n";
+    int oldbake = OIIO::get_int_attribute ("colorconvert:bake");
+    const int res = 256, n = res * res * 4;
+    TypeDesc types[] = { TypeDesc::UINT8, TypeDesc::UINT16 };
+    for (TypeDesc type : types) {
+        ImageSpec spec (res, res, 4, type);
+        ImageBuf A (spec);
+        std::vector<float> pixels (n);
+        for (int i = 0;  i < n;  ++i)
+            pixels[i] = float((i * 7919) % 65536) / 65535.0f;
+        A.set_pixels (A.roi(), TypeDesc::FLOAT, &pixels[0]);
+
+        std::vector<float> result[2];
+        for (int bake = 0;  bake < 2;  ++bake) {
+            OIIO::attribute ("colorconvert:bake", bake);
+            ImageBuf R;
+            OIIO_CHECK_ASSERT (ImageBufAlgo::colorconvert (R, A, "sRGB", "linear"));
+            result[bake].resize (n);
+            R.get_pixels (R.roi(), TypeDesc::FLOAT, &result[bake][0]);
+        }
+        OIIO_CHECK_ASSERT (result[0] == result[1]);
+    }
+    OIIO::attribute ("colorconvert:bake", oldbake);
+}
+
+
+
+// The built-in transfer functions must transform the color channels of
+// 1 to 4 channel images like the scalar versions do, and leave alpha be.
+void
+test_colorconvert_builtin ()
+{
+    std::cout << "test colorconvert builtin\n";
+    const int w = 19;
+    for (int nc = 1;  nc <= 4;  ++nc) {
+        ImageSpec spec (w, 1, nc, TypeDesc::FLOAT);
+        std::vector<float> pixels (w*nc);
+        for (int i = 0;  i < w*nc;  ++i)
+            pixels[i] = float(i % 23) / 22.0f;
+        ImageBuf A (spec, &pixels[0]), R;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::colorconvert (R, A, "linear", "sRGB"));
+        for (int x = 0;  x < w;  ++x)
+            for (int c = 0;  c < nc;  ++c) {
+                float v = pixels[x*nc+c];
+                OIIO_CHECK_EQUAL_THRESH (R.getchannel (x, 0, 0, c),
+                                         c < 3 ? linear_to_sRGB(v) : v,
+                                         1.0e-4f);
+            }
+    }
+}
+
+
+
+// A processor found in the cache must not report an error left over
+// from an earlier failed request.
+void
+test_colorprocessor_cache_error ()
+{
+    std::cout << "test color processor cache error\n";
+    ColorConfig config;
+    ColorProcessor *p = config.createColorProcessor ("sRGB", "linear");
+    OIIO_CHECK_ASSERT (p != NULL);
+    ColorConfig::deleteColorProcessor (p);
+    p = config.createColorProcessor ("no_such_space", "linear");
+    OIIO_CHECK_ASSERT (p == NULL);
+    ColorConfig::deleteColorProcessor (p);
+    p = config.createColorProcessor ("sRGB", "linear");   // cache hit
+    OIIO_CHECK_ASSERT (p != NULL);
+    OIIO_CHECK_ASSERT (! config.error ());
+    OIIO_CHECK_EQUAL (config.geterror (), "");
+    ColorConfig::deleteColorProcessor (p);
+}
+
+
+
+// Make a deep R,G,B,A,Z,Zback image (plus an optional uint "id" channel)
+// with 0-3 front-to-back samples per pixel that depend on seed.
+static void
+make_deep_test_image (ImageBuf &buf, int seed, bool idchannel=false)
+{
+    ImageSpec spec (37, 23, 6, TypeDesc::FLOAT);
+    spec.channelnames.assign ({ "R", "G", "B", "A", "Z", "Zback" });
+    if (idchannel) {
+        spec.channelformats.assign (6, TypeDesc::FLOAT);
+        spec.channelformats.push_back (TypeDesc::UINT);
+        spec.channelnames.push_back ("id");
+        spec.nchannels = 7;
+    }
+    spec.z_channel = 4;
+    spec.deep = true;
+    buf.reset (spec);
+    DeepData &dd (*buf.deepdata());
+    int npixels = dd.pixels();
+    std::vector<unsigned int> nsamples (npixels);
+    for (int p = 0;  p < npixels;  ++p)
+        nsamples[p] = (p * 7 + seed) % 4;
+    dd.set_all_samples (nsamples);
+    for (int p = 0;  p < npixels;  ++p) {
+        float z = 1.0f + float((p * 13 + seed) % 5);
+        for (int s = 0;  s < int(nsamples[p]);  ++s) {
+            float a = 0.25f + 0.125f * float((p + s + seed) % 5);
+            for (int c = 0;  c < 3;  ++c)
+                dd.set_deep_value (p, c, s, a * float((p + c + s) % 3) * 0.5f);
+            dd.set_deep_value (p, 3, s, a);
+            dd.set_deep_value (p, 4, s, z);
+            z += 0.5f + float((p + seed * s) % 3);
+            dd.set_deep_value (p, 5, s, z);
+            if (idchannel)
+                dd.set_deep_value (p, 6, s, uint32_t(p + s));
+        }
+    }
+}
+
+
+
+static bool
+same_deep_data (const DeepData &a, const DeepData &b)
+{
+    if (a.pixels() != b.pixels() || a.channels() != b.channels())
+        return false;
+    for (int p = 0;  p < a.pixels();  ++p) {
+        if (a.samples(p) != b.samples(p))
+            return false;
+        for (int c = 0;  c < a.channels();  ++c)
+            for (int s = 0;  s < a.samples(p);  ++s)
+                if (a.deep_value (p, c, s) != b.deep_value (p, c, s))
+                    return false;
+    }
+    return true;
+}
+
+
+
+// The bulk and parallel deep paths must give the same results as the
+// per-pixel operations they replace.
+void
+test_deep_ops ()
+{
+    std::cout << "test deep ops\n";
+    ImageBuf A, B;
+    make_deep_test_image (A, 0);
+    make_deep_test_image (B, 3);
+    const DeepData &Add (*A.deepdata());
+    const DeepData &Bdd (*B.deepdata());
+    int npixels = Add.pixels(), nc = Add.channels();
+
+    // set_all_samples on allocated data vs. set_samples on each pixel
+    {
+        DeepData bulk (Add), single (Add);
+        std::vector<unsigned int> nsamples (npixels);
+        for (int p = 0;  p < npixels;  ++p)
+            nsamples[p] = (p * 5) % 6;
+        bulk.set_all_samples (nsamples);
+        for (int p = 0;  p < npixels;  ++p)
+            single.set_samples (p, nsamples[p]);
+        for (int p = 0;  p < npixels;  ++p) {
+            OIIO_CHECK_EQUAL (bulk.samples(p), int(nsamples[p]));
+            // Only the samples that were kept have defined values
+            int kept = std::min (Add.samples(p), int(nsamples[p]));
+            for (int c = 0;  c < nc;  ++c)
+                for (int s = 0;  s < kept;  ++s)
+                    OIIO_CHECK_EQUAL (bulk.deep_value (p, c, s),
+                                      single.deep_value (p, c, s));
+        }
+    }
+
+    // get_pointers vs. data_ptr
+    {
+        std::vector<void*> pointers;
+        Add.get_pointers (pointers);
+        OIIO_CHECK_EQUAL (pointers.size(), size_t(npixels * nc));
+        for (int p = 0;  p < npixels;  ++p)
+            for (int c = 0;  c < nc;  ++c)
+                OIIO_CHECK_ASSERT (pointers[p*nc+c] == (Add.samples(p)
+                                       ? Add.data_ptr (p, c, 0) : NULL));
+    }
+
+    // flatten: the all-float fast path vs. the generic deep_value path,
+    // which an extra uint channel forces.
+    {
+        ImageBuf Aid, F, Fid;
+        make_deep_test_image (Aid, 0, true);
+        ImageBufAlgo::flatten (F, A);
+        ImageBufAlgo::flatten (Fid, Aid);
+        for (ImageBuf::ConstIterator<float> f (F), fid (Fid);
+             ! f.done();  ++f, ++fid)
+            for (int c = 0;  c < nc;  ++c)
+                OIIO_CHECK_EQUAL (f[c], fid[c]);
+    }
+
+    // deep_merge in parallel vs. merging each pixel in turn
+    {
+        DeepData ref (Add);
+        for (int p = 0;  p < npixels;  ++p)
+            ref.merge_deep_pixels (p, Bdd, p);
+        ImageBuf M;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::deep_merge (M, A, B, false));
+        OIIO_CHECK_ASSERT (same_deep_data (*M.deepdata(), ref));
+    }
+
+    // deep_holdout in parallel vs. one thread
+    {
+        ImageBuf H, H1;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::deep_holdout (H, A, B));
+        OIIO_CHECK_ASSERT (ImageBufAlgo::deep_holdout (H1, A, B, ROI::All(), 1));
+        OIIO_CHECK_ASSERT (same_deep_data (*H.deepdata(), *H1.deepdata()));
+    }
+}
+
+
+
+// Presents a separable filter as a non-separable one, so that resize
+// takes its general 2D path.
+class NonSeparableFilter : public Filter2D {
+public:
+    NonSeparableFilter (const Filter2D *f)
+        : Filter2D (f->width(), f->height()), m_f(f) { }
+    float operator() (float x, float y) const {
+        return m_f->xfilt (x) * m_f->yfilt (y);
+    }
+    string_view name (void) const { return m_f->name(); }
+private:
+    const Filter2D *m_f;
+};
+
+
+
+// The two-pass separable resize must match the general 2D filtering,
+// up to float rounding, including at the clamped edges and outside a
+// data window that is smaller than the display window.
+void
+test_resize_separable ()
+{
+    std::cout << "test resize separable\n";
+    const char *filters[] = { "lanczos3", "blackman-harris", "gaussian" };
+    int sizes[][2] = { { 23, 17 }, { 71, 52 } };   // down and up
+    for (int nc = 3;  nc <= 4;  ++nc) {
+        ImageSpec spec (37, 29, nc, TypeDesc::FLOAT);
+        ImageBuf A (spec), Aw;
+        ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+        // A copy whose data window is inset within the display window
+        ImageBufAlgo::crop (Aw, A, ROI (3, 31, 2, 25, 0, 1, 0, nc));
+        Aw.set_full (0, 37, 0, 29, 0, 1);
+        const ImageBuf *srcs[] = { &A, &Aw };
+        for (const ImageBuf *src : srcs) {
+            for (auto fname : filters) {
+                for (auto &size : sizes) {
+                    Filter2D *f = Filter2D::create (fname, 4.0f, 4.0f);
+                    NonSeparableFilter g (f);
+                    ROI roi (0, size[0], 0, size[1], 0, 1, 0, nc);
+                    ImageBuf R, G;
+                    OIIO_CHECK_ASSERT (ImageBufAlgo::resize (R, *src, f, roi));
+                    OIIO_CHECK_ASSERT (ImageBufAlgo::resize (G, *src, &g, roi));
+                    ImageBufAlgo::CompareResults cr;
+                    ImageBufAlgo::compare (R, G, 1.0e-5f, 1.0e-5f, cr);
+                    OIIO_CHECK_EQUAL (cr.nfail, 0);
+                    Filter2D::destroy (f);
+                }
+            }
+        }
+    }
+}
+
+
+
+// Brute force convolution, summing over every kernel tap (with the
+// source clamped at its edges) for every pixel.
+static void
+convolve_reference (ImageBuf &R, const ImageBuf &src, const ImageBuf &kernel,
+                    bool normalize)
+{
+    R.reset (src.spec());
+    int nc = src.nchannels();
+    float scale = 1.0f;
+    if (normalize) {
+        scale = 0.0f;
+        for (ImageBuf::ConstIterator<float> k (kernel);  ! k.done();  ++k)
+            scale += k[0];
+        scale = 1.0f / scale;
+    }
+    ROI kroi = kernel.roi();
+    std::vector<float> sum (nc);
+    ImageBuf::ConstIterator<float> s (src, ImageBuf::WrapClamp);
+    for (ImageBuf::Iterator<float> d (R);  ! d.done();  ++d) {
+        std::fill (sum.begin(), sum.end(), 0.0f);
+        ImageBuf::ConstIterator<float> k (kernel);
+        s.rerange (d.x() + kroi.xbegin, d.x() + kroi.xend,
+                   d.y() + kroi.ybegin, d.y() + kroi.yend,
+                   0, 1, ImageBuf::WrapClamp);
+        for ( ;  ! s.done();  ++s, ++k)
+            for (int c = 0;  c < nc;  ++c)
+                sum[c] += k[0] * s[c];
+        for (int c = 0;  c < nc;  ++c)
+            d[c] = scale * sum[c];
+    }
+}
+
+
+
+// convolve's separable and FFT methods must match summing over the
+// whole kernel at every pixel.
+void
+test_convolve_methods ()
+{
+    std::cout << "test convolve methods\n";
+    ImageBuf A (ImageSpec (64, 48, 3, TypeDesc::FLOAT)), Aw;
+    ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+    // A copy whose data window is inset within the display window
+    ImageBufAlgo::crop (Aw, A, ROI (5, 57, 4, 40, 0, 1, 0, 3));
+    Aw.set_full (0, 64, 0, 48, 0, 1);
+    const ImageBuf *srcs[] = { &A, &Aw };
+    // A small separable kernel, a big separable one, and a big one that
+    // is not separable (which takes the FFT).
+    struct { const char *name; float size, thresh; } kernels[] = {
+        { "gaussian", 5, 1.0e-5f }, { "gaussian", 31, 1.0e-5f },
+        { "disk", 31, 1.0e-4f }
+    };
+    for (auto &kern : kernels) {
+        ImageBuf K;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::make_kernel (K, kern.name,
+                                                      kern.size, kern.size));
+        for (const ImageBuf *src : srcs) {
+            for (int normalize = 0;  normalize < 2;  ++normalize) {
+                ImageBuf R, Ref;
+                OIIO_CHECK_ASSERT (ImageBufAlgo::convolve (R, *src, K,
+                                                           normalize != 0));
+                convolve_reference (Ref, *src, K, normalize != 0);
+                ImageBufAlgo::CompareResults cr;
+                ImageBufAlgo::compare (R, Ref, kern.thresh, kern.thresh, cr);
+                OIIO_CHECK_EQUAL (cr.nfail, 0);
+            }
+        }
+    }
+}
+
+
+
+// Brute force median (op 0), dilate (op 1) or erode (op 2) over the
+// existing pixels of each width x height window.
+static void
+window_reference (ImageBuf &R, const ImageBuf &A, int width, int height,
+                  int op)
+{
+    R.reset (A.spec());
+    int w_2 = std::max (1, width/2);
+    int h_2 = std::max (1, height/2);
+    int nc = A.nchannels();
+    std::vector<std::vector<float> > vals (nc);
+    ImageBuf::ConstIterator<float> a (A);
+    for (ImageBuf::Iterator<float> r (R);  ! r.done();  ++r) {
+        a.rerange (r.x()-w_2, r.x()-w_2+width, r.y()-h_2, r.y()-h_2+height,
+                   0, 1, ImageBuf::WrapClamp);
+        for (int c = 0;  c < nc;  ++c)
+            vals[c].clear ();
+        for ( ;  ! a.done();  ++a)
+            if (a.exists())
+                for (int c = 0;  c < nc;  ++c)
+                    vals[c].push_back (a[c]);
+        for (int c = 0;  c < nc;  ++c) {
+            std::vector<float> &v (vals[c]);
+            std::sort (v.begin(), v.end());
+            if (op == 0)
+                r[c] = v.size() ? v[v.size()/2] : 0.0f;
+            else if (op == 1)
+                r[c] = v.size() ? v.back() : -std::numeric_limits<float>::max();
+            else
+                r[c] = v.size() ? v.front() : std::numeric_limits<float>::max();
+        }
+    }
+}
+
+
+
+// The histogram median filters (8 and 16 bit), the nth_element median
+// (other types), and the running max/min dilate and erode must give
+// exactly what examining every pixel of each window does.
+void
+test_window_filters ()
+{
+    std::cout << "test median, dilate, erode\n";
+    TypeDesc types[] = { TypeDesc::UINT8, TypeDesc::UINT16, TypeDesc::FLOAT };
+    int windows[][2] = { { 1, 1 }, { 4, 4 }, { 5, 5 }, { 7, 3 } };
+    for (TypeDesc type : types) {
+        ImageBuf A (ImageSpec (41, 27, 3, type)), Aw;
+        ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+        // A copy whose data window is inset within the display window
+        ImageBufAlgo::crop (Aw, A, ROI (3, 37, 2, 24, 0, 1, 0, 3));
+        Aw.set_full (0, 41, 0, 27, 0, 1);
+        const ImageBuf *srcs[] = { &A, &Aw };
+        for (const ImageBuf *src : srcs) {
+            for (auto &win : windows) {
+                for (int op = 0;  op < 3;  ++op) {
+                    ImageBuf R, Ref;
+                    if (op == 0)
+                        ImageBufAlgo::median_filter (R, *src, win[0], win[1]);
+                    else if (op == 1)
+                        ImageBufAlgo::dilate (R, *src, win[0], win[1]);
+                    else
+                        ImageBufAlgo::erode (R, *src, win[0], win[1]);
+                    window_reference (Ref, *src, win[0], win[1], op);
+                    ImageBufAlgo::CompareResults cr;
+                    ImageBufAlgo::compare (R, Ref, 0.0f, 0.0f, cr);
+                    OIIO_CHECK_EQUAL (cr.nfail, 0);
+                }
+            }
+        }
+    }
+}
+
+
+
+static bool
+same_pixels (const ImageBuf &A, const ImageBuf &B)
+{
+    ImageBufAlgo::CompareResults cr;
+    ImageBufAlgo::compare (A, B, 0.0f, 0.0f, cr);
+    return cr.nfail == 0;
+}
+
+
+
+// Text drawn with cached faces and glyphs must look the same as the first
+// time it was drawn, whatever sizes were used in between and however
+// many threads draw at once.
+void
+test_render_text_cache ()
+{
+    std::cout << "test render_text glyph cache\n";
+    const char *text = "Hello, glyphs!";
+    ImageSpec spec (220, 64, 3, TypeDesc::FLOAT);
+    int sizes[] = { 24, 12, 31 };
+    std::vector<ImageBuf> first (3);
+    for (int i = 0;  i < 3;  ++i) {
+        first[i].reset (spec);
+        ImageBufAlgo::zero (first[i]);
+        if (! ImageBufAlgo::render_text (first[i], 10, 40, text, sizes[i])) {
+            std::cout << "  no font support, skipping\n";
+            return;
+        }
+    }
+    OIIO_CHECK_ASSERT (! same_pixels (first[0], first[1]));
+
+    // Again, with every glyph cached
+    for (int i = 0;  i < 3;  ++i) {
+        ImageBuf again (spec);
+        ImageBufAlgo::zero (again);
+        OIIO_CHECK_ASSERT (ImageBufAlgo::render_text (again, 10, 40, text,
+                                                      sizes[i]));
+        OIIO_CHECK_ASSERT (same_pixels (again, first[i]));
+    }
+
+    // text_size is stable and covers what was drawn
+    ROI size = ImageBufAlgo::text_size (text, sizes[0]);
+    OIIO_CHECK_EQUAL (size, ImageBufAlgo::text_size (text, sizes[0]));
+    ROI drawn = ImageBufAlgo::nonzero_region (first[0]);
+    OIIO_CHECK_ASSERT (drawn.xbegin >= 10 + size.xbegin &&
+                       drawn.xend <= 10 + size.xend &&
+                       drawn.ybegin >= 40 + size.ybegin &&
+                       drawn.yend <= 40 + size.yend);
+
+    // Concurrent renders, sharing the cached faces
+    const int n = 24;
+    std::vector<ImageBuf> bufs (n);
+    parallel_for_chunked (0, n, 1, [&](int64_t b, int64_t e) {
+        for (int64_t i = b;  i < e;  ++i) {
+            bufs[i].reset (spec);
+            ImageBufAlgo::zero (bufs[i]);
+            ImageBufAlgo::render_text (bufs[i], 10, 40, text, sizes[i % 3],
+                                       "", array_view<const float>(),
+                                       ImageBufAlgo::TextAlignX::Left,
+                                       ImageBufAlgo::TextAlignY::Baseline,
+                                       0, ROI::All(), 1);
+        }
+    });
+    for (int i = 0;  i < n;  ++i)
+        OIIO_CHECK_ASSERT (same_pixels (bufs[i], first[i % 3]));
+
+    // Drawing into 8 bit and half images (over a gray background, with a
+    // drop shadow) must match drawing into float, to within the precision
+    // of the destination type.
+    const float gray[3] = { 0.25f, 0.5f, 0.75f };
+    const float color[3] = { 1.0f, 0.5f, 0.0f };
+    using ImageBufAlgo::TextAlignX;
+    using ImageBufAlgo::TextAlignY;
+    ImageBuf bg (spec), fref (spec);
+    ImageBufAlgo::fill (bg, gray);
+    ImageBufAlgo::fill (fref, gray);
+    OIIO_CHECK_ASSERT (ImageBufAlgo::render_text (fref, 10, 40, text,
+                            sizes[0], "", color, TextAlignX::Left,
+                            TextAlignY::Baseline, 2));
+    OIIO_CHECK_ASSERT (! same_pixels (fref, bg));
+    TypeDesc types[] = { TypeDesc::UINT8, TypeDesc::HALF };
+    float thresh[] = { 1.01f / 255.0f, 2e-3f };
+    for (int i = 0;  i < 2;  ++i) {
+        ImageBuf R (ImageSpec (spec.width, spec.height, spec.nchannels,
+                               types[i]));
+        ImageBufAlgo::fill (R, gray);
+        OIIO_CHECK_ASSERT (ImageBufAlgo::render_text (R, 10, 40, text,
+                                sizes[0], "", color, TextAlignX::Left,
+                                TextAlignY::Baseline, 2));
+        ImageBufAlgo::CompareResults cr;
+        ImageBufAlgo::compare (R, fref, thresh[i], 0.0f, cr);
+        OIIO_CHECK_EQUAL (cr.nfail, 0);
+    }
+}
+
+
+
+// The parallel computePixelStats (including the integer path for 8 and
+// 16 bit images), histogram and color_count must agree with a plain
+// pixel-by-pixel pass, and with each other no matter the thread count.
+void
+test_parallel_reductions ()
+{
+    std::cout << "test parallel stats, histogram, color_count\n";
+    const int w = 131, h = 77, nc = 3;
+    TypeDesc types[] = { TypeDesc::UINT8, TypeDesc::UINT16, TypeDesc::HALF,
+                         TypeDesc::FLOAT };
+    for (TypeDesc type : types) {
+        ImageBuf A (ImageSpec (w, h, nc, type));
+        ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+        if (type == TypeDesc::FLOAT) {
+            float odd[3] = { std::numeric_limits<float>::quiet_NaN(),
+                             std::numeric_limits<float>::infinity(), -2.0f };
+            for (int i = 0;  i < 40;  ++i)
+                A.setpixel ((i * 37) % w, (i * 11) % h, odd);
+        }
+
+        // Reference stats
+        std::vector<float> mn (nc, std::numeric_limits<float>::max());
+        std::vector<float> mx (nc, -std::numeric_limits<float>::max());
+        std::vector<double> sum (nc, 0.0), sum2 (nc, 0.0);
+        std::vector<imagesize_t> nans (nc, 0), infs (nc, 0), finite (nc, 0);
+        for (ImageBuf::ConstIterator<float> a (A);  ! a.done();  ++a) {
+            for (int c = 0;  c < nc;  ++c) {
+                float v = a[c];
+                if (std::isnan (v))
+                    ++nans[c];
+                else if (std::isinf (v))
+                    ++infs[c];
+                else {
+                    ++finite[c];
+                    mn[c] = std::min (mn[c], v);
+                    mx[c] = std::max (mx[c], v);
+                    sum[c] += v;
+                    sum2[c] += double(v) * double(v);
+                }
+            }
+        }
+        ImageBufAlgo::PixelStats stats, stats1;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::computePixelStats (stats, A));
+        OIIO_CHECK_ASSERT (ImageBufAlgo::computePixelStats (stats1, A,
+                                                            ROI::All(), 1));
+        for (int c = 0;  c < nc;  ++c) {
+            double avg = sum[c] / double(finite[c]);
+            double stddev = sqrt (sum2[c] / double(finite[c]) - avg * avg);
+            OIIO_CHECK_EQUAL (stats.min[c], mn[c]);
+            OIIO_CHECK_EQUAL (stats.max[c], mx[c]);
+            OIIO_CHECK_EQUAL_THRESH (stats.avg[c], avg, 1.0e-5);
+            OIIO_CHECK_EQUAL_THRESH (stats.stddev[c], stddev, 1.0e-5);
+            OIIO_CHECK_EQUAL (stats.nancount[c], nans[c]);
+            OIIO_CHECK_EQUAL (stats.infcount[c], infs[c]);
+            OIIO_CHECK_EQUAL (stats.finitecount[c], finite[c]);
+            OIIO_CHECK_EQUAL (stats1.min[c], stats.min[c]);
+            OIIO_CHECK_EQUAL (stats1.max[c], stats.max[c]);
+            OIIO_CHECK_EQUAL_THRESH (stats1.avg[c], stats.avg[c], 1.0e-6);
+            OIIO_CHECK_EQUAL_THRESH (stats1.stddev[c], stats.stddev[c], 1.0e-6);
+        }
+
+        // color_count of two colors, with a generous eps so that both
+        // match plenty of pixels.
+        float colors[2*nc] = { 0.25f, 0.5f, 0.75f,  0.5f, 0.5f, 0.5f };
+        float eps[nc] = { 0.2f, 0.3f, 0.2f };
+        imagesize_t ref[2] = { 0, 0 };
+        for (ImageBuf::ConstIterator<float> a (A);  ! a.done();  ++a)
+            for (int col = 0;  col < 2;  ++col) {
+                bool match = true;
+                for (int c = 0;  c < nc;  ++c)
+                    match &= (fabsf (a[c] - colors[col*nc+c]) <= eps[c]);
+                ref[col] += match;
+            }
+        imagesize_t count[2], count1[2];
+        OIIO_CHECK_ASSERT (ImageBufAlgo::color_count (A, count, 2, colors, eps));
+        OIIO_CHECK_ASSERT (ImageBufAlgo::color_count (A, count1, 2, colors, eps,
+                                                      ROI::All(), 1));
+        for (int col = 0;  col < 2;  ++col) {
+            OIIO_CHECK_EQUAL (count[col], ref[col]);
+            OIIO_CHECK_EQUAL (count1[col], ref[col]);
+        }
+
+        // histogram (float only), over a range narrower than the values,
+        // with and without asking for submin.
+        if (type == TypeDesc::FLOAT) {
+            const int bins = 50;
+            const float lo = 0.1f, hi = 0.9f;
+            float ratio = bins / (hi - lo);
+            std::vector<imagesize_t> refhist (bins, 0);
+            imagesize_t refsubmin = 0, refsupermax = 0;
+            for (ImageBuf::ConstIterator<float> a (A);  ! a.done();  ++a) {
+                float v = a[1];
+                if (v >= lo && v < hi)
+                    ++refhist[int((v - lo) * ratio)];
+                else if (v == hi)
+                    ++refhist[bins-1];
+                else if (v < lo)
+                    ++refsubmin;
+                else
+                    ++refsupermax;   // including NaN
+            }
+            std::vector<imagesize_t> hist;
+            imagesize_t submin = 0, supermax = 0;
+            OIIO_CHECK_ASSERT (ImageBufAlgo::histogram (A, 1, hist, bins, lo, hi,
+                                                        &submin, &supermax));
+            OIIO_CHECK_ASSERT (hist == refhist);
+            OIIO_CHECK_EQUAL (submin, refsubmin);
+            OIIO_CHECK_EQUAL (supermax, refsupermax);
+            OIIO_CHECK_ASSERT (ImageBufAlgo::histogram (A, 1, hist, bins, lo, hi,
+                                                        NULL, &supermax));
+            OIIO_CHECK_EQUAL (supermax, refsupermax + refsubmin);
+        }
+    }
+}
+
+
+
+// compare_pass must pass exactly when compare finds no more than
+// maxfailures failing pixels, with failures just over and just under
+// the budget, for matching and mismatched pixel formats.
+void
+test_compare_pass ()
+{
+    std::cout << "test compare_pass\n";
+    const int w = 157, h = 93, nbad = 12;
+    TypeDesc types[] = { TypeDesc::FLOAT, TypeDesc::HALF, TypeDesc::UINT8 };
+    for (TypeDesc atype : types) {
+        for (TypeDesc btype : types) {
+            ImageBuf A (ImageSpec (w, h, 4, atype));
+            ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+            ImageBuf B;
+            B.copy (A, btype);
+            // Spread the failures over the image, so that they fall in
+            // different spans and threads.
+            for (int i = 0;  i < nbad;  ++i) {
+                int x = (i * 53) % w, y = (i * 31) % h, c = i % 4;
+                float v = A.getchannel (x, y, 0, c);
+                float bad[4];
+                B.getpixel (x, y, bad);
+                bad[c] = v > 0.5f ? v - 0.5f : v + 0.5f;
+                B.setpixel (x, y, bad);
+            }
+            ImageBufAlgo::CompareResults cr;
+            ImageBufAlgo::compare (A, B, 0.1f, 0.1f, cr);
+            OIIO_CHECK_EQUAL (cr.nfail, imagesize_t(nbad));
+            OIIO_CHECK_ASSERT (ImageBufAlgo::compare_pass (A, B, 0.1f, nbad));
+            OIIO_CHECK_ASSERT (ImageBufAlgo::compare_pass (A, B, 0.1f, nbad+1));
+            OIIO_CHECK_ASSERT (! ImageBufAlgo::compare_pass (A, B, 0.1f, nbad-1));
+            OIIO_CHECK_ASSERT (! ImageBufAlgo::compare_pass (A, B, 0.1f, 0));
+            OIIO_CHECK_ASSERT (! ImageBufAlgo::compare_pass (A, B, 0.1f, nbad-1,
+                                                             ROI::All(), 1));
+            OIIO_CHECK_ASSERT (ImageBufAlgo::compare_pass (A, B, 0.6f));
+            OIIO_CHECK_ASSERT (ImageBufAlgo::compare_pass (A, A, 0.0f));
+        }
+    }
+
+    // NaN and Inf count the way compare counts them
+    ImageBuf A (ImageSpec (64, 64, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+    ImageBuf B (A);
+    float odd[3] = { std::numeric_limits<float>::quiet_NaN(),
+                     std::numeric_limits<float>::infinity(), 0.5f };
+    B.setpixel (10, 20, odd);
+    B.setpixel (40, 50, odd);
+    ImageBufAlgo::CompareResults cr;
+    ImageBufAlgo::compare (A, B, 0.1f, 0.1f, cr);
+    for (imagesize_t m = 0;  m < 4;  ++m)
+        OIIO_CHECK_EQUAL (ImageBufAlgo::compare_pass (A, B, 0.1f, m),
+                          cr.nfail <= m);
+}
+
+
+
+// fft and ifft must match a brute force (unitary) discrete Fourier
+// transform, for even and odd sizes, and undo each other.
+void
+test_fft ()
+{
+    std::cout << "test fft, ifft\n";
+    typedef std::complex<double> cpx;
+    const double twopi = 2.0 * M_PI;
+    int sizes[][2] = { { 12, 10 }, { 9, 7 }, { 16, 1 }, { 2, 5 }, { 1, 6 } };
+    for (auto &size : sizes) {
+        int w = size[0], h = size[1];
+        double norm = 1.0 / sqrt (double(w) * double(h));
+
+        // fft of channel 1 of a 3 channel image
+        ImageBuf A (ImageSpec (w, h, 3, TypeDesc::FLOAT));
+        ImageBufAlgo::noise (A, "uniform", -1.0f, 1.0f);
+        ImageBuf F;
+        ROI roi = A.roi();
+        roi.chbegin = 1;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::fft (F, A, roi));
+        for (int v = 0;  v < h;  ++v)
+            for (int u = 0;  u < w;  ++u) {
+                cpx sum = 0.0;
+                for (int y = 0;  y < h;  ++y)
+                    for (int x = 0;  x < w;  ++x)
+                        sum += double(A.getchannel (x, y, 0, 1))
+                             * std::polar (1.0, -twopi * (double(u*x)/w + double(v*y)/h));
+                sum *= norm;
+                OIIO_CHECK_EQUAL_THRESH (F.getchannel (u, v, 0, 0), sum.real(), 1.0e-4);
+                OIIO_CHECK_EQUAL_THRESH (F.getchannel (u, v, 0, 1), sum.imag(), 1.0e-4);
+            }
+
+        // ifft undoes it
+        ImageBuf I;
+        OIIO_CHECK_ASSERT (ImageBufAlgo::ifft (I, F));
+        for (int y = 0;  y < h;  ++y)
+            for (int x = 0;  x < w;  ++x)
+                OIIO_CHECK_EQUAL_THRESH (I.getchannel (x, y, 0, 0),
+                                         A.getchannel (x, y, 0, 1), 1.0e-4);
+
+        // ifft of a spectrum that isn't conjugate symmetric gives the real
+        // part of the inverse transform.
+        ImageBuf G (ImageSpec (w, h, 2, TypeDesc::FLOAT));
+        ImageBufAlgo::noise (G, "uniform", -1.0f, 1.0f);
+        OIIO_CHECK_ASSERT (ImageBufAlgo::ifft (I, G));
+        for (int y = 0;  y < h;  ++y)
+            for (int x = 0;  x < w;  ++x) {
+                cpx sum = 0.0;
+                for (int v = 0;  v < h;  ++v)
+                    for (int u = 0;  u < w;  ++u)
+                        sum += cpx (G.getchannel (u, v, 0, 0), G.getchannel (u, v, 0, 1))
+                             * std::polar (1.0, twopi * (double(u*x)/w + double(v*y)/h));
+                OIIO_CHECK_EQUAL_THRESH (I.getchannel (x, y, 0, 0),
+                                         sum.real() * norm, 1.0e-4);
+            }
+    }
+}
+
+
+
 void
 benchmark_parallel_image (int res, int iters)
 {
@@ -782,6 +1949,50 @@ benchmark_parallel_image (int res, int iters)
 
 
 
+// Time column-heavy operations with source and destination pixels in
+// ordinary scanline-major versus tile-major local memory.
+void
+benchmark_local_tiles (int res, int iters)
+{
+    std::cout << "\nTime " << res << "x" << res
+              << " RGBA float, scanline-major vs 64x64 tile-major pixels\n";
+    std::cout << "  op          scanline     tiles   (best of " << ntrials << ")\n";
+    std::cout << "  ---------- ---------- ----------\n";
+    ImageSpec spec (res, res, 4, TypeDesc::FLOAT);
+    ImageBuf A (spec);
+    ImageBufAlgo::noise (A, "uniform", 0.0f, 1.0f);
+    ImageBuf At (A);
+    At.set_local_tiles (64, 64);
+    ImageBuf R (spec), Rt (spec);
+    Rt.set_local_tiles (64, 64);
+    Imath::M33f M (0.7f, 0.6f, 0.0f, -0.6f, 0.7f, 0.0f,
+                   0.3f*res, 0.1f*res, 1.0f);
+    typedef std::function<void(ImageBuf &, const ImageBuf &)> Op;
+    struct { const char *name; Op op; } ops[] = {
+        { "transpose", [](ImageBuf &R, const ImageBuf &A){
+              ImageBufAlgo::transpose (R, A); } },
+        { "rotate90",  [](ImageBuf &R, const ImageBuf &A){
+              ImageBufAlgo::rotate90 (R, A); } },
+        { "flop",      [](ImageBuf &R, const ImageBuf &A){
+              ImageBufAlgo::flop (R, A); } },
+        { "rotate",    [](ImageBuf &R, const ImageBuf &A){
+              ImageBufAlgo::rotate (R, A, 0.5f); } },
+        { "warp",      [&](ImageBuf &R, const ImageBuf &A){
+              ImageBufAlgo::warp (R, A, M); } },
+    };
+    for (auto &o : ops) {
+        double t = time_trial (std::bind (o.op, std::ref(R), std::cref(A)),
+                               ntrials, iters) / iters;
+        double tt = time_trial (std::bind (o.op, std::ref(Rt), std::cref(At)),
+                                ntrials, iters) / iters;
+        std::cout << Strutil::format ("  %-10s %7.2f ms %7.2f ms\n",
+                                      o.name, t*1000, tt*1000);
+    }
+    OIIO_CHECK_EQUAL (Rt.local_tile_width(), 64);
+}
+
+
+
 int
 main (int argc, char **argv)
 {
@@ -804,19 +2015,39 @@ main (int argc, char **argv)
     test_sub ();
     test_mul ();
     test_mad ();
+    test_pipeline ();
     test_compare ();
+    test_compare_channel_view ();
     test_isConstantColor ();
     test_isConstantChannel ();
     test_isMonochrome ();
     test_computePixelStats ();
+    test_computePixelHash ();
     histogram_computation_test ();
     test_maketx_from_imagebuf ();
+    test_maketx_from_views ();
+    test_maketx_stream ();
+    test_maketx_pipeline ();
     test_IBAprep ();
+    test_simd_dispatch ();
+    test_direct_conversions ();
+    test_colorconvert_bake ();
+    test_colorprocessor_cache_error ();
+    test_colorconvert_builtin ();
+    test_deep_ops ();
+    test_resize_separable ();
+    test_convolve_methods ();
+    test_window_filters ();
+    test_render_text_cache ();
+    test_parallel_reductions ();
+    test_compare_pass ();
+    test_fft ();
 
     benchmark_parallel_image (64, iterations*64);
     benchmark_parallel_image (512, iterations*16);
     benchmark_parallel_image (1024, iterations*4);
     benchmark_parallel_image (2048, iterations);
+    benchmark_local_tiles (1024, std::max (1, iterations));
 
     return unit_test_failures;
 }
@@ -37,7 +37,9 @@
 #include <OpenEXR/ImathBox.h>
 
 #include <cmath>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -45,6 +47,7 @@
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/filter.h>
 #include <OpenImageIO/thread.h>
+#include <OpenImageIO/simd.h>
 
 OIIO_NAMESPACE_BEGIN
 
@@ -247,6 +250,9 @@ resize_ (ImageBuf &dst, const ImageBuf &src,
             if (totalweight_x != 0.0f)
                 for (int i = 0;  i < xtaps;  ++i)  // normalize x filter
                     xfiltval[i] /= totalweight_x;  // weights
+            else
+                for (int i = 0;  i < xtaps;  ++i)  // no coverage: this
+                    xfiltval[i] = 0.0f;            // column will be black
         }
     }
 
@@ -292,8 +298,89 @@ resize_ (ImageBuf &dst, const ImageBuf &src,
     //
     // Separate cases for separable and non-separable filters.
     if (separable) {
+        // Separable filters are applied in two passes. The horizontal pass
+        // filters each source row this band needs (only once, the first
+        // time it's needed) into a float scratch row of roi.width()
+        // pixels; we keep a ring of ytaps such rows. The vertical pass
+        // then forms each output scanline as a weighted sum of scratch
+        // rows. Both passes are loops over contiguous floats, so the cost
+        // per output pixel is xtaps+ytaps rather than xtaps*ytaps.
+        //
+        // Source pixels outside the display window are clamped to its
+        // edge, and any outside the data window are black, just like
+        // ImageBuf::WrapClamp.
+        using namespace simd;
+        int width = roi.width();
+        int rowlen = width * nchannels;
+
+        // Range of source columns [xmin,xmax] touched by the x filter
+        // taps, and the first of them for each output column.
+        std::vector<int> xstart (width);
+        int xmin = std::numeric_limits<int>::max();
+        int xmax = std::numeric_limits<int>::min();
+        for (int x = roi.xbegin;  x < roi.xend;  ++x) {
+            float s = (x-dstfx+0.5f)*dstpixelwidth;
+            int src_x = ifloor (srcfx + s * srcfw);
+            xstart[x-roi.xbegin] = src_x - radi;
+            xmin = std::min (xmin, src_x - radi);
+            xmax = std::max (xmax, src_x + radi);
+        }
+        int padwidth = xmax - xmin + 1;
+        // For each of those columns, the index within a row of the source
+        // data window that supplies it, or -1 if it's black.
+        std::vector<int> padcol (padwidth);
+        for (int i = 0;  i < padwidth;  ++i) {
+            int sx = clamp (xmin+i, srcspec.full_x,
+                            srcspec.full_x + srcspec.full_width - 1);
+            padcol[i] = (sx >= srcspec.x && sx < srcspec.x + srcspec.width)
+                      ? sx - srcspec.x : -1;
+        }
+        int srcz = srcspec.z;
+
+        std::vector<float> srcrow (srcspec.width * nchannels);
+        std::vector<float> padrow (padwidth * nchannels);
+        std::vector<float> ring (ytaps * rowlen);
+        std::vector<int> ringrow (ytaps, std::numeric_limits<int>::min());
+        std::vector<float> outrow (rowlen);
+
+        // Horizontal pass for source row sy, into h[0..rowlen-1].
+        auto filter_row = [&](int sy, float *h) {
+            if (sy < srcspec.y || sy >= srcspec.y + srcspec.height) {
+                std::fill (h, h+rowlen, 0.0f);
+                return;
+            }
+            src.get_pixels (ROI (srcspec.x, srcspec.x + srcspec.width,
+                                 sy, sy+1, srcz, srcz+1, 0, nchannels),
+                            TypeDesc::FLOAT, &srcrow[0]);
+            for (int i = 0;  i < padwidth;  ++i) {
+                float *p = &padrow[i*nchannels];
+                if (padcol[i] >= 0)
+                    std::copy_n (&srcrow[padcol[i]*nchannels], nchannels, p);
+                else
+                    std::fill (p, p+nchannels, 0.0f);
+            }
+            for (int x = 0;  x < width;  ++x) {
+                const float *in = &padrow[(xstart[x]-xmin)*nchannels];
+                const float *xfiltval = xfiltval_all + x * xtaps;
+                float *o = h + x * nchannels;
+                if (nchannels == 4) {
+                    vfloat4 sum = vfloat4::Zero();
+                    for (int i = 0;  i < xtaps;  ++i, in += 4)
+                        sum += vfloat4(xfiltval[i]) * vfloat4(in);
+                    sum.store (o);
+                } else {
+                    for (int c = 0;  c < nchannels;  ++c)
+                        o[c] = 0.0f;
+                    for (int i = 0;  i < xtaps;  ++i, in += nchannels) {
+                        float w = xfiltval[i];
+                        for (int c = 0;  c < nchannels;  ++c)
+                            o[c] += w * in[c];
+                    }
+                }
+            }
+        };
+
         ImageBuf::Iterator<DSTTYPE> out (dst, roi);
-        ImageBuf::ConstIterator<SRCTYPE> srcpel (src, ImageBuf::WrapClamp);
         for (int y = roi.ybegin;  y < roi.yend;  ++y) {
             float t = (y-dstfy+0.5f)*dstpixelheight;
             float src_yf = srcfy + t * srcfh;
@@ -312,45 +399,40 @@ resize_ (ImageBuf &dst, const ImageBuf &src,
                 for (int i = 0;  i < ytaps;  ++i)
                     yfiltval[i] /= totalweight_y;
 
-            for (int x = roi.xbegin;  x < roi.xend;  ++x, ++out) {
-                float s = (x-dstfx+0.5f)*dstpixelwidth;
-                float src_xf = srcfx + s * srcfw;
-                int src_x = ifloor (src_xf);
-                for (int c = 0;  c < nchannels;  ++c)
-                    pel[c] = 0.0f;
-                const float *xfiltval = xfiltval_all + (x-roi.xbegin) * xtaps;
-                float totalweight_x = 0.0f;
-                for (int i = 0;  i < xtaps;  ++i)
-                    totalweight_x += xfiltval[i];
-                if (totalweight_x != 0.0f) {
-                    srcpel.rerange (src_x-radi, src_x+radi+1,
-                                    src_y-radj, src_y+radj+1,
-                                    0, 1, ImageBuf::WrapClamp);
-                    for (int j = -radj;  j <= radj;  ++j) {
-                        float wy = yfiltval[j+radj];
-                        if (wy == 0.0f) {
-                            // 0 weight for this y tap -- move to next line
-                            srcpel.pos (srcpel.x(), srcpel.y()+1, srcpel.z());
-                            continue;
-                        }
-                        for (int i = 0;  i < xtaps; ++i, ++srcpel) {
-                            float w = wy * xfiltval[i];
-                            if (w)
-                                for (int c = 0;  c < nchannels;  ++c)
-                                    pel[c] += w * srcpel[c];
-                        }
-                    }
+            // Vertical pass: accumulate the weighted scratch rows.
+            std::fill (outrow.begin(), outrow.end(), 0.0f);
+            for (int j = 0;  j < ytaps && totalweight_y != 0.0f;  ++j) {
+                float wy = yfiltval[j];
+                if (wy == 0.0f)
+                    continue;   // 0 weight for this y tap
+                int sy = clamp (src_y-radj+j, srcspec.full_y,
+                                srcspec.full_y + srcspec.full_height - 1);
+                // The (clamped) rows under one scanline's taps are at most
+                // ytaps consecutive rows, so they never share a ring slot.
+                int slot = ((sy % ytaps) + ytaps) % ytaps;
+                float *h = &ring[slot * rowlen];
+                if (ringrow[slot] != sy) {
+                    filter_row (sy, h);
+                    ringrow[slot] = sy;
                 }
-                // Copy the pixel value (already normalized) to the output.
-                DASSERT (out.x() == x && out.y() == y);
-                if (totalweight_y == 0.0f) {
-                    // zero it out
-                    for (int c = 0;  c < nchannels;  ++c)
-                        out[c] = 0.0f;
-                } else {
-                    for (int c = 0;  c < nchannels;  ++c)
-                        out[c] = pel[c];
+                float *o = &outrow[0];
+                int k = 0;
+                vfloat8 w8 (wy);
+                for ( ;  k+8 <= rowlen;  k += 8) {
+                    vfloat8 acc (o+k);
+                    acc += w8 * vfloat8(h+k);
+                    acc.store (o+k);
                 }
+                for ( ;  k < rowlen;  ++k)
+                    o[k] += wy * h[k];
+            }
+
+            // Copy the scanline (already normalized) to the output.
+            const float *o = &outrow[0];
+            for (int x = roi.xbegin;  x < roi.xend;  ++x, ++out, o += nchannels) {
+                DASSERT (out.x() == x && out.y() == y);
+                for (int c = 0;  c < nchannels;  ++c)
+                    out[c] = o[c];
             }
         }
 
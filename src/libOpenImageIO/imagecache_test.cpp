@@ -33,9 +33,11 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/unittest.h>
 
 #include <iostream>
+#include <sstream>
 
 using namespace OIIO;
 
@@ -84,6 +86,79 @@ test_get_pixels_cachechannels (int chbegin = 0, int chend = 4,
 
 
 
+// Make a texture of img, consulting and updating the dedup index.  Return
+// true if an existing texture was copied rather than img converted.
+static bool
+make_dedup_texture (const ImageBuf &img, const std::string &filename,
+                    const std::string &indexfile,
+                    string_view wrapmodes = "black,black")
+{
+    ImageSpec config;
+    config.attribute ("maketx:dedup_index", indexfile);
+    config.attribute ("maketx:verbose", 1);
+    config.attribute ("wrapmodes", wrapmodes);
+    std::ostringstream out;
+    OIIO_CHECK_ASSERT (ImageBufAlgo::make_texture (ImageBufAlgo::MakeTxTexture,
+                                                   img, filename, config, &out));
+    return out.str().find ("Identical to existing texture") != std::string::npos;
+}
+
+
+
+void
+test_dedup_index ()
+{
+    std::cout << "\nTesting the persistent dedup index\n";
+    std::string indexfile ("dedup_test.idx");
+    Filesystem::remove (indexfile);
+
+    ImageBuf A (ImageSpec (64, 64, 3, TypeDesc::FLOAT));
+    const float dark[3] = { 0.1f, 0.2f, 0.3f };
+    const float light[3] = { 0.9f, 0.8f, 0.7f };
+    ImageBufAlgo::checker (A, 8, 8, 1, dark, light);
+    // The same pixels, but with the data window moved
+    ImageSpec offsetspec (A.spec());
+    offsetspec.x = offsetspec.y = 8;
+    offsetspec.full_width = offsetspec.full_height = 80;
+    ImageBuf O (offsetspec);
+    ImageBufAlgo::paste (O, 8, 8, 0, 0, A);
+
+    // Only an identical texture is copied
+    OIIO_CHECK_ASSERT (! make_dedup_texture (A, "dedupA.exr", indexfile));
+    OIIO_CHECK_ASSERT (make_dedup_texture (A, "dedupB.exr", indexfile));
+    OIIO_CHECK_ASSERT (! make_dedup_texture (A, "dedupC.exr", indexfile,
+                                             "clamp,clamp"));
+    OIIO_CHECK_ASSERT (! make_dedup_texture (O, "dedupD.exr", indexfile));
+    OIIO_CHECK_ASSERT (make_dedup_texture (O, "dedupE.exr", indexfile));
+
+    // An ImageCache using the index still sees each file's own data
+    // window and wrap modes, and the right pixels.
+    ImageCache *imagecache = ImageCache::create (false /*not shared*/);
+    imagecache->attribute ("dedup_index", indexfile);
+    const char *files[] = { "dedupA.exr", "dedupB.exr", "dedupC.exr",
+                            "dedupD.exr", "dedupE.exr" };
+    const int origin[] = { 0, 0, 0, 8, 8 };
+    const char *wrap[] = { "black,black", "black,black", "clamp,clamp",
+                           "black,black", "black,black" };
+    for (int i = 0;  i < 5;  ++i) {
+        ustring filename (files[i]);
+        ImageSpec spec;
+        OIIO_CHECK_ASSERT (imagecache->get_imagespec (filename, spec));
+        OIIO_CHECK_EQUAL (spec.x, origin[i]);
+        OIIO_CHECK_EQUAL (spec.get_string_attribute ("wrapmodes"), wrap[i]);
+        float p[3] = { -1, -1, -1 };
+        int x = origin[i] + 8, y = origin[i];  // a light square
+        OIIO_CHECK_ASSERT (imagecache->get_pixels (filename, 0, 0,
+                                                   x, x+1, y, y+1, 0, 1,
+                                                   TypeDesc::FLOAT, p));
+        OIIO_CHECK_EQUAL (p[0], light[0]);
+        OIIO_CHECK_EQUAL (p[2], light[2]);
+    }
+    ImageCache::destroy (imagecache);
+}
+
+
+
 int
 main (int argc, char **argv)
 {
@@ -93,6 +168,7 @@ main (int argc, char **argv)
     test_get_pixels_cachechannels (0, 4, 0, 4);
     test_get_pixels_cachechannels (6, 9);
     test_get_pixels_cachechannels (6, 9, 6, 9);
+    test_dedup_index ();
 
     return unit_test_failures;
 }
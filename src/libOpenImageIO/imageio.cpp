@@ -46,6 +46,7 @@
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/imageio.h>
 #include "imageio_pvt.h"
+#include "simd_kernels.h"
 
 OIIO_NAMESPACE_BEGIN
 
@@ -64,6 +65,7 @@ recursive_mutex imageio_mutex;
 atomic_int oiio_threads (threads_default());
 atomic_int oiio_exr_threads (threads_default());
 atomic_int oiio_read_chunk (256);
+atomic_int colorconvert_bake (1);
 int tiff_half (0);
 ustring plugin_searchpath (OIIO_DEFAULT_PLUGIN_SEARCHPATH);
 std::string format_list;   // comma-separated list of all formats
@@ -223,15 +225,24 @@ attribute (string_view name, TypeDesc type, const void *val)
         default_thread_pool()->resize (ot-1);
         return true;
     }
+    if (name == "plugin_searchpath" && type == TypeDesc::TypeString) {
+        ustring newpath (*(const char **)val);
+        bool changed = false;
+        {
+            spin_lock lock (attrib_mutex);
+            changed = (newpath != plugin_searchpath);
+            plugin_searchpath = newpath;
+        }
+        // Make the next catalog look in the new directories.
+        if (changed)
+            pvt::invalidate_plugin_catalog ();
+        return true;
+    }
     spin_lock lock (attrib_mutex);
     if (name == "read_chunk" && type == TypeDesc::TypeInt) {
         oiio_read_chunk = *(const int *)val;
         return true;
     }
-    if (name == "plugin_searchpath" && type == TypeDesc::TypeString) {
-        plugin_searchpath = ustring (*(const char **)val);
-        return true;
-    }
     if (name == "exr_threads" && type == TypeDesc::TypeInt) {
         oiio_exr_threads = Imath::clamp (*(const int *)val, -1, maxthreads);
         return true;
@@ -244,6 +255,13 @@ attribute (string_view name, TypeDesc type, const void *val)
         print_debug = *(const int *)val;
         return true;
     }
+    if (name == "simd_level" && type == TypeDesc::TypeString) {
+        return pvt::set_simd_level (*(const char **)val);
+    }
+    if (name == "colorconvert:bake" && type == TypeDesc::TypeInt) {
+        colorconvert_bake = Imath::clamp (*(const int *)val, 0, 2);
+        return true;
+    }
     return false;
 }
 
@@ -315,6 +333,22 @@ getattribute (string_view name, TypeDesc type, void *val)
         *(ustring *)val = ustring(oiio_simd_caps());
         return true;
     }
+    if (name == "simd_level" && type == TypeDesc::TypeString) {
+        *(ustring *)val = ustring(pvt::simd_kernels().level);
+        return true;
+    }
+    if (name == "colorconvert:bake" && type == TypeDesc::TypeInt) {
+        *(int *)val = colorconvert_bake;
+        return true;
+    }
+    if (name == "simd_levels" && type == TypeDesc::TypeString) {
+        *(ustring *)val = ustring(pvt::simd_levels());
+        return true;
+    }
+    if (name == "simd_kernels" && type == TypeDesc::TypeString) {
+        *(ustring *)val = ustring(pvt::simd_kernels_report());
+        return true;
+    }
     return false;
 }
 
@@ -425,13 +459,13 @@ pvt::convert_to_float (const void *src, float *dst, int nvals,
     case TypeDesc::FLOAT :
         return (float *)src;
     case TypeDesc::UINT8 :
-        convert_type ((const unsigned char *)src, dst, nvals);
+        simd_kernels().uint8_to_float ((const unsigned char *)src, dst, nvals);
         break;
     case TypeDesc::HALF :
-        convert_type ((const half *)src, dst, nvals);
+        simd_kernels().half_to_float ((const half *)src, dst, nvals);
         break;
     case TypeDesc::UINT16 :
-        convert_type ((const unsigned short *)src, dst, nvals);
+        simd_kernels().uint16_to_float ((const unsigned short *)src, dst, nvals);
         break;
     case TypeDesc::INT8:
         convert_type ((const char *)src, dst, nvals);
@@ -498,6 +532,22 @@ const void *
 pvt::convert_from_float (const float *src, void *dst, size_t nvals,
                          long long quant_min, long long quant_max, TypeDesc format)
 {
+    // The common cases with the default quantization go to the kernels
+    // for the best SIMD level of this machine.
+    if (src && format.basetype == TypeDesc::HALF) {
+        simd_kernels().float_to_half (src, (half *)dst, nvals);
+        return dst;
+    }
+    if (src && format.basetype == TypeDesc::UINT8 &&
+          quant_min == 0 && quant_max == 255) {
+        simd_kernels().float_to_uint8 (src, (unsigned char *)dst, nvals);
+        return dst;
+    }
+    if (src && format.basetype == TypeDesc::UINT16 &&
+          quant_min == 0 && quant_max == 65535) {
+        simd_kernels().float_to_uint16 (src, (unsigned short *)dst, nvals);
+        return dst;
+    }
     switch (format.basetype) {
     case TypeDesc::FLOAT :
         return src;
@@ -558,6 +608,109 @@ pvt::parallel_convert_from_float (const float *src, void *dst, size_t nvals,
 
 
 
+namespace {
+
+// Lookup tables for the conversions between half and the integer types.
+// Each entry is computed just as the conversion through float would be,
+// so the results are identical.  (Non-finite halfs go to 0 or the
+// maximum rather than being undefined.)
+struct HalfTables {
+    HalfTables () {
+        for (int i = 0;  i < 65536;  ++i) {
+            half h;
+            h.setBits ((unsigned short)i);
+            float f = h;
+            if (isnan (f))
+                f = 0.0f;
+            to_uint8[i] = convert_type<float,unsigned char> (f);
+            to_uint16[i] = convert_type<float,unsigned short> (f);
+            from_uint16[i] = convert_type<unsigned short,float> ((unsigned short)i);
+        }
+        for (int i = 0;  i < 256;  ++i)
+            from_uint8[i] = convert_type<unsigned char,float> ((unsigned char)i);
+    }
+    unsigned char to_uint8[65536];
+    unsigned short to_uint16[65536];
+    half from_uint8[256];
+    half from_uint16[65536];
+};
+
+
+static const HalfTables &
+half_tables ()
+{
+    static HalfTables tables;   // built on first use
+    return tables;
+}
+
+}  // anon namespace
+
+
+
+bool
+pvt::has_direct_conversion (TypeDesc src, TypeDesc dst)
+{
+    auto common = [](TypeDesc t) {
+        return t == TypeDesc::UINT8 || t == TypeDesc::UINT16 ||
+               t == TypeDesc::HALF;
+    };
+    return src != dst && common(src) && common(dst);
+}
+
+
+
+bool
+pvt::convert_direct (TypeDesc src_type, const void *src,
+                     TypeDesc dst_type, void *dst, size_t n)
+{
+    if (! has_direct_conversion (src_type, dst_type))
+        return false;
+    typedef unsigned char uchar;
+    typedef unsigned short ushort;
+    const HalfTables *tables = (src_type == TypeDesc::HALF ||
+                                dst_type == TypeDesc::HALF)
+                             ? &half_tables() : NULL;
+    // The integer kernels are simple enough for the compiler to vectorize.
+    if (src_type == TypeDesc::UINT8 && dst_type == TypeDesc::UINT16) {
+        // x/255*65535 == x*257 exactly
+        const uchar *s = (const uchar *)src;
+        ushort *d = (ushort *)dst;
+        for (size_t i = 0;  i < n;  ++i)
+            d[i] = ushort (s[i] * 257);
+    } else if (src_type == TypeDesc::UINT16 && dst_type == TypeDesc::UINT8) {
+        // round(x/257) == (x+128)/257, done as a multiply and shift
+        // (verified exhaustively for all 16 bit x).
+        const ushort *s = (const ushort *)src;
+        uchar *d = (uchar *)dst;
+        for (size_t i = 0;  i < n;  ++i)
+            d[i] = uchar (((unsigned int)(s[i]) + 128u) * 65281u >> 24);
+    } else if (src_type == TypeDesc::HALF) {
+        const ushort *s = (const ushort *)src;   // the bits of the halfs
+        if (dst_type == TypeDesc::UINT8) {
+            uchar *d = (uchar *)dst;
+            for (size_t i = 0;  i < n;  ++i)
+                d[i] = tables->to_uint8[s[i]];
+        } else {
+            ushort *d = (ushort *)dst;
+            for (size_t i = 0;  i < n;  ++i)
+                d[i] = tables->to_uint16[s[i]];
+        }
+    } else if (src_type == TypeDesc::UINT8) {   // to half
+        const uchar *s = (const uchar *)src;
+        half *d = (half *)dst;
+        for (size_t i = 0;  i < n;  ++i)
+            d[i] = tables->from_uint8[s[i]];
+    } else {                                    // uint16 to half
+        const ushort *s = (const ushort *)src;
+        half *d = (half *)dst;
+        for (size_t i = 0;  i < n;  ++i)
+            d[i] = tables->from_uint16[s[i]];
+    }
+    return true;
+}
+
+
+
 bool
 convert_types (TypeDesc src_type, const void *src, 
                TypeDesc dst_type, void *dst, int n)
@@ -574,6 +727,10 @@ convert_types (TypeDesc src_type, const void *src,
         return true;
     }
 
+    // Common pairs that don't need to go through float at all
+    if (pvt::convert_direct (src_type, src, dst_type, dst, n))
+        return true;
+
     // Conversion is to a non-float type
 
     std::unique_ptr<float[]> tmp;   // In case we need a lot of temp space
@@ -593,7 +750,7 @@ convert_types (TypeDesc src_type, const void *src,
     switch (dst_type.basetype) {
     case TypeDesc::UINT8 :  convert_type (buf, (unsigned char *)dst, n);  break;
     case TypeDesc::UINT16 : convert_type (buf, (unsigned short *)dst, n); break;
-    case TypeDesc::HALF :   convert_type (buf, (half *)dst, n);   break;
+    case TypeDesc::HALF :   pvt::simd_kernels().float_to_half (buf, (half *)dst, n); break;
     case TypeDesc::INT8 :   convert_type (buf, (char *)dst, n);   break;
     case TypeDesc::INT16 :  convert_type (buf, (short *)dst, n);  break;
     case TypeDesc::INT :    convert_type (buf, (int *)dst, n);  break;
@@ -30,7 +30,9 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -51,8 +53,10 @@ typedef const char* (*PluginLibVersionFunc) ();
 
 namespace {
 
-// Map format name to ImageInput creation
+// Map format name (and extensions) to ImageInput creation
 static InputPluginMap input_formats;
+// Map format name only to ImageInput creation
+static InputPluginMap input_format_names;
 // Map format name to ImageOutput creation
 static OutputPluginMap output_formats;
 // Map file extension to ImageInput creation
@@ -65,6 +69,8 @@ static std::map <std::string, Plugin::Handle> plugin_handles;
 static std::map <std::string, std::string> plugin_filepaths;
 // Map format name to underlying implementation library
 static std::map <std::string, std::string> format_library_versions;
+// Plugin searchpaths whose directories have already been scanned
+static std::set <std::string> cataloged_searchpaths;
 
 
 
@@ -79,6 +85,136 @@ add_if_missing (std::vector<std::string> &vec, const std::string &val)
         vec.push_back (val);
 }
 
+
+
+// Signatures found at a fixed offset near the start of files of each
+// format.  These are only used to decide which plugins to ask first when
+// the file extension doesn't lead us to a reader; the plugin itself still
+// has the final word via valid_file() or open().  Formats with no reliable
+// signature (e.g. Targa, RLA, camera raw) are simply not listed, and will
+// be found by the exhaustive search.
+struct FormatMagic {
+    const char *format;     // Format name
+    int offset;             // Byte offset of the signature
+    int len;                // Length of the signature in bytes
+    const char *magic;      // The signature itself
+};
+
+static const FormatMagic format_magic[] = {
+    { "openexr",     0,  4, "\x76\x2f\x31\x01" },
+    { "tiff",        0,  4, "II*\0" },
+    { "tiff",        0,  4, "MM\0*" },
+    { "tiff",        0,  4, "II+\0" },          // BigTIFF
+    { "tiff",        0,  4, "MM\0+" },          // BigTIFF
+    { "jpeg",        0,  3, "\xff\xd8\xff" },
+    { "png",         0,  8, "\x89PNG\r\n\x1a\n" },
+    { "dpx",         0,  4, "SDPX" },
+    { "dpx",         0,  4, "XPDS" },
+    { "cineon",      0,  4, "\x80\x2a\x5f\xd7" },
+    { "cineon",      0,  4, "\xd7\x5f\x2a\x80" },
+    { "gif",         0,  6, "GIF87a" },
+    { "gif",         0,  6, "GIF89a" },
+    { "psd",         0,  4, "8BPS" },
+    { "fits",        0,  6, "SIMPLE" },
+    { "hdr",         0,  2, "#?" },
+    { "sgi",         0,  2, "\x01\xda" },
+    { "dds",         0,  4, "DDS " },
+    { "iff",         0,  4, "FOR4" },
+    { "softimage",   0,  4, "\x53\x80\xf6\x34" },
+    { "zfile",       0,  4, "\x2f\x08\x67\xab" },
+    { "zfile",       0,  4, "\xab\x67\x08\x2f" },
+    { "webp",        8,  4, "WEBP" },
+    { "jpeg2000",    0, 12, "\0\0\0\x0cjP  \r\n\x87\n" },
+    { "jpeg2000",    0,  4, "\xff\x4f\xff\x51" },
+    { "ptex",        0,  4, "Ptex" },
+    { "field3d",     0,  8, "\x89HDF\r\n\x1a\n" },
+    { "dicom",     128,  4, "DICM" },
+    { "bmp",         0,  2, "BM" },
+    { "ico",         0,  4, "\0\0\1\0" },
+    { "pnm",         0,  2, "P1" },
+    { "pnm",         0,  2, "P2" },
+    { "pnm",         0,  2, "P3" },
+    { "pnm",         0,  2, "P4" },
+    { "pnm",         0,  2, "P5" },
+    { "pnm",         0,  2, "P6" },
+};
+
+
+
+/// Read the first few bytes of the file (just once) and return the names
+/// of the formats whose signatures match, most specific first.
+static std::vector<std::string>
+formats_from_magic (const std::string &filename)
+{
+    std::vector<std::string> names;
+    FILE *fd = Filesystem::fopen (filename, "rb");
+    if (! fd)
+        return names;
+    unsigned char header[132];   // enough to cover the DICOM preamble
+    int nread = (int) fread (header, 1, sizeof(header), fd);
+    fclose (fd);
+    for (const auto &m : format_magic) {
+        if (m.offset + m.len <= nread &&
+            ! memcmp (header + m.offset, m.magic, m.len))
+            add_if_missing (names, m.format);
+    }
+    return names;
+}
+
+
+
+/// Return the distinct ImageInput creators for the named formats, skipping
+/// any we don't (yet) have a plugin for.  The caller must hold a lock on
+/// imageio_mutex.
+static std::vector<ImageInput::Creator>
+input_creators_for (const std::vector<std::string> &names)
+{
+    std::vector<ImageInput::Creator> creators;
+    for (const auto &name : names) {
+        InputPluginMap::const_iterator found = input_format_names.find (name);
+        if (found != input_format_names.end() &&
+            std::find (creators.begin(), creators.end(),
+                       found->second) == creators.end())
+            creators.push_back (found->second);
+    }
+    return creators;
+}
+
+
+
+/// Create an ImageInput with the given creator and see if it can read the
+/// file.  Return the ImageInput if so (opened if do_open is true, closed
+/// otherwise), or NULL if not.
+static ImageInput *
+try_input_creator (ImageInput::Creator creator, const std::string &filename,
+                   bool do_open, const ImageSpec &config)
+{
+    ImageInput *in = NULL;
+    try {
+        in = creator();
+    } catch (...) {
+        // Safety in case the ctr throws an exception
+    }
+    if (! in)
+        return NULL;
+    if (! do_open && ! in->valid_file(filename)) {
+        // Since we didn't need to open it, we just checked whether
+        // it was a valid file, and it's not.
+        delete in;
+        return NULL;
+    }
+    // We either need to open it, or we already know it appears
+    // to be a file of the right type.
+    ImageSpec tmpspec;
+    if (in->open (filename, tmpspec, config)) {
+        if (! do_open)
+            in->close ();
+        return in;
+    }
+    delete in;
+    return NULL;
+}
+
 } // anon namespace
 
 
@@ -98,6 +234,7 @@ declare_imageio_format (const std::string &format_name,
     if (input_creator) {
         if (input_formats.find(format_name) != input_formats.end())
             input_formats[format_name] = input_creator;
+        input_format_names[format_name] = input_creator;
         std::string extsym = format_name + "_input_extensions";
         for (const char **e = input_extensions; e && *e; ++e) {
             std::string ext (*e);
@@ -271,6 +408,10 @@ namespace {
 static void
 catalog_builtin_plugins ()
 {
+    static bool builtins_cataloged = false;
+    if (builtins_cataloged)
+        return;
+    builtins_cataloged = true;
 #ifdef EMBED_PLUGINS
     // Use DECLAREPLUG macro to make this more compact and easy to read.
 #define DECLAREPLUG(name)                                                 \
@@ -360,8 +501,11 @@ append_if_env_exists (std::string &searchpath, const char *env,
 
 
 /// Look at ALL imageio plugins in the searchpath and add them to the
-/// catalog.  This routine is not reentrant and should only be called
-/// by a routine that is holding a lock on imageio_mutex.
+/// catalog.  Each distinct searchpath is only scanned once (until the
+/// "plugin_searchpath" attribute changes), so repeated calls (for example,
+/// for every file whose extension we don't know) are cheap.  This routine
+/// is not reentrant and should only be called by a routine that is holding
+/// a lock on imageio_mutex.
 void
 pvt::catalog_all_plugins (std::string searchpath)
 {
@@ -374,6 +518,8 @@ pvt::catalog_all_plugins (std::string searchpath)
 #if defined(__linux__) || defined(__FreeBSD__)
     append_if_env_exists (searchpath, "LD_LIBRARY_PATH");
 #endif
+    if (! cataloged_searchpaths.insert (searchpath).second)
+        return;   // Already scanned these directories
 
     size_t patlen = pattern.length();
     std::vector<std::string> dirs;
@@ -395,6 +541,15 @@ pvt::catalog_all_plugins (std::string searchpath)
 
 
 
+void
+pvt::invalidate_plugin_catalog ()
+{
+    recursive_lock_guard lock (imageio_mutex);
+    cataloged_searchpaths.clear ();
+}
+
+
+
 ImageOutput *
 ImageOutput::create (const std::string &filename,
                      const std::string &plugin_searchpath)
@@ -488,18 +643,37 @@ ImageInput::create (const std::string &filename,
         format = filename;
     }
 
+    // If the extension doesn't tell us the format, peek at the first few
+    // bytes of the file for a known signature.  This is done only once
+    // per file, rather than having every plugin open the file in turn.
+    std::vector<std::string> magic_formats;
+    bool known_ext = false;
+    {
+        recursive_lock_guard lock (imageio_mutex);  // Ensure thread safety
+        Strutil::to_lower (format);
+        catalog_builtin_plugins ();
+        known_ext = (input_formats.find (format) != input_formats.end());
+    }
+    if (! known_ext && filename != format)
+        magic_formats = formats_from_magic (filename);
+
     ImageInput::Creator create_function = NULL;
+    std::vector<ImageInput::Creator> magic_creators;
     { // scope the lock:
         recursive_lock_guard lock (imageio_mutex);  // Ensure thread safety
 
-        // See if it's already in the table.  If not, scan all plugins we can
-        // find to populate the table.
-        Strutil::to_lower (format);
+        // See if it's already in the table.  If not, and the file's
+        // signature doesn't match any format we already know, scan all
+        // plugins we can find to populate the table.  Walking the plugin
+        // directories (and loading every DSO in them) is deferred until
+        // it is really needed.
         InputPluginMap::const_iterator found = input_formats.find (format);
-        if (found == input_formats.end()) {
+        magic_creators = input_creators_for (magic_formats);
+        if (found == input_formats.end() && magic_creators.empty()) {
             catalog_all_plugins (plugin_searchpath.size() ? plugin_searchpath
                                  : pvt::plugin_searchpath.string());
             found = input_formats.find (format);
+            magic_creators = input_creators_for (magic_formats);
         }
         if (found != input_formats.end())
             create_function = found->second;
@@ -508,6 +682,12 @@ ImageInput::create (const std::string &filename,
     // Remember which prototypes we've already tried, so we don't double dip.
     std::vector<ImageInput::Creator> formats_tried;
 
+    // Pass the trial opens a configuration request that includes a
+    // "nowait" option so that it returns immediately if it's a plugin
+    // that might wait for an event, like a socket that doesn't yet exist.
+    ImageSpec config;
+    config.attribute ("nowait", (int)1);
+
     std::string specific_error;
     if (create_function) {
         if (filename != format) {
@@ -542,16 +722,37 @@ ImageInput::create (const std::string &filename,
         }
     }
 
+    if (! create_function && known_ext && filename != format) {
+        // The extension was misleading, so now check the signature.
+        magic_formats = formats_from_magic (filename);
+        recursive_lock_guard lock (imageio_mutex);  // Ensure thread safety
+        magic_creators = input_creators_for (magic_formats);
+    }
+
+    if (! create_function) {
+        // Give the formats whose signature matched the file first shot.
+        // For a misnamed or extensionless file, this usually finds the
+        // reader without trying any other plugin.
+        for (auto creator : magic_creators) {
+            if (std::find (formats_tried.begin(), formats_tried.end(),
+                           creator) != formats_tried.end())
+                continue;
+            formats_tried.push_back (creator);
+            ImageInput *in = try_input_creator (creator, filename,
+                                                do_open, config);
+            if (in)
+                return in;
+        }
+    }
+
     if (! create_function) {
         // If a plugin can't be found that was explicitly designated for
-        // this extension, then just try every one we find and see if
-        // any will open the file.  Pass it a configuration request that
-        // includes a "nowait" option so that it returns immediately if
-        // it's a plugin that might wait for an event, like a socket that
-        // doesn't yet exist).
-        ImageSpec config;
-        config.attribute ("nowait", (int)1);
+        // this extension or matched the file signature, then just try
+        // every one we find and see if any will open the file.  If we
+        // put off scanning the plugin directories above, it's time now.
         recursive_lock_guard lock (imageio_mutex);  // Ensure thread safety
+        catalog_all_plugins (plugin_searchpath.size() ? plugin_searchpath
+                             : pvt::plugin_searchpath.string());
         for (InputPluginMap::const_iterator plugin = input_formats.begin();
              plugin != input_formats.end(); ++plugin)
         {
@@ -561,30 +762,10 @@ ImageInput::create (const std::string &filename,
                 continue;
             formats_tried.push_back (plugin->second);  // remember
 
-            ImageSpec tmpspec;
-            ImageInput *in = NULL;
-            try {
-                in = plugin->second();
-            } catch (...) {
-                // Safety in case the ctr throws an exception
-            }
-            if (! in)
-                continue;
-            if (! do_open && ! in->valid_file(filename)) {
-                // Since we didn't need to open it, we just checked whether
-                // it was a valid file, and it's not.  Try the next one.
-                delete in;
-                continue;
-            }
-            // We either need to open it, or we already know it appears
-            // to be a file of the right type.
-            bool ok = in->open(filename, tmpspec, config);
-            if (ok) {
-                if (! do_open)
-                    in->close ();
+            ImageInput *in = try_input_creator (plugin->second, filename,
+                                                do_open, config);
+            if (in)
                 return in;
-            }
-            delete in;
         }
     }
 
@@ -374,12 +374,25 @@ ImageOutput::to_native_rectangle (int xbegin, int xend, int ybegin, int yend,
     // The remaining code is where all channels in the file have the
     // same data type, which may or may not be what the user passed in
     // (cases #3 and #4 above).
+    bool do_dither = (dither && format.is_floating_point() &&
+                      m_spec.format.basetype == TypeDesc::UINT8);
+
+    // Between uint8, uint16 and half there are direct conversions, which
+    // need neither a float buffer nor a separate pass to make the data
+    // contiguous.  (Dither is applied in float, so it can't use them.)
+    if (! do_dither && pvt::has_direct_conversion (format, m_spec.format)) {
+        scratch.resize (native_rectangle_bytes);
+        parallel_convert_image (m_spec.nchannels, width, height, depth,
+                                data, format, xstride, ystride, zstride,
+                                &scratch[0], m_spec.format,
+                                AutoStride, AutoStride, AutoStride);
+        return &scratch[0];
+    }
+
     imagesize_t contiguoussize = contiguous ? 0 : rectangle_values * input_pixel_bytes;
     contiguoussize = (contiguoussize+3) & (~3); // Round up to 4-byte boundary
     DASSERT ((contiguoussize & 3) == 0);
     imagesize_t floatsize = rectangle_values * sizeof(float);
-    bool do_dither = (dither && format.is_floating_point() &&
-                      m_spec.format.basetype == TypeDesc::UINT8);
     scratch.resize (contiguoussize + floatsize + native_rectangle_bytes);
 
     // Force contiguity if not already present
@@ -196,6 +196,35 @@ time_ic_get_pixels ()
 
 
 
+static void
+time_open_headers (const ImageSpec *config)
+{
+    for (ustring filename : input_filename) {
+        ImageInput *in = ImageInput::open (filename.c_str(), config);
+        ASSERT (in);
+        in->close ();
+        delete in;
+    }
+}
+
+
+
+static void
+test_open (const std::string &explanation, bool header_only)
+{
+    ImageSpec config;
+    if (header_only)
+        config.attribute ("oiio:HeaderOnly", 1);
+    double t = time_trial (std::bind (time_open_headers, &config), ntrials);
+    double rate = double(input_filename.size()) / t;
+    std::cout << "  " << explanation << ": "
+              << Strutil::timeintervalformat(t,2)
+              << " = " << Strutil::format("%5.1f",rate) << " files/s"
+              << std::endl;
+}
+
+
+
 static void
 test_read (const std::string &explanation,
            void (*func)(), int autotile=64, int autoscanline=1)
@@ -560,6 +589,11 @@ main (int argc, char **argv)
     imagecache->invalidate_all (true);  // Don't hold anything
 
     if (! iter_only) {
+        std::cout << "Timing opening images (metadata scan):\n";
+        test_open ("open                                         ", false);
+        test_open ("open (oiio:HeaderOnly)                       ", true);
+        std::cout << std::endl;
+
         std::cout << "Timing various ways of reading images:\n";
         if (conversion == TypeDesc::UNKNOWN)
             std::cout << "    ImageInput reads will keep data in native format.\n";
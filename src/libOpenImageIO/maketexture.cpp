@@ -31,6 +31,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <future>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -56,6 +57,8 @@
 #include <OpenImageIO/thread.h>
 #include <OpenImageIO/filter.h>
 
+#include "../libtexture/dedup_index.h"
+
 #ifdef USE_BOOST_REGEX
 # include <boost/regex.hpp>
   using boost::regex;
@@ -335,7 +338,7 @@ resize_block (ImageBuf &dst, const ImageBuf &src, ROI roi, bool envlatlmode,
     DASSERT (dstspec.nchannels == srcspec.nchannels);
     DASSERT (dst.localpixels());
     bool ok;
-    if (src.localpixels() &&                      // Not a cached image
+    if (src.contiguous() && dst.contiguous() &&   // Not cached or a view
         !envlatlmode &&                           // not latlong wrap mode
         roi.xbegin == 0 &&                        // Region x at origin
         dstspec.width == roi.width() &&           // Full width ROI
@@ -509,6 +512,53 @@ maketx_merge_spec (ImageSpec &dstspec, const ImageSpec &srcspec)
 
 
 
+// Canonical name of a "maketx:hash_algorithm", or "" if it's unknown.
+static std::string
+hash_algorithm_name (string_view name)
+{
+    if (name.empty() || Strutil::iequals (name, "sha1") ||
+        Strutil::iequals (name, "sha-1"))
+        return "sha1";
+    if (Strutil::iequals (name, "xxh64") || Strutil::iequals (name, "xxhash"))
+        return "xxh64";
+    if (Strutil::iequals (name, "farmhash128") ||
+        Strutil::iequals (name, "farmhash"))
+        return "farmhash128";
+    return std::string();
+}
+
+
+
+// Is the existing texture file the one we're about to write: the same
+// top level pixel hash, dedup key (which covers the resolution, windows,
+// channels, data types, and texture metadata), tiling, compression, and
+// MIP-mapped or not?
+static bool
+same_texture_file (const std::string &filename, const ImageSpec &dstspec,
+                   string_view hash_attr, string_view hash,
+                   const std::string &dedupkey, bool mipmap)
+{
+    if (pvt::DedupIndex::file_key (hash, filename) != dedupkey)
+        return false;
+    ImageInput *in = ImageInput::open (filename);
+    if (! in)
+        return false;
+    const ImageSpec &spec (in->spec());
+    bool same = (spec.get_string_attribute (hash_attr) == hash &&
+                 spec.tile_width == dstspec.tile_width &&
+                 spec.tile_height == dstspec.tile_height &&
+                 spec.tile_depth == dstspec.tile_depth &&
+                 Strutil::iequals (spec.get_string_attribute ("compression"),
+                                   dstspec.get_string_attribute ("compression")));
+    ImageSpec tmp;
+    same &= (in->seek_subimage (0, 1, tmp) == mipmap);
+    in->close ();
+    ImageInput::destroy (in);
+    return same;
+}
+
+
+
 static bool
 write_mipmap (ImageBufAlgo::MakeTextureMode mode,
               std::shared_ptr<ImageBuf> &img,
@@ -518,7 +568,7 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
               string_view filtername, const ImageSpec &configspec,
               std::ostream &outstream,
               double &stat_writetime, double &stat_miptime,
-              size_t &peak_mem)
+              double &stat_writeoverlap, size_t &peak_mem)
 {
     bool envlatlmode = (mode == ImageBufAlgo::MakeTxEnvLatl);
     bool orig_was_overscan =
@@ -581,16 +631,78 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
         outstream << "  Top level is " << formatres(outspec) << std::endl;
     }
 
-    if (! img->write (out)) {
-        // ImageBuf::write transfers any errors from the ImageOutput to
-        // the ImageBuf.
-        outstream << "maketx ERROR: Write failed \" : " << img->geterror() << "\n";
-        out->close ();
-        return false;
+    // In pipelined mode, each level is compressed and written by a
+    // background task while the main thread filters the next level down
+    // from it.  Only one level is ever in flight, and the main thread
+    // doesn't touch 'out' (or modify the level being written) until that
+    // write has finished.  (Don't pipeline if we're already running
+    // inside the thread pool, where waiting on another pool task could
+    // deadlock.)
+    bool pipeline = mipmap &&
+                    configspec.get_int_attribute ("maketx:pipeline", 1) != 0 &&
+                    ! default_thread_pool()->this_thread_is_in_pool();
+    std::future<std::string> pending;   // error message, or "" if ok
+    double pending_time = 0.0;          // set by the background write
+    auto write_level = [&](std::shared_ptr<ImageBuf> level,
+                           bool append, ImageSpec levelspec) -> std::string {
+        Timer timer;
+        std::string err;
+        // If the format explicitly supports MIP-maps, use that,
+        // otherwise try to simulate MIP-mapping with multi-image.
+        ImageOutput::OpenMode mode = out->supports ("mipmap") ?
+            ImageOutput::AppendMIPLevel : ImageOutput::AppendSubimage;
+        if (append && ! out->open (outputfilename.c_str(), levelspec, mode)) {
+            err = Strutil::format ("maketx ERROR: Could not append \"%s\" : %s\n",
+                                   outputfilename, out->geterror());
+        } else if (! level->write (out)) {
+            // ImageBuf::write transfers any errors from the
+            // ImageOutput to the ImageBuf.
+            err = append ? Strutil::format ("maketx ERROR writing \"%s\" : %s\n",
+                                            outputfilename, level->geterror())
+                         : Strutil::format ("maketx ERROR: Write failed \" : %s\n",
+                                            level->geterror());
+            out->close ();
+        }
+        pending_time = timer();
+        return err;
+    };
+    // Wait for any background write to finish, and account for it.  The
+    // part of the write that ran while we were computing the next level
+    // is tallied as overlap.
+    auto finish_write = [&]() -> bool {
+        if (! pending.valid())
+            return true;
+        Timer waittimer;
+        std::string err = pending.get ();
+        stat_writetime += pending_time;
+        stat_writeoverlap += std::max (0.0, pending_time - waittimer());
+        if (err.size()) {
+            outstream << err;
+            return false;
+        }
+        return true;
+    };
+
+    // The resize below wants each level's display window to match its
+    // pixels.  That's set up before the level is written, never while a
+    // background write might be reading it.  (It doesn't change what's
+    // written, which follows outspec.)
+    img->set_full (img->xbegin(), img->xend(), img->ybegin(),
+                   img->yend(), img->zbegin(), img->zend());
+    if (pipeline) {
+        stat_writetime += writetimer();
+        pending = default_thread_pool()->push ([=,&write_level](int){
+            return write_level (img, false, outspec);
+        });
+    } else {
+        std::string err = write_level (img, false, outspec);
+        if (err.size()) {
+            outstream << err;
+            return false;
+        }
+        stat_writetime += writetimer();
     }
 
-    stat_writetime += writetimer();
-
     if (mipmap) {  // Mipmap levels:
         if (verbose)
             outstream << "  Mipmapping...\n" << std::flush;
@@ -652,8 +764,6 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
                 smallspec.full_x = 0;
                 smallspec.full_y = 0;
                 small->reset (smallspec);  // Realocate with new size
-                img->set_full (img->xbegin(), img->xend(), img->ybegin(),
-                               img->yend(), img->zbegin(), img->zend());
 
                 if (filtername == "box" && !orig_was_overscan && sharpen <= 0.0f) {
                     ImageBufAlgo::parallel_image (get_roi(small->spec()),
@@ -661,6 +771,7 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
                 } else {
                     Filter2D *filter = setup_filter (small->spec(), img->spec(), filtername);
                     if (! filter) {
+                        finish_write ();
                         outstream << "maketx ERROR: could not make filter \"" << filtername << "\"\n";
                         return false;
                     }
@@ -675,8 +786,15 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
                         }
                         outstream << "\n";
                     }
-                    if (do_highlight_compensation)
+                    if (do_highlight_compensation && pending.valid()) {
+                        // img may still be being written; don't modify
+                        // it in place.
+                        std::shared_ptr<ImageBuf> comp (new ImageBuf);
+                        ImageBufAlgo::rangecompress (*comp, *img);
+                        std::swap (img, comp);
+                    } else if (do_highlight_compensation) {
                         ImageBufAlgo::rangecompress (*img, *img);
+                    }
                     if (sharpen > 0.0f && sharpen_first) {
                         std::shared_ptr<ImageBuf> sharp (new ImageBuf);
                         bool uok = ImageBufAlgo::unsharp_mask (*sharp, *img,
@@ -708,26 +826,27 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
             outspec.set_format (outputdatatype);
             if (envlatlmode && src_samples_border)
                 fix_latl_edges (*small);
+            small->set_full (small->xbegin(), small->xend(), small->ybegin(),
+                             small->yend(), small->zbegin(), small->zend());
 
-            Timer writetimer;
-            // If the format explicitly supports MIP-maps, use that,
-            // otherwise try to simulate MIP-mapping with multi-image.
-            ImageOutput::OpenMode mode = out->supports ("mipmap") ?
-                ImageOutput::AppendMIPLevel : ImageOutput::AppendSubimage;
-            if (! out->open (outputfilename.c_str(), outspec, mode)) {
-                outstream << "maketx ERROR: Could not append \"" << outputfilename
-                          << "\" : " << out->geterror() << "\n";
-                return false;
-            }
-            if (! small->write (out)) {
-                // ImageBuf::write transfers any errors from the
-                // ImageOutput to the ImageBuf.
-                outstream << "maketx ERROR writing \"" << outputfilename
-                          << "\" : " << small->geterror() << "\n";
-                out->close ();
+            // The previous level must be completely written before this
+            // one can be appended.
+            if (! finish_write ())
                 return false;
+            if (pipeline) {
+                std::shared_ptr<ImageBuf> level = small;
+                ImageSpec levelspec = outspec;
+                pending = default_thread_pool()->push ([=,&write_level](int){
+                    return write_level (level, true, levelspec);
+                });
+            } else {
+                std::string err = write_level (small, true, outspec);
+                stat_writetime += pending_time;
+                if (err.size()) {
+                    outstream << err;
+                    return false;
+                }
             }
-            stat_writetime += writetimer();
             if (verbose) {
                 size_t mem = Sysutil::memory_used(true);
                 peak_mem = std::max (peak_mem, mem);
@@ -740,6 +859,8 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
         }
     }
 
+    if (! finish_write ())
+        return false;
     if (verbose)
         outstream << "  Wrote file: " << outputfilename << "  ("
                   << Strutil::memformat(Sysutil::memory_used(true)) << ")\n";
@@ -756,6 +877,295 @@ write_mipmap (ImageBufAlgo::MakeTextureMode mode,
 
 
 
+// Can this texture be made by write_mipmap_streaming?  If not, return
+// false and say why.  Anything beyond a plain, unresized, box-filtered
+// 2D texture still needs whole levels in memory.
+static bool
+can_stream (ImageBufAlgo::MakeTextureMode mode, const ImageSpec &configspec,
+            const ImageSpec &spec, std::string &why)
+{
+    std::string incolorspace = configspec.get_string_attribute ("maketx:incolorspace");
+    std::string outcolorspace = configspec.get_string_attribute ("maketx:outcolorspace");
+    std::string fixnan = configspec.get_string_attribute ("maketx:fixnan");
+    int nchannels = configspec.get_int_attribute ("maketx:nchannels", -1);
+    bool set_full = configspec.get_int_attribute ("maketx:set_full_to_pixels");
+    if (mode != ImageBufAlgo::MakeTxTexture && mode != ImageBufAlgo::MakeTxShadow)
+        why = "environment maps";
+    else if (spec.depth > 1)
+        why = "volume textures";
+    else if (! set_full && (spec.x != spec.full_x || spec.y != spec.full_y ||
+                            spec.width != spec.full_width ||
+                            spec.height != spec.full_height))
+        why = "crop or overscan windows";
+    else if (configspec.get_int_attribute ("maketx:resize") &&
+             (! ispow2 (spec.width) || ! ispow2 (spec.height)))
+        why = "resizing to a power of 2";
+    else if (configspec.get_string_attribute ("maketx:filtername", "box") != "box")
+        why = "filters other than box";
+    else if (configspec.get_float_attribute ("maketx:sharpen", 0.0f) > 0.0f)
+        why = "sharpening";
+    else if (configspec.get_int_attribute ("maketx:highlightcomp", 0))
+        why = "highlight compensation";
+    else if (configspec.get_int_attribute ("maketx:allow_pixel_shift"))
+        why = "allow_pixel_shift";
+    else if (configspec.get_string_attribute ("maketx:mipimages").size())
+        why = "custom MIP images";
+    else if (incolorspace.size() && outcolorspace.size() &&
+             incolorspace != outcolorspace)
+        why = "color conversion";
+    else if (fixnan.size() && fixnan != "none")
+        why = "fixnan";
+    else if (nchannels > 0 && nchannels != spec.nchannels)
+        why = "changing the number of channels";
+    else
+        return true;
+    return false;
+}
+
+
+
+// Bilinear sample positions, within a source row or column of n pixels,
+// of the m pixels of the next MIP level down.  These are the positions
+// resize_block uses, except that an exact halving averages each pair of
+// pixels exactly, as resize_block_2pass does.
+static void
+mip_sample_positions (int n, int m, std::vector<int> &i0,
+                      std::vector<int> &i1, std::vector<float> &frac)
+{
+    i0.resize (m);  i1.resize (m);  frac.resize (m);
+    float scale = 1.0f / (float)m;
+    for (int i = 0;  i < m;  ++i) {
+        if (n == 2*m) {
+            i0[i] = 2*i;
+            frac[i] = 0.5f;
+        } else {
+            frac[i] = floorfrac ((i+0.5f)*scale*(float)n - 0.5f, &i0[i]);
+        }
+        i1[i] = Imath::clamp (i0[i]+1, 0, n-1);
+        i0[i] = Imath::clamp (i0[i], 0, n-1);
+    }
+}
+
+
+
+// Out-of-core version of write_mipmap, for box-filtered 2D textures that
+// need no resizing.  Rather than holding whole MIP levels in memory, each
+// level is streamed through a band of tile_height scanlines: every band
+// is written as a row of tiles as soon as it's read, and is also filtered
+// down into the next level, which is spooled to a temporary file of float
+// scanlines until it's that level's turn to be written.  Memory use
+// depends on the image width, but not on its height.
+static bool
+write_mipmap_streaming (const ImageBuf &src, const ImageSpec &outspec_template,
+                        std::string outputfilename, ImageOutput *out,
+                        TypeDesc outputdatatype, bool mipmap,
+                        const ImageSpec &configspec, std::ostream &outstream,
+                        double &stat_readtime, double &stat_writetime,
+                        double &stat_miptime, size_t &peak_mem)
+{
+    ImageSpec outspec = outspec_template;
+    outspec.set_format (outputdatatype);
+
+    if (mipmap && !out->supports ("multiimage") && !out->supports ("mipmap")) {
+        outstream << "maketx ERROR: \"" << outputfilename
+                  << "\" format does not support multires images\n";
+        return false;
+    }
+    if (! strcmp (out->format_name(), "openexr")) {
+        if (mipmap)
+            outspec.attribute ("openexr:roundingmode", 0 /* ROUND_DOWN */);
+        else
+            outspec.attribute ("openexr:levelmode", 0 /* ONE_LEVEL */);
+    }
+
+    bool verbose = configspec.get_int_attribute ("maketx:verbose") != 0;
+    if (verbose) {
+        outstream << "  Writing file: " << outputfilename << std::endl;
+        outstream << "  Streaming, " << outspec.tile_height
+                  << " scanlines at a time\n";
+        outstream << "  Top level is " << formatres(outspec) << std::endl;
+    }
+
+    const int nchannels = outspec.nchannels;
+    const int bandrows = std::max (1, outspec.tile_height);
+    // If the format explicitly supports MIP-maps, use that, otherwise try
+    // to simulate MIP-mapping with multi-image.
+    ImageOutput::OpenMode appendmode = out->supports ("mipmap") ?
+        ImageOutput::AppendMIPLevel : ImageOutput::AppendSubimage;
+
+    FILE *spool = NULL;        // Spooled pixels of this level (not the top)
+    std::string spoolname;
+    FILE *nextspool = NULL;    // Spooled pixels of the next level
+    std::string nextname;
+    bool ok = true;
+    for (int level = 0;  ok;  ++level) {
+        int w = outspec.width, h = outspec.height;
+        size_t rowfloats = size_t(w) * nchannels;
+
+        Timer writetimer;
+        if (! out->open (outputfilename.c_str(), outspec,
+                         level ? appendmode : ImageOutput::Create)) {
+            outstream << "maketx ERROR: Could not "
+                      << (level ? "append" : "open") << " \""
+                      << outputfilename << "\" : " << out->geterror() << "\n";
+            ok = false;
+            break;
+        }
+        stat_writetime += writetimer();
+
+        // The next level down, if any, and where its pixels sample this
+        // level.
+        bool more = mipmap && (w > 1 || h > 1);
+        ImageSpec nextspec = outspec;
+        std::vector<int> xi0, xi1, yi0, yi1;
+        std::vector<float> xfrac, yfrac;
+        if (more) {
+            nextspec.width = std::max (1, w/2);
+            nextspec.height = std::max (1, h/2);
+            nextspec.full_width = nextspec.width;
+            nextspec.full_height = nextspec.height;
+            nextspec.x = nextspec.y = 0;
+            nextspec.full_x = nextspec.full_y = 0;
+            mip_sample_positions (w, nextspec.width, xi0, xi1, xfrac);
+            mip_sample_positions (h, nextspec.height, yi0, yi1, yfrac);
+            nextname = Filesystem::unique_path (outputfilename + ".%%%%%%%%.mip");
+            nextspool = Filesystem::fopen (nextname, "w+b");
+            if (! nextspool) {
+                outstream << "maketx ERROR: Could not create temporary file \""
+                          << nextname << "\"\n";
+                ok = false;
+                break;
+            }
+        }
+        int nw = nextspec.width, nh = nextspec.height;
+        size_t nextrowfloats = size_t(nw) * nchannels;
+
+        // One band of this level; the band's rows filtered horizontally
+        // to the next level's width (slot 0 holds the last row of the
+        // previous band, which the next level may still need); and one
+        // finished row of the next level.
+        std::vector<float> band (bandrows * rowfloats);
+        std::vector<float> hrows (more ? (bandrows+1) * nextrowfloats : 0);
+        std::vector<float> nextrow (more ? nextrowfloats : 0);
+        int ny = 0;    // Next row of the next level to finish
+        for (int y = 0;  y < h && ok;  y += bandrows) {
+            int n = std::min (bandrows, h - y);
+            Timer readtimer;
+            if (level == 0) {
+                ok = src.get_pixels (ROI (src.xbegin(), src.xend(),
+                                          src.ybegin()+y, src.ybegin()+y+n,
+                                          src.zbegin(), src.zbegin()+1,
+                                          0, nchannels),
+                                     TypeDesc::FLOAT, &band[0]);
+                stat_readtime += readtimer();
+            } else {
+                ok = fread (&band[0], sizeof(float), n*rowfloats, spool) == n*rowfloats;
+                stat_miptime += readtimer();
+            }
+            if (! ok) {
+                outstream << "maketx ERROR: Could not read pixels for MIP level "
+                          << level << "\n";
+                break;
+            }
+
+            writetimer.reset ();
+            writetimer.start ();
+            ok = out->write_tiles (outspec.x, outspec.x+w,
+                                   outspec.y+y, outspec.y+y+n,
+                                   outspec.z, outspec.z+1,
+                                   TypeDesc::FLOAT, &band[0]);
+            stat_writetime += writetimer();
+            if (! ok) {
+                outstream << "maketx ERROR writing \"" << outputfilename
+                          << "\" : " << out->geterror() << "\n";
+                break;
+            }
+            if (! more)
+                continue;
+
+            Timer miptimer;
+            parallel_for (0, n, [&](int64_t i){
+                const float *s = &band[i*rowfloats];
+                float *d = &hrows[(i+1)*nextrowfloats];
+                for (int x = 0;  x < nw;  ++x, d += nchannels) {
+                    const float *s0 = s + xi0[x]*nchannels;
+                    const float *s1 = s + xi1[x]*nchannels;
+                    float f = xfrac[x], f1 = 1.0f - f;
+                    for (int c = 0;  c < nchannels;  ++c)
+                        d[c] = s0[c]*f1 + s1[c]*f;
+                }
+            });
+            // Finish every next-level row whose source rows have arrived.
+            while (ny < nh && yi1[ny] < y+n) {
+                const float *r0 = &hrows[(yi0[ny]-y+1)*nextrowfloats];
+                const float *r1 = &hrows[(yi1[ny]-y+1)*nextrowfloats];
+                float f = yfrac[ny], f1 = 1.0f - f;
+                for (size_t i = 0;  i < nextrowfloats;  ++i)
+                    nextrow[i] = f1*r0[i] + f*r1[i];
+                if (fwrite (&nextrow[0], sizeof(float), nextrowfloats,
+                            nextspool) != nextrowfloats) {
+                    outstream << "maketx ERROR: Could not write temporary file \""
+                              << nextname << "\"\n";
+                    ok = false;
+                    break;
+                }
+                ++ny;
+            }
+            std::copy (&hrows[n*nextrowfloats], &hrows[(n+1)*nextrowfloats],
+                       &hrows[0]);
+            stat_miptime += miptimer();
+        }
+
+        size_t mem = Sysutil::memory_used(true);
+        peak_mem = std::max (peak_mem, mem);
+        if (verbose && level > 0)
+            outstream << Strutil::format ("    %-15s (%s)", formatres(outspec),
+                                          Strutil::memformat(mem))
+                      << std::endl;
+
+        // This level is done; the next one becomes the current one.
+        if (spool) {
+            fclose (spool);
+            Filesystem::remove (spoolname);
+            spool = NULL;
+        }
+        if (! more)
+            break;
+        spool = nextspool;
+        spoolname = nextname;
+        nextspool = NULL;
+        if (ok && (fflush (spool) != 0 || fseek (spool, 0, SEEK_SET) != 0)) {
+            outstream << "maketx ERROR: Could not write temporary file \""
+                      << spoolname << "\"\n";
+            ok = false;
+        }
+        outspec = nextspec;
+    }
+
+    if (spool) {
+        fclose (spool);
+        Filesystem::remove (spoolname);
+    }
+    if (nextspool) {
+        fclose (nextspool);
+        Filesystem::remove (nextname);
+    }
+
+    if (verbose && ok)
+        outstream << "  Wrote file: " << outputfilename << "  ("
+                  << Strutil::memformat(Sysutil::memory_used(true)) << ")\n";
+    Timer writetimer;
+    if (! out->close () && ok) {
+        outstream << "maketx ERROR writing \"" << outputfilename
+                  << "\" : " << out->geterror() << "\n";
+        ok = false;
+    }
+    stat_writetime += writetimer ();
+    return ok;
+}
+
+
+
 static bool
 make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
                    const ImageBuf *input,
@@ -769,6 +1179,7 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
     double stat_writetime = 0;
     double stat_resizetime = 0;
     double stat_miptime = 0;
+    double stat_writeoverlap = 0;
     double stat_colorconverttime = 0;
     size_t peak_mem = 0;
     Timer alltime;
@@ -794,19 +1205,42 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
         return false;
     }
 
+    // A streamed conversion reads the file through a private ImageCache
+    // that breaks even an untiled file into float tiles, so that the file
+    // is never held in memory whole (as a cache without autotile would),
+    // and the top level is the same float pixels the in-memory path
+    // hashes and filters.  (Declared before src, so it outlives it.)
+    std::shared_ptr<ImageCache> streamcache;
     std::shared_ptr<ImageBuf> src;
     if (input == NULL) {
         // No buffer supplied -- create one to read the file
-        src.reset (new ImageBuf(filename));
+        if (configspec.get_int_attribute ("maketx:stream")) {
+            streamcache.reset (ImageCache::create (false /* not shared */),
+                               [](ImageCache *ic){ ImageCache::destroy (ic); });
+            streamcache->attribute ("forcefloat", 1);
+            streamcache->attribute ("autotile", 64);
+            streamcache->attribute ("autoscanline", 1);
+            streamcache->attribute ("unassociatedalpha",
+                    configspec.get_int_attribute ("maketx:ignore_unassoc"));
+            src.reset (new ImageBuf (filename, streamcache.get()));
+        } else {
+            src.reset (new ImageBuf(filename));
+        }
         src->init_spec (filename, 0, 0); // force it to get the spec, not read
     } else if (input->cachedpixels()) {
         // Image buffer supplied that's backed by ImageCache -- create a
         // copy (very light weight, just another cache reference)
         src.reset (new ImageBuf(*input));
-    } else {
-        // Image buffer supplied that has pixels -- wrap it
+    } else if (input->contiguous()) {
+        // Image buffer supplied that has contiguous pixels -- wrap it
         src.reset (new ImageBuf(input->name(), input->spec(),
                                 (void *)input->localpixels()));
+    } else {
+        // Image buffer supplied whose pixels can't be wrapped as a
+        // plain buffer (a view with its parent's strides, or tile-major
+        // pixels) -- copy them into an ordinary scanline-major image
+        src.reset (new ImageBuf);
+        src->copy (*input);
     }
     ASSERT (src.get());
 
@@ -823,6 +1257,15 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
         }
     }
 
+    std::string hash_algorithm = hash_algorithm_name (
+            configspec.get_string_attribute ("maketx:hash_algorithm"));
+    if (hash_algorithm.empty()) {
+        outstream << "maketx ERROR: unknown hash algorithm \""
+                  << configspec.get_string_attribute ("maketx:hash_algorithm")
+                  << "\"\n";
+        return false;
+    }
+
     // Write the texture to a temp file first, then rename it to the final
     // destination (same directory). This improves robustness. There is less
     // chance a crash during texture conversion will leave behind a
@@ -903,12 +1346,24 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
     bool read_local = (src->spec().image_bytes() < imagesize_t(local_mb_thresh * 1024*1024));
 
     bool verbose = configspec.get_int_attribute ("maketx:verbose") != 0;
+
+    // Decide whether to stream the texture out a band at a time rather
+    // than making in-memory copies of the whole image.  A streamed file is
+    // left in the ImageCache rather than read.
+    bool streaming = false;
+    if (configspec.get_int_attribute ("maketx:stream")) {
+        std::string why;
+        streaming = can_stream (mode, configspec, src->spec(), why);
+        if (verbose && ! streaming)
+            outstream << "  Not streaming: unsupported with " << why << "\n";
+    }
+
     double misc_time_1 = alltime.lap();
     STATUS ("prep", misc_time_1);
     if (from_filename) {
         if (verbose)
             outstream << "Reading file: " << src->name() << std::endl;
-        if (! src->read (0, 0, read_local)) {
+        if (! src->read (0, 0, read_local && ! streaming)) {
             outstream  << "maketx ERROR: Could not read \"" 
                        << src->name() << "\" : " << src->geterror() << "\n";
             return false;
@@ -932,6 +1387,17 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
         src = latlong;
     }
 
+    // The streamed top level must be float, like the in-memory path's
+    // (which it is when read from a file, but a supplied buffer may not
+    // be).
+    if (streaming && src->spec().format != TypeDesc::FLOAT) {
+        if (verbose)
+            outstream << "  Not streaming: unsupported with non-float input\n";
+        streaming = false;
+    }
+    if (streaming && verbose)
+        outstream << "  Streaming (out-of-core) conversion\n";
+
     // Some things require knowing a bunch about the pixel statistics.
     bool constant_color_detect = configspec.get_int_attribute("maketx:constant_color_detect");
     bool opaque_detect = configspec.get_int_attribute("maketx:opaque_detect");
@@ -977,8 +1443,9 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
     
     int nchannels = configspec.get_int_attribute ("maketx:nchannels", -1);
 
-    // If requested -- and alpha is 1.0 everywhere -- drop it.
-    if (opaque_detect &&
+    // If requested -- and alpha is 1.0 everywhere -- drop it.  (Not when
+    // streaming, where the channels would need a full in-memory copy.)
+    if (opaque_detect && ! streaming &&
           src->spec().alpha_channel == src->nchannels()-1 &&
           nchannels <= 0 &&
           pixel_stats.min[src->spec().alpha_channel] == 1.0f &&
@@ -993,7 +1460,7 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
 
     // If requested - and we're a monochrome image - drop the extra channels
     if (configspec.get_int_attribute("maketx:monochrome_detect") &&
-          nchannels <= 0 &&
+          ! streaming && nchannels <= 0 &&
           src->nchannels() == 3 && src->spec().alpha_channel < 0 &&  // RGB only
           ImageBufAlgo::isMonochrome(*src)) {
         if (verbose)
@@ -1325,8 +1792,19 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
     double misc_time_3 = alltime.lap(); 
     STATUS ("misc3", misc_time_3);
 
+    if (streaming && (do_resize || orig_was_overscan)) {
+        // can_stream should have ruled these out, but just in case...
+        if (verbose)
+            outstream << "  Not streaming: image needs resizing\n";
+        streaming = false;
+    }
+
     std::shared_ptr<ImageBuf> toplevel;  // Ptr to top level of mipmap
-    if (! do_resize && dstspec.format == src->spec().format) {
+    if (streaming) {
+        // The top level is read from src (float, like dstspec) a band at
+        // a time.
+        toplevel = src;
+    } else if (! do_resize && dstspec.format == src->spec().format) {
         // No resize needed, no format conversion needed -- just stick to
         // the image we've already got
         toplevel = src;
@@ -1373,6 +1851,7 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
     // Eliminate any SHA-1 or ConstantColor hints in the ImageDescription.
     if (desc.size()) {
         desc = regex_replace (desc, regex("SHA-1=[[:xdigit:]]*[ ]*"), "");
+        desc = regex_replace (desc, regex("oiio:PixelHash=[[:alnum:]:]*[ ]*"), "");
         static const char *fp_number_pattern =
             "([+-]?((?:(?:[[:digit:]]*\\.)?[[:digit:]]+(?:[eE][+-]?[[:digit:]]+)?)))";
         const std::string constcolor_pattern =
@@ -1398,25 +1877,39 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
     if (configspec.get_int_attribute ("maketx:highlightcomp", 0))
         addlHashData << "highlightcomp=1 ";
 
+    // SHA-1 is stored as "oiio:SHA-1", as always.  The faster hashes are
+    // stored as "oiio:PixelHash", prefixed by the algorithm name, so that
+    // fingerprints made by different algorithms never match.
     const int sha1_blocksize = 256;
-    std::string hash_digest = configspec.get_int_attribute("maketx:hash", 1) ?
-        ImageBufAlgo::computePixelHashSHA1 (*toplevel, addlHashData.str(),
-                                            ROI::All(), sha1_blocksize) : "";
+    std::string hash_digest;
+    dstspec.erase_attribute ("oiio:SHA-1");
+    dstspec.erase_attribute ("oiio:PixelHash");
+    const char *hash_attr = (hash_algorithm == "sha1") ? "oiio:SHA-1"
+                                                       : "oiio:PixelHash";
+    if (configspec.get_int_attribute("maketx:hash", 1)) {
+        hash_digest = ImageBufAlgo::computePixelHash (*toplevel,
+                                hash_algorithm, addlHashData.str(),
+                                ROI::All(), sha1_blocksize);
+        if (hash_digest.size() && hash_algorithm != "sha1")
+            hash_digest = hash_algorithm + ":" + hash_digest;
+    }
     if (hash_digest.length()) {
         if (out->supports("arbitrary_metadata")) {
-            dstspec.attribute ("oiio:SHA-1", hash_digest);
+            dstspec.attribute (hash_attr, hash_digest);
         } else {
             if (desc.length())
                 desc += " ";
-            desc += "oiio:SHA-1=";
+            desc += hash_attr;
+            desc += "=";
             desc += hash_digest;
             updatedDesc = true;
         }
         if (verbose)
-            outstream << "  SHA-1: " << hash_digest << std::endl;
+            outstream << "  " << (hash_algorithm == "sha1" ? "SHA-1" : "PixelHash")
+                      << ": " << hash_digest << std::endl;
     }
     double stat_hashtime = alltime.lap();
-    STATUS ("SHA-1 hash", stat_hashtime);
+    STATUS ("pixel hash", stat_hashtime);
   
     if (isConstantColor) {
         std::ostringstream os; // Emulate a JSON array
@@ -1469,16 +1962,65 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
 
     maketx_merge_spec (dstspec, configspec);
 
+    // With a dedup index, look for a texture already made from identical
+    // pixels with identical settings.  If there is one, copy it rather
+    // than computing and writing all the MIP levels again.
+    bool nomipmap = configspec.get_int_attribute ("maketx:nomipmap") != 0;
+    std::shared_ptr<pvt::DedupIndex> dedup;
+    std::string dedupkey, identical;
+    std::string dedupfile = configspec.get_string_attribute ("maketx:dedup_index");
+    if (dedupfile.size() && hash_digest.size()) {
+        dedup = pvt::DedupIndex::get (dedupfile);
+        // The top level as write_mipmap will write it
+        ImageSpec keyspec = dstspec;
+        keyspec.set_format (out_dataformat);
+        if (mode == ImageBufAlgo::MakeTxEnvLatl &&
+                ! strcmp (out->format_name(), "openexr")) {
+            keyspec.attribute ("oiio:updirection", "y");
+            keyspec.attribute ("oiio:sampleborder", 1);
+        }
+        dedupkey = pvt::DedupIndex::key (hash_digest,
+                                         std::vector<ImageSpec>(1, keyspec));
+        identical = dedup->find_canonical (dedupkey, outputfilename);
+        bool mipmap = !shadowmode && !nomipmap &&
+                      (dstspec.width > 1 || dstspec.height > 1);
+        if (identical.size() &&
+            ! same_texture_file (identical, dstspec, hash_attr, hash_digest,
+                                dedupkey, mipmap))
+            identical.clear ();
+        if (identical.size() && verbose)
+            outstream << "  Identical to existing texture " << identical << "\n";
+    }
+
     double misc_time_4 = alltime.lap();
     STATUS ("misc4", misc_time_4);
 
     // Write out, and compute, the mipmap levels for the speicifed image
-    bool nomipmap = configspec.get_int_attribute ("maketx:nomipmap") != 0;
-    bool ok = write_mipmap (mode, toplevel, dstspec, tmpfilename,
-                            out, out_dataformat, !shadowmode && !nomipmap,
-                            filtername, configspec, outstream,
-                            stat_writetime, stat_miptime, peak_mem);
+    bool ok;
+    if (identical.size()) {
+        std::string err;
+        ok = Filesystem::copy (identical, tmpfilename, err);
+        if (! ok)
+            outstream << "maketx ERROR: could not copy \"" << identical
+                      << "\": " << err << "\n";
+        stat_writetime += alltime.lap();
+    } else if (streaming)
+        ok = write_mipmap_streaming (*toplevel, dstspec, tmpfilename,
+                                     out, out_dataformat,
+                                     !shadowmode && !nomipmap,
+                                     configspec, outstream, stat_readtime,
+                                     stat_writetime, stat_miptime, peak_mem);
+    else
+        ok = write_mipmap (mode, toplevel, dstspec, tmpfilename,
+                           out, out_dataformat, !shadowmode && !nomipmap,
+                           filtername, configspec, outstream,
+                           stat_writetime, stat_miptime,
+                           stat_writeoverlap, peak_mem);
     delete out;  // don't need it any more
+    STATUS ("mip computation", stat_miptime);
+    STATUS ("file write", stat_writetime);
+    if (stat_writeoverlap > 0.0)
+        STATUS ("  (overlapped with mip)", stat_writeoverlap);
 
     // If using update mode, stamp the output file with a modification time
     // matching that of the input file.
@@ -1493,6 +2035,11 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
         if (! ok)
             outstream << "maketx ERROR: could not rename file: " << err << "\n";
     }
+    // Record the new texture in the dedup index, as it was actually
+    // written.
+    if (ok && dedup)
+        dedup->add (pvt::DedupIndex::file_key (hash_digest, outputfilename),
+                    outputfilename);
     if (! ok)
         Filesystem::remove (tmpfilename);
 
@@ -1503,12 +2050,14 @@ make_texture_impl (ImageBufAlgo::MakeTextureMode mode,
 
         outstream << Strutil::format ("  file read:       %5.2f\n", stat_readtime);
         outstream << Strutil::format ("  file write:      %5.2f\n", stat_writetime);
+        if (stat_writeoverlap > 0.0)
+            outstream << Strutil::format ("    (overlapped):  %5.2f\n", stat_writeoverlap);
         outstream << Strutil::format ("  initial resize:  %5.2f\n", stat_resizetime);
         outstream << Strutil::format ("  hash:            %5.2f\n", stat_hashtime);
         outstream << Strutil::format ("  mip computation: %5.2f\n", stat_miptime);
         outstream << Strutil::format ("  color convert:   %5.2f\n", stat_colorconverttime);
         outstream << Strutil::format ("  unaccounted:     %5.2f  (%5.2f %5.2f %5.2f %5.2f)\n",
-                                      all-stat_readtime-stat_writetime-stat_resizetime-stat_hashtime-stat_miptime,
+                                      all-stat_readtime-stat_writetime-stat_resizetime-stat_hashtime-stat_miptime+stat_writeoverlap,
                                       misc_time_1, misc_time_2, misc_time_3, misc_time_4);
         outstream << Strutil::format ("maketx peak memory used: %s\n",
                                       Strutil::memformat(peak_mem));
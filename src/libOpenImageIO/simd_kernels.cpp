@@ -0,0 +1,524 @@
+/*
+  Copyright 2017 Larry Gritz and the other authors and contributors.
+  All Rights Reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  * Neither the name of the software's owners nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  (This is the Modified BSD License)
+*/
+
+
+/// \file
+/// The SIMD kernels that are chosen among at runtime.
+///
+/// This file is compiled once with the library's own flags, which also
+/// builds the dispatch logic.  On x86 the build then compiles it again
+/// for each higher ISA level (see simd_kernels_level.cpp.in), with
+/// OIIO_SIMD_KERNEL_VARIANT set to the level name and the matching
+/// -m flags.  Those copies hold only the kernel table.
+///
+/// The same code is compiled with several sets of flags, so no function
+/// that a higher-level copy emits may share its name with one that the
+/// rest of the library uses.  Otherwise the linker could keep, say, the
+/// AVX2 build of an out-of-line simd.h constructor (as a Debug build
+/// emits them) for the whole library, and it would crash on older CPUs.
+/// So the higher-level copies compile simd.h, and the headers it brings
+/// in, into a namespace of their own, and build with hidden visibility;
+/// the kernels themselves are in an anonymous namespace within it.
+/// OpenEXR's half is outside our namespace, so the kernels have their own
+/// half conversions rather than instantiating any of its inline ones.
+
+#include <cstddef>
+#include <cstring>
+
+#include <OpenEXR/half.h>
+
+#include "simd_kernels.h"
+
+#ifndef OIIO_SIMD_KERNEL_VARIANT
+#  include <atomic>
+#  include <string>
+#  include <vector>
+#  include <OpenImageIO/platform.h>
+#  include <OpenImageIO/strutil.h>
+#  define OIIO_SIMD_KERNEL_VARIANT base
+#  define OIIO_SIMD_KERNEL_DISPATCH 1
+#endif
+
+#define OIIO_SIMD_KERNEL_CAT2(a,b) a##b
+#define OIIO_SIMD_KERNEL_CAT(a,b) OIIO_SIMD_KERNEL_CAT2(a,b)
+#define OIIO_SIMD_KERNEL_TABLE \
+        OIIO_SIMD_KERNEL_CAT(simd_kernels_, OIIO_SIMD_KERNEL_VARIANT)
+#define OIIO_SIMD_KERNEL_NS \
+        OIIO_SIMD_KERNEL_CAT(simd_level_, OIIO_SIMD_KERNEL_VARIANT)
+
+#ifndef OIIO_SIMD_KERNEL_DISPATCH
+// Declare everything in simd.h (and its own OIIO includes) in
+// OIIO_NAMESPACE::simd_level_<variant>, for this copy only.
+#  undef OIIO_NAMESPACE_BEGIN
+#  undef OIIO_NAMESPACE_END
+#  define OIIO_NAMESPACE_BEGIN \
+        namespace OIIO_NAMESPACE { namespace OIIO_SIMD_KERNEL_NS {
+#  define OIIO_NAMESPACE_END } }
+#endif
+
+#include <OpenImageIO/simd.h>
+
+#ifndef OIIO_SIMD_KERNEL_DISPATCH
+#  undef OIIO_NAMESPACE_BEGIN
+#  undef OIIO_NAMESPACE_END
+#  define OIIO_NAMESPACE_BEGIN namespace OIIO_NAMESPACE {
+#  define OIIO_NAMESPACE_END }
+#endif
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace OIIO_SIMD_KERNEL_NS {
+namespace {
+
+// Widest float/int vector this compilation has native support for.
+#if OIIO_SIMD >= 16
+typedef simd::vfloat16 vfloatN;
+typedef simd::vint16   vintN;
+#elif OIIO_SIMD_AVX
+typedef simd::vfloat8  vfloatN;
+typedef simd::vint8    vintN;
+#else
+typedef simd::vfloat4  vfloatN;
+typedef simd::vint4    vintN;
+#endif
+const size_t N = sizeof(vfloatN) / sizeof(float);
+
+
+// Level of the flags this copy was compiled with.
+#if OIIO_SIMD_AVX >= 512
+const char *kernel_level = "avx512";   const int kernel_rank = 4;
+#elif OIIO_SIMD_AVX >= 2
+const char *kernel_level = "avx2";     const int kernel_rank = 3;
+#elif OIIO_SIMD_AVX
+const char *kernel_level = "avx";      const int kernel_rank = 2;
+#elif OIIO_SIMD_SSE >= 4
+const char *kernel_level = "sse4";     const int kernel_rank = 1;
+#elif OIIO_SIMD_SSE
+const char *kernel_level = "sse2";     const int kernel_rank = 0;
+#elif OIIO_SIMD_NEON
+const char *kernel_level = "neon";     const int kernel_rank = 0;
+#else
+const char *kernel_level = "scalar";   const int kernel_rank = 0;
+#endif
+
+
+
+// Scalar half <-> float, on the bits of the half, giving the same
+// results as OpenEXR's half (rounding to nearest even).
+OIIO_FORCEINLINE float
+half_bits_to_float (unsigned short h)
+{
+    unsigned int s = (unsigned int)(h & 0x8000) << 16;
+    unsigned int e = (h >> 10) & 0x1f;
+    unsigned int m = h & 0x3ff;
+    unsigned int bits;
+    if (e == 0 && m == 0) {
+        bits = s;                                   // zero
+    } else if (e == 0) {
+        e = 127 - 15 + 1;                           // denormal: normalize
+        while (! (m & 0x400)) {
+            m <<= 1;
+            --e;
+        }
+        bits = s | (e << 23) | ((m & 0x3ff) << 13);
+    } else if (e == 31) {
+        bits = s | 0x7f800000 | (m << 13);          // inf or nan
+    } else {
+        bits = s | ((e + 127 - 15) << 23) | (m << 13);
+    }
+    float f;
+    memcpy (&f, &bits, sizeof(f));
+    return f;
+}
+
+
+OIIO_FORCEINLINE unsigned short
+float_to_half_bits (float f)
+{
+    unsigned int i;
+    memcpy (&i, &f, sizeof(i));
+    int s = (i >> 16) & 0x8000;
+    int e = int((i >> 23) & 0xff) - (127 - 15);
+    int m = i & 0x7fffff;
+    if (e <= 0) {
+        if (e < -10)
+            return (unsigned short) s;              // underflows to zero
+        m |= 0x800000;                              // denormal
+        int t = 14 - e;
+        m = (m + ((1 << (t-1)) - 1) + ((m >> t) & 1)) >> t;
+        return (unsigned short) (s | m);
+    }
+    if (e == 0xff - (127 - 15)) {
+        if (m == 0)
+            return (unsigned short) (s | 0x7c00);   // inf
+        m >>= 13;                                   // nan, kept a nan
+        return (unsigned short) (s | 0x7c00 | m | (m == 0));
+    }
+    m = m + 0xfff + ((m >> 13) & 1);
+    if (m & 0x800000) {
+        m = 0;                                      // rounded up a binade
+        e += 1;
+    }
+    if (e > 30)
+        return (unsigned short) (s | 0x7c00);       // overflows to inf
+    return (unsigned short) (s | (e << 10) | (m >> 13));
+}
+
+
+
+// Integer -> float is x * (1/max), as in convert_type().
+template<typename S>
+inline void
+int_to_float (const S *src, float *dst, size_t n, float scale)
+{
+    vfloatN s (scale);
+    size_t i = 0;
+    for ( ; i + N <= n;  i += N) {
+        vfloatN v (src + i);
+        (v * s).store (dst + i);
+    }
+    for ( ; i < n;  ++i)
+        dst[i] = src[i] * scale;
+}
+
+
+// Float -> integer is clamp(trunc(x*max + 0.5), 0, max), which is the
+// quantize() of convert_from_float().  max() is applied before min() so
+// that NaN goes to 0, as it does there.
+template<typename D>
+inline void
+float_to_int (const float *src, D *dst, size_t n, float scale)
+{
+    vfloatN s (scale), half_one (0.5f), zero (0.0f);
+    size_t i = 0;
+    for ( ; i + N <= n;  i += N) {
+        vfloatN v = vfloatN(src + i) * s + half_one;
+        vintN iv (simd::min (simd::max (v, zero), s));
+        iv.store (dst + i);
+    }
+    for ( ; i < n;  ++i) {
+        float v = src[i] * scale + 0.5f;
+        dst[i] = D (v >= 0.0f ? (v < scale ? v : scale) : 0.0f);
+    }
+}
+
+
+void
+uint8_to_float (const unsigned char *src, float *dst, size_t n)
+{
+    int_to_float (src, dst, n, 1.0f/255.0f);
+}
+
+
+void
+uint16_to_float (const unsigned short *src, float *dst, size_t n)
+{
+    int_to_float (src, dst, n, 1.0f/65535.0f);
+}
+
+
+void
+half_to_float (const half *src, float *dst, size_t n)
+{
+    size_t i = 0;
+#if OIIO_SIMD_SSE
+    for ( ; i + N <= n;  i += N)
+        vfloatN(src + i).store (dst + i);
+#endif
+    const unsigned short *h = (const unsigned short *) src;
+    for ( ; i < n;  ++i)
+        dst[i] = half_bits_to_float (h[i]);
+}
+
+
+void
+float_to_uint8 (const float *src, unsigned char *dst, size_t n)
+{
+    float_to_int (src, dst, n, 255.0f);
+}
+
+
+void
+float_to_uint16 (const float *src, unsigned short *dst, size_t n)
+{
+    float_to_int (src, dst, n, 65535.0f);
+}
+
+
+void
+float_to_half (const float *src, half *dst, size_t n)
+{
+    size_t i = 0;
+    // Without F16C, simd.h would store through OpenEXR's half.
+#if (OIIO_F16C_ENABLED && OIIO_SIMD_SSE) || OIIO_SIMD_AVX >= 512
+    for ( ; i + N <= n;  i += N)
+        vfloatN(src + i).store (dst + i);
+#endif
+    unsigned short *h = (unsigned short *) dst;
+    for ( ; i < n;  ++i)
+        h[i] = float_to_half_bits (src[i]);
+}
+
+
+// Broadcast each pixel's alpha (channel 3) across its 4 channels.
+inline simd::vfloat4 splat_alpha (const simd::vfloat4 &v) {
+    return simd::shuffle<3> (v);
+}
+#if OIIO_SIMD_AVX
+inline simd::vfloat8 splat_alpha (const simd::vfloat8 &v) {
+    return simd::shuffle<3,3,3,3,7,7,7,7> (v);
+}
+#endif
+#if OIIO_SIMD >= 16
+inline simd::vfloat16 splat_alpha (const simd::vfloat16 &v) {
+    return simd::shuffle<3> (v);   // within each group of 4
+}
+#endif
+
+
+// a + (1 - clamp(alpha_a,0,1)) * b, as over_rgba_simd() does it, for
+// N/4 pixels at a time.
+void
+over_rgba (const float *a, const float *b, float *r, size_t npixels)
+{
+    vfloatN zero (0.0f), one (1.0f);
+    size_t n = npixels * 4, i = 0;
+    for ( ; i + N <= n;  i += N) {
+        vfloatN f (a + i);
+        vfloatN alpha = simd::min (simd::max (splat_alpha (f), zero), one);
+        (f + (one - alpha) * vfloatN(b + i)).store (r + i);
+    }
+    simd::vfloat4 zero4 (0.0f), one4 (1.0f);
+    for ( ; i < n;  i += 4) {
+        simd::vfloat4 f (a + i);
+        simd::vfloat4 alpha = simd::min (simd::max (splat_alpha (f), zero4), one4);
+        (f + (one4 - alpha) * simd::vfloat4(b + i)).store (r + i);
+    }
+}
+
+}  // anon namespace
+
+}  // namespace OIIO_SIMD_KERNEL_NS
+
+
+
+namespace pvt {
+
+const SimdKernels *OIIO_SIMD_KERNEL_TABLE ();
+
+const SimdKernels *
+OIIO_SIMD_KERNEL_TABLE ()
+{
+    using namespace OIIO_SIMD_KERNEL_NS;
+    static const SimdKernels table = {
+        kernel_level, kernel_rank,
+        uint8_to_float, uint16_to_float, half_to_float,
+        float_to_uint8, float_to_uint16, float_to_half,
+        over_rgba
+    };
+    return &table;
+}
+
+
+
+
+#ifdef OIIO_SIMD_KERNEL_DISPATCH
+
+// The tables from the copies of this file built for other levels.
+#ifdef OIIO_SIMD_KERNELS_SSE4
+const SimdKernels *simd_kernels_sse4 ();
+#endif
+#ifdef OIIO_SIMD_KERNELS_AVX
+const SimdKernels *simd_kernels_avx ();
+#endif
+#ifdef OIIO_SIMD_KERNELS_AVX2
+const SimdKernels *simd_kernels_avx2 ();
+#endif
+#ifdef OIIO_SIMD_KERNELS_AVX512
+const SimdKernels *simd_kernels_avx512 ();
+#endif
+
+
+namespace {
+
+static const char *level_names[] = { "sse2", "sse4", "avx", "avx2", "avx512" };
+
+
+// Has the OS enabled saving of the register state in mask (XCR0 bits)?
+// Without that, the AVX registers can't be used even if cpuid lists them.
+static bool
+os_saves_state (unsigned int mask)
+{
+    int info[4];
+    cpuid (info, 1, 0);
+    if (! (info[2] & (1<<27)))    // OSXSAVE
+        return false;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    unsigned long long xcr0 = _xgetbv (0);
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned int lo, hi;
+    __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+    unsigned long long xcr0 = ((unsigned long long)hi << 32) | lo;
+#else
+    unsigned long long xcr0 = 0;
+#endif
+    return (xcr0 & mask) == mask;
+}
+
+
+// Can this machine run code compiled for the given rank?
+static bool
+hw_supports (int rank)
+{
+    switch (rank) {
+    case 0 : return true;
+    case 1 : return cpu_has_sse41() && cpu_has_sse42();
+    case 2 : return hw_supports(1) && cpu_has_avx() && os_saves_state (0x6);
+    case 3 : return hw_supports(2) && cpu_has_avx2() && cpu_has_fma()
+                    && cpu_has_f16c();
+    case 4 : return hw_supports(3) && cpu_has_avx512f() && cpu_has_avx512dq()
+                    && cpu_has_avx512bw() && os_saves_state (0xe6);
+    default: return false;
+    }
+}
+
+
+struct KernelRegistry {
+    // Usable tables, in increasing rank, one per level.
+    std::vector<const SimdKernels *> available;
+    std::atomic<const SimdKernels *> current;
+
+    KernelRegistry () {
+        const SimdKernels *candidates[] = {
+            simd_kernels_base (),
+#ifdef OIIO_SIMD_KERNELS_SSE4
+            simd_kernels_sse4 (),
+#endif
+#ifdef OIIO_SIMD_KERNELS_AVX
+            simd_kernels_avx (),
+#endif
+#ifdef OIIO_SIMD_KERNELS_AVX2
+            simd_kernels_avx2 (),
+#endif
+#ifdef OIIO_SIMD_KERNELS_AVX512
+            simd_kernels_avx512 (),
+#endif
+        };
+        // The base table always runs.  The others are only worth having
+        // if they are a step up from it (a build whose own flags already
+        // include AVX compiles the "sse4" copy at AVX, too).
+        available.push_back (candidates[0]);
+        for (auto k : candidates) {
+            if (k->rank > available.back()->rank && hw_supports (k->rank))
+                available.push_back (k);
+        }
+        current = available.back();
+    }
+};
+
+
+static KernelRegistry &
+registry ()
+{
+    static KernelRegistry r;
+    return r;
+}
+
+}  // anon namespace
+
+
+
+const SimdKernels &
+simd_kernels ()
+{
+    return *registry().current.load (std::memory_order_relaxed);
+}
+
+
+
+bool
+set_simd_level (string_view level)
+{
+    KernelRegistry &r (registry());
+    if (level.empty() || level == "auto") {
+        r.current = r.available.back();
+        return true;
+    }
+    int rank = -1;
+    for (int i = 0;  i < int(sizeof(level_names)/sizeof(level_names[0]));  ++i)
+        if (level == level_names[i])
+            rank = i;
+    if (level == r.available[0]->level)   // e.g. "neon" or "scalar"
+        rank = r.available[0]->rank;
+    if (rank < 0)
+        return false;
+    // Highest available level not above the one asked for (or the base
+    // level, if that's above it already).
+    const SimdKernels *k = r.available[0];
+    for (auto a : r.available)
+        if (a->rank <= rank)
+            k = a;
+    r.current = k;
+    return true;
+}
+
+
+
+std::string
+simd_levels ()
+{
+    std::vector<string_view> names;
+    for (auto k : registry().available)
+        names.emplace_back (k->level);
+    return Strutil::join (names, ",");
+}
+
+
+
+std::string
+simd_kernels_report ()
+{
+    static const char *kernel_names[] = {
+        "uint8_to_float", "uint16_to_float", "half_to_float",
+        "float_to_uint8", "float_to_uint16", "float_to_half", "over_rgba"
+    };
+    const char *level = simd_kernels().level;
+    std::vector<std::string> entries;
+    for (auto name : kernel_names)
+        entries.push_back (std::string(name) + ":" + level);
+    return Strutil::join (entries, ",");
+}
+
+#endif  /* OIIO_SIMD_KERNEL_DISPATCH */
+
+}  // end namespace pvt
+
+OIIO_NAMESPACE_END
@@ -0,0 +1,100 @@
+/*
+  Copyright 2017 Larry Gritz and the other authors and contributors.
+  All Rights Reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  * Neither the name of the software's owners nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  (This is the Modified BSD License)
+*/
+
+
+/// \file
+/// Private declarations for the SIMD kernels that are compiled for
+/// several instruction set levels and chosen among at runtime.
+
+
+#ifndef OPENIMAGEIO_SIMD_KERNELS_H
+#define OPENIMAGEIO_SIMD_KERNELS_H
+
+#include <cstddef>
+#include <string>
+
+#include <OpenEXR/half.h>
+
+#include <OpenImageIO/oiioversion.h>
+#include <OpenImageIO/string_view.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+/// The hot inner loops that simd_kernels.cpp provides.  The library
+/// always has the set compiled at its own baseline SIMD flags.  On x86 it
+/// may also have sets compiled for higher levels (sse4, avx, avx2,
+/// avx512).  simd_kernels() returns the best set the hardware runs, or
+/// the one chosen with the "simd_level" attribute.
+///
+/// Every set computes bit-identical results.  The higher levels only
+/// process more values per instruction.
+struct SimdKernels {
+    const char *level;   ///< "sse2", "sse4", "avx", "avx2", "avx512"...
+    int rank;            ///< Ordering of levels; higher needs more hardware
+
+    /// Contiguous value conversions.  They match convert_type() and the
+    /// default quantization of convert_from_float().
+    void (*uint8_to_float) (const unsigned char *src, float *dst, size_t n);
+    void (*uint16_to_float) (const unsigned short *src, float *dst, size_t n);
+    void (*half_to_float) (const half *src, float *dst, size_t n);
+    void (*float_to_uint8) (const float *src, unsigned char *dst, size_t n);
+    void (*float_to_uint16) (const float *src, unsigned short *dst, size_t n);
+    void (*float_to_half) (const float *src, half *dst, size_t n);
+
+    /// r = a over b for npixels contiguous float RGBA pixels.  r may
+    /// alias a or b.
+    void (*over_rgba) (const float *a, const float *b, float *r,
+                       size_t npixels);
+};
+
+/// The kernel set currently in use.
+const SimdKernels &simd_kernels ();
+
+/// Choose the kernel set to use by level name.  "" or "auto" selects
+/// the best one the hardware supports.  A known level that the library
+/// wasn't built with, or that the hardware can't run, falls back to the
+/// best available level below it.  Return false for an unknown name.
+bool set_simd_level (string_view level);
+
+/// Comma-separated list of the levels that are both compiled in and
+/// supported by this hardware, lowest first.
+std::string simd_levels ();
+
+/// Comma-separated "kernel:level" list of the variants in use.
+std::string simd_kernels_report ();
+
+}  // end namespace pvt
+
+OIIO_NAMESPACE_END
+
+#endif // OPENIMAGEIO_SIMD_KERNELS_H
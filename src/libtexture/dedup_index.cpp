@@ -0,0 +1,294 @@
+/*
+  Copyright 2017 Larry Gritz and the other authors and contributors.
+  All Rights Reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  * Neither the name of the software's owners nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  (This is the Modified BSD License)
+*/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+#ifndef _WIN32
+# include <sys/stat.h>
+#endif
+
+#include <OpenImageIO/platform.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/strutil.h>
+
+#include "dedup_index.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+
+namespace {
+
+// Index entries name files by absolute path, so that every process
+// sharing the index agrees on them regardless of its working directory.
+std::string
+absolute_path (string_view filename)
+{
+    std::string f = filename;
+    if (f.size() && ! Filesystem::path_is_absolute (f))
+        f = Filesystem::current_path() + "/" + f;
+    return f;
+}
+
+
+// Keys and paths are tab-separated fields of one line.
+std::string
+sanitize (string_view s)
+{
+    std::string r = s;
+    for (auto &c : r)
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    return r;
+}
+
+}  // anon namespace
+
+
+
+std::shared_ptr<DedupIndex>
+DedupIndex::get (string_view indexfile)
+{
+    static OIIO::mutex registry_mutex;
+    static std::map<std::string, std::shared_ptr<DedupIndex> > registry;
+    std::string name = absolute_path (indexfile);
+    lock_guard lock (registry_mutex);
+    std::shared_ptr<DedupIndex> &index (registry[name]);
+    if (! index)
+        index.reset (new DedupIndex (name));
+    return index;
+}
+
+
+
+std::string
+DedupIndex::key (string_view sha1, const std::vector<ImageSpec> &subimages)
+{
+    if (sha1.empty() || subimages.empty())
+        return std::string();
+    const ImageSpec &spec (subimages[0]);
+    std::string formats;
+    for (const ImageSpec &s : subimages)
+        formats += Strutil::format ("%s%s", formats.size() ? "," : "",
+                                    s.format);
+    std::string k = Strutil::format ("%s;%s;%s;%s;%d;%d",
+                        sha1, spec.get_string_attribute ("textureformat"),
+                        spec.get_string_attribute ("wrapmodes"),
+                        spec.get_string_attribute ("oiio:updirection"),
+                        spec.get_int_attribute ("oiio:sampleborder"),
+                        spec.nchannels);
+    k += Strutil::format (";%dx%dx%d%+d%+d%+d;%dx%dx%d%+d%+d%+d;%d;%s",
+                          spec.width, spec.height, spec.depth,
+                          spec.x, spec.y, spec.z,
+                          spec.full_width, spec.full_height, spec.full_depth,
+                          spec.full_x, spec.full_y, spec.full_z,
+                          int(subimages.size()), formats);
+    return sanitize (k);
+}
+
+
+
+std::string
+DedupIndex::file_key (string_view sha1, string_view filename)
+{
+    ImageInput *in = ImageInput::open (filename);
+    if (! in)
+        return std::string();
+    std::vector<ImageSpec> subimages;
+    ImageSpec spec;
+    for (int s = 0;  in->seek_subimage (s, 0, spec);  ++s)
+        subimages.push_back (spec);
+    in->close ();
+    ImageInput::destroy (in);
+    return key (sha1, subimages);
+}
+
+
+
+long long
+DedupIndex::mtime (const std::string &path)
+{
+    // Whole seconds (as Filesystem::last_write_time gives) would miss a
+    // file rewritten with the same size within a second of being recorded.
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (! GetFileAttributesExW (Strutil::utf8_to_utf16(path).c_str(),
+                                GetFileExInfoStandard, &attr))
+        return 0;
+    // 100ns ticks
+    return (long long) ((unsigned long long)attr.ftLastWriteTime.dwHighDateTime << 32
+                        | attr.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat st;
+    if (stat (path.c_str(), &st) != 0)
+        return 0;
+# if defined(__APPLE__)
+    return (long long)st.st_mtimespec.tv_sec * 1000000000LL
+         + st.st_mtimespec.tv_nsec;
+# else
+    return (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+# endif
+#endif
+}
+
+
+
+bool
+DedupIndex::unchanged (const std::string &path, const Entry &e)
+{
+    return Filesystem::exists (path) && mtime (path) == e.mtime &&
+           Filesystem::file_size (path) == e.size;
+}
+
+
+
+void
+DedupIndex::refresh ()
+{
+    FILE *file = Filesystem::fopen (m_indexfile, "rb");
+    if (! file)
+        return;
+    fseek (file, 0, SEEK_END);
+    unsigned long long end = (unsigned long long) ftell (file);
+    if (end < m_offset) {
+        // The index was truncated or replaced -- start over
+        m_offset = 0;
+        m_files.clear ();
+        m_keys.clear ();
+    }
+    std::string text (size_t(end - m_offset), '\0');
+    fseek (file, long(m_offset), SEEK_SET);
+    size_t n = text.size() ? fread (&text[0], 1, text.size(), file) : 0;
+    fclose (file);
+    text.resize (n);
+    // Only consume complete lines; another process may be mid-append.
+    size_t last = text.rfind ('\n');
+    if (last == std::string::npos)
+        return;
+    text.resize (last + 1);
+    m_offset += text.size();
+
+    std::vector<string_view> lines, fields;
+    Strutil::split (text, lines, "\n");
+    for (string_view line : lines) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        fields.clear ();
+        Strutil::split (line, fields, "\t", 4);
+        if (fields.size() != 4)
+            continue;
+        std::string path = fields[3];
+        Entry &e (m_files[path]);
+        e.key = fields[0];
+        e.mtime = strtoll (std::string(fields[1]).c_str(), NULL, 10);
+        e.size = strtoull (std::string(fields[2]).c_str(), NULL, 10);
+        std::vector<std::string> &paths (m_keys[e.key]);
+        if (std::find (paths.begin(), paths.end(), path) == paths.end())
+            paths.push_back (path);
+    }
+}
+
+
+
+std::string
+DedupIndex::find_key (string_view filename)
+{
+    std::string path = absolute_path (filename);
+    lock_guard lock (m_mutex);
+    refresh ();
+    auto found = m_files.find (path);
+    if (found == m_files.end() || ! unchanged (path, found->second))
+        return std::string();
+    return found->second.key;
+}
+
+
+
+std::string
+DedupIndex::find_canonical (string_view key, string_view exclude)
+{
+    std::string excluded = absolute_path (exclude);
+    lock_guard lock (m_mutex);
+    refresh ();
+    auto found = m_keys.find (key);
+    if (found == m_keys.end())
+        return std::string();
+    for (const std::string &path : found->second) {
+        if (path == excluded)
+            continue;
+        // The file may have been recorded again since with other content
+        const Entry &e (m_files[path]);
+        if (e.key == key && unchanged (path, e))
+            return path;
+    }
+    return std::string();
+}
+
+
+
+bool
+DedupIndex::add (string_view key, string_view filename)
+{
+    std::string path = absolute_path (filename);
+    if (key.empty() || ! Filesystem::exists (path))
+        return false;
+    Entry e;
+    e.key = sanitize (key);
+    e.mtime = mtime (path);
+    e.size = Filesystem::file_size (path);
+    lock_guard lock (m_mutex);
+    refresh ();
+    auto found = m_files.find (path);
+    if (found != m_files.end() && found->second.key == e.key &&
+        found->second.mtime == e.mtime && found->second.size == e.size)
+        return true;   // already recorded just like this
+    std::string line = Strutil::format ("%s\t%lld\t%llu\t%s\n", e.key,
+                                        e.mtime, e.size, sanitize (path));
+    // Append the whole line with a single write, so that lines from
+    // processes sharing the index never interleave.
+    FILE *file = Filesystem::fopen (m_indexfile, "ab");
+    if (! file)
+        return false;
+    bool ok = fwrite (line.data(), 1, line.size(), file) == line.size();
+    ok &= (fclose (file) == 0);
+    refresh ();
+    return ok;
+}
+
+
+}  // end namespace pvt
+
+OIIO_NAMESPACE_END
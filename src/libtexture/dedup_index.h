@@ -0,0 +1,131 @@
+/*
+  Copyright 2017 Larry Gritz and the other authors and contributors.
+  All Rights Reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+  * Neither the name of the software's owners nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  (This is the Modified BSD License)
+*/
+
+
+/// \file
+/// Private declaration of the persistent texture deduplication index that
+/// is shared by maketx and the ImageCache.
+
+
+#ifndef OPENIMAGEIO_DEDUP_INDEX_H
+#define OPENIMAGEIO_DEDUP_INDEX_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/string_view.h>
+#include <OpenImageIO/thread.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+/// DedupIndex is an on-disk index from texture content to the texture
+/// files holding it, so that files with identical content can be
+/// recognized across assets and sessions -- by maketx before converting
+/// an image, and by the ImageCache before opening a file.
+///
+/// The index file is plain text, one line per recorded texture file:
+///     key <TAB> mtime <TAB> size <TAB> absolute-path
+/// The modification time (in nanoseconds, where the platform records
+/// them) and size describe the file when it was recorded; an entry whose
+/// file has since changed (or vanished) is ignored.  Lines
+/// are only ever appended, each with a single write, so any number of
+/// processes may share one index.  The first valid entry for a key names
+/// the canonical file for that content.
+class DedupIndex {
+public:
+    /// Return the shared DedupIndex for the given index file, which need
+    /// not exist yet.
+    static std::shared_ptr<DedupIndex> get (string_view indexfile);
+
+    /// Return the key identifying a texture whose top level has the given
+    /// pixel hash fingerprint (the "oiio:SHA-1", or the algorithm-prefixed
+    /// "oiio:PixelHash") and whose subimages (top MIP level of each) have
+    /// the given specs: the hash plus everything else that the ImageCache
+    /// also requires to match for duplicates -- texture format, wrap
+    /// modes, up direction, border sampling, resolution, channels, data
+    /// and display windows, and the number of subimages and the pixel
+    /// data type of each.  Return "" if sha1 is empty or there are no
+    /// subimages.
+    static std::string key (string_view sha1,
+                            const std::vector<ImageSpec> &subimages);
+
+    /// Return the key for the texture file, with the given fingerprint,
+    /// as it is on disk now (or "" if the file can't be opened).
+    static std::string file_key (string_view sha1, string_view filename);
+
+    /// Return the key recorded for filename, or "" if it was never
+    /// recorded or the file changed since.
+    std::string find_key (string_view filename);
+
+    /// Return the canonical file (other than 'exclude') holding the
+    /// content identified by key, or "" if there isn't one.
+    std::string find_canonical (string_view key, string_view exclude = "");
+
+    /// Record that filename, as it is on disk now, holds the content
+    /// identified by key.  Return false if the index couldn't be written.
+    bool add (string_view key, string_view filename);
+
+    const std::string &indexfile () const { return m_indexfile; }
+
+private:
+    struct Entry {
+        std::string key;
+        long long mtime = 0;
+        unsigned long long size = 0;
+    };
+
+    DedupIndex (string_view indexfile) : m_indexfile(indexfile) { }
+    // Read any lines appended to the index since the last refresh.
+    // Call with m_mutex held.
+    void refresh ();
+    // Modification time of the file, as finely as the platform records it.
+    static long long mtime (const std::string &path);
+    // Does the file still match what was recorded in e?
+    static bool unchanged (const std::string &path, const Entry &e);
+
+    std::string m_indexfile;
+    OIIO::mutex m_mutex;
+    unsigned long long m_offset = 0;     // Bytes of the index already read
+    std::unordered_map<std::string, Entry> m_files;  // latest entry per file
+    std::unordered_map<std::string, std::vector<std::string> > m_keys;
+};
+
+
+}  // end namespace pvt
+
+OIIO_NAMESPACE_END
+
+#endif // OPENIMAGEIO_DEDUP_INDEX_H
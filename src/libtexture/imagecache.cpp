@@ -680,8 +680,12 @@ ImageCacheFile::init_from_spec ()
     // FIXME -- compute Mtex, Mras
 #endif
 
-    // See if there's a SHA-1 hash in the image description
+    // See if there's a SHA-1 hash in the image description, or else one
+    // of the faster pixel hashes (which carry their algorithm name as a
+    // prefix, so they never collide with a SHA-1).
     std::string fing = spec.get_string_attribute ("oiio:SHA-1");
+    if (fing.empty())
+        fing = spec.get_string_attribute ("oiio:PixelHash");
     if (fing.length()) {
         m_fingerprint = ustring(fing);
         // If it looks like something other than OIIO wrote the file, forget
@@ -1170,6 +1174,18 @@ ImageCacheImpl::find_file (ustring filename,
 
 
 
+// The persistent dedup index key of an opened file.
+static std::string
+dedup_key (const ImageCacheFile *tf)
+{
+    std::vector<ImageSpec> subimages;
+    for (int s = 0, e = tf->subimages();  s < e;  ++s)
+        subimages.push_back (tf->nativespec (s, 0));
+    return DedupIndex::key (tf->fingerprint(), subimages);
+}
+
+
+
 ImageCacheFile *
 ImageCacheImpl::verify_file (ImageCacheFile *tf,
                              ImageCachePerThreadInfo *thread_info,
@@ -1183,10 +1199,17 @@ ImageCacheImpl::verify_file (ImageCacheFile *tf,
         return tf;
     }
 
-    // Open the file if it's never been opened before.
+    // A file the persistent dedup index already knows to hold the same
+    // texture as another can be pointed at that one without being opened
+    // at all.  (Header queries still open it, below.)
+    if (m_dedup && m_deduplicate && ! header_only && ! tf->validspec() &&
+        ! tf->duplicate())
+        find_indexed_duplicate (tf, thread_info);
+
+    // Open the file if it's never been opened before (and we need it).
     // No need to have the file cache locked for this, though we lock
     // the tf->m_input_mutex if we need to open it.
-    if (! tf->validspec()) {
+    if (! tf->validspec() && (header_only || ! tf->duplicate())) {
         Timer timer;
         if (! thread_info)
             thread_info = get_perthread_info ();
@@ -1205,6 +1228,8 @@ ImageCacheImpl::verify_file (ImageCacheFile *tf,
             // let's save them from their own foolishness.
             if (tf->fingerprint() && m_deduplicate) {
                 // std::cerr << filename << " hash=" << tf->fingerprint() << "\n";
+                if (m_dedup)
+                    m_dedup->add (dedup_key (tf), tf->filename());
                 ImageCacheFile *dup = find_fingerprint (tf->fingerprint(), tf);
                 if (dup != tf) {
                     // Already in fingerprints -- mark this one as a
@@ -1251,6 +1276,34 @@ ImageCacheImpl::verify_file (ImageCacheFile *tf,
 
 
 
+void
+ImageCacheImpl::find_indexed_duplicate (ImageCacheFile *tf,
+                                        ImageCachePerThreadInfo *thread_info)
+{
+    if (! thread_info)
+        thread_info = get_perthread_info ();
+    std::string key = m_dedup->find_key (tf->filename());
+    if (key.empty())
+        return;
+    std::string canonical = m_dedup->find_canonical (key, tf->filename());
+    if (canonical.empty())
+        return;
+    // Open the canonical file, and make sure it really does hold what the
+    // index says it does.
+    ImageCacheFile *dup = find_file (ustring(canonical), thread_info);
+    dup = verify_file (dup, thread_info, true);
+    if (! dup || dup == tf || dup->broken() || ! dup->validspec() ||
+        dedup_key (dup) != key)
+        return;
+    if (dup->duplicate())
+        dup = dup->duplicate();
+    recursive_lock_guard guard (tf->m_input_mutex);
+    if (! tf->validspec() && ! tf->duplicate())
+        tf->duplicate (dup);
+}
+
+
+
 ImageCacheFile *
 ImageCacheImpl::find_fingerprint (ustring finger, ImageCacheFile *file)
 {
@@ -1737,6 +1790,7 @@ ImageCacheImpl::getstats (int level) const
         INTOPT(accept_unmipped);
         INTOPT(read_before_insert);
         INTOPT(deduplicate);
+        STROPT(dedup_index);
         INTOPT(unassociatedalpha);
         INTOPT(failure_retries);
 #undef BOOLOPT
@@ -1801,6 +1855,13 @@ ImageCacheImpl::getstats (int level) const
             ASSERT (file);
             if (file->is_udim())
                 continue;
+            if (file->duplicate() && file->subimages() == 0) {
+                // Never opened, known to be a duplicate from the index
+                out << Strutil::format ("%7d %69s ", i+1, "")
+                    << file->filename() << "  DUPLICATES "
+                    << file->duplicate()->filename() << "\n";
+                continue;
+            }
             if (file->broken() || file->subimages() == 0) {
                 out << "  BROKEN                                                                      " 
                     << file->filename() << "\n";
@@ -2087,6 +2148,13 @@ ImageCacheImpl::attribute (string_view name, TypeDesc type,
             m_latlong_y_up_default = y_up;
             do_invalidate = true;
         }
+    } else if (name == "dedup_index" && type == TypeDesc::STRING) {
+        std::string s = std::string (*(const char **)val);
+        if (s != m_dedup_index) {
+            m_dedup_index = s;
+            m_dedup = s.size() ? DedupIndex::get (s) : nullptr;
+            do_invalidate = true;
+        }
     } else if (name == "substitute_image" && type == TypeDesc::STRING) {
         m_substitute_image = ustring (*(const char **)val);
         do_invalidate = true;
@@ -2152,6 +2220,10 @@ ImageCacheImpl::getattribute (string_view name, TypeDesc type,
         *(const char **)val = ustring (m_latlong_y_up_default ? "y" : "z").c_str();
         return true;
     }
+    if (name == "dedup_index" && type == TypeDesc::STRING) {
+        *(const char **)val = ustring(m_dedup_index).c_str();
+        return true;
+    }
     if (name == "substitute_image" && type == TypeDesc::STRING) {
         *(const char **)val = m_substitute_image.c_str();
         return true;
@@ -49,6 +49,8 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/unordered_map_concurrent.h>
 
+#include "dedup_index.h"
+
 
 OIIO_NAMESPACE_BEGIN
 
@@ -1047,6 +1049,12 @@ private:
     /// fingerprint table.
     ImageCacheFile *find_fingerprint (ustring finger, ImageCacheFile *file);
 
+    /// Consult the persistent dedup index about the not yet opened file
+    /// tf, and if it's recorded as holding the same texture as another
+    /// file, mark it as a duplicate of that one without opening it.
+    void find_indexed_duplicate (ImageCacheFile *tf,
+                                 ImageCachePerThreadInfo *thread_info);
+
     /// Clear all the per-thread microcaches.
     void purge_perthread_microcaches ();
 
@@ -1069,6 +1077,8 @@ private:
     bool m_accept_unmipped;      ///< Accept unmipped images?
     bool m_read_before_insert;   ///< Read tiles before adding to cache?
     bool m_deduplicate;          ///< Detect duplicate files?
+    std::string m_dedup_index;   ///< Persistent dedup index file
+    std::shared_ptr<DedupIndex> m_dedup; ///< ...and the index itself
     bool m_unassociatedalpha;    ///< Keep unassociated alpha files as they are?
     int m_failure_retries;       ///< Times to re-try disk failures
     bool m_latlong_y_up_default; ///< Is +y the default "up" for latlong?
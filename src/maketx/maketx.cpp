@@ -197,6 +197,9 @@ getargs (int argc, char *argv[], ImageSpec &configspec)
     Imath::M44f Mcam(0.0f), Mscr(0.0f);  // Initialize to 0
     bool separate = false;
     bool nomipmap = false;
+    bool stream = false;
+    std::string dedup_index;
+    std::string hash_algorithm;
     bool prman_metadata = false;
     bool constant_color_detect = false;
     bool monochrome_detect = false;
@@ -246,6 +249,9 @@ getargs (int argc, char *argv[], ImageSpec &configspec)
                           "Compress HDR range before resize, expand after.",
                   "--sharpen %f", &sharpen, "Sharpen MIP levels (default = 0.0 = no)",
                   "--nomipmap", &nomipmap, "Do not make multiple MIP-map levels",
+                  "--stream", &stream, "Convert a band at a time, with bounded memory, when possible",
+                  "--dedup-index %s", &dedup_index, "Index file of existing textures: copy an identical one instead of converting, and record the result",
+                  "--hash-algorithm %s", &hash_algorithm, "Pixel hash to store: sha1 (default), xxh64, farmhash128",
                   "--checknan", &checknan, "Check for NaN/Inf values (abort if found)",
                   "--fixnan %s", &fixnan, "Attempt to fix NaN/Inf values in the image (options: none, black, box3)",
                   "--fullpixels", &set_full_to_pixels, "Set the 'full' image range to be the pixel data window",
@@ -370,6 +376,11 @@ getargs (int argc, char *argv[], ImageSpec &configspec)
     configspec.attribute ("maketx:runstats", runstats);
     configspec.attribute ("maketx:resize", doresize);
     configspec.attribute ("maketx:nomipmap", nomipmap);
+    configspec.attribute ("maketx:stream", stream);
+    if (dedup_index.size())
+        configspec.attribute ("maketx:dedup_index", dedup_index);
+    if (hash_algorithm.size())
+        configspec.attribute ("maketx:hash_algorithm", hash_algorithm);
     configspec.attribute ("maketx:updatemode", updatemode);
     configspec.attribute ("maketx:constant_color_detect", constant_color_detect);
     configspec.attribute ("maketx:monochrome_detect", monochrome_detect);
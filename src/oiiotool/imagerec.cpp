@@ -230,11 +230,25 @@ ImageRec::ImageRec (const std::string &name, const ImageSpec &spec,
 
 
 
+ImageRec::ImageRec (const std::string &name, ImageRecRef src,
+                    const std::vector<ImageBufAlgo::Pipeline> &pipelines)
+    : m_name(name), m_elaborated(false),
+      m_metadata_modified(false), m_pixels_modified(true),
+      m_was_output(false), m_time(src->time()),
+      m_imagecache(src->m_imagecache),
+      m_deferred_src(src), m_deferred_pipelines(pipelines)
+{
+}
+
+
+
 bool
 ImageRec::read (ReadPolicy readpolicy, string_view channel_set)
 {
     if (elaborated())
         return true;
+    if (deferred())
+        return read_deferred ();
     static ustring u_subimages("subimages"), u_miplevels("miplevels");
     int subimages = 0;
     ustring uname (name());
@@ -319,16 +333,17 @@ ImageRec::read (ReadPolicy readpolicy, string_view channel_set)
                 error ("%s", ib->geterror());
 
             allok &= ok;
-            // Remove any existing SHA-1 hash from the spec.
+            // Remove any existing SHA-1 or other pixel hash from the spec.
             ib->specmod().erase_attribute ("oiio:SHA-1");
+            ib->specmod().erase_attribute ("oiio:PixelHash");
             std::string desc = ib->spec().get_string_attribute ("ImageDescription");
             if (desc.size()) {
 #ifdef USE_BOOST_REGEX
-                static boost::regex regex_sha ("SHA-1=[[:xdigit:]]*[ ]*");
+                static boost::regex regex_sha ("(SHA-1|PixelHash)=[[:alnum:]:]*[ ]*");
                 ib->specmod().attribute ("ImageDescription",
                                          boost::regex_replace (desc, regex_sha, ""));
 #else
-                static std::regex regex_sha ("SHA-1=[[:xdigit:]]*[ ]*");
+                static std::regex regex_sha ("(SHA-1|PixelHash)=[[:alnum:]:]*[ ]*");
                 ib->specmod().attribute ("ImageDescription",
                                          std::regex_replace (desc, regex_sha, ""));
 #endif
@@ -352,6 +367,31 @@ ImageRec::read (ReadPolicy readpolicy, string_view channel_set)
 }
 
 
+bool
+ImageRec::read_deferred ()
+{
+    bool allok = true;
+    int subimages = (int) m_deferred_pipelines.size();
+    m_subimages.resize (subimages);
+    for (int s = 0;  s < subimages;  ++s) {
+        ImageBufRef ib (new ImageBuf);
+        bool ok = m_deferred_pipelines[s].apply (*ib, (*m_deferred_src)(s));
+        if (! ok)
+            error ("%s", ib->geterror());
+        allok &= ok;
+        m_subimages[s].m_miplevels.assign (1, ib);
+        m_subimages[s].m_specs.assign (1, ib->spec());
+    }
+    // We no longer need the source (which may have been an intermediate
+    // result that nothing else refers to).
+    m_deferred_src.reset ();
+    m_deferred_pipelines.clear ();
+    m_elaborated = true;
+    return allok;
+}
+
+
+
 namespace {
 static spin_mutex err_mutex;
 }
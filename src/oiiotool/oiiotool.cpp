@@ -41,6 +41,7 @@
 #include <utility>
 #include <cctype>
 #include <map>
+#include <functional>
 
 #include <OpenEXR/ImfTimeCode.h>
 
@@ -91,6 +92,73 @@ static Oiiotool ot;
     }
 
 
+// Point operations -- those where each output pixel depends only on the
+// same pixel of the input -- on float images are not run right away.
+// Instead, the result is a deferred ImageRec that records the operation
+// in a Pipeline for each subimage, after those of the input image if it
+// is itself deferred. When something finally needs the pixels, a whole
+// run of consecutive point operations is done in a single fused pass,
+// without allocating any intermediate images. The record function adds
+// the operation to one subimage's pipeline, or returns false if it can't.
+// The result is named 'name', or keeps the input's name if that's empty.
+// Return true if the operation was deferred, false if the caller should
+// perform it the usual way.
+typedef std::function<bool(ImageBufAlgo::Pipeline &pipeline)> PointOpRecorder;
+
+static bool
+defer_point_op (string_view command, bool allsubimages,
+                const PointOpRecorder &record, string_view name = "")
+{
+    ImageRecRef A = ot.top();
+    if (! A)
+        return false;
+    ImageRecRef src;
+    std::vector<ImageBufAlgo::Pipeline> pipelines;
+    if (A->deferred()) {
+        src = A->deferred_src();
+        pipelines = A->deferred_pipelines();
+        if (! allsubimages)
+            pipelines.resize (1);
+    } else {
+        if (! ot.read (A))
+            return false;
+        src = A;
+        for (int s = 0, n = allsubimages ? A->subimages() : 1;  s < n;  ++s) {
+            // MIP-mapped, deep, and non-float images (for which the result
+            // of each step would be rounded) go the usual way.
+            const ImageBuf &Aib ((*A)(s));
+            if (A->miplevels(s) != 1 || Aib.deep() ||
+                Aib.spec().format != TypeDesc::FLOAT)
+                return false;
+            pipelines.emplace_back (Aib.spec());
+        }
+    }
+    for (auto &p : pipelines)
+        if (! record (p))
+            return false;
+    if (ot.debug)
+        std::cout << "Deferring '" << command << "' (fused pipeline now "
+                  << pipelines[0].size() << " ops)\n";
+    ot.pop ();
+    ot.push (new ImageRec (name.size() ? std::string(name) : A->name(),
+                           src, pipelines));
+    return true;
+}
+
+
+
+// Is an OiiotoolOp-style command to be applied to all subimages?
+static bool
+op_allsubimages (string_view command)
+{
+    std::map<std::string,std::string> options;
+    options["allsubimages"] = ot.allsubimages;
+    ot.extract_options (options, command);
+    return Strutil::from_string<int>(options["allsubimages"]);
+}
+
+
+
 #define UNARY_IMAGE_OP(name,impl)                                      \
     static int action_##name (int argc, const char *argv[]) {          \
         const int nargs = 1, ninputs = 1;                              \
@@ -115,12 +183,42 @@ static Oiiotool ot;
     }
 
 
-#define BINARY_IMAGE_COLOR_OP(name,impl,defaultval)                    \
+// Unary op that is a point operation, which may be deferred and fused
+// (pipeop names the ImageBufAlgo::Pipeline method).
+#define POINT_UNARY_IMAGE_OP(name,impl,pipeop)                         \
+    static int action_##name (int argc, const char *argv[]) {          \
+        const int nargs = 1, ninputs = 1;                              \
+        if (ot.postpone_callback (ninputs, action_##name, argc, argv)) \
+            return 0;                                                  \
+        ASSERT (argc == nargs);                                        \
+        string_view command = ot.express (argv[0]);                    \
+        if (defer_point_op (command, op_allsubimages (command),        \
+                [](ImageBufAlgo::Pipeline &p) {                        \
+                    p.pipeop ();  return true; }, #name))              \
+            return 0;                                                  \
+        OiiotoolSimpleUnaryOp<IBAunary> op (impl, ot, #name,           \
+                                            argc, argv, ninputs);      \
+        return op();                                                   \
+    }
+
+
+// Image-and-constants point operation, which may be deferred and fused
+// (pipeop names the ImageBufAlgo::Pipeline method).
+#define BINARY_IMAGE_COLOR_OP(name,impl,pipeop,defaultval)             \
     static int action_##name (int argc, const char *argv[]) {          \
         const int nargs = 2, ninputs = 1;                              \
         if (ot.postpone_callback (ninputs, action_##name, argc, argv)) \
             return 0;                                                  \
         ASSERT (argc == nargs);                                        \
+        string_view command = ot.express (argv[0]);                    \
+        string_view values = ot.express (argv[1]);                     \
+        if (defer_point_op (command, op_allsubimages (command),        \
+                [&](ImageBufAlgo::Pipeline &p) {                       \
+                    std::vector<float> val = color_op_values (values,  \
+                                            p.spec().nchannels,        \
+                                            float(defaultval));        \
+                    p.pipeop (&val[0]);  return true; }, #name))       \
+            return 0;                                                  \
         OiiotoolImageColorOp<IBAbinary_img_col> op (impl, ot, #name,   \
                                               argc, argv, ninputs);    \
         return op();                                                   \
@@ -230,6 +328,18 @@ Oiiotool::read (ImageRecRef img, ReadPolicy readpolicy)
     if (img->elaborated())
         return true;
 
+    // A deferred image is "read" by running the fused point operations
+    // that produce it. Account for that as its own class of operation,
+    // not as file reading.
+    if (img->deferred()) {
+        Timer timer (enable_function_timing);
+        bool ok = img->read (readpolicy);
+        function_times["(fused point ops)"] += timer();
+        if (! ok)
+            error ("point ops on "+img->name(), img->geterror());
+        return ok;
+    }
+
     // Cause the ImageRec to get read.  Try to compute how long it took.
     // Subtract out ImageCache time, to avoid double-accounting it later.
     float pre_ic_time, post_ic_time;
@@ -614,6 +724,7 @@ adjust_output_options (string_view filename,
     // Make sure we kill any special hints that maketx adds and that will
     // no longer be valid after whatever oiiotool operations we've done.
     spec.erase_attribute ("oiio:SHA-1");
+    spec.erase_attribute ("oiio:PixelHash");
     spec.erase_attribute ("oiio:ConstantColor");
     spec.erase_attribute ("oiio:AverageColor");
 }
@@ -1751,7 +1862,39 @@ private:
     string_view fromspace, tospace;
 };
 
-OP_CUSTOMCLASS (colorconvert, OpColorConvert, 1);
+static int
+action_colorconvert (int argc, const char *argv[])
+{
+    if (ot.postpone_callback (1, action_colorconvert, argc, argv))
+        return 0;
+    string_view command = ot.express (argv[0]);
+    string_view fromspace = ot.express (argv[1]);
+    string_view tospace = ot.express (argv[2]);
+    std::map<std::string,std::string> options;
+    options["strict"] = "1";
+    ot.extract_options (options, command);
+    bool strict = Strutil::from_string<int>(options["strict"]);
+    if (fromspace != tospace &&
+        defer_point_op (command, op_allsubimages (command),
+                        [&](ImageBufAlgo::Pipeline &p) {
+                            p.colorconvert (fromspace, tospace, false,
+                                            options["key"], options["value"],
+                                            &ot.colorconfig);
+                            if (p.has_error()) {
+                                // Leave it to OpColorConvert to report
+                                // the error, unless we're told not to be
+                                // strict, in which case it's a copy.
+                                std::string err = p.geterror();
+                                if (strict)
+                                    return false;
+                                ot.warning (command, err);
+                            }
+                            return true;
+                        }, "colorconvert"))
+        return 0;
+    OpColorConvert op (ot, "colorconvert", argc, argv);
+    return op();
+}
 
 
 
@@ -2021,6 +2164,51 @@ OiioTool::decode_channel_set (const ImageSpec &spec, string_view chanlist,
 
 
 
+// Does the channel list select an in-order run of existing channels
+// (with no constant fills), which can be viewed rather than copied?
+static bool
+is_channel_run (const std::vector<int> &channels)
+{
+    if (channels.empty() || channels[0] < 0)
+        return false;
+    for (size_t c = 1;  c < channels.size();  ++c)
+        if (channels[c] != channels[0] + int(c))
+            return false;
+    return true;
+}
+
+
+
+// Make dst a zero-copy view of the run of src channels selected by
+// channels (see is_channel_run), named just as IBA::channels would name
+// them.
+static bool
+view_channels (ImageBuf &dst, const ImageBuf &src,
+               const std::vector<int> &channels,
+               const std::vector<std::string> &newchannelnames)
+{
+    ROI roi = src.roi();
+    roi.chbegin = channels[0];
+    roi.chend = channels[0] + (int)channels.size();
+    if (! dst.make_view (src, roi))
+        return false;
+    ImageSpec &spec (dst.specmod());
+    spec.alpha_channel = -1;
+    spec.z_channel = -1;
+    for (int c = 0;  c < spec.nchannels;  ++c) {
+        if (newchannelnames[c].size())
+            spec.channelnames[c] = newchannelnames[c];
+        if (Strutil::iequals (spec.channelnames[c], "A") ||
+            Strutil::iequals (spec.channelnames[c], "alpha"))
+            spec.alpha_channel = c;
+        if (Strutil::iequals (spec.channelnames[c], "Z"))
+            spec.z_channel = c;
+    }
+    return true;
+}
+
+
+
 int
 action_channels (int argc, const char *argv[])
 {
@@ -2030,18 +2218,37 @@ action_channels (int argc, const char *argv[])
     string_view command  = ot.express (argv[0]);
     string_view chanlist = ot.express (argv[1]);
 
-    ImageRecRef A (ot.pop());
-    ot.read (A);
-
     if (chanlist == "RGB")   // Fix common synonyms/mistakes
         chanlist = "R,G,B";
     else if (chanlist == "RGBA")
         chanlist = "R,G,B,A";
 
+    if (defer_point_op (command, ot.allsubimages,
+                        [&](ImageBufAlgo::Pipeline &p) {
+                            std::vector<std::string> newchannelnames;
+                            std::vector<int> channels;
+                            std::vector<float> values;
+                            if (! decode_channel_set (p.spec(), chanlist,
+                                        newchannelnames, channels, values))
+                                return false;
+                            p.channels ((int)channels.size(), &channels[0],
+                                        &values[0], &newchannelnames[0]);
+                            return ! p.has_error();
+                        })) {
+        ot.function_times[command] += timer();
+        return 0;
+    }
+
+    ImageRecRef A (ot.pop());
+    ot.read (A);
+
     // Decode the channel set, make the full list of ImageSpec's we'll
-    // need to describe the new ImageRec with the altered channels.
+    // need to describe the new ImageRec with the altered channels.  If
+    // every subimage just keeps a run of its channels, and its pixels are
+    // in memory, the result can view them rather than copy them.
     std::vector<int> allmiplevels;
     std::vector<ImageSpec> allspecs;
+    bool view = true;
     for (int s = 0, subimages = ot.allsubimages ? A->subimages() : 1;
          s < subimages;  ++s) {
         std::vector<std::string> newchannelnames;
@@ -2056,7 +2263,10 @@ action_channels (int argc, const char *argv[])
         }
         int miplevels = ot.allsubimages ? A->miplevels(s) : 1;
         allmiplevels.push_back (miplevels);
+        view &= is_channel_run (channels);
         for (int m = 0;  m < miplevels;  ++m) {
+            const ImageBuf &Aib ((*A)(s,m));
+            view &= (Aib.localpixels() && ! Aib.deep());
             ImageSpec spec = *A->spec(s,m);
             spec.nchannels = (int)newchannelnames.size();
             spec.channelformats.clear();
@@ -2065,9 +2275,11 @@ action_channels (int argc, const char *argv[])
         }
     }
 
-    // Create the replacement ImageRec
+    // Create the replacement ImageRec (with no pixels of its own yet, if
+    // it's to be a view)
     ImageRecRef R (new ImageRec(A->name(), (int)allmiplevels.size(),
-                                &allmiplevels[0], &allspecs[0]));
+                                &allmiplevels[0],
+                                view ? NULL : &allspecs[0]));
     ot.push (R);
 
     // Subimage by subimage, MIP level by MIP level, copy/shuffle the
@@ -2080,7 +2292,10 @@ action_channels (int argc, const char *argv[])
                             channels, values);
         for (int m = 0, miplevels = R->miplevels(s);  m < miplevels;  ++m) {
             // Shuffle the indexed/named channels
-            bool ok = ImageBufAlgo::channels ((*R)(s,m), (*A)(s,m),
+            bool ok = view
+                ? view_channels ((*R)(s,m), (*A)(s,m), channels,
+                                 newchannelnames)
+                : ImageBufAlgo::channels ((*R)(s,m), (*A)(s,m),
                                       (int)channels.size(), &channels[0],
                                       &values[0], &newchannelnames[0], false);
             if (! ok)
@@ -2447,16 +2662,16 @@ BINARY_IMAGE_OP (mul, ImageBufAlgo::mul);
 BINARY_IMAGE_OP (div, ImageBufAlgo::div);
 BINARY_IMAGE_OP (absdiff, ImageBufAlgo::absdiff);
 
-BINARY_IMAGE_COLOR_OP (addc, ImageBufAlgo::add, 0);
-BINARY_IMAGE_COLOR_OP (subc, ImageBufAlgo::sub, 0);
-BINARY_IMAGE_COLOR_OP (mulc, ImageBufAlgo::mul, 1);
-BINARY_IMAGE_COLOR_OP (divc, ImageBufAlgo::div, 1);
-BINARY_IMAGE_COLOR_OP (absdiffc, ImageBufAlgo::absdiff, 0);
-BINARY_IMAGE_COLOR_OP (powc, ImageBufAlgo::pow, 1.0f);
+BINARY_IMAGE_COLOR_OP (addc, ImageBufAlgo::add, add, 0);
+BINARY_IMAGE_COLOR_OP (subc, ImageBufAlgo::sub, sub, 0);
+BINARY_IMAGE_COLOR_OP (mulc, ImageBufAlgo::mul, mul, 1);
+BINARY_IMAGE_COLOR_OP (divc, ImageBufAlgo::div, div, 1);
+BINARY_IMAGE_COLOR_OP (absdiffc, ImageBufAlgo::absdiff, absdiff, 0);
+BINARY_IMAGE_COLOR_OP (powc, ImageBufAlgo::pow, pow, 1.0f);
 
-UNARY_IMAGE_OP (abs, ImageBufAlgo::abs);
-UNARY_IMAGE_OP (unpremult, ImageBufAlgo::unpremult);
-UNARY_IMAGE_OP (premult, ImageBufAlgo::premult);
+POINT_UNARY_IMAGE_OP (abs, ImageBufAlgo::abs, abs);
+POINT_UNARY_IMAGE_OP (unpremult, ImageBufAlgo::unpremult, unpremult);
+POINT_UNARY_IMAGE_OP (premult, ImageBufAlgo::premult, premult);
 
 
 
@@ -2949,6 +3164,16 @@ action_capture (int argc, const char *argv[])
 
 
 
+// Can the roi of src be a zero-copy view (ImageBuf::make_view) instead
+// of a copy?
+static bool
+can_view (const ImageBuf &src, ROI roi)
+{
+    return src.localpixels() && ! src.deep() && src.contains_roi (roi);
+}
+
+
+
 int
 action_crop (int argc, const char *argv[])
 {
@@ -2991,9 +3216,11 @@ action_crop (int argc, const char *argv[])
             ROI roi = Aib.roi();
             if (w != spec.width || h != spec.height || d != spec.depth ||
                     x != spec.x || y != spec.y || z != spec.z) {
-                roi = ROI (x, x+w, y, y+h, z, z+d);
+                roi = ROI (x, x+w, y, y+h, z, z+d, 0, Aib.nchannels());
             }
-            bool ok = ImageBufAlgo::crop (Rib, Aib, roi);
+            // Narrowing in-memory pixels needs no copy, just a view.
+            bool ok = can_view (Aib, roi) ? Rib.make_view (Aib, roi)
+                                          : ImageBufAlgo::crop (Rib, Aib, roi);
             if (! ok)
                 ot.error (command, Rib.geterror());
             R->update_spec_from_imagebuf (s, 0);
@@ -3107,10 +3334,23 @@ action_cut (int argc, const char *argv[])
     ot.adjust_geometry (argv[0], newspec.width, newspec.height,
                         newspec.x, newspec.y, size.c_str());
 
-    ImageRecRef R (new ImageRec (A->name(), newspec, ot.imagecache));
+    ImageRecRef R (new ImageRec (A->name(), 1, NULL));
     const ImageBuf &Aib ((*A)(0,0));
     ImageBuf &Rib ((*R)(0,0));
-    ImageBufAlgo::cut (Rib, Aib, get_roi(newspec));
+    ROI roi = get_roi (newspec);
+    roi.chend = Aib.nchannels();
+    if (can_view (Aib, roi)) {
+        // Cutting from in-memory pixels needs no copy, just a view that
+        // is moved to the origin.
+        Rib.make_view (Aib, roi);
+        Rib.specmod().x = 0;
+        Rib.specmod().y = 0;
+        Rib.specmod().z = 0;
+        Rib.set_roi_full (Rib.roi());
+    } else {
+        ImageBufAlgo::cut (Rib, Aib, roi);
+    }
+    R->update_spec_from_imagebuf (0, 0);
 
     ImageSpec &spec (*R->spec(0,0));
     set_roi (spec, Rib.roi());
@@ -3933,6 +4173,30 @@ action_clamp (int argc, const char *argv[])
     Timer timer (ot.enable_function_timing);
     string_view command = ot.express (argv[0]);
 
+    std::map<std::string,std::string> options;
+    options["clampalpha"] = "0";  // initialize
+    ot.extract_options (options, command);
+    bool clampalpha01 = strtol (options["clampalpha"].c_str(), NULL, 10) != 0;
+    auto limits = [&](int nchans, std::vector<float> &min,
+                      std::vector<float> &max) {
+        const float big = std::numeric_limits<float>::max();
+        min.assign (nchans, -big);
+        max.assign (nchans, big);
+        Strutil::extract_from_list_string (min, options["min"]);
+        Strutil::extract_from_list_string (max, options["max"]);
+    };
+
+    if (defer_point_op (command, ot.allsubimages,
+                        [&](ImageBufAlgo::Pipeline &p) {
+                            std::vector<float> min, max;
+                            limits (p.spec().nchannels, min, max);
+                            p.clamp (&min[0], &max[0], clampalpha01);
+                            return true;
+                        })) {
+        ot.function_times[command] += timer();
+        return 0;
+    }
+
     ImageRecRef A = ot.pop();
     ot.read (A);
     ImageRecRef R (new ImageRec (*A, ot.allsubimages ? -1 : 0,
@@ -3940,16 +4204,8 @@ action_clamp (int argc, const char *argv[])
                                  true /*writeable*/, false /*copy_pixels*/));
     ot.push (R);
     for (int s = 0, subimages = R->subimages();  s < subimages;  ++s) {
-        int nchans = (*R)(s,0).nchannels();
-        const float big = std::numeric_limits<float>::max();
-        std::vector<float> min (nchans, -big);
-        std::vector<float> max (nchans, big);
-        std::map<std::string,std::string> options;
-        options["clampalpha"] = "0";  // initialize
-        ot.extract_options (options, command);
-        Strutil::extract_from_list_string (min, options["min"]);
-        Strutil::extract_from_list_string (max, options["max"]);
-        bool clampalpha01 = strtol (options["clampalpha"].c_str(), NULL, 10) != 0;
+        std::vector<float> min, max;
+        limits ((*R)(s,0).nchannels(), min, max);
 
         for (int m = 0, miplevels=R->miplevels(s);  m < miplevels;  ++m) {
             ImageBuf &Rib ((*R)(s,m));
@@ -4881,6 +5137,9 @@ print_help (ArgParse &ap)
                   << Strutil::wordwrap(Strutil::join (libvec, ", "), columns, 4)
                   << std::endl;
     }
+    std::cout << "SIMD kernels: " << OIIO::get_string_attribute("simd_level")
+              << " (available: " << OIIO::get_string_attribute("simd_levels")
+              << ")\n";
 }
 
 
@@ -34,6 +34,7 @@
 #include <memory>
 
 #include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/sysutil.h>
 
@@ -310,6 +311,13 @@ public:
     ImageRec (const std::string &name, const ImageSpec &spec,
               ImageCache *imagecache);
 
+    // Initialize a deferred ImageRec, whose pixels aren't computed until
+    // it is read: then subimage s is the result of running pipelines[s]
+    // on subimage s of src (which must already be read), in one fused
+    // pass.
+    ImageRec (const std::string &name, ImageRecRef src,
+              const std::vector<ImageBufAlgo::Pipeline> &pipelines);
+
     enum WinMerge { WinMergeUnion, WinMergeIntersection, WinMergeA, WinMergeB };
 
     // Initialize a new ImageRec based on two exemplars.  Initialize
@@ -358,6 +366,14 @@ public:
     bool read (ReadPolicy readpolicy = ReadDefault,
                string_view channel_set = "");
 
+    // Is this a deferred ImageRec, not yet read? If so, its pixels will be
+    // computed from deferred_src() by the deferred_pipelines().
+    bool deferred () const { return m_deferred_src.get() != NULL; }
+    ImageRecRef deferred_src () const { return m_deferred_src; }
+    const std::vector<ImageBufAlgo::Pipeline> & deferred_pipelines () const {
+        return m_deferred_pipelines;
+    }
+
     // ir(subimg,mip) references a specific MIP level of a subimage
     // ir(subimg) references the first MIP level of a subimage
     // ir() references the first MIP level of the first subimage
@@ -440,10 +456,15 @@ private:
     ImageCache *m_imagecache;
     mutable std::string m_err;
     ImageSpec m_configspec;
+    ImageRecRef m_deferred_src;
+    std::vector<ImageBufAlgo::Pipeline> m_deferred_pipelines;
 
     // Add to the error message
     void append_error (string_view message) const;
 
+    // Compute the pixels of a deferred ImageRec
+    bool read_deferred ();
+
 };
 
 
@@ -684,6 +705,20 @@ protected:
 };
 
 
+// Decode the scalar or per-channel constants argument of an op like
+// --addc, for an image with nchans channels: a single value is used for
+// all channels, and channels not given a value get defaultval.
+inline std::vector<float>
+color_op_values (string_view list, int nchans, float defaultval)
+{
+    std::vector<float> val (nchans, defaultval);
+    int nvals = Strutil::extract_from_list_string (val, list);
+    val.resize (nvals);
+    val.resize (nchans, val.size() == 1 ? val.back() : defaultval);
+    return val;
+}
+
+
 typedef bool (*IBAunary) (ImageBuf &dst, const ImageBuf &A, ROI roi, int nthreads);
 typedef bool (*IBAbinary) (ImageBuf &dst, const ImageBuf &A,
                            const ImageBuf &B, ROI roi, int nthreads);
@@ -728,11 +763,8 @@ public:
           defaultval(defaultval)
     {}
     virtual int impl (ImageBuf **img) {
-        int nchans = img[1]->spec().nchannels;
-        std::vector<float> val (nchans, defaultval);
-        int nvals = Strutil::extract_from_list_string (val, args[1]);
-        val.resize (nvals);
-        val.resize (nchans, val.size() == 1 ? val.back() : defaultval);
+        std::vector<float> val = color_op_values (args[1],
+                                    img[1]->spec().nchannels, defaultval);
         return opimpl (*img[0], *img[1], &val[0], ROI(), 0);
     }
 protected:
@@ -224,6 +224,9 @@ private:
     double m_background_color[4];
     ///< Do not convert unassociated alpha
     bool m_keep_unassociated_alpha;
+    //oiio:HeaderOnly config option: only parse what the ImageSpecs need,
+    //deferring the channel data layout until pixels are actually read
+    bool m_header_only;
 
 
     FileHeader m_header;
@@ -236,6 +239,10 @@ private:
     //Reset to initial state
     void init ();
 
+    //Finish an open that was done with oiio:HeaderOnly, so that pixels
+    //can be read
+    bool complete_header_only_open ();
+
     //File Header
     bool load_header ();
     bool read_header ();
@@ -589,7 +596,7 @@ PSDInput::open (const std::string &name, ImageSpec &newspec)
         return false;
     }
 
-    // Layers
+    // Layers (in header-only mode, just the layer records)
     if (!load_layers ()) {
         error ("failed to open \"%s\": failed load_layers", name);
         return false;
@@ -608,7 +615,11 @@ PSDInput::open (const std::string &name, ImageSpec &newspec)
     }
 
     // Image Data
-    if (!load_image_data ()) {
+    if (m_header_only) {
+        // Just enough for setup() to refer to the composite's channels;
+        // their data positions are filled in if pixels are requested.
+        m_image_data.channel_info.resize (m_header.channel_count);
+    } else if (!load_image_data ()) {
         error ("failed to open \"%s\": failed load_image_data", name);
         return false;
     }
@@ -638,11 +649,32 @@ PSDInput::open (const std::string &name, ImageSpec &newspec,
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
 
+    m_header_only = config.get_int_attribute ("oiio:HeaderOnly", 0) != 0;
+
     return open (name, newspec);
 }
 
 
 
+bool
+PSDInput::complete_header_only_open ()
+{
+    // Reopen without the header-only hint, preserving the other options
+    // and the current subimage.
+    std::string filename = m_filename;
+    int subimage = m_subimage;
+    bool want_raw = m_WantRaw;
+    bool keep_unassociated_alpha = m_keep_unassociated_alpha;
+    init ();
+    m_WantRaw = want_raw;
+    m_keep_unassociated_alpha = keep_unassociated_alpha;
+    ImageSpec dummyspec;
+    return open (filename, dummyspec)
+        && seek_subimage (subimage, 0, dummyspec);
+}
+
+
+
 bool
 PSDInput::close ()
 {
@@ -743,6 +775,9 @@ PSDInput::read_native_scanline (int y, int z, void *data)
     if (y < 0 || y > m_spec.height)
         return false;
 
+    if (m_header_only && !complete_header_only_open ())
+        return false;
+
     if (m_channel_buffers.size () < m_channels[m_subimage].size ())
         m_channel_buffers.resize (m_channels[m_subimage].size ());
 
@@ -865,6 +900,7 @@ PSDInput::init ()
     m_rle_buffer.clear ();
     m_transparency_index = -1;
     m_keep_unassociated_alpha = false;
+    m_header_only = false;
     m_background_color[0] = 1.0;
     m_background_color[1] = 1.0;
     m_background_color[2] = 1.0;
@@ -1307,6 +1343,14 @@ PSDInput::load_resource_thumbnail (uint32_t length, bool isBGR)
         return false;
     }
 
+    // Don't bother decompressing the thumbnail for a header-only open
+    if (m_header_only) {
+        composite_attribute ("thumbnail_width", (int)width);
+        composite_attribute ("thumbnail_height", (int)height);
+        composite_attribute ("thumbnail_nchannels", 3);
+        return true;
+    }
+
     cinfo.err = jpeg_std_error (&jerr.pub);
     jerr.pub.error_exit = thumbnail_error_exit;
     if (setjmp (jerr.setjmp_buffer)) {
@@ -1408,6 +1452,10 @@ PSDInput::load_layers ()
         if (!load_layer (layer))
             return false;
     }
+    // The per-channel data layout (including the RLE row lengths of every
+    // channel of every layer) is only needed to read pixels.
+    if (m_header_only)
+        return true;
     for (int16_t layer_nbr = 0; layer_nbr < layer_info.layer_count; ++layer_nbr) {
         Layer &layer = m_layers[layer_nbr];
         if (!load_layer_channels (layer))
@@ -808,6 +808,20 @@ IBA_computePixelHashSHA1 (const ImageBuf &src,
 
 
 
+std::string
+IBA_computePixelHash (const ImageBuf &src,
+                      const std::string &algorithm = std::string(),
+                      const std::string &extrainfo = std::string(),
+                      ROI roi = ROI::All(),
+                      int blocksize = 0, int nthreads=0)
+{
+    ScopedGILRelease gil;
+    return ImageBufAlgo::computePixelHash (src, algorithm, extrainfo, roi,
+                                           blocksize, nthreads);
+}
+
+
+
 bool
 IBA_warp (ImageBuf &dst, const ImageBuf &src, tuple values_M,
           const std::string &filtername = "", float filterwidth = 0.0f,
@@ -1825,6 +1839,11 @@ void declare_imagebufalgo()
               arg("blocksize")=0, arg("nthreads")=0))
         .staticmethod("computePixelHashSHA1")
 
+        .def("computePixelHash", &IBA_computePixelHash,
+             (arg("src"), arg("algorithm")="", arg("extrainfo")="",
+              arg("roi")=ROI::All(), arg("blocksize")=0, arg("nthreads")=0))
+        .staticmethod("computePixelHash")
+
         .def("warp", &IBA_warp,
              (arg("dst"), arg("src"), arg("M"),
               arg("filtername")="", arg("filterwidth")=0.0f,
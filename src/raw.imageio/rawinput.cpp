@@ -46,7 +46,8 @@ OIIO_PLUGIN_NAMESPACE_BEGIN
 
 class RawInput : public ImageInput {
 public:
-    RawInput () : m_process(true), m_image(NULL) {}
+    RawInput () : m_process(true), m_unpacked(false), m_header_only(false),
+                  m_image(NULL) {}
     virtual ~RawInput() { close(); }
     virtual const char * format_name (void) const { return "raw"; }
     virtual int supports (string_view feature) const {
@@ -61,7 +62,15 @@ public:
 
 private:
     bool process();
+    bool unpack();
+    // Reopen a file that was opened with the "oiio:HeaderOnly" hint
+    // without it, so that its pixels can be read.
+    bool complete_header_only_open ();
     bool m_process;
+    bool m_unpacked;            ///< Has the raw data been unpacked yet?
+    bool m_header_only;         ///< Opened with "oiio:HeaderOnly"?
+    ImageSpec m_config;         ///< Configuration the file was opened with
+    std::string m_filename;
     LibRaw m_processor;
     libraw_processed_image_t *m_image;
 
@@ -110,15 +119,20 @@ RawInput::open (const std::string &name, ImageSpec &newspec,
     int ret;
 
     // open the image
+    m_filename = name;
+    m_unpacked = false;
+    m_config = config;
+    m_header_only = config.get_int_attribute ("oiio:HeaderOnly", 0) != 0;
     if ( (ret = m_processor.open_file(name.c_str()) ) != LIBRAW_SUCCESS) {
         error ("Could not open file \"%s\", %s", name.c_str(), libraw_strerror(ret));
         return false;
     }
 
-    if ( (ret = m_processor.unpack() ) != LIBRAW_SUCCESS) {
-        error ("Could not unpack \"%s\", %s",name.c_str(), libraw_strerror(ret));
+    // Unpacking decodes all the raw sensor data, which isn't needed to
+    // fill out the spec, so a header-only open defers it until the first
+    // pixel read (see unpack()).
+    if (! m_header_only && ! unpack())
         return false;
-    }
 
     // Forcing the Libraw to adjust sizes based on the capture device orientation
     m_processor.adjust_sizes_info_only();
@@ -371,6 +385,40 @@ RawInput::close()
 
 
 
+bool
+RawInput::complete_header_only_open ()
+{
+    ImageSpec config = m_config;
+    config.erase_attribute ("oiio:HeaderOnly");
+    std::string filename = m_filename;
+    close ();
+    ImageSpec dummyspec;
+    return open (filename, dummyspec, config);
+}
+
+
+
+bool
+RawInput::unpack()
+{
+    if (m_unpacked)
+        return true;
+    // LibRaw can't unpack once adjust_sizes_info_only() has been called,
+    // as it is when a header-only open defers the unpack, so instead open
+    // the file again, unpacking it this time.
+    if (m_header_only)
+        return complete_header_only_open ();
+    int ret;
+    if ( (ret = m_processor.unpack() ) != LIBRAW_SUCCESS) {
+        error ("Could not unpack \"%s\", %s", m_filename.c_str(), libraw_strerror(ret));
+        return false;
+    }
+    m_unpacked = true;
+    return true;
+}
+
+
+
 bool
 RawInput::process()
 {
@@ -409,6 +457,9 @@ RawInput::read_native_scanline (int y, int z, void *data)
     if (y < 0 || y >= m_spec.height) // out of range scanline
         return false;
 
+    if (! unpack())
+        return false;
+
     if (! m_process) {
         // The user has selected not to apply any debayering.
         // We take the raw data directly
@@ -1043,6 +1043,15 @@ TIFFInput::readspec (bool read_meta)
         desc = regex_replace (desc, regex("SHA-1=[[:xdigit:]]*[ ]*"), "");
         updatedDesc = true;
     }
+    found = desc.rfind ("oiio:PixelHash=");
+    if (found != std::string::npos) {
+        size_t begin = desc.find_first_of ('=', found) + 1;
+        size_t end = std::min (desc.find_first_of (' ', begin), desc.size());
+        string_view s = string_view (desc.data()+begin, end-begin);
+        m_spec.attribute ("oiio:PixelHash", s);
+        desc = regex_replace (desc, regex("oiio:PixelHash=[[:alnum:]:]*[ ]*"), "");
+        updatedDesc = true;
+    }
     if (updatedDesc) {
         if (desc.size())
             m_spec.attribute ("ImageDescription", desc);
@@ -9,6 +9,14 @@ failureok = True
 command += oiio_app("idiff") + " img1.exr img2.exr >> out.txt ;\n"
 command += oiio_app("oiiotool") + " -diff img1.exr img2.exr >> out.txt ;\n"
 
+# idiff's quick pass/fail test: identical images, a difference under the
+# thresholds, and a difference just over them that is (or, with a lower
+# failpercent, is not) allowed for.
+command += oiio_app("idiff") + " img1.exr img1.exr >> out.txt ;\n"
+command += oiio_app("idiff") + " -fail 0.6 -warn 0.6 img1.exr img2.exr >> out.txt ;\n"
+command += oiio_app("idiff") + " -fail 0.4 -warn 0.4 -failpercent 2 -warnpercent 2 img1.exr img2.exr >> out.txt ;\n"
+command += oiio_app("idiff") + " -fail 0.4 -warn 0.4 -failpercent 0.5 -warnpercent 0.5 img1.exr img2.exr >> out.txt ;\n"
+
 
 # Outputs to check against references
 outputs = [ "out.txt" ]
@@ -0,0 +1,20 @@
+#!/usr/bin/env python
+
+# "jpeg:scale" decodes at 1/2, 1/4 or 1/8 resolution in the DCT domain.
+# The source is gray checks of 16x16 pixels, so every 8x8 block is flat
+# and the reduced decode should exactly match a full decode resampled
+# down to the same size.
+command += oiiotool ("--pattern checker:width=16:height=16:color1=0.25:color2=0.75 256x192 1 -d uint8 -o src.jpg")
+for scale in [ 2, 4, 8 ] :
+    w = 256 // scale
+    h = 192 // scale
+    command += oiiotool ("--iconfig jpeg:scale " + str(scale) + " src.jpg"
+                         + " --echo \"scale " + str(scale)
+                         + ": {TOP.width}x{TOP.height} jpeg:scale={TOP.jpeg:scale}\""
+                         + " -o scaled" + str(scale) + ".tif")
+    command += oiiotool ("src.jpg --resample " + str(w) + "x" + str(h)
+                         + " -o resampled" + str(scale) + ".tif")
+    command += diff_command ("scaled" + str(scale) + ".tif",
+                             "resampled" + str(scale) + ".tif")
+
+outputs = [ "out.txt" ]
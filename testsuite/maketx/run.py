@@ -113,6 +113,22 @@ command += maketx_command ("white.exr", "whiteenv.exr",
                            "--envlatl")
 command += oiiotool ("--stats whiteenv.exr")
 
+# Test --dedup-index: converting the same image again with the same
+# settings copies the first texture, but a different wrap mode or data
+# window must not.  (Print how many of each were copies.)
+if os.path.isfile ("dedup.idx") :
+    os.remove ("dedup.idx")
+command += oiiotool ("checker.tif --origin +8+8 --fullsize 144x144+0+0"
+                     + " -d half -o " + oiio_relpath("checker-offset.exr"))
+for (infile, outfile, args) in [ ("checker.tif", "dedup1.exr", ""),
+                                 ("checker.tif", "dedup2.exr", ""),
+                                 ("checker.tif", "dedup3.exr", "--wrap clamp"),
+                                 ("checker-offset.exr", "dedup4.exr", "") ] :
+    command += maketx_command (infile, outfile,
+                               "--dedup-index dedup.idx -v " + args,
+                               silent=True, concat=False)
+    command += " | grep -c \"Identical to existing\" >> out.txt || true ;\n"
+
 outputs = [ "out.txt" ]
 
 
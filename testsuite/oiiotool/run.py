@@ -239,6 +239,20 @@ command += oiiotool ("--info -v -metamatch Debug --iconfig oiio:DebugOpenConfig!
 command += oiiotool ("--pattern fill:color=.6,.5,.4,.3,.2 64x64 5 -d uint8 -o const5.tif")
 command += oiiotool ("-i:ch=R,G,B const5.tif -o const5-rgb.tif")
 
+# test that deferred (fused) --mulc/--divc/--powc given fewer values than
+# channels leave the rest alone, just like the immediate path taken for
+# MIP-mapped input
+command += oiiotool ("--pattern constant:color=0.25,0.5,0.75,0.5 64x64 4 "
+                   + "-d half -otex rgbamip.exr")
+for op in [ "mulc 2,2,2", "divc 2,2,2", "powc 2,2,2" ] :
+    name = op.split()[0]
+    command += oiiotool ("--pattern constant:color=0.25,0.5,0.75,0.5 64x64 4 "
+                       + "--" + op + " -d half -o " + name + "-deferred.exr")
+    command += oiiotool ("rgbamip.exr --" + op + " -d half -o "
+                       + name + "-immediate.exr")
+    command += oiiotool ("--diff " + name + "-deferred.exr "
+                       + name + "-immediate.exr")
+
 # To add more tests, just append more lines like the above and also add
 # the new 'feature.tif' (or whatever you call it) to the outputs list,
 # below.
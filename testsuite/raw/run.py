@@ -0,0 +1,16 @@
+#!/usr/bin/env python
+
+# Every raw file must read the same whether or not it was opened with the
+# "oiio:HeaderOnly" hint, which defers LibRaw's unpacking of the sensor
+# data until the pixels are first read.  (idiff fails the test on any
+# difference.)
+imagedir = parent + "/oiio-images/raw"
+files = sorted (os.listdir (imagedir))
+for f in files :
+    command += oiiotool (imagedir + "/" + f + " -o raw-full.tif")
+    command += oiiotool ("--iconfig oiio:HeaderOnly 1 " + imagedir + "/" + f
+                         + " -o raw-headeronly.tif")
+    command += diff_command ("raw-full.tif", "raw-headeronly.tif",
+                             silent=True)
+
+outputs = [ ]